@@ -0,0 +1,55 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * Runs the registered benchmarks, only those whose name contains the
+ * first argument if any.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "MobiusBench.h"
+
+// registered benchmarks, in reverse order of registration
+static MobiusBenchmark* registered = nullptr;
+
+MobiusBenchmark::MobiusBenchmark(const char* name, void (*run)())
+    : name(name), run(run), next(registered) {
+    registered = this;
+}
+
+MobiusBenchmark* MobiusBenchmark::first() {
+    return registered;
+}
+
+int64_t MobiusBenchmark::nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void MobiusBenchmark::report(const char* label, uint32_t operations, int64_t elapsedNanos) {
+    double perOperation = (0 < operations) ? (double)elapsedNanos / operations : 0.0;
+    printf("  %-52s %12.1f ns/op  (%u ops)\n", label, perOperation, operations);
+}
+
+void MobiusBenchmark::reportRate(const char* label, uint64_t count, const char* unit, int64_t elapsedNanos) {
+    double perSecond = (0 < elapsedNanos) ? (double)count * 1e9 / elapsedNanos : 0.0;
+    printf("  %-52s %12.0f %s/s\n", label, perSecond, unit);
+}
+
+int main(int argc, char** argv) {
+    const char* filter = (1 < argc) ? argv[1] : nullptr;
+    // run in the order declared
+    MobiusBenchmark* benchmarks[256];
+    int count = 0;
+    for (MobiusBenchmark* benchmark = MobiusBenchmark::first(); benchmark && count < 256; benchmark = benchmark->next) {
+        if (nullptr == filter || nullptr != strstr(benchmark->name, filter)) {
+            benchmarks[count++] = benchmark;
+        }
+    }
+    for (int i = count - 1; 0 <= i; i--) {
+        printf("%s\n", benchmarks[i]->name);
+        fflush(stdout);
+        benchmarks[i]->run();
+    }
+    return (0 < count) ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#ifndef _MobiusBench_h
+#define _MobiusBench_h
+
+#include <cstdint>
+
+/*!
+ * @brief A benchmark of the host benchmark executable.
+ *
+ * Benchmarks are declared with MOBIUS_BENCH(name) and register themselves
+ * before main runs. Each measures its own loop and prints the result with
+ * report (or reportRate). "mobius_bench <text>" runs only the benchmarks whose name
+ * contains the text.
+ */
+struct MobiusBenchmark {
+    const char* name;
+    void (*run)();
+    MobiusBenchmark* next;
+
+    /*!
+     * Register the benchmark (benchmarks are never unregistered).
+     */
+    MobiusBenchmark(const char* name, void (*run)());
+
+    /*!
+     * Get the first registered benchmark (nullptr if none).
+     */
+    static MobiusBenchmark* first();
+
+    /*!
+     * Get a monotonic time (in nanoseconds).
+     */
+    static int64_t nowNanos();
+
+    /*!
+     * Print the time per operation of 'operations' taking 'elapsedNanos'.
+     */
+    static void report(const char* label, uint32_t operations, int64_t elapsedNanos);
+
+    /*!
+     * Print the rate of 'count' 'unit's (e.g. "bytes") taking 'elapsedNanos'.
+     */
+    static void reportRate(const char* label, uint64_t count, const char* unit, int64_t elapsedNanos);
+};
+
+#define MOBIUS_BENCH(name) \
+    static void name(); \
+    static MobiusBenchmark name##_benchmark(#name, name); \
+    static void name()
+
+#endif
@@ -0,0 +1,84 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * Command latency with and without a MobiusConnectionManager keeping the
+ * device connected, against MobiusSimulatedTransport with a connect time
+ * standing in for the BLE connect and discovery.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "MobiusBench.h"
+#include "MobiusConnectionManager.h"
+#include "MobiusSimulatedTransport.h"
+
+static const uint32_t CONNECT_MILLIS = 30;
+static const uint32_t LATENCY_MILLIS = 2;
+static const uint32_t COMMANDS = 20;
+
+/*!
+ * Simulated device taking CONNECT_MILLIS to connect.
+ */
+struct SlowConnectTransport : MobiusTransport {
+    MobiusSimulatedTransport simulated;
+
+    bool connect(Receiver* receiver) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(CONNECT_MILLIS));
+        return simulated.connect(receiver);
+    }
+    void disconnect() override { simulated.disconnect(); }
+    bool isConnected() override { return simulated.isConnected(); }
+    bool write(const uint8_t* data, size_t length) override { return simulated.write(data, length); }
+    const uint8_t* getAddress() const override { return simulated.getAddress(); }
+};
+
+MOBIUS_BENCH(connectionLatency) {
+    SlowConnectTransport transport;
+    transport.simulated.setLatency(LATENCY_MILLIS);
+    MobiusDevice device(&transport);
+
+    // cold: connect for every command, as a loop of connect, set, disconnect would
+    int64_t start = MobiusBenchmark::nowNanos();
+    for (uint32_t i = 0; i < COMMANDS; i++) {
+        if (!device.connect() || !device.setScene((uint16_t)i)) {
+            printf("  cold command failed\n");
+            return;
+        }
+        device.disconnect();
+    }
+    MobiusBenchmark::report("cold connect and setScene", COMMANDS, MobiusBenchmark::nowNanos() - start);
+
+    // warm: the manager keeps the link up, a command only pays for its request
+    MobiusConnectionManager manager;
+    manager.add(&device);
+    manager.start();
+    if (!manager.waitForConnection(&device, 1000)) {
+        printf("  manager failed to connect\n");
+        return;
+    }
+    start = MobiusBenchmark::nowNanos();
+    for (uint32_t i = 0; i < COMMANDS; i++) {
+        if (!manager.sendWhenConnected(&device, [i](MobiusDevice& d) { return d.setScene((uint16_t)i); }, 1000)) {
+            printf("  warm command failed\n");
+            break;
+        }
+    }
+    MobiusBenchmark::report("warm setScene through the manager", COMMANDS, MobiusBenchmark::nowNanos() - start);
+
+    // a dropped link, reconnected by the manager before the command is sent
+    int64_t elapsed = 0;
+    for (uint32_t i = 0; i < COMMANDS / 4; i++) {
+        transport.simulated.setInRange(false);
+        transport.simulated.setInRange(true);
+        start = MobiusBenchmark::nowNanos();
+        if (!manager.sendWhenConnected(&device, [i](MobiusDevice& d) { return d.setScene((uint16_t)i); }, 2000)) {
+            printf("  command after a drop failed\n");
+            break;
+        }
+        elapsed += MobiusBenchmark::nowNanos() - start;
+    }
+    MobiusBenchmark::report("setScene after a dropped link (manager reconnects)", COMMANDS / 4, elapsed);
+    manager.stop();
+    device.disconnect();
+}
@@ -0,0 +1,65 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * Reassembly of fragmented confirms by MobiusFrameAssembler, including
+ * the incremental CRC, for the fragment sizes of the default and a
+ * negotiated MTU.
+ */
+
+#include <cstdio>
+#include "MobiusBench.h"
+#include "MobiusCRC.h"
+#include "MobiusFrameAssembler.h"
+
+static const uint32_t FRAMES = 200000;
+
+/*!
+ * Build a confirm with 'dataSize' data bytes into 'frame'.
+ */
+static void buildConfirm(uint16_t dataSize, MobiusFrame& frame) {
+    frame.data[0] = 0x02;
+    frame.data[1] = 0xdf;
+    frame.data[2] = 0x17;
+    frame.data[3] = 0x01;
+    frame.data[4] = 0x00;
+    frame.data[5] = 0x00;
+    frame.data[6] = 0x00;
+    frame.data[7] = (uint8_t)dataSize;
+    frame.data[8] = (uint8_t)(dataSize >> 8);
+    for (uint16_t i = 0; i < dataSize; i++) {
+        frame.data[9 + i] = (uint8_t)(i * 7);
+    }
+    frame.size = 9 + dataSize + 2;
+    uint16_t crc = MobiusCRC::crc16(&frame.data[1], frame.size - 3);
+    frame.data[frame.size - 2] = (uint8_t)crc;
+    frame.data[frame.size - 1] = (uint8_t)(crc >> 8);
+}
+
+MOBIUS_BENCH(frameAssembler) {
+    static const uint16_t dataSizes[] = { 4, 64, 200 };
+    static const uint16_t fragmentSizes[] = { 20, 244 };
+    MobiusFrameAssembler assembler;
+    for (uint16_t fragmentSize : fragmentSizes) {
+        for (uint16_t dataSize : dataSizes) {
+            MobiusFrame frame;
+            buildConfirm(dataSize, frame);
+            uint32_t valid = 0;
+            int64_t start = MobiusBenchmark::nowNanos();
+            for (uint32_t i = 0; i < FRAMES; i++) {
+                for (uint16_t offset = 0; offset < frame.size; offset += fragmentSize) {
+                    uint16_t length = (frame.size - offset < fragmentSize) ? frame.size - offset : fragmentSize;
+                    assembler.append(&frame.data[offset], length, offset + length == frame.size);
+                }
+                valid += assembler.isCrcValid() ? 1 : 0;
+            }
+            int64_t elapsed = MobiusBenchmark::nowNanos() - start;
+            if (FRAMES != valid) {
+                printf("  only %u of %u frames were valid\n", valid, FRAMES);
+                return;
+            }
+            char label[64];
+            snprintf(label, sizeof(label), "%u data bytes, %u byte fragments", dataSize, fragmentSize);
+            MobiusBenchmark::reportRate(label, FRAMES, "frames", elapsed);
+        }
+    }
+}
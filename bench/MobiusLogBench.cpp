@@ -0,0 +1,62 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * Cost of the library's logging per advertisement and per request, at the
+ * compile-time level the library was built with. mobius_bench uses the
+ * default level, while mobius_bench_log_<level> is built for each level
+ * (run them all with the mobius_bench_log_levels target). Enabled sites
+ * are formatted as on an ESP32 logging at that level, but not printed.
+ */
+
+#include <cstdio>
+#include "MobiusBench.h"
+#include "MobiusDevice.h"
+#include "MobiusLog.h"
+#include "MobiusSimulatedTransport.h"
+
+static const uint32_t ADVERTISEMENTS = 200000;
+static const uint32_t REQUESTS = 20000;
+
+MOBIUS_BENCH(logCost) {
+    printf("  MOBIUS_LOG_LEVEL %d\n", (int)MOBIUS_LOG_LEVEL);
+    static bool initialized = false;
+    if (!initialized) {
+        MobiusDevice::init();
+        initialized = true;
+    }
+    NimBLEAdvertisedDeviceCallbacks* callbacks = NimBLEDevice::getScan()->getAdvertisedDeviceCallbacks();
+    if (nullptr == callbacks) {
+        printf("  no scan callbacks\n");
+        return;
+    }
+    NimBLEAdvertisedDevice other(NimBLEAddress("12:34:56:78:9a:bc"), "Other", -70,
+                                 std::vector<NimBLEUUID>(1, NimBLEUUID((uint16_t)0x180f)));
+    NimBLEAdvertisedDevice mobius(NimBLEAddress("c4:4f:33:0a:1b:2c"), "MOBIUS", -60,
+                                  std::vector<NimBLEUUID>(1, Mobius::GENERAL_SERVICE));
+
+    int64_t start = MobiusBenchmark::nowNanos();
+    for (uint32_t i = 0; i < ADVERTISEMENTS; i++) {
+        callbacks->onResult(&other);
+    }
+    MobiusBenchmark::report("advertisement, other device", ADVERTISEMENTS, MobiusBenchmark::nowNanos() - start);
+
+    // the first is found, the rest are repeats of a known address
+    start = MobiusBenchmark::nowNanos();
+    for (uint32_t i = 0; i < ADVERTISEMENTS; i++) {
+        callbacks->onResult(&mobius);
+    }
+    MobiusBenchmark::report("advertisement, Mobius device", ADVERTISEMENTS, MobiusBenchmark::nowNanos() - start);
+
+    MobiusSimulatedTransport simulated;
+    MobiusDevice device(&simulated);
+    if (!device.connect()) {
+        printf("  failed to connect\n");
+        return;
+    }
+    start = MobiusBenchmark::nowNanos();
+    for (uint32_t i = 0; i < REQUESTS; i++) {
+        device.setScene((uint16_t)i);
+    }
+    MobiusBenchmark::report("request, setScene", REQUESTS, MobiusBenchmark::nowNanos() - start);
+    device.disconnect();
+}
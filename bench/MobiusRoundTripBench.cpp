@@ -0,0 +1,127 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * Request and response round trips against MobiusSimulatedTransport. With
+ * no latency the response is delivered during the write, so these measure
+ * the CPU cost of building, matching and verifying each request.
+ */
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "MobiusBench.h"
+#include "MobiusCRC.h"
+#include "MobiusDevice.h"
+#include "MobiusSimulatedTransport.h"
+
+static const uint32_t ROUND_TRIPS = 20000;
+
+MOBIUS_BENCH(roundTrip) {
+    MobiusSimulatedTransport simulated;
+    MobiusDevice device(&simulated);
+    if (!device.connect()) {
+        printf("  failed to connect\n");
+        return;
+    }
+    int64_t start = MobiusBenchmark::nowNanos();
+    for (uint32_t i = 0; i < ROUND_TRIPS; i++) {
+        device.setScene((uint16_t)i);
+    }
+    MobiusBenchmark::report("setScene", ROUND_TRIPS, MobiusBenchmark::nowNanos() - start);
+
+    start = MobiusBenchmark::nowNanos();
+    for (uint32_t i = 0; i < ROUND_TRIPS; i++) {
+        device.getCurrentScene(true);
+    }
+    MobiusBenchmark::report("getCurrentScene", ROUND_TRIPS, MobiusBenchmark::nowNanos() - start);
+
+    simulated.setFragmentSize(20);
+    start = MobiusBenchmark::nowNanos();
+    for (uint32_t i = 0; i < ROUND_TRIPS; i++) {
+        device.getCurrentScene(true);
+    }
+    MobiusBenchmark::report("getCurrentScene, 20 byte fragments", ROUND_TRIPS, MobiusBenchmark::nowNanos() - start);
+    device.disconnect();
+}
+
+MOBIUS_BENCH(roundTripWithLatency) {
+    static const uint32_t count = 100;
+    MobiusSimulatedTransport simulated;
+    simulated.setLatency(2);
+    MobiusDevice device(&simulated);
+    if (!device.connect()) {
+        printf("  failed to connect\n");
+        return;
+    }
+    int64_t start = MobiusBenchmark::nowNanos();
+    for (uint32_t i = 0; i < count; i++) {
+        device.setScene((uint16_t)i);
+    }
+    MobiusBenchmark::report("setScene, 2 ms latency", count, MobiusBenchmark::nowNanos() - start);
+    device.disconnect();
+}
+
+MOBIUS_BENCH(crc16) {
+    static const size_t sizes[] = { 10, 64, 256, 1024, 4096 };
+    // about 64 MB per measurement
+    static const uint64_t bytesPerRun = 64ULL << 20;
+    static uint8_t data[4096];
+    for (uint16_t i = 0; i < sizeof data; i++) {
+        data[i] = (uint8_t)(i * 31);
+    }
+    struct Variant {
+        const char* name;
+        uint16_t (*update)(uint16_t crc, const uint8_t* data, size_t length);
+    };
+    static const Variant variants[] = { { "bytewise", &MobiusCRC::updateBytewise },
+                                        { "slice-by-4", &MobiusCRC::updateSlice4 },
+                                        { "slice-by-8", &MobiusCRC::update } };
+    volatile uint16_t sink = 0;
+    char label[64];
+    for (size_t size : sizes) {
+        uint32_t count = (uint32_t)(bytesPerRun / size);
+        for (const Variant& variant : variants) {
+            int64_t start = MobiusBenchmark::nowNanos();
+            for (uint32_t i = 0; i < count; i++) {
+                sink = sink + variant.update(MobiusCRC::init(), data, size);
+            }
+            snprintf(label, sizeof label, "crc16 %s, %u bytes", variant.name, (unsigned)size);
+            MobiusBenchmark::reportRate(label, (uint64_t)count * size, "bytes", MobiusBenchmark::nowNanos() - start);
+        }
+    }
+}
+
+MOBIUS_BENCH(windowDepth) {
+    static const uint8_t windowSizes[] = { 1, 2, 4, 8 };
+    static const uint32_t senders = 8;
+    static const uint32_t count = 25;
+    for (uint8_t windowSize : windowSizes) {
+        MobiusSimulatedTransport simulated;
+        simulated.setLatency(2);
+        // the window takes effect on the next connect
+        MobiusDevice::setWindowSize(windowSize);
+        MobiusDevice device(&simulated);
+        if (!device.connect()) {
+            printf("  failed to connect\n");
+            break;
+        }
+        int64_t start = MobiusBenchmark::nowNanos();
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t < senders; t++) {
+            threads.emplace_back([&device] {
+                for (uint32_t i = 0; i < count; i++) {
+                    device.setScene((uint16_t)i);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        int64_t elapsed = MobiusBenchmark::nowNanos() - start;
+        device.disconnect();
+        char label[64];
+        snprintf(label, sizeof(label), "setScene, 2 ms latency, window %u", windowSize);
+        MobiusBenchmark::reportRate(label, senders * count, "requests", elapsed);
+    }
+    MobiusDevice::setWindowSize(4);
+}
@@ -3,9 +3,11 @@
  *
  * This example shows how a Mobius device may be controlled with an analog signal.
  * First this will scans for BLE enabled Mobius devices (expecting just one). Once
- * the device is discovered this checks the analog PIN (A0) every 2 seconds for the
- * current state. When a new state is detected this will connect to the Mobius
- * device and set the scene corresponding to the state.
+ * the device is discovered it is kept connected by a MobiusConnectionManager and
+ * this checks the analog PIN (A0) every 2 seconds for the current state. When a
+ * new state is detected this will queue setting the scene corresponding to the
+ * state. Scene changes which are still queued when the state changes again are
+ * replaced, so only the latest one is sent, and the feed scene goes first.
  * 
  * The circuit:
  * - M5Atom
@@ -14,6 +16,8 @@
  */
 #include <FastLED.h>
 #include <ESP32_MobiusBLE.h>
+#include "MobiusConnectionManager.h"
+#include "MobiusCommandQueue.h"
 #include "FastLEDDeviceEventListener.h"
 
 // define LED configuration
@@ -31,6 +35,10 @@ const gpio_num_t DISABLE_PIN = GPIO_NUM_23;
 byte currentState = 0;
 // define a variable for the MobiusDevice to be controlled
 MobiusDevice pump;
+// keep the pump connected, checking the link with a keep-alive every 30 seconds
+MobiusConnectionManager manager(30000);
+// send the scene changes from a background task once the pump is connected
+MobiusCommandQueue commands(&pump, &manager);
 
 /*!
  * Main Setup method
@@ -69,6 +77,11 @@ void setup() {
   }
   
   pump = deviceBuffer[0];
+
+  // connect now and reconnect automatically whenever the link drops
+  manager.add(&pump);
+  manager.start();
+  commands.start();
 }
 
 
@@ -81,26 +94,22 @@ void loop() {
 
   if (currentState != newState) {
     // now in a different state, update a maybe do something
-    if (1 == newState && pump.connect()) {
+    if (1 == newState) {
       Serial.println("Feed Mode");
-      // new state is the feed state AND the device is connected
-      if(pump.setFeedScene()) {
+      // new state is the feed state, set it (ahead of anything else) once the device is connected
+      if (commands.setFeedScene()) {
         // update the current state so not to re-enter feed state next loop
         currentState = newState;
       }
-      // disconnect from the device
-      pump.disconnect();
-    } else if (2 == newState && pump.connect()) {
+    } else if (2 == newState) {
       Serial.println("Maintenance Mode");
-      // new state is the maintenance state AND the device is connected
+      // new state is the maintenance state, set it once the device is connected
       // set the sceneId to the custom/unique ID
       uint16_t sceneId = 1234;
-      if(pump.setScene(sceneId)) {
+      if (commands.setScene(sceneId)) {
         // update the current state so not to re-enter maintenance state next loop
         currentState = newState;
       }
-      // disconnect from the device
-      pump.disconnect();
     } else {
       // update the current state
       currentState = newState;
@@ -0,0 +1,74 @@
+/*!
+ * Switch a Group of Mobius Devices Together
+ *
+ * This example shows how several Mobius devices may be switched to a new scene
+ * within a tight window. It runs against simulated devices, so no pumps are
+ * needed, and compares switching the devices one after another with switching
+ * them as a MobiusDeviceGroup. For each it prints the spread between the first
+ * and the last device confirming the scene.
+ * 
+ * Replace the simulated devices with MobiusDevices found by a scan to switch
+ * real pumps.
+ * 
+ * The circuit:
+ * - any ESP32
+ * 
+ * This example code is released into the public domain.
+ */
+#include <ESP32_MobiusBLE.h>
+#include "MobiusDeviceGroup.h"
+#include "MobiusSimulatedTransport.h"
+
+// number of simulated devices (at most MobiusDeviceGroup::MAX_DEVICES)
+const uint8_t DEVICE_COUNT = 3;
+// simulated response time (in milliseconds), plus up to the jitter
+const uint32_t LATENCY = 40;
+const uint32_t JITTER = 20;
+
+MobiusSimulatedTransport simulated[DEVICE_COUNT];
+MobiusDevice devices[DEVICE_COUNT];
+MobiusDeviceGroup tank;
+
+/*!
+ * Main Setup method
+ */
+void setup() {
+  // connect the serial port for logs
+  Serial.begin(115200);
+  while (!Serial);
+
+  for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+    simulated[i].setLatency(LATENCY, JITTER);
+    // a different jitter sequence for each device
+    simulated[i].setSeed(i + 1);
+    devices[i] = MobiusDevice(&simulated[i]);
+    tank.add(&devices[i]);
+  }
+}
+
+/*!
+ * Main Loop method
+ */
+void loop() {
+  // one after another, as a loop over the devices would
+  uint32_t firstMicros = 0;
+  uint32_t lastMicros = 0;
+  for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+    devices[i].connect();
+    if (devices[i].setFeedScene()) {
+      lastMicros = micros();
+      firstMicros = firstMicros ? firstMicros : lastMicros;
+    }
+    devices[i].disconnect();
+  }
+  Serial.printf("One after another: spread %u us\n", lastMicros - firstMicros);
+
+  // as a group, connected first and written in one burst
+  tank.connect();
+  uint8_t changed = tank.setFeedScene();
+  Serial.printf("As a group: %d of %d changed, write spread %u us, confirm spread %u us\n",
+                changed, DEVICE_COUNT, tank.getWriteSkewMicros(), tank.getConfirmSkewMicros());
+  tank.disconnect();
+
+  delay(5000);
+}
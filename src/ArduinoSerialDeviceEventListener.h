@@ -18,6 +18,7 @@ class ArduinoSerialDeviceEventListener : public MobiusDeviceEventListener {
 public:
     ArduinoSerialDeviceEventListener();
     ~ArduinoSerialDeviceEventListener();
+    using MobiusDeviceEventListener::onEvent;
     
     /*!
      * @brief Write a message to the Serial stream.
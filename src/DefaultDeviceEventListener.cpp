@@ -13,6 +13,7 @@
 #include <esp_log.h>
 static const char* LOG_TAG = "DefaultDeviceEventListener";
 #endif
+#include "MobiusLog.h"
 
 /*!
  * Default constructor.
@@ -30,7 +31,7 @@ DefaultDeviceEventListener::~DefaultDeviceEventListener() {}
  * @param event MobiusDeviceEvent
  */
 void DefaultDeviceEventListener::onEvent(MobiusDeviceEvent event) {
-    ESP_LOGD(LOG_TAG, "- %s", getEventName(event).c_str());
+    MOBIUS_LOGD("- %s", getEventName(event).c_str());
 }
 
 /*
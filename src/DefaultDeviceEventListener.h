@@ -17,6 +17,7 @@ class DefaultDeviceEventListener : public MobiusDeviceEventListener {
 public:
     DefaultDeviceEventListener();
     ~DefaultDeviceEventListener();
+    using MobiusDeviceEventListener::onEvent;
     
     /*!
      * @brief Log the event at DEBUG level.
@@ -18,6 +18,7 @@ class FastLEDDeviceEventListener : public MobiusDeviceEventListener {
 public:
     FastLEDDeviceEventListener();
     ~FastLEDDeviceEventListener();
+    using MobiusDeviceEventListener::onEvent;
     
     /*!
      * @brief Blink the LED.
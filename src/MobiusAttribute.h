@@ -0,0 +1,128 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusAttribute_h
+#define _MobiusAttribute_h
+
+#include <cstdint>
+#include <cstddef>
+
+/*!
+ * @brief Compile-time description of a C2 attribute.
+ *
+ * Each attribute is declared once with its C2 ID, the type of its value
+ * and the number of bytes the value takes on the wire (little endian,
+ * zero padded when wider than the type). The descriptor, the SET
+ * encoding and the decoding of a GET confirm are all generated from the
+ * declaration, e.g.
+ *
+ *     typedef MobiusAttribute<401, uint16_t, 4> SceneAttribute;
+ *     auto request = SceneAttribute::encode(sceneId); // request.bytes
+ *
+ * Encoding is constexpr, so constant values are built at compile time
+ * and other values compile down to fixed stores.
+ *
+ * @tparam ID C2 attribute ID
+ * @tparam T value type (an unsigned integer of at most 4 bytes)
+ * @tparam WIDTH number of value bytes on the wire (default sizeof(T))
+ */
+template<uint16_t ID, typename T, uint8_t WIDTH = sizeof(T)>
+struct MobiusAttribute {
+    static_assert(sizeof(T) <= 4, "MobiusAttribute values are at most 4 bytes");
+    static_assert(0 < WIDTH, "MobiusAttribute needs at least one value byte");
+
+    typedef T ValueType;
+
+    static const uint16_t ATTRIBUTE_ID = ID;
+    static const uint8_t VALUE_WIDTH = WIDTH;
+    // id (2 bytes), 0x00, 0x01
+    static const uint16_t DESCRIPTOR_SIZE = 4;
+    // descriptor, value length, value
+    static const uint16_t ENCODED_SIZE = DESCRIPTOR_SIZE + 1 + WIDTH;
+    // status, descriptor, value length, value
+    static const uint16_t BODY_VALUE_OFFSET = 1 + DESCRIPTOR_SIZE + 1;
+
+    /*!
+     * @brief Bytes of the attribute descriptor (used to GET the attribute).
+     */
+    struct Descriptor {
+        uint8_t bytes[DESCRIPTOR_SIZE];
+    };
+
+    /*!
+     * @brief Bytes of the attribute with a value (used to SET the attribute).
+     */
+    struct Encoded {
+        uint8_t bytes[ENCODED_SIZE];
+    };
+
+    /*!
+     * @brief Get the attribute descriptor.
+     *
+     * @return a Descriptor
+     */
+    static constexpr Descriptor descriptor() {
+        return Descriptor{{ (uint8_t)(ID & 0xff), (uint8_t)(ID >> 8), 0x00, 0x01 }};
+    }
+
+    /*!
+     * @brief Encode the attribute with the given 'value'.
+     *
+     * @return an Encoded attribute
+     */
+    static constexpr Encoded encode(T value) {
+        return encode(value, typename MakeIndices<WIDTH>::type());
+    }
+
+    /*!
+     * @brief Decode a value from its 'WIDTH' wire bytes.
+     *
+     * @param value pointer to the first value byte
+     * @return the value
+     */
+    static constexpr T decode(const uint8_t* value) {
+        return (T)decodeBytes(value, 0);
+    }
+
+    /*!
+     * @brief Decode the value from the data of a GET confirm.
+     *
+     * @param body data of the confirm (see MobiusDevice::parseResponseData)
+     * @param bodySize size of the data
+     * @param value set to the decoded value, only if successful
+     * @return true if the data held this attribute
+     */
+    static bool parse(const uint8_t* body, uint16_t bodySize, T& value) {
+        bool isValid = (BODY_VALUE_OFFSET + VALUE_BYTES <= bodySize);
+        isValid = isValid && (0x00 == body[0]); // all response data starts with 0x00
+        isValid = isValid && ((uint8_t)(ID & 0xff) == body[1]) && ((uint8_t)(ID >> 8) == body[2]);
+        if (isValid) {
+            value = decode(&body[BODY_VALUE_OFFSET]);
+        }
+        return isValid;
+    }
+
+private:
+    // only the bytes which fit in T are decoded
+    static const uint8_t VALUE_BYTES = (WIDTH < sizeof(T)) ? WIDTH : sizeof(T);
+
+    template<int... I> struct Indices {};
+    template<int N, int... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+    template<int... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+    static constexpr uint8_t valueByte(T value, int index) {
+        return (index < (int)sizeof(T)) ? (uint8_t)(((uint32_t)value >> (8 * index)) & 0xff) : 0x00;
+    }
+
+    template<int... I>
+    static constexpr Encoded encode(T value, Indices<I...>) {
+        return Encoded{{ (uint8_t)(ID & 0xff), (uint8_t)(ID >> 8), 0x00, 0x01, WIDTH, valueByte(value, I)... }};
+    }
+
+    static constexpr uint32_t decodeBytes(const uint8_t* value, int index) {
+        return (index >= VALUE_BYTES) ? 0 : (((uint32_t)value[index] << (8 * index)) | decodeBytes(value, index + 1));
+    }
+};
+
+#endif
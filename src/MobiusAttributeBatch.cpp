@@ -0,0 +1,193 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <cstring>
+#include "MobiusAttributeBatch.h"
+#include "MobiusDevice.h"
+
+/*!
+ * @brief Remove all attributes and results.
+ */
+void MobiusAttributeBatch::clear() {
+    _opCode = 0;
+    _count = 0;
+    _payload.size = 0;
+    _response.size = 0;
+}
+
+/*!
+ * @brief Add an attribute to read.
+ *
+ * @param descriptor 4 byte attribute descriptor (e.g. Mobius::ATTRIBUTE_CURRENT_SCENE)
+ * @return false if the batch holds SETs or is full
+ */
+bool MobiusAttributeBatch::addGet(const uint8_t* descriptor) {
+    return append(Mobius::OP_CODE_GET, descriptor, DESCRIPTOR_SIZE);
+}
+
+/*!
+ * @brief Add an attribute value to write.
+ *
+ * @param attribute attribute descriptor followed by its value length and value
+ * @param length size of the attribute (e.g. sizeof Mobius::ATTRIBUTE_SCENE)
+ * @return false if the batch holds GETs, is full or the attribute is malformed
+ */
+bool MobiusAttributeBatch::addSet(const uint8_t* attribute, uint16_t length) {
+    // the value length byte must agree with the attribute size
+    bool valid = (DESCRIPTOR_SIZE < length) && (DESCRIPTOR_SIZE + 1 + attribute[DESCRIPTOR_SIZE] == length);
+    return valid && append(Mobius::OP_CODE_SET, attribute, length);
+}
+
+/*!
+ * @brief Get the number of attributes in the batch.
+ *
+ * @return a uint8_t
+ */
+uint8_t MobiusAttributeBatch::getCount() const {
+    return _count;
+}
+
+/*!
+ * @brief Get the result of the attribute at 'index' (in the order added).
+ *
+ * @return the Result, or nullptr if the index is out of range
+ */
+const MobiusAttributeBatch::Result* MobiusAttributeBatch::getResult(uint8_t index) const {
+    return (index < _count) ? &_results[index] : nullptr;
+}
+
+/*!
+ * @brief Get the result for the attribute with the given 'attributeId'.
+ *
+ * @return the Result, or nullptr if the attribute is not in the batch
+ */
+const MobiusAttributeBatch::Result* MobiusAttributeBatch::findResult(uint16_t attributeId) const {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (attributeId == _results[i].attributeId) {
+            return &_results[i];
+        }
+    }
+    return nullptr;
+}
+
+/*!
+ * @brief Get the request op code (Mobius::OP_CODE_GET or Mobius::OP_CODE_SET).
+ *
+ * @return a uint8_t, 0 while the batch is empty
+ */
+uint8_t MobiusAttributeBatch::getOpCode() const {
+    return _opCode;
+}
+
+/*!
+ * @brief Get the request payload.
+ *
+ * @return pointer to getPayloadSize() bytes
+ */
+const uint8_t* MobiusAttributeBatch::getPayload() const {
+    return _payload.data;
+}
+
+/*!
+ * @brief Get the size of the request payload.
+ *
+ * @return a uint16_t
+ */
+uint16_t MobiusAttributeBatch::getPayloadSize() const {
+    return _payload.size;
+}
+
+/*!
+ * @brief Get the frame which receives the confirm.
+ *
+ * @return a MobiusFrame
+ */
+MobiusFrame& MobiusAttributeBatch::getResponse() {
+    return _response;
+}
+
+/*!
+ * @brief Decode the confirm held in the response frame into results.
+ *
+ * A GET confirm holds a status byte followed by each attribute as
+ * id (2 bytes), 0x00, 0x01, value length and value. A SET confirm holds
+ * only the status and Mobius::RESPONSE_DATA_SUCCESSFUL.
+ *
+ * @return true if the confirm was valid and every attribute was successful
+ */
+bool MobiusAttributeBatch::decodeResponse() {
+    for (uint8_t i = 0; i < _count; i++) {
+        _results[i].successful = false;
+        _results[i].length = 0;
+        _results[i].value = nullptr;
+    }
+    bool isValid = (_response.size > HEADER_SIZE + 2);
+    isValid = isValid && (0x02 == _response.data[0]);
+    isValid = isValid && (Mobius::OP_GROUP_CONFIRM == _response.data[1]);
+    isValid = isValid && (_opCode == _response.data[2]);
+    if (!isValid) {
+        return false;
+    }
+    uint16_t bodySize = (_response.data[8] << 8) + (_response.data[7]);
+    if (bodySize > _response.size - HEADER_SIZE - 2) {
+        bodySize = _response.size - HEADER_SIZE - 2;
+    }
+    const uint8_t* body = &_response.data[HEADER_SIZE];
+    // all response data starts with 0x00
+    if (0 == bodySize || 0x00 != body[0]) {
+        return false;
+    }
+
+    bool allSuccessful = true;
+    if (Mobius::OP_CODE_SET == _opCode) {
+        bool setSuccessful = (1 + sizeof Mobius::RESPONSE_DATA_SUCCESSFUL == bodySize);
+        setSuccessful = setSuccessful && (0 == memcmp(&body[1], Mobius::RESPONSE_DATA_SUCCESSFUL, sizeof Mobius::RESPONSE_DATA_SUCCESSFUL));
+        for (uint8_t i = 0; i < _count; i++) {
+            _results[i].successful = setSuccessful;
+        }
+        return setSuccessful;
+    }
+
+    // GET, match each returned attribute to its result by ID
+    uint16_t offset = 1;
+    while (offset + DESCRIPTOR_SIZE + 1 <= bodySize) {
+        uint16_t attributeId = (body[offset + 1] << 8) + (body[offset]);
+        uint8_t length = body[offset + DESCRIPTOR_SIZE];
+        uint16_t valueOffset = offset + DESCRIPTOR_SIZE + 1;
+        if (valueOffset + length > bodySize) {
+            break; // truncated
+        }
+        for (uint8_t i = 0; i < _count; i++) {
+            if (attributeId == _results[i].attributeId && !_results[i].successful) {
+                _results[i].successful = true;
+                _results[i].length = length;
+                _results[i].value = &body[valueOffset];
+                break;
+            }
+        }
+        offset = valueOffset + length;
+    }
+    for (uint8_t i = 0; i < _count; i++) {
+        allSuccessful = allSuccessful && _results[i].successful;
+    }
+    return allSuccessful;
+}
+
+/*!
+ * Append an attribute to the payload and reserve its result.
+ */
+bool MobiusAttributeBatch::append(uint8_t opCode, const uint8_t* attribute, uint16_t length) {
+    // leave room for the request header and CRC
+    uint16_t capacity = MobiusFrame::CAPACITY - HEADER_SIZE - 2;
+    if ((0 != _opCode && opCode != _opCode) || MAX_ATTRIBUTES <= _count || capacity < _payload.size + length) {
+        return false;
+    }
+    _opCode = opCode;
+    memcpy(&_payload.data[_payload.size], attribute, length);
+    _payload.size += length;
+    Result& result = _results[_count++];
+    result = Result();
+    result.attributeId = (attribute[1] << 8) + (attribute[0]);
+    return true;
+}
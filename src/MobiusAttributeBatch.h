@@ -0,0 +1,179 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusAttributeBatch_h
+#define _MobiusAttributeBatch_h
+
+#include <cstdint>
+#include <cstddef>
+#include "MobiusFrame.h"
+#include "MobiusAttribute.h"
+
+/*!
+ * Maximum number of attributes in a single MobiusAttributeBatch.
+ */
+#ifndef MOBIUS_BATCH_MAX_ATTRIBUTES
+#define MOBIUS_BATCH_MAX_ATTRIBUTES 8
+#endif
+
+/*!
+ * @brief Several attribute GETs or SETs packed into one request.
+ * 
+ * Attributes (e.g. addGet<Mobius::SceneAttribute>() or
+ * addSet<Mobius::SceneAttribute>(sceneId)) are appended into one request
+ * payload, so reading or writing N attributes takes a single round trip.
+ * A batch holds either GETs or SETs, not both. Once sent with
+ * MobiusDevice::sendBatch the confirm is decoded into one result per
+ * attribute.
+ * 
+ * A batch owns its payload and response frames, so it may be reused
+ * (see clear) for periodic status sweeps without any allocation.
+ */
+class MobiusAttributeBatch {
+public:
+    static const uint8_t MAX_ATTRIBUTES = MOBIUS_BATCH_MAX_ATTRIBUTES;
+
+    /*!
+     * @brief Result of a single attribute in the batch.
+     */
+    struct Result {
+        uint16_t attributeId = 0;
+        bool successful = false;       // value was returned (GET) or set (SET)
+        uint8_t length = 0;            // number of value bytes (GET only)
+        const uint8_t* value = nullptr;// points into the batch's response (GET only)
+    };
+
+    /*!
+     * @brief Remove all attributes and results.
+     */
+    void clear();
+
+    /*!
+     * @brief Add an attribute to read.
+     * 
+     * @param descriptor 4 byte attribute descriptor (e.g. Mobius::ATTRIBUTE_CURRENT_SCENE)
+     * @return false if the batch holds SETs or is full
+     */
+    bool addGet(const uint8_t* descriptor);
+
+    /*!
+     * @brief Add an attribute value to write.
+     * 
+     * @param attribute attribute descriptor followed by its value length and value
+     * @param length size of the attribute (e.g. sizeof Mobius::ATTRIBUTE_SCENE)
+     * @return false if the batch holds GETs, is full or the attribute is malformed
+     */
+    bool addSet(const uint8_t* attribute, uint16_t length);
+
+    /*!
+     * @brief Add a declared MobiusAttribute to read.
+     * 
+     * @return false if the batch holds SETs or is full
+     */
+    template<typename Attribute>
+    bool addGet() {
+        const typename Attribute::Descriptor descriptor = Attribute::descriptor();
+        return addGet(descriptor.bytes);
+    }
+
+    /*!
+     * @brief Add a declared MobiusAttribute 'value' to write.
+     * 
+     * @return false if the batch holds GETs or is full
+     */
+    template<typename Attribute>
+    bool addSet(typename Attribute::ValueType value) {
+        const typename Attribute::Encoded attribute = Attribute::encode(value);
+        return addSet(attribute.bytes, sizeof attribute.bytes);
+    }
+
+    /*!
+     * @brief Get the value returned for a declared MobiusAttribute.
+     * 
+     * @param value set to the attribute value, only if successful
+     * @return true if the attribute was read successfully
+     */
+    template<typename Attribute>
+    bool getValue(typename Attribute::ValueType& value) const {
+        const Result* result = findResult(Attribute::ATTRIBUTE_ID);
+        bool found = result && result->successful && (Attribute::VALUE_WIDTH <= result->length);
+        if (found) {
+            value = Attribute::decode(result->value);
+        }
+        return found;
+    }
+
+    /*!
+     * @brief Get the number of attributes in the batch.
+     * 
+     * @return a uint8_t
+     */
+    uint8_t getCount() const;
+
+    /*!
+     * @brief Get the result of the attribute at 'index' (in the order added).
+     * 
+     * @return the Result, or nullptr if the index is out of range
+     */
+    const Result* getResult(uint8_t index) const;
+
+    /*!
+     * @brief Get the result for the attribute with the given 'attributeId'.
+     * 
+     * @return the Result, or nullptr if the attribute is not in the batch
+     */
+    const Result* findResult(uint16_t attributeId) const;
+
+    /*!
+     * @brief Get the request op code (Mobius::OP_CODE_GET or Mobius::OP_CODE_SET).
+     * 
+     * @return a uint8_t, 0 while the batch is empty
+     */
+    uint8_t getOpCode() const;
+
+    /*!
+     * @brief Get the request payload.
+     * 
+     * @return pointer to getPayloadSize() bytes
+     */
+    const uint8_t* getPayload() const;
+
+    /*!
+     * @brief Get the size of the request payload.
+     * 
+     * @return a uint16_t
+     */
+    uint16_t getPayloadSize() const;
+
+    /*!
+     * @brief Get the frame which receives the confirm.
+     * 
+     * @return a MobiusFrame
+     */
+    MobiusFrame& getResponse();
+
+    /*!
+     * @brief Decode the confirm held in the response frame into results.
+     * 
+     * @return true if the confirm was valid and every attribute was successful
+     */
+    bool decodeResponse();
+
+private:
+    static const uint16_t DESCRIPTOR_SIZE = 4;
+    static const uint16_t HEADER_SIZE = 9;
+
+    uint8_t _opCode = 0;
+    uint8_t _count = 0;
+    Result _results[MAX_ATTRIBUTES];
+    MobiusFrame _payload;
+    MobiusFrame _response;
+
+    /*!
+     * Append an attribute to the payload and reserve its result.
+     */
+    bool append(uint8_t opCode, const uint8_t* attribute, uint16_t length);
+};
+
+#endif
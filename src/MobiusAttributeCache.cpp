@@ -0,0 +1,137 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <cstring>
+#include <mutex>
+#include "MobiusAttributeCache.h"
+
+MobiusAttributeCache::MobiusAttributeCache(const MobiusAttributeCache& other) {
+    std::lock_guard<std::mutex> lock(other._mutex);
+    memcpy(_entries, other._entries, sizeof _entries);
+    _hits = other._hits;
+    _misses = other._misses;
+}
+
+MobiusAttributeCache& MobiusAttributeCache::operator=(const MobiusAttributeCache& other) {
+    if (this != &other) {
+        std::lock(_mutex, other._mutex);
+        std::lock_guard<std::mutex> lock(_mutex, std::adopt_lock);
+        std::lock_guard<std::mutex> otherLock(other._mutex, std::adopt_lock);
+        memcpy(_entries, other._entries, sizeof _entries);
+        _hits = other._hits;
+        _misses = other._misses;
+    }
+    return *this;
+}
+
+/*!
+ * @brief Look up a cached attribute value.
+ *
+ * @param attributeId C2 attribute ID
+ * @param value buffer receiving the value bytes
+ * @param length number of value bytes wanted
+ * @param nowMillis current time (in milliseconds)
+ * @param ttlMillis maximum age of the value (in milliseconds)
+ * @return true (a hit) if a fresh enough value was copied into 'value'
+ */
+bool MobiusAttributeCache::lookup(uint16_t attributeId, uint8_t* value, uint8_t length, uint32_t nowMillis, uint32_t ttlMillis) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry* entry = find(attributeId);
+    bool hit = entry && (length <= entry->length) && (nowMillis - entry->updatedMillis < ttlMillis);
+    if (hit) {
+        memcpy(value, entry->value, length);
+        _hits++;
+    } else {
+        _misses++;
+    }
+    return hit;
+}
+
+/*!
+ * @brief Store an attribute value confirmed by the device.
+ *
+ * @param attributeId C2 attribute ID
+ * @param value value bytes
+ * @param length number of value bytes
+ * @param nowMillis current time (in milliseconds)
+ */
+void MobiusAttributeCache::store(uint16_t attributeId, const uint8_t* value, uint8_t length, uint32_t nowMillis) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry* entry = find(attributeId);
+    if (length > VALUE_CAPACITY) {
+        if (entry) {
+            entry->valid = false;
+        }
+        return;
+    }
+    if (!entry) {
+        // use a free entry, otherwise replace the oldest
+        entry = &_entries[0];
+        for (uint8_t i = 0; entry->valid && i < MOBIUS_ATTRIBUTE_CACHE_SIZE; i++) {
+            if (!_entries[i].valid || (nowMillis - _entries[i].updatedMillis > nowMillis - entry->updatedMillis)) {
+                entry = &_entries[i];
+            }
+        }
+    }
+    entry->valid = true;
+    entry->attributeId = attributeId;
+    entry->length = length;
+    memcpy(entry->value, value, length);
+    entry->updatedMillis = nowMillis;
+}
+
+/*!
+ * @brief Remove the cached value of an attribute.
+ *
+ * @param attributeId C2 attribute ID
+ */
+void MobiusAttributeCache::invalidate(uint16_t attributeId) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry* entry = find(attributeId);
+    if (entry) {
+        entry->valid = false;
+    }
+}
+
+/*!
+ * @brief Remove all cached values (the counters are kept).
+ */
+void MobiusAttributeCache::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (uint8_t i = 0; i < MOBIUS_ATTRIBUTE_CACHE_SIZE; i++) {
+        _entries[i].valid = false;
+    }
+}
+
+/*!
+ * @brief Get the number of lookups served from the cache.
+ *
+ * @return a uint32_t
+ */
+uint32_t MobiusAttributeCache::getHitCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _hits;
+}
+
+/*!
+ * @brief Get the number of lookups not served from the cache.
+ *
+ * @return a uint32_t
+ */
+uint32_t MobiusAttributeCache::getMissCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _misses;
+}
+
+/*!
+ * Find the entry for 'attributeId', or nullptr.
+ */
+MobiusAttributeCache::Entry* MobiusAttributeCache::find(uint16_t attributeId) {
+    for (uint8_t i = 0; i < MOBIUS_ATTRIBUTE_CACHE_SIZE; i++) {
+        if (_entries[i].valid && attributeId == _entries[i].attributeId) {
+            return &_entries[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,111 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusAttributeCache_h
+#define _MobiusAttributeCache_h
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+/*!
+ * Number of attributes cached per device.
+ */
+#ifndef MOBIUS_ATTRIBUTE_CACHE_SIZE
+#define MOBIUS_ATTRIBUTE_CACHE_SIZE 4
+#endif
+
+/*!
+ * @brief Cache of recently read or written attribute values.
+ * 
+ * Holds the wire bytes of up to MOBIUS_ATTRIBUTE_CACHE_SIZE attribute
+ * values along with the time they were last confirmed by the device.
+ * Lookups only succeed within the given time-to-live, and count as a hit
+ * or a miss.
+ * 
+ * A copy takes the values and counters, each cache keeps its own lock.
+ */
+class MobiusAttributeCache {
+public:
+    /*!
+     * Maximum number of value bytes cached per attribute.
+     */
+    static const uint8_t VALUE_CAPACITY = 4;
+
+    MobiusAttributeCache() = default;
+    MobiusAttributeCache(const MobiusAttributeCache& other);
+    MobiusAttributeCache& operator=(const MobiusAttributeCache& other);
+
+    /*!
+     * @brief Look up a cached attribute value.
+     * 
+     * @param attributeId C2 attribute ID
+     * @param value buffer receiving the value bytes
+     * @param length number of value bytes wanted
+     * @param nowMillis current time (in milliseconds)
+     * @param ttlMillis maximum age of the value (in milliseconds)
+     * @return true (a hit) if a fresh enough value was copied into 'value'
+     */
+    bool lookup(uint16_t attributeId, uint8_t* value, uint8_t length, uint32_t nowMillis, uint32_t ttlMillis);
+
+    /*!
+     * @brief Store an attribute value confirmed by the device.
+     * 
+     * Replaces the least recently updated attribute when full. Values
+     * longer than VALUE_CAPACITY are not cached.
+     * 
+     * @param attributeId C2 attribute ID
+     * @param value value bytes
+     * @param length number of value bytes
+     * @param nowMillis current time (in milliseconds)
+     */
+    void store(uint16_t attributeId, const uint8_t* value, uint8_t length, uint32_t nowMillis);
+
+    /*!
+     * @brief Remove the cached value of an attribute.
+     * 
+     * @param attributeId C2 attribute ID
+     */
+    void invalidate(uint16_t attributeId);
+
+    /*!
+     * @brief Remove all cached values (the counters are kept).
+     */
+    void clear();
+
+    /*!
+     * @brief Get the number of lookups served from the cache.
+     * 
+     * @return a uint32_t
+     */
+    uint32_t getHitCount() const;
+
+    /*!
+     * @brief Get the number of lookups not served from the cache.
+     * 
+     * @return a uint32_t
+     */
+    uint32_t getMissCount() const;
+
+private:
+    struct Entry {
+        bool valid = false;
+        uint16_t attributeId = 0;
+        uint8_t length = 0;
+        uint8_t value[VALUE_CAPACITY];
+        uint32_t updatedMillis = 0;
+    };
+
+    Entry _entries[MOBIUS_ATTRIBUTE_CACHE_SIZE];
+    uint32_t _hits = 0;
+    uint32_t _misses = 0;
+    mutable std::mutex _mutex;
+
+    /*!
+     * Find the entry for 'attributeId', or nullptr.
+     */
+    Entry* find(uint16_t attributeId);
+};
+
+#endif
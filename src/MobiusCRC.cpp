@@ -4,6 +4,70 @@
 
 #include "MobiusCRC.h"
 
+namespace {
+    const uint16_t POLYNOMIAL = 0x1021;
+    const int SLICES = 8;
+
+    /*!
+     * Shift the remaining 'bits' through the CRC register 'crc'.
+     */
+    constexpr uint16_t shiftBits(uint16_t crc, int bits) {
+        return (0 == bits) ? crc
+            : shiftBits((crc & 0x8000) ? (uint16_t)((crc << 1) ^ POLYNOMIAL) : (uint16_t)(crc << 1), bits - 1);
+    }
+
+    /*!
+     * CRC-16/CCITT-FALSE lookup table entry.
+     *
+     * Slice 0 is the classic byte table. Slice k holds the CRC of byte b
+     * followed by k zero bytes, which lets k + 1 bytes be processed with
+     * independent lookups.
+     */
+    constexpr uint16_t tableValue(int slice, int b) {
+        return (0 == slice) ? shiftBits((uint16_t)(b << 8), 8)
+            : (uint16_t)((tableValue(slice - 1, b) << 8) ^ tableValue(0, tableValue(slice - 1, b) >> 8));
+    }
+
+    template<int... I> struct Indices {};
+    template<int N, int... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+    template<int... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+    struct CRC16Table {
+        uint16_t values[256];
+    };
+
+    template<int... I>
+    constexpr CRC16Table makeTable(int slice, Indices<I...>) {
+        return CRC16Table{{ tableValue(slice, I)... }};
+    }
+
+    constexpr CRC16Table makeTable(int slice) {
+        return makeTable(slice, MakeIndices<256>::type());
+    }
+
+    constexpr CRC16Table TABLES[SLICES] = {
+        makeTable(0), makeTable(1), makeTable(2), makeTable(3),
+        makeTable(4), makeTable(5), makeTable(6), makeTable(7)
+    };
+
+    constexpr uint16_t updateByte(uint16_t crc, uint8_t data) {
+        return (uint16_t)((crc << 8) ^ TABLES[0].values[(data ^ (crc >> 8)) & 0xff]);
+    }
+
+    constexpr uint16_t checkString(const char* data, uint16_t crc = 0xFFFF) {
+        return *data ? checkString(data + 1, updateByte(crc, *data)) : crc;
+    }
+
+    // spot check against the table copied from the Mobius android app
+    static_assert(TABLES[0].values[1] == 4129, "CRC16 table mismatch");
+    static_assert(TABLES[0].values[8] == (uint16_t)-32504, "CRC16 table mismatch");
+    static_assert(TABLES[0].values[255] == 7920, "CRC16 table mismatch");
+    // standard check value for CRC-16/CCITT-FALSE
+    static_assert(checkString("123456789") == 0x29B1, "CRC16 check value mismatch");
+}
+
+const uint16_t (&Mobius::CRC16_TABLE)[256] = TABLES[0].values;
+
 /*!
  * @brief Generates a 16 bit CRC.
  *
@@ -11,11 +75,80 @@
  * @param length size the byte array
  * @return 16 bit CRC value
  */
-uint16_t MobiusCRC::crc16(uint8_t* data, int length) {
-    uint16_t crc16 = -1;
-    for (int i = 0; i < length; i++) {
-        uint8_t dex = (data[i] ^ ((uint8_t)(crc16 >> 8))) & 0xff;
-        crc16 = (uint16_t)((crc16 << 8) ^ Mobius::CRC16_TABLE[dex]);
+uint16_t MobiusCRC::crc16(const uint8_t* data, size_t length) {
+    return final(update(init(), data, length));
+}
+
+/*!
+ * @brief Start an incremental CRC.
+ *
+ * @return initial CRC state
+ */
+uint16_t MobiusCRC::init() {
+    return 0xFFFF;
+}
+
+/*!
+ * @brief Add bytes to an incremental CRC.
+ *
+ * @param crc current CRC state
+ * @param data bytes to add
+ * @param length number of bytes to add
+ * @return updated CRC state
+ */
+uint16_t MobiusCRC::update(uint16_t crc, const uint8_t* data, size_t length) {
+    const CRC16Table* t = TABLES;
+    while (length >= 8) {
+        crc = t[7].values[(data[0] ^ (crc >> 8)) & 0xff] ^ t[6].values[(data[1] ^ crc) & 0xff] ^
+              t[5].values[data[2]] ^ t[4].values[data[3]] ^ t[3].values[data[4]] ^
+              t[2].values[data[5]] ^ t[1].values[data[6]] ^ t[0].values[data[7]];
+        data += 8;
+        length -= 8;
+    }
+    return updateBytewise(crc, data, length);
+}
+
+/*!
+ * @brief Add bytes to an incremental CRC, 4 bytes per step.
+ *
+ * @param crc current CRC state
+ * @param data bytes to add
+ * @param length number of bytes to add
+ * @return updated CRC state
+ */
+uint16_t MobiusCRC::updateSlice4(uint16_t crc, const uint8_t* data, size_t length) {
+    const CRC16Table* t = TABLES;
+    while (length >= 4) {
+        crc = t[3].values[(data[0] ^ (crc >> 8)) & 0xff] ^ t[2].values[(data[1] ^ crc) & 0xff] ^
+              t[1].values[data[2]] ^ t[0].values[data[3]];
+        data += 4;
+        length -= 4;
     }
-    return crc16;
+    return updateBytewise(crc, data, length);
+}
+
+/*!
+ * @brief Add bytes to an incremental CRC, one byte per step.
+ *
+ * @param crc current CRC state
+ * @param data bytes to add
+ * @param length number of bytes to add
+ * @return updated CRC state
+ */
+uint16_t MobiusCRC::updateBytewise(uint16_t crc, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        crc = updateByte(crc, data[i]);
+    }
+    return crc;
+}
+
+/*!
+ * @brief Finish an incremental CRC.
+ *
+ * @param crc current CRC state
+ * @return 16 bit CRC value
+ */
+uint16_t MobiusCRC::final(uint16_t crc) {
+    // CRC-16/CCITT-FALSE has no final xor
+    return crc;
 }
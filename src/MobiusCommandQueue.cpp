@@ -0,0 +1,351 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <chrono>
+#include "MobiusCommandQueue.h"
+#include "MobiusMetrics.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include <esp32-hal-log.h>
+#define LOG_TAG ""
+#else
+#include <esp_log.h>
+static const char* LOG_TAG = "MobiusCommandQueue";
+#endif
+#include "MobiusLog.h"
+
+/*
+ * How often stop checks the background task has ended
+ */
+static const uint32_t STOP_CHECK_MILLIS = 10;
+
+/*!
+ * Main constructor.
+ *
+ * @param device MobiusDevice the commands are sent to, must outlive the queue
+ * @param manager MobiusConnectionManager keeping the device connected (default none)
+ * @param connectTimeoutMillis time to wait for a connection before trying again (in milliseconds)
+ */
+MobiusCommandQueue::MobiusCommandQueue(MobiusDevice* device, MobiusConnectionManager* manager, uint32_t connectTimeoutMillis)
+    : _task(nullptr), _running(false) {
+    _device = device;
+    _manager = manager;
+    _connectTimeoutMillis = connectTimeoutMillis;
+    _depth = 0;
+    _maxDepth = 0;
+    _sequence = 0;
+}
+
+/*!
+ * De-construct the class, dropping any queued commands.
+ */
+MobiusCommandQueue::~MobiusCommandQueue() {
+    stop();
+    clear();
+}
+
+/*!
+ * @brief Start the background task sending the commands.
+ *
+ * @return true only if the task is running
+ */
+bool MobiusCommandQueue::start() {
+    if (_running.exchange(true)) {
+        return true;
+    }
+    TaskHandle_t task = nullptr;
+    if (pdPASS != xTaskCreate(taskMain, "MobiusCmdQueue", 4096, this, 1, &task)) {
+        MOBIUS_LOGW("- Failed to create the command queue task");
+        _running = false;
+        return false;
+    }
+    _task = task;
+    return true;
+}
+
+/*!
+ * @brief Stop the background task once the current command has finished.
+ *
+ * Called from a command callback it returns without waiting, as the
+ * task can't end while it is running the callback.
+ */
+void MobiusCommandQueue::stop() {
+    if (_running) {
+        {
+            // synchronize with the task so the wake up can't be missed
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        _condition.notify_all();
+        if (xTaskGetCurrentTaskHandle() == _task.load()) {
+            // the task ends once the callback returns
+            return;
+        }
+        // the task deletes itself once it sees the flag
+        while (nullptr != _task.load()) {
+            vTaskDelay(pdMS_TO_TICKS(STOP_CHECK_MILLIS));
+        }
+    }
+}
+
+/*!
+ * @brief Queue setting a new scene.
+ *
+ * @param sceneId scene to set
+ * @param priority MobiusPriority
+ * @param callback called with the outcome
+ * @return true if queued
+ */
+bool MobiusCommandQueue::setScene(uint16_t sceneId, MobiusPriority priority, Callback callback) {
+    return enqueueSet<Mobius::SceneAttribute>(sceneId, priority, callback);
+}
+
+/*!
+ * @brief Queue setting the default feed scene, at high priority.
+ *
+ * @param callback called with the outcome
+ * @return true if queued
+ */
+bool MobiusCommandQueue::setFeedScene(Callback callback) {
+    return setScene(Mobius::FEED_SCENE_ID, MobiusPriority::high, callback);
+}
+
+/*!
+ * @brief Queue running the schedule.
+ *
+ * @param priority MobiusPriority
+ * @param callback called with the outcome
+ * @return true if queued
+ */
+bool MobiusCommandQueue::runSchedule(MobiusPriority priority, Callback callback) {
+    return enqueueSet<Mobius::OperationStateAttribute>(Mobius::OPERATION_STATE_SCHEDULE, priority, callback);
+}
+
+/*!
+ * @brief Queue reading the currently running scene, at low priority.
+ *
+ * @param callback called with the outcome and the scene
+ * @return true if queued
+ */
+bool MobiusCommandQueue::getCurrentScene(Callback callback) {
+    return enqueueGet<Mobius::SceneAttribute>(MobiusPriority::low, callback);
+}
+
+/*!
+ * @brief Drop all queued commands.
+ */
+void MobiusCommandQueue::clear() {
+    Command dropped[MOBIUS_COMMAND_QUEUE_CAPACITY];
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (uint8_t i = 0; i < MOBIUS_COMMAND_QUEUE_CAPACITY; i++) {
+            dropped[i] = _commands[i];
+            _commands[i] = Command();
+        }
+        _depth = 0;
+    }
+    // outside the lock, so callbacks may queue again
+    for (uint8_t i = 0; i < MOBIUS_COMMAND_QUEUE_CAPACITY; i++) {
+        if (dropped[i].used && dropped[i].callback) {
+            dropped[i].callback(MobiusCommandStatus::dropped, dropped[i].value);
+        }
+    }
+}
+
+/*!
+ * @brief Get the number of queued commands (not counting one being sent).
+ *
+ * @return a uint8_t
+ */
+uint8_t MobiusCommandQueue::getDepth() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _depth;
+}
+
+/*!
+ * @brief Get the largest number of commands queued at once.
+ *
+ * @return a uint8_t
+ */
+uint8_t MobiusCommandQueue::getMaxDepth() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _maxDepth;
+}
+
+/*!
+ * Queue the command, coalescing or merging it with a queued one.
+ *
+ * @return false if there was no room
+ */
+bool MobiusCommandQueue::enqueue(bool isSet, uint16_t attributeId, Sender sender, uint32_t value, MobiusPriority priority, Callback callback) {
+    bool queued = true;
+    // a command pushed out by this one, reported outside the lock
+    Callback displaced;
+    uint32_t displacedValue = 0;
+    MobiusCommandStatus displacedStatus = MobiusCommandStatus::dropped;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Command* match = nullptr;
+        Command* unused = nullptr;
+        Command* victim = nullptr;
+        for (uint8_t i = 0; i < MOBIUS_COMMAND_QUEUE_CAPACITY; i++) {
+            Command& command = _commands[i];
+            if (!command.used) {
+                unused = unused ? unused : &command;
+            } else if (isSet == command.isSet && attributeId == command.attributeId) {
+                match = &command;
+            } else if (command.priority < priority && (nullptr == victim || command.priority < victim->priority
+                       || (command.priority == victim->priority && command.sequence > victim->sequence))) {
+                // the newest of the lowest priority commands
+                victim = &command;
+            }
+        }
+
+        if (match && isSet) {
+            // last writer wins, keeping the place of the first
+            MOBIUS_LOGD("- Coalescing SET of attribute %u", attributeId);
+            MobiusMetrics::increment(MobiusCounter::coalesced);
+            displaced = match->callback;
+            displacedValue = match->value;
+            displacedStatus = MobiusCommandStatus::superseded;
+            match->value = value;
+            match->callback = callback;
+        } else if (match) {
+            // both callers receive the value read once
+            MOBIUS_LOGD("- Merging GET of attribute %u", attributeId);
+            MobiusMetrics::increment(MobiusCounter::deduplicated);
+            if (match->callback && callback) {
+                Callback first = match->callback;
+                match->callback = [first, callback](MobiusCommandStatus status, uint32_t read) {
+                    first(status, read);
+                    callback(status, read);
+                };
+            } else if (callback) {
+                match->callback = callback;
+            }
+        } else {
+            Command* slot = unused;
+            if (nullptr == slot && victim) {
+                MOBIUS_LOGD("- Queue full, dropping a lower priority command");
+                MobiusMetrics::increment(MobiusCounter::dropped);
+                displaced = victim->callback;
+                displacedValue = victim->value;
+                slot = victim;
+                _depth--;
+            }
+            if (slot) {
+                slot->used = true;
+                slot->isSet = isSet;
+                slot->attributeId = attributeId;
+                slot->sender = sender;
+                slot->value = value;
+                slot->priority = priority;
+                slot->sequence = _sequence++;
+                slot->enqueuedMicros = MobiusMetrics::now();
+                slot->callback = callback;
+                _depth++;
+                _maxDepth = (_depth > _maxDepth) ? _depth : _maxDepth;
+            } else {
+                MOBIUS_LOGW("- Queue full, unable to queue the command");
+                MobiusMetrics::increment(MobiusCounter::dropped);
+                queued = false;
+            }
+        }
+        if (match && match->priority < priority) {
+            match->priority = priority;
+        }
+    }
+    if (queued) {
+        _condition.notify_all();
+    }
+    if (displaced) {
+        displaced(displacedStatus, displacedValue);
+    }
+    return queued;
+}
+
+/*!
+ * Take the next command to send into 'command'.
+ *
+ * @return false if the queue is empty
+ */
+bool MobiusCommandQueue::take(Command& command) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Command* next = nullptr;
+    for (uint8_t i = 0; i < MOBIUS_COMMAND_QUEUE_CAPACITY; i++) {
+        Command& candidate = _commands[i];
+        if (candidate.used && (nullptr == next || candidate.priority > next->priority
+                               || (candidate.priority == next->priority && candidate.sequence < next->sequence))) {
+            next = &candidate;
+        }
+    }
+    if (nullptr == next) {
+        return false;
+    }
+    command = *next;
+    *next = Command();
+    _depth--;
+    return true;
+}
+
+/*!
+ * Make sure the device is connected before taking a command.
+ *
+ * @return true only if connected
+ */
+bool MobiusCommandQueue::awaitConnection() {
+    bool connected;
+    if (_manager) {
+        connected = _manager->waitForConnection(_device, _connectTimeoutMillis);
+    } else {
+        connected = _device->isConnected() || _device->connect();
+        if (!connected) {
+            // wait before trying again, unless stopped
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait_for(lock, std::chrono::milliseconds(_connectTimeoutMillis), [this] { return !_running; });
+        }
+    }
+    return connected;
+}
+
+/*!
+ * Send the 'command' and report its outcome.
+ */
+void MobiusCommandQueue::send(Command& command) {
+    MobiusMetrics::record(MobiusPhase::queue_wait, command.enqueuedMicros);
+    bool successful;
+    if (_manager) {
+        // doesn't overlap with a reconnect or keep-alive of the device
+        successful = _manager->sendWhenConnected(_device, [&command](MobiusDevice& device) {
+            return command.sender(device, command.value);
+        }, _connectTimeoutMillis);
+    } else {
+        successful = command.sender(*_device, command.value);
+    }
+    if (command.callback) {
+        command.callback(successful ? MobiusCommandStatus::successful : MobiusCommandStatus::failed, command.value);
+    }
+}
+
+/*!
+ * Background task body.
+ */
+void MobiusCommandQueue::taskMain(void* queue) {
+    MobiusCommandQueue* self = static_cast<MobiusCommandQueue*>(queue);
+    while (self->_running) {
+        {
+            std::unique_lock<std::mutex> lock(self->_mutex);
+            self->_condition.wait(lock, [self] { return 0 < self->_depth || !self->_running; });
+        }
+        // connect first, so the command sent is the latest once connected
+        Command command;
+        if (self->_running && self->awaitConnection() && self->take(command)) {
+            self->send(command);
+        }
+    }
+    // a task started since (from a callback) keeps its handle
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    self->_task.compare_exchange_strong(task, nullptr);
+    vTaskDelete(nullptr);
+}
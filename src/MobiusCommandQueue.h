@@ -0,0 +1,291 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusCommandQueue_h
+#define _MobiusCommandQueue_h
+
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "MobiusDevice.h"
+#include "MobiusConnectionManager.h"
+
+/*!
+ * Number of commands a MobiusCommandQueue can hold.
+ */
+#ifndef MOBIUS_COMMAND_QUEUE_CAPACITY
+#define MOBIUS_COMMAND_QUEUE_CAPACITY 8
+#endif
+
+/*!
+ * @brief enum for the priority of a queued command, higher runs first.
+ */
+enum class MobiusPriority { low,    // e.g. status polls
+                            normal, // e.g. scene changes
+                            high    // e.g. feed or emergency scenes
+                            };
+
+/*!
+ * @brief enum for the outcome of a queued command.
+ */
+enum class MobiusCommandStatus { successful, // the device confirmed the command
+                                 failed,     // the request failed
+                                 superseded, // replaced by a newer SET of the same attribute
+                                 dropped     // removed from a full (or destroyed) queue
+                                 };
+
+/*!
+ * @brief Prioritized queue of commands for a single MobiusDevice.
+ *
+ * Commands are sent one at a time by a background task, highest priority
+ * first and in the order queued within a priority, so enqueueing never
+ * blocks. A SET of an attribute which already has a SET queued replaces
+ * its value (the last writer wins) and keeps its place, and a GET of an
+ * attribute which already has a GET queued is merged into it. The queue
+ * therefore holds at most one SET and one GET per attribute, and a
+ * flapping input costs at most one request in flight plus the latest
+ * value.
+ *
+ *     MobiusCommandQueue queue(&pump, &manager);
+ *     queue.start();
+ *     queue.setScene(1234);                        // normal priority
+ *     queue.setFeedScene();                        // high priority, runs first
+ *     queue.enqueueGet<Mobius::SceneAttribute>(MobiusPriority::low,
+ *         [](MobiusCommandStatus status, uint32_t scene) { ... });
+ *
+ * With a MobiusConnectionManager, commands wait for it to connect the
+ * device, otherwise the queue's task connects the device itself. Wait
+ * times are recorded as the queue_wait phase of MobiusMetrics, with the
+ * coalesced, deduplicated and dropped counters.
+ */
+class MobiusCommandQueue {
+public:
+    /*!
+     * Receives the outcome of a command, and the value read for a GET (or
+     * written for a SET). Called from the queue's task, or from the caller
+     * of enqueue when the command is superseded or dropped.
+     */
+    typedef std::function<void(MobiusCommandStatus status, uint32_t value)> Callback;
+
+    /*!
+     * Main constructor.
+     *
+     * @param device MobiusDevice the commands are sent to, must outlive the queue
+     * @param manager MobiusConnectionManager keeping the device connected (default none)
+     * @param connectTimeoutMillis time to wait for a connection before trying again (in milliseconds)
+     */
+    MobiusCommandQueue(MobiusDevice* device, MobiusConnectionManager* manager = nullptr, uint32_t connectTimeoutMillis = 1000);
+
+    /*!
+     * De-construct the class, dropping any queued commands.
+     */
+    ~MobiusCommandQueue();
+
+    /*!
+     * @brief Start the background task sending the commands.
+     *
+     * @return true only if the task is running
+     */
+    bool start();
+
+    /*!
+     * @brief Stop the background task once the current command has finished.
+     *
+     * Waits for the task to end, except when called from a command
+     * callback (which runs on the task): it then returns straight away and
+     * the task ends once the callback returns. A callback must therefore
+     * not destroy its queue.
+     */
+    void stop();
+
+    /*!
+     * @brief Queue a SET of an attribute.
+     *
+     * Works for any attribute declared as a MobiusAttribute. Replaces the
+     * value of an already queued SET of the attribute, which keeps its
+     * place and takes the higher of both priorities.
+     *
+     * @param value new attribute value
+     * @param priority MobiusPriority (default normal)
+     * @param callback called with the outcome (default none)
+     * @return false if the queue is full of commands of the same or higher priority
+     */
+    template<typename Attribute>
+    bool enqueueSet(typename Attribute::ValueType value, MobiusPriority priority = MobiusPriority::normal, Callback callback = nullptr);
+
+    /*!
+     * @brief Queue a GET of an attribute.
+     *
+     * Works for any attribute declared as a MobiusAttribute. Merged into
+     * an already queued GET of the attribute, both callbacks receive the
+     * value.
+     *
+     * @param priority MobiusPriority (default low)
+     * @param callback called with the outcome and the value (default none)
+     * @return false if the queue is full of commands of the same or higher priority
+     */
+    template<typename Attribute>
+    bool enqueueGet(MobiusPriority priority = MobiusPriority::low, Callback callback = nullptr);
+
+    /*!
+     * @brief Queue setting a new scene.
+     *
+     * @param sceneId scene to set
+     * @param priority MobiusPriority (default normal)
+     * @param callback called with the outcome (default none)
+     * @return true if queued
+     */
+    bool setScene(uint16_t sceneId, MobiusPriority priority = MobiusPriority::normal, Callback callback = nullptr);
+
+    /*!
+     * @brief Queue setting the default feed scene, at high priority.
+     *
+     * @param callback called with the outcome (default none)
+     * @return true if queued
+     */
+    bool setFeedScene(Callback callback = nullptr);
+
+    /*!
+     * @brief Queue running the schedule.
+     *
+     * @param priority MobiusPriority (default normal)
+     * @param callback called with the outcome (default none)
+     * @return true if queued
+     */
+    bool runSchedule(MobiusPriority priority = MobiusPriority::normal, Callback callback = nullptr);
+
+    /*!
+     * @brief Queue reading the currently running scene, at low priority.
+     *
+     * @param callback called with the outcome and the scene
+     * @return true if queued
+     */
+    bool getCurrentScene(Callback callback);
+
+    /*!
+     * @brief Drop all queued commands.
+     */
+    void clear();
+
+    /*!
+     * @brief Get the number of queued commands (not counting one being sent).
+     *
+     * @return a uint8_t
+     */
+    uint8_t getDepth();
+
+    /*!
+     * @brief Get the largest number of commands queued at once.
+     *
+     * @return a uint8_t
+     */
+    uint8_t getMaxDepth();
+
+private:
+    /*!
+     * Sends a command to the device, reading or writing 'value'.
+     */
+    typedef bool (*Sender)(MobiusDevice& device, uint32_t& value);
+
+    struct Command {
+        bool used = false;
+        bool isSet = false;
+        uint16_t attributeId = 0;
+        Sender sender = nullptr;
+        uint32_t value = 0;
+        MobiusPriority priority = MobiusPriority::low;
+        // order queued, lower runs first within a priority
+        uint32_t sequence = 0;
+        int64_t enqueuedMicros = 0;
+        Callback callback;
+    };
+
+    MobiusDevice* _device;
+    MobiusConnectionManager* _manager;
+    uint32_t _connectTimeoutMillis;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    Command _commands[MOBIUS_COMMAND_QUEUE_CAPACITY];
+    uint8_t _depth;
+    uint8_t _maxDepth;
+    uint32_t _sequence;
+    std::atomic<TaskHandle_t> _task;
+    std::atomic<bool> _running;
+
+    /*!
+     * Queue the command, coalescing or merging it with a queued one.
+     *
+     * @return false if there was no room
+     */
+    bool enqueue(bool isSet, uint16_t attributeId, Sender sender, uint32_t value, MobiusPriority priority, Callback callback);
+
+    /*!
+     * Take the next command to send into 'command'.
+     *
+     * @return false if the queue is empty
+     */
+    bool take(Command& command);
+
+    /*!
+     * Make sure the device is connected before taking a command.
+     *
+     * @return true only if connected
+     */
+    bool awaitConnection();
+
+    /*!
+     * Send the 'command' and report its outcome.
+     */
+    void send(Command& command);
+
+    /*!
+     * Background task body.
+     */
+    static void taskMain(void* queue);
+
+    template<typename Attribute>
+    static bool sendSet(MobiusDevice& device, uint32_t& value) {
+        return device.set<Attribute>((typename Attribute::ValueType)value);
+    }
+
+    template<typename Attribute>
+    static bool sendGet(MobiusDevice& device, uint32_t& value) {
+        typename Attribute::ValueType read;
+        bool found = device.get<Attribute>(read);
+        value = found ? (uint32_t)read : 0;
+        return found;
+    }
+};
+
+/*!
+ * @brief Queue a SET of an attribute.
+ *
+ * @param value new attribute value
+ * @param priority MobiusPriority
+ * @param callback called with the outcome
+ * @return false if the queue is full of commands of the same or higher priority
+ */
+template<typename Attribute>
+bool MobiusCommandQueue::enqueueSet(typename Attribute::ValueType value, MobiusPriority priority, Callback callback) {
+    return enqueue(true, Attribute::ATTRIBUTE_ID, &sendSet<Attribute>, (uint32_t)value, priority, callback);
+}
+
+/*!
+ * @brief Queue a GET of an attribute.
+ *
+ * @param priority MobiusPriority
+ * @param callback called with the outcome and the value
+ * @return false if the queue is full of commands of the same or higher priority
+ */
+template<typename Attribute>
+bool MobiusCommandQueue::enqueueGet(MobiusPriority priority, Callback callback) {
+    return enqueue(false, Attribute::ATTRIBUTE_ID, &sendGet<Attribute>, 0, priority, callback);
+}
+
+#endif
@@ -0,0 +1,105 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <chrono>
+#include "MobiusCompletion.h"
+
+/*!
+ * Default constructor.
+ */
+MobiusCompletion::MobiusCompletion() : _completed(false), _notifyTask(nullptr) {}
+
+/*!
+ * De-construct the class.
+ */
+MobiusCompletion::~MobiusCompletion() {}
+
+/*!
+ * @brief Reset the completion so it may be waited on again.
+ */
+void MobiusCompletion::reset() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _frame.size = 0;
+    _completed = false;
+    _notifyTask = nullptr;
+    _resetTime = std::chrono::steady_clock::now();
+}
+
+/*!
+ * @brief Complete with the given response data.
+ *
+ * @param data bytes of the response
+ * @param length size of the byte array
+ */
+void MobiusCompletion::complete(const uint8_t* data, size_t length) {
+    TaskHandle_t notifyTask;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        // a newer response replaces any unread one
+        _frame.assign(data, length);
+        _completed = true;
+        _completedTime = std::chrono::steady_clock::now();
+        notifyTask = _notifyTask;
+    }
+    _condition.notify_one();
+    if (nullptr != notifyTask) {
+        xTaskNotifyGive(notifyTask);
+    }
+}
+
+/*!
+ * @brief Wait for the completion.
+ *
+ * @param timeoutMillis maximum time to wait (in milliseconds)
+ * @return true only if completed before the timeout
+ */
+bool MobiusCompletion::wait(uint32_t timeoutMillis) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _condition.wait_for(lock, std::chrono::milliseconds(timeoutMillis), [this] { return _completed; });
+}
+
+/*!
+ * @brief Also wake a FreeRTOS task when completed.
+ *
+ * @param task TaskHandle_t to notify (nullptr for none)
+ */
+void MobiusCompletion::setNotifyTask(TaskHandle_t task) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _notifyTask = task;
+}
+
+/*!
+ * @brief Copy the response into the given 'response' frame.
+ *
+ * @param response frame to receive the response
+ * @return false if not completed
+ */
+bool MobiusCompletion::copyTo(MobiusFrame& response) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_completed) {
+        return false;
+    }
+    response.assign(_frame.data, _frame.size);
+    return true;
+}
+
+/*!
+ * @brief Get the time from the reset to the completion.
+ *
+ * @return elapsed time (in milliseconds), up to now if not completed
+ */
+uint32_t MobiusCompletion::getElapsedMillis() {
+    return getElapsedMicros() / 1000;
+}
+
+/*!
+ * @brief Get the time from the reset to the completion.
+ *
+ * @return elapsed time (in microseconds), up to now if not completed
+ */
+uint32_t MobiusCompletion::getElapsedMicros() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::chrono::steady_clock::time_point end = _completed ? _completedTime : std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - _resetTime).count();
+}
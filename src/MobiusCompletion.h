@@ -0,0 +1,96 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusCompletion_h
+#define _MobiusCompletion_h
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "MobiusFrame.h"
+
+/*!
+ * @brief Completion object for a single Mobius request.
+ * 
+ * A request waits on its MobiusCompletion while the response is
+ * delivered from the BLE notification callback. Completing the object
+ * wakes the waiting caller immediately instead of it polling for data.
+ */
+class MobiusCompletion {
+public:
+    MobiusCompletion();
+    ~MobiusCompletion();
+
+    /*!
+     * @brief Reset the completion so it may be waited on again.
+     */
+    void reset();
+
+    /*!
+     * @brief Complete with the given response data.
+     * 
+     * Copies the 'data' (of size 'length') into the completion's frame
+     * and wakes the waiting caller.
+     * 
+     * @param data bytes of the response
+     * @param length size of the byte array
+     */
+    void complete(const uint8_t* data, size_t length);
+
+    /*!
+     * @brief Wait for the completion.
+     * 
+     * @param timeoutMillis maximum time to wait (in milliseconds)
+     * @return true only if completed before the timeout
+     */
+    bool wait(uint32_t timeoutMillis);
+
+    /*!
+     * @brief Also wake a FreeRTOS task when completed.
+     * 
+     * Lets a single task wait for many completions at once with
+     * ulTaskNotifyTake. Cleared by reset.
+     * 
+     * @param task TaskHandle_t to notify (nullptr for none)
+     */
+    void setNotifyTask(TaskHandle_t task);
+
+    /*!
+     * @brief Copy the response into the given 'response' frame.
+     * 
+     * @param response frame to receive the response
+     * @return false if not completed
+     */
+    bool copyTo(MobiusFrame& response);
+
+    /*!
+     * @brief Get the time from the reset to the completion.
+     * 
+     * @return elapsed time (in milliseconds), up to now if not completed
+     */
+    uint32_t getElapsedMillis();
+
+    /*!
+     * @brief Get the time from the reset to the completion.
+     * 
+     * @return elapsed time (in microseconds), up to now if not completed
+     */
+    uint32_t getElapsedMicros();
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _completed;
+    TaskHandle_t _notifyTask;
+    MobiusFrame _frame;
+    std::chrono::steady_clock::time_point _resetTime;
+    std::chrono::steady_clock::time_point _completedTime;
+};
+
+#endif
@@ -0,0 +1,211 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <chrono>
+#include <esp_timer.h>
+#include "MobiusConnectionManager.h"
+#include "MobiusMetrics.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include <esp32-hal-log.h>
+#define LOG_TAG ""
+#else
+#include <esp_log.h>
+static const char* LOG_TAG = "MobiusConnectionManager";
+#endif
+#include "MobiusLog.h"
+
+/*
+ * How often the background task checks the managed devices
+ */
+static const uint32_t CHECK_INTERVAL_MILLIS = 100;
+
+/*!
+ * Main constructor.
+ *
+ * @param keepAliveMillis idle time before a keep-alive request is sent (0 to disable)
+ * @param minBackoffMillis first delay before reconnecting a dropped device
+ * @param maxBackoffMillis longest delay between reconnect attempts
+ */
+MobiusConnectionManager::MobiusConnectionManager(uint32_t keepAliveMillis, uint32_t minBackoffMillis, uint32_t maxBackoffMillis)
+    : _task(nullptr), _running(false) {
+    _count = 0;
+    _keepAliveMillis = keepAliveMillis;
+    _minBackoffMillis = minBackoffMillis;
+    _maxBackoffMillis = maxBackoffMillis;
+}
+
+/*!
+ * De-construct the class.
+ */
+MobiusConnectionManager::~MobiusConnectionManager() {
+    stop();
+}
+
+/*!
+ * @brief Add a device to be kept connected.
+ *
+ * @param device MobiusDevice to manage
+ * @return false if the device could not be added
+ */
+bool MobiusConnectionManager::add(MobiusDevice* device) {
+    std::lock_guard<std::mutex> lock(_stateMutex);
+    if (nullptr == device || _count >= MAX_DEVICES) {
+        return false;
+    }
+    Entry& entry = _entries[_count++];
+    entry.device = device;
+    entry.backoffMillis = _minBackoffMillis;
+    entry.nextAttemptMillis = 0;
+    entry.lastActivityMillis = nowMillis();
+    return true;
+}
+
+/*!
+ * @brief Start the background connection task.
+ *
+ * @return true only if the task is running
+ */
+bool MobiusConnectionManager::start() {
+    if (_running.exchange(true)) {
+        return true;
+    }
+    TaskHandle_t task = nullptr;
+    if (pdPASS != xTaskCreate(taskMain, "MobiusConnMgr", 4096, this, 1, &task)) {
+        MOBIUS_LOGW("- Failed to create the connection task");
+        _running = false;
+        return false;
+    }
+    _task = task;
+    return true;
+}
+
+/*!
+ * @brief Stop the background connection task.
+ */
+void MobiusConnectionManager::stop() {
+    if (_running) {
+        _running = false;
+        // the task deletes itself once it sees the flag
+        while (nullptr != _task.load()) {
+            vTaskDelay(pdMS_TO_TICKS(CHECK_INTERVAL_MILLIS));
+        }
+    }
+}
+
+/*!
+ * @brief Wait for the device to be connected.
+ *
+ * @param device a managed MobiusDevice
+ * @param timeoutMillis maximum time to wait (in milliseconds)
+ * @return true only if the device is connected
+ */
+bool MobiusConnectionManager::waitForConnection(MobiusDevice* device, uint32_t timeoutMillis) {
+    std::unique_lock<std::mutex> lock(_stateMutex);
+    Entry* entry = nullptr;
+    for (uint8_t i = 0; i < _count && nullptr == entry; i++) {
+        entry = (device == _entries[i].device) ? &_entries[i] : nullptr;
+    }
+    if (nullptr == entry) {
+        return false;
+    }
+    // the device itself is only read under the entry's mutex, by the task or a command
+    return _connected.wait_for(lock, std::chrono::milliseconds(timeoutMillis),
+                               [entry] { return entry->connected; });
+}
+
+/*!
+ * Find the entry of a managed 'device'.
+ */
+MobiusConnectionManager::Entry* MobiusConnectionManager::findEntry(MobiusDevice* device) {
+    std::lock_guard<std::mutex> lock(_stateMutex);
+    for (uint8_t i = 0; i < _count; i++) {
+        if (device == _entries[i].device) {
+            return &_entries[i];
+        }
+    }
+    return nullptr;
+}
+
+/*!
+ * Connect, reconnect or keep alive the device of the given 'entry'.
+ */
+void MobiusConnectionManager::service(Entry& entry) {
+    int64_t now = nowMillis();
+    // skip the device while a command is using it
+    std::unique_lock<std::mutex> lock(entry.mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    if (entry.device->isConnected()) {
+        if (0 < _keepAliveMillis && _keepAliveMillis <= (now - entry.lastActivityMillis)) {
+            MOBIUS_LOGD("- Sending keep-alive");
+            uint16_t sceneId;
+            if (entry.device->get<Mobius::SceneAttribute>(sceneId, true)) {
+                entry.lastActivityMillis = nowMillis();
+            } else {
+                // an unanswered keep-alive means the link is gone, even if still reported up
+                MOBIUS_LOGW("- Keep-alive failed, reconnecting");
+                entry.device->disconnect();
+                entry.backoffMillis = _minBackoffMillis;
+                entry.nextAttemptMillis = nowMillis();
+            }
+        }
+    } else if (now >= entry.nextAttemptMillis) {
+        if (entry.device->connect()) {
+            entry.backoffMillis = _minBackoffMillis;
+            entry.lastActivityMillis = nowMillis();
+        } else {
+            // wait longer after each failure, up to the maximum
+            MOBIUS_LOGD("- Reconnect failed, retrying in %u ms", (unsigned)entry.backoffMillis);
+            MobiusMetrics::increment(MobiusCounter::retries);
+            entry.nextAttemptMillis = nowMillis() + entry.backoffMillis;
+            entry.backoffMillis = (entry.backoffMillis > _maxBackoffMillis / 2) ? _maxBackoffMillis : entry.backoffMillis * 2;
+        }
+    }
+    setConnected(entry, entry.device->isConnected());
+}
+
+/*!
+ * Publish whether the device of the 'entry' is 'connected', waking
+ * the waiters if it is. The entry's mutex is held.
+ */
+void MobiusConnectionManager::setConnected(Entry& entry, bool connected) {
+    {
+        std::lock_guard<std::mutex> stateLock(_stateMutex);
+        entry.connected = connected;
+    }
+    if (connected) {
+        _connected.notify_all();
+    }
+}
+
+/*!
+ * Background task body.
+ */
+void MobiusConnectionManager::taskMain(void* manager) {
+    MobiusConnectionManager* self = static_cast<MobiusConnectionManager*>(manager);
+    while (self->_running) {
+        uint8_t count;
+        {
+            std::lock_guard<std::mutex> lock(self->_stateMutex);
+            count = self->_count;
+        }
+        for (uint8_t i = 0; i < count && self->_running; i++) {
+            self->service(self->_entries[i]);
+        }
+        vTaskDelay(pdMS_TO_TICKS(CHECK_INTERVAL_MILLIS));
+    }
+    // a task started since keeps its handle
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    self->_task.compare_exchange_strong(task, nullptr);
+    vTaskDelete(nullptr);
+}
+
+/*!
+ * Current time in milliseconds.
+ */
+int64_t MobiusConnectionManager::nowMillis() {
+    return esp_timer_get_time() / 1000;
+}
@@ -0,0 +1,165 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusConnectionManager_h
+#define _MobiusConnectionManager_h
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "MobiusDevice.h"
+
+/*!
+ * @brief Keeps MobiusDevices connected.
+ * 
+ * A background task connects every added device, reconnects with an
+ * exponential backoff when a link drops and optionally keeps idle links
+ * alive (reconnecting when a keep-alive goes unanswered). Commands sent through sendWhenConnected only pay for the
+ * request itself rather than a full connect and discovery.
+ */
+class MobiusConnectionManager {
+public:
+    /*!
+     * Maximum number of devices which may be managed.
+     */
+    static const uint8_t MAX_DEVICES = MOBIUS_MAX_SESSIONS;
+
+    /*!
+     * Main constructor.
+     *
+     * @param keepAliveMillis idle time before a keep-alive request is sent (0 to disable)
+     * @param minBackoffMillis first delay before reconnecting a dropped device
+     * @param maxBackoffMillis longest delay between reconnect attempts
+     */
+    MobiusConnectionManager(uint32_t keepAliveMillis = 0, uint32_t minBackoffMillis = 250, uint32_t maxBackoffMillis = 30000);
+
+    /*!
+     * De-construct the class.
+     */
+    ~MobiusConnectionManager();
+
+    /*!
+     * @brief Add a device to be kept connected.
+     * 
+     * The 'device' must outlive the manager.
+     * 
+     * @param device MobiusDevice to manage
+     * @return false if the device could not be added
+     */
+    bool add(MobiusDevice* device);
+
+    /*!
+     * @brief Start the background connection task.
+     * 
+     * @return true only if the task is running
+     */
+    bool start();
+
+    /*!
+     * @brief Stop the background connection task.
+     * 
+     * Managed devices are left as they are.
+     */
+    void stop();
+
+    /*!
+     * @brief Wait for the device to be connected.
+     * 
+     * @param device a managed MobiusDevice
+     * @param timeoutMillis maximum time to wait (in milliseconds)
+     * @return true only if the device is connected
+     */
+    bool waitForConnection(MobiusDevice* device, uint32_t timeoutMillis);
+
+    /*!
+     * @brief Run a command once the device is connected.
+     * 
+     * Waits for the device to be connected and then calls 'command' with it.
+     * The command will not overlap with a reconnect of the same device.
+     * 
+     * Example: manager.sendWhenConnected(&pump, [](MobiusDevice& d) { return d.setFeedScene(); }, 5000);
+     * 
+     * @param device a managed MobiusDevice
+     * @param command callable taking MobiusDevice& and returning bool
+     * @param timeoutMillis maximum time to wait for the connection (in milliseconds)
+     * @return result of the command, or false if not connected in time
+     */
+    template<typename Command>
+    bool sendWhenConnected(MobiusDevice* device, Command command, uint32_t timeoutMillis) {
+        Entry* entry = findEntry(device);
+        int64_t deadlineMillis = nowMillis() + timeoutMillis;
+        while (entry) {
+            int64_t remainingMillis = deadlineMillis - nowMillis();
+            if (remainingMillis < 0 || !waitForConnection(device, (uint32_t)remainingMillis)) {
+                break;
+            }
+            std::lock_guard<std::mutex> lock(entry->mutex);
+            if (device->isConnected()) {
+                bool result = command(*device);
+                entry->lastActivityMillis = nowMillis();
+                setConnected(*entry, device->isConnected());
+                return result;
+            }
+            // dropped since the task last looked, wait for it to reconnect
+            setConnected(*entry, false);
+        }
+        return false;
+    }
+
+private:
+    /*!
+     * A managed device and its reconnect state.
+     */
+    struct Entry {
+        MobiusDevice* device = nullptr;
+        std::mutex mutex;
+        uint32_t backoffMillis = 0;
+        int64_t nextAttemptMillis = 0;
+        int64_t lastActivityMillis = 0;
+        // last state seen under 'mutex', guarded by _stateMutex
+        bool connected = false;
+    };
+
+    Entry _entries[MAX_DEVICES];
+    uint8_t _count;
+    uint32_t _keepAliveMillis;
+    uint32_t _minBackoffMillis;
+    uint32_t _maxBackoffMillis;
+    std::mutex _stateMutex;
+    std::condition_variable _connected;
+    std::atomic<TaskHandle_t> _task;
+    std::atomic<bool> _running;
+
+    /*!
+     * Find the entry of a managed 'device'.
+     */
+    Entry* findEntry(MobiusDevice* device);
+
+    /*!
+     * Connect, reconnect or keep alive the device of the given 'entry'.
+     */
+    void service(Entry& entry);
+
+    /*!
+     * Publish whether the device of the 'entry' is 'connected', waking
+     * the waiters if it is. The entry's mutex is held.
+     */
+    void setConnected(Entry& entry, bool connected);
+
+    /*!
+     * Background task body.
+     */
+    static void taskMain(void* manager);
+
+    /*!
+     * Current time in milliseconds.
+     */
+    static int64_t nowMillis();
+};
+
+#endif
@@ -4,8 +4,10 @@
 
 #include "MobiusDevice.h"
 #include "MobiusCRC.h"
+#include "MobiusMetrics.h"
 #include "DefaultDeviceEventListener.h"
 #include <mutex>
+#include <esp_timer.h>
 
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
 #include <esp32-hal-log.h>
@@ -14,11 +16,27 @@
 #include <esp_log.h>
 static const char* LOG_TAG = "MobiusDevice";
 #endif
+#include "MobiusLog.h"
 
 // from Arduino
 #define lowByte(w) ((uint8_t) ((w) & 0xff))
 #define highByte(w) ((uint8_t) ((w) >> 8))
 
+/*
+ * Compare 'length' bytes at compile time
+ */
+static constexpr bool sameBytes(const uint8_t* a, const uint8_t* b, size_t length) {
+    return (0 == length) || ((*a == *b) && sameBytes(a + 1, b + 1, length - 1));
+}
+
+// the generated attribute encodings must match the raw arrays
+static_assert(sizeof Mobius::ATTRIBUTE_CURRENT_SCENE == Mobius::SceneAttribute::DESCRIPTOR_SIZE, "ATTRIBUTE_CURRENT_SCENE size mismatch");
+static_assert(sameBytes(Mobius::ATTRIBUTE_CURRENT_SCENE, Mobius::SceneAttribute::descriptor().bytes, sizeof Mobius::ATTRIBUTE_CURRENT_SCENE), "ATTRIBUTE_CURRENT_SCENE mismatch");
+static_assert(sizeof Mobius::ATTRIBUTE_SCENE == Mobius::SceneAttribute::ENCODED_SIZE, "ATTRIBUTE_SCENE size mismatch");
+static_assert(sameBytes(Mobius::ATTRIBUTE_SCENE, Mobius::SceneAttribute::encode(0xFFFF).bytes, sizeof Mobius::ATTRIBUTE_SCENE), "ATTRIBUTE_SCENE mismatch");
+static_assert(sizeof Mobius::ATTRIBUTE_OPERATION_STATE == Mobius::OperationStateAttribute::ENCODED_SIZE, "ATTRIBUTE_OPERATION_STATE size mismatch");
+static_assert(sameBytes(Mobius::ATTRIBUTE_OPERATION_STATE, Mobius::OperationStateAttribute::encode(0xFF).bytes, sizeof Mobius::ATTRIBUTE_OPERATION_STATE), "ATTRIBUTE_OPERATION_STATE mismatch");
+
 
 /**!
  * Implement BLEAdvertisedDeviceCallbacks to count the number of
@@ -27,20 +45,59 @@ static const char* LOG_TAG = "MobiusDevice";
  */
 uint8_t MobiusDevice::MobiusDeviceScanCallbacks::_expectedDevices = 0;
 uint8_t MobiusDevice::MobiusDeviceScanCallbacks::_foundDevices = 0;
+MobiusDevice::ScanCallback MobiusDevice::MobiusDeviceScanCallbacks::_callback = nullptr;
+MobiusPresenceRegistry* MobiusDevice::MobiusDeviceScanCallbacks::_registry = nullptr;
+BLEAddress MobiusDevice::MobiusDeviceScanCallbacks::_foundAddresses[MOBIUS_MAX_SCAN_DEVICES];
 
-// static MobiusDevice variables
-MobiusDeviceEventListener* MobiusDevice::_listener = nullptr;
-uint8_t* MobiusDevice::_responseData = nullptr;
-size_t   MobiusDevice::_responseDataSize = 0;
-bool MobiusDevice::_responseUnread = false;
-/*
- * Mutex for performing a call and reading the response
- */
-std::mutex _callMutex;
-/*
- * Mutex for reading/writing to the (static) response data
+/*!
+ * Called for each advertising BLE server.
  */
-std::mutex _responseDataMutex;
+void MobiusDevice::MobiusDeviceScanCallbacks::onResult(NimBLEAdvertisedDevice* advertisedDevice) {
+    MOBIUS_LOGD("- BLE Advertised Device found: %s", advertisedDevice->toString().c_str());
+    // found a device, so check for the service
+    if (!advertisedDevice->haveServiceUUID() || !advertisedDevice->isAdvertisingService(Mobius::GENERAL_SERVICE)) {
+        return;
+    }
+    BLEAddress address = advertisedDevice->getAddress();
+    if (_registry) {
+        // every advertisement updates the presence and RSSI history
+        _registry->record(address.getNative(), address.getType(), advertisedDevice->getRSSI(), esp_timer_get_time() / 1000);
+    }
+    // only deliver each address once (scan responses repeat the advertisement)
+    for (uint8_t i = 0; i < _foundDevices; i++) {
+        if (address.equals(_foundAddresses[i])) {
+            return;
+        }
+    }
+    if (_foundDevices >= MOBIUS_MAX_SCAN_DEVICES) {
+        MOBIUS_LOGD("- Ignoring Mobius BLE device, too many found");
+        return;
+    }
+    // update the number of Mobius devices found
+    _foundAddresses[_foundDevices++] = address;
+    MOBIUS_LOGD("- Mobius BLE device found: %s", address.toString().c_str());
+    if (_callback) {
+        // only the address is kept, the advertisement belongs to the scan
+        MobiusDevice device((MobiusDeviceHandle(address)));
+        _callback(device);
+    }
+    if (0 < _expectedDevices && _foundDevices >= _expectedDevices) {
+        MOBIUS_LOGD("- Stopping scanner early");
+        BLEDevice::getScan()->stop();
+    }
+}
+
+// static MobiusDevice variables
+MobiusEventBus MobiusDevice::_eventBus;
+uint8_t MobiusDevice::_windowSize = 4;
+uint8_t MobiusDevice::_maxRetransmissions = 1;
+BLEAdvertisedDeviceCallbacks* MobiusDevice::_scanCallbacks = nullptr;
+MobiusScanProfile MobiusDevice::_scanProfile = MobiusScanProfile::balanced;
+BLEAddress MobiusDevice::_expectedAddresses[MOBIUS_PRESENCE_CAPACITY];
+uint8_t MobiusDevice::_expectedCount = 0;
+bool MobiusDevice::_adaptiveLowPower = false;
+TimerHandle_t MobiusDevice::_adaptiveTimer = nullptr;
+std::mutex MobiusDevice::_trackingMutex;
 
 
 /*!
@@ -48,38 +105,199 @@ std::mutex _responseDataMutex;
  * 
  * Performs a scan for nearby BLEDevices which have are advertising
  * the GENERAL_SERVICE (i.e. the "MOBIUS" service). Any found devices
- * will be added the give 'deviceBuffer'. Once the 'expectedCount' is
- * reached, scanning will cease regardless of how much time is left
- * until 'scanDuration'.
+ * will be added the give 'deviceBuffer', up to its 'bufferSize'. Once
+ * the 'expectedCount' is reached (or the buffer is full), scanning will
+ * cease regardless of how much time is left until 'scanDuration'.
  * 
  * @param scanDuration maximum scan time (in seconds)
  * @param deviceBuffer buffer to hold all found devices
- * @param expectedCount number of devices expected to be found (default 1)
+ * @param bufferSize number of devices the buffer can hold
+ * @param expectedCount number of devices expected to be found
  * @return number of found devices (number of MobiusDevice added)
  */
-uint8_t MobiusDevice::scanForMobiusDevices(uint32_t scanDuration, MobiusDevice* deviceBuffer, uint8_t expectedCount) {
-    MobiusDevice::_listener->onEvent(MobiusDeviceEvent::scanning_begin);
-    // reset the scanning counts
-    MobiusDevice::MobiusDeviceScanCallbacks::_expectedDevices = expectedCount;
-    MobiusDevice::MobiusDeviceScanCallbacks::_foundDevices = 0;
+uint8_t MobiusDevice::scanForMobiusDevices(uint32_t scanDuration, MobiusDevice* deviceBuffer, uint8_t bufferSize, uint8_t expectedCount) {
     uint8_t count = 0;
-    ESP_LOGI(LOG_TAG, "- Scanning for BLE devices");
-    // get the singleton BLEScan object
-    BLEScan* scanner = BLEDevice::getScan();
-    BLEScanResults results = scanner->start(scanDuration, false);
-    int deviceCount = results.getCount();
-    for (int i = 0; i < deviceCount; i++) {
-        BLEAdvertisedDevice advertisedDevice = results.getDevice(i);
-        if (advertisedDevice.haveServiceUUID() && advertisedDevice.isAdvertisingService(Mobius::GENERAL_SERVICE)) {
-            deviceBuffer[count++] = MobiusDevice(new BLEAdvertisedDevice(advertisedDevice));
-            ESP_LOGD(LOG_TAG, "- Updated deviceBuffer with: %s", advertisedDevice.toString().c_str());
+    // stop early once the buffer is full, even if more devices are expected
+    uint8_t stopCount = (expectedCount < bufferSize) ? expectedCount : bufferSize;
+    prepareScan([&count, deviceBuffer, bufferSize](MobiusDevice& device) {
+        if (count < bufferSize) {
+            deviceBuffer[count++] = device;
         }
+    }, stopCount);
+    MOBIUS_LOGI("- Scanning for BLE devices");
+    // get the singleton BLEScan object, blocks until the scan has ended
+    BLEDevice::getScan()->start(scanDuration, false);
+    finishScan();
+    MOBIUS_LOGD("- Expecting to find %d devices; found %d", expectedCount, count);
+    return count;
+}
+
+/*!
+ * @brief Start scanning for Mobius devices without blocking.
+ *
+ * @param scanDuration maximum scan time (in seconds, 0 scans until stopped)
+ * @param callback called for each found MobiusDevice
+ * @param expectedCount number of devices after which to stop (default 0, no limit)
+ * @return true only if scanning was started
+ */
+bool MobiusDevice::startScan(uint32_t scanDuration, ScanCallback callback, uint8_t expectedCount) {
+    BLEScan* scanner = BLEDevice::getScan();
+    if (scanner->isScanning()) {
+        MOBIUS_LOGW("- Already scanning");
+        return false;
+    }
+    prepareScan(callback, expectedCount);
+    MOBIUS_LOGI("- Scanning for BLE devices");
+    if (!scanner->start(scanDuration, scanComplete, false)) {
+        finishScan();
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * @brief Stop a scan started with startScan.
+ */
+void MobiusDevice::stopScan() {
+    // the BLEScan calls scanComplete once stopped
+    BLEDevice::getScan()->stop();
+}
+
+/*!
+ * @brief Continuously track Mobius devices in range.
+ *
+ * @param registry MobiusPresenceRegistry to update
+ * @return true only if tracking was started
+ */
+bool MobiusDevice::startPresenceTracking(MobiusPresenceRegistry* registry) {
+    std::lock_guard<std::mutex> lock(MobiusDevice::_trackingMutex);
+    BLEScan* scanner = BLEDevice::getScan();
+    MobiusDevice::MobiusDeviceScanCallbacks::_registry = registry;
+    // every advertisement is needed for the RSSI history, not only the first
+    scanner->setAdvertisedDeviceCallbacks(MobiusDevice::_scanCallbacks, true);
+    if (!startScan(0, nullptr)) {
+        scanner->setAdvertisedDeviceCallbacks(MobiusDevice::_scanCallbacks, false);
+        MobiusDevice::MobiusDeviceScanCallbacks::_registry = nullptr;
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * @brief Stop tracking Mobius devices in range.
+ */
+void MobiusDevice::stopPresenceTracking() {
+    std::lock_guard<std::mutex> lock(MobiusDevice::_trackingMutex);
+    BLEScan* scanner = BLEDevice::getScan();
+    if (MobiusDevice::MobiusDeviceScanCallbacks::_registry && scanner->isScanning()) {
+        stopScan();
+    }
+    scanner->setAdvertisedDeviceCallbacks(MobiusDevice::_scanCallbacks, false);
+    MobiusDevice::MobiusDeviceScanCallbacks::_registry = nullptr;
+}
+
+/*!
+ * @brief Set the scanning duty cycle profile.
+ *
+ * @param profile MobiusScanProfile (default balanced)
+ */
+void MobiusDevice::setScanProfile(MobiusScanProfile profile) {
+    std::lock_guard<std::mutex> lock(MobiusDevice::_trackingMutex);
+    MobiusDevice::_scanProfile = profile;
+    MobiusDevice::_adaptiveLowPower = false;
+    applyScanParameters(MobiusScanParameters::forProfile(profile));
+    if (MobiusScanProfile::adaptive == profile && nullptr == MobiusDevice::_adaptiveTimer) {
+        // check once a second whether the expected devices are all present
+        MobiusDevice::_adaptiveTimer = xTimerCreate("MobiusScan", pdMS_TO_TICKS(1000), pdTRUE, nullptr, adaptiveScanCheck);
+        xTimerStart(MobiusDevice::_adaptiveTimer, 0);
+    }
+    BLEScan* scanner = BLEDevice::getScan();
+    if (MobiusDevice::MobiusDeviceScanCallbacks::_registry && scanner->isScanning()) {
+        // parameters only take effect when scanning starts, so restart the tracking scan
+        stopScan();
+        startScan(0, nullptr);
+    }
+}
+
+/*!
+ * @brief Set the devices expected to be in range.
+ *
+ * @param addresses array of expected device addresses
+ * @param count number of addresses in the array
+ */
+void MobiusDevice::setExpectedDevices(const BLEAddress* addresses, uint8_t count) {
+    if (count > MOBIUS_PRESENCE_CAPACITY) {
+        count = MOBIUS_PRESENCE_CAPACITY;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        MobiusDevice::_expectedAddresses[i] = addresses[i];
+    }
+    MobiusDevice::_expectedCount = count;
+}
+
+/*!
+ * Apply the given scan 'parameters' to the BLEScan.
+ */
+void MobiusDevice::applyScanParameters(const MobiusScanParameters& parameters) {
+    BLEScan* scanner = BLEDevice::getScan();
+    scanner->setInterval(parameters.intervalMillis);
+    scanner->setWindow(parameters.windowMillis);
+    scanner->setActiveScan(parameters.activeScan);
+}
+
+/*!
+ * Periodically switch the adaptive profile between fast and low power scanning.
+ */
+void MobiusDevice::adaptiveScanCheck(TimerHandle_t /*timer*/) {
+    std::lock_guard<std::mutex> lock(MobiusDevice::_trackingMutex);
+    MobiusPresenceRegistry* registry = MobiusDevice::MobiusDeviceScanCallbacks::_registry;
+    if (MobiusScanProfile::adaptive != MobiusDevice::_scanProfile || nullptr == registry || 0 == MobiusDevice::_expectedCount) {
+        return;
+    }
+    uint32_t nowMillis = esp_timer_get_time() / 1000;
+    bool allPresent = true;
+    for (uint8_t i = 0; allPresent && i < MobiusDevice::_expectedCount; i++) {
+        allPresent = registry->isPresent(MobiusDevice::_expectedAddresses[i].getNative(), nowMillis);
     }
+    if (allPresent == MobiusDevice::_adaptiveLowPower) {
+        return;
+    }
+    // all devices known, so save power; or one went missing, so find it fast
+    MobiusDevice::_adaptiveLowPower = allPresent;
+    MOBIUS_LOGD("- Adaptive scanning switching to %s", (allPresent ? "low_power" : "fast_discovery"));
+    applyScanParameters(MobiusScanParameters::forProfile(allPresent ? MobiusScanProfile::low_power : MobiusScanProfile::fast_discovery));
+    if (BLEDevice::getScan()->isScanning()) {
+        stopScan();
+        startScan(0, nullptr);
+    }
+}
+
+/*!
+ * Reset the scan state and set the 'callback' for found devices.
+ */
+void MobiusDevice::prepareScan(ScanCallback callback, uint8_t expectedCount) {
+    MobiusDevice::_eventBus.publish(MobiusDeviceEvent::scanning_begin);
+    // reset the scanning counts
+    MobiusDevice::MobiusDeviceScanCallbacks::_expectedDevices = expectedCount;
+    MobiusDevice::MobiusDeviceScanCallbacks::_foundDevices = 0;
+    MobiusDevice::MobiusDeviceScanCallbacks::_callback = callback;
+}
+
+/*!
+ * Clear the scan state once scanning has ended.
+ */
+void MobiusDevice::finishScan() {
+    MobiusDevice::MobiusDeviceScanCallbacks::_callback = nullptr;
     // delete any results fromBLEScan buffer to release memory
-    scanner->clearResults();
-    MobiusDevice::_listener->onEvent(MobiusDeviceEvent::scanning_end);
-    ESP_LOGD(LOG_TAG, "- Expecting to find %d devices; found %d", expectedCount, count);
-    return count;
+    BLEDevice::getScan()->clearResults();
+    MobiusDevice::_eventBus.publish(MobiusDeviceEvent::scanning_end);
+}
+
+/*!
+ * Called by the BLEScan once a non-blocking scan has ended.
+ */
+void MobiusDevice::scanComplete(BLEScanResults /*results*/) {
+    finishScan();
 }
 
 /*!
@@ -96,50 +314,194 @@ void MobiusDevice::init(MobiusDeviceEventListener* listener) {
     
     // initialize the singleton BLEScan object
     BLEScan* scanner = BLEDevice::getScan();
-    scanner->setInterval(1349);
-    scanner->setWindow(449);
-    scanner->setActiveScan(true);
-    scanner->setAdvertisedDeviceCallbacks(new MobiusDeviceScanCallbacks());
+    applyScanParameters(MobiusScanParameters::forProfile(MobiusDevice::_scanProfile));
+    // found devices are delivered from the callbacks, so don't keep results
+    scanner->setMaxResults(0);
+    // the callbacks keep no state of their own, so one instance serves every init
+    static MobiusDeviceScanCallbacks scanCallbacks;
+    MobiusDevice::_scanCallbacks = &scanCallbacks;
+    scanner->setAdvertisedDeviceCallbacks(MobiusDevice::_scanCallbacks);
     
     // initialize the handler
     if (nullptr == listener) {
-        MobiusDevice::_listener = new DefaultDeviceEventListener();
-    } else {
-        MobiusDevice::_listener = listener;
+        static DefaultDeviceEventListener defaultListener;
+        listener = &defaultListener;
     }
+    MobiusDevice::_eventBus.addListener(listener);
+    MobiusDevice::_eventBus.start();
 }
 
+/*!
+ * @brief Add a listener for (some) events.
+ *
+ * @param listener MobiusDeviceEventListener
+ * @param mask events to receive (default ALL_EVENTS)
+ * @return false if MOBIUS_MAX_LISTENERS are already listening
+ */
+bool MobiusDevice::addEventListener(MobiusDeviceEventListener* listener, uint32_t mask) {
+    return MobiusDevice::_eventBus.addListener(listener, mask);
+}
 
 /*!
- * WARNING: Due to the BLERemoteCharacteristic API, this static function will handle ALL
- *          received notifications regardless of which MobiusDevice instance the message
- *          is intended for. To avoid messages from being read by the wrong MobiusDevice
- *          instance, it is recommended to limit the number of instance actively
- *          connected at any given time.
+ * @brief Remove a listener added with init or addEventListener.
  *
- * Receives notify messages from devices and writes data from 'RESPONSE_CHARACTERISTIC_2'
- * to '_responseData' for other threads to read.
+ * @param listener MobiusDeviceEventListener
  */
-void MobiusDevice::notifyCallback(BLERemoteCharacteristic* responseCharacteristic, uint8_t* pData, size_t length, bool isNotify) {
-    MobiusDevice::_listener->onEvent(MobiusDeviceEvent::notification_received);
-    BLEUUID uuid = responseCharacteristic->getUUID();
-    ESP_LOGD(LOG_TAG, "- Received response from characteristic %s", uuid.toString().c_str());
-    
-    ESP_LOG_BUFFER_HEXDUMP(LOG_TAG, pData, length, ESP_LOG_DEBUG);
-    if (uuid.equals(Mobius::RESPONSE_CHARACTERISTIC_2)) {
-        // get mutex lock to update response data safely
-        _responseDataMutex.lock();
-        // data has been read, so start fresh
-        delete MobiusDevice::_responseData;
-        // set new response data
-        MobiusDevice::_responseData = new uint8_t[length];
-        memcpy(MobiusDevice::_responseData, pData, length);
-        MobiusDevice::_responseDataSize = length;
-        MobiusDevice::_responseUnread = true;
-        _responseDataMutex.unlock();
-    } else {
-        ESP_LOGW(LOG_TAG, "- Received unexpected response on %s", uuid.toString().c_str());
-        ESP_LOG_BUFFER_HEXDUMP(LOG_TAG, pData, length, ESP_LOG_DEBUG);
+void MobiusDevice::removeEventListener(MobiusDeviceEventListener* listener) {
+    MobiusDevice::_eventBus.removeListener(listener);
+}
+
+/*!
+ * @brief Set what happens to events when the listener falls behind.
+ *
+ * @param policy MobiusEventOverflowPolicy (default drop_newest)
+ */
+void MobiusDevice::setEventOverflowPolicy(MobiusEventOverflowPolicy policy) {
+    MobiusDevice::_eventBus.setOverflowPolicy(policy);
+}
+
+/*!
+ * @brief Get the number of events dropped because the listener fell behind.
+ *
+ * @return a uint32_t
+ */
+uint32_t MobiusDevice::getDroppedEventCount() {
+    return MobiusDevice::_eventBus.getDropCount();
+}
+
+/*!
+ * @brief Set the number of requests allowed in flight.
+ *
+ * @param windowSize number of requests allowed in flight (1 to 8)
+ */
+void MobiusDevice::setWindowSize(uint8_t windowSize) {
+    MobiusDevice::_windowSize = windowSize;
+}
+
+/*!
+ * @brief Set how often an unanswered request is sent again.
+ *
+ * @param retransmissions number of times a request is resent (default 1, 0 disables)
+ */
+void MobiusDevice::setMaxRetransmissions(uint8_t retransmissions) {
+    MobiusDevice::_maxRetransmissions = retransmissions;
+}
+
+/*!
+ * @brief Enable or disable caching of discovered attributes.
+ *
+ * @param enabled true to keep clients (and their attributes) between connections
+ */
+void MobiusDevice::setHandleCacheEnabled(bool enabled) {
+    MobiusNimBLETransport::setHandleCacheEnabled(enabled);
+}
+
+/*!
+ * @brief Set a new scene on several devices at once.
+ *
+ * Sends a set scene request with the given 'sceneId' to each of the
+ * connected 'devices' before waiting for any response, so all devices
+ * are commanded in roughly the time of a single request.
+ *
+ * Up to MOBIUS_FRAME_POOL_SIZE (8) devices are commanded at once, more
+ * are set in rounds. A device without a free frame counts as failed.
+ *
+ * @param devices array of connected MobiusDevice
+ * @param count number of devices in the array
+ * @param sceneId scene to set on every device
+ * @return number of devices which successfully set the scene
+ */
+uint8_t MobiusDevice::setSceneOnAll(MobiusDevice* devices, uint8_t count, uint16_t sceneId) {
+    const Mobius::SceneAttribute::Encoded attribute = Mobius::SceneAttribute::encode(sceneId);
+
+    uint8_t successCount = 0;
+    MobiusFrame response;
+    // each device needs a pooled frame, so more devices are set in rounds of the pool size
+    for (uint16_t first = 0; first < count; first += MOBIUS_FRAME_POOL_SIZE) {
+        uint8_t roundCount = (count - first < MOBIUS_FRAME_POOL_SIZE) ? (uint8_t)(count - first) : MOBIUS_FRAME_POOL_SIZE;
+        MobiusDevice* round = &devices[first];
+        MobiusFrame* requests[MOBIUS_FRAME_POOL_SIZE];
+        MobiusCompletion* completions[MOBIUS_FRAME_POOL_SIZE];
+        // write every request first so the devices handle them concurrently
+        for (uint8_t i = 0; i < roundCount; i++) {
+            completions[i] = nullptr;
+            requests[i] = MobiusFramePool::acquire();
+            if (nullptr == requests[i]) {
+                MOBIUS_LOGW("- No free frame for device %u", (unsigned)(first + i));
+            } else if (round[i].buildRequest(attribute.bytes, sizeof attribute.bytes, Mobius::OP_CODE_SET, 0x0800, *requests[i])) {
+                completions[i] = round[i].beginRequest(*requests[i]);
+            }
+        }
+        // then collect and verify the responses, a device without a frame has failed
+        for (uint8_t i = 0; i < roundCount; i++) {
+            if (nullptr == requests[i]) {
+                continue;
+            }
+            if (round[i].awaitResponse(*requests[i], completions[i], response)
+                && round[i].responseSuccessful(*requests[i], response)) {
+                successCount++;
+                // write-through, the device now holds the scene
+                round[i]._cache.store(Mobius::SceneAttribute::ATTRIBUTE_ID,
+                    &attribute.bytes[sizeof attribute.bytes - Mobius::SceneAttribute::VALUE_WIDTH],
+                    Mobius::SceneAttribute::VALUE_WIDTH, nowMillis());
+            } else {
+                round[i]._cache.invalidate(Mobius::SceneAttribute::ATTRIBUTE_ID);
+            }
+            MobiusFramePool::release(requests[i]);
+        }
+    }
+    MOBIUS_LOGD("- Set scene %d on %d of %d devices", sceneId, successCount, count);
+    return successCount;
+}
+
+
+/*!
+ * Session for a device with the given 'address' (may be nullptr).
+ */
+MobiusDevice::Session::Session(uint8_t windowSize, const uint8_t* address)
+    : hasAddress(nullptr != address), requests(windowSize) {
+    memset(this->address, 0, sizeof this->address);
+    if (address) {
+        memcpy(this->address, address, sizeof this->address);
+    }
+}
+
+/*!
+ * Receives the response fragments from the transport. Fragments on the data channel
+ * (RX_DATA) are collected until the fragment on the final channel (RX_FINAL) completes
+ * the frame, which then completes the in-flight request with the same message ID,
+ * waking the thread waiting for it.
+ */
+void MobiusDevice::Session::onReceive(MobiusTransport::Channel channel, const uint8_t* data, size_t length) {
+    if (MobiusDevice::_eventBus.isWanted(MobiusDeviceEvent::notification_received)) {
+        MobiusDeviceEventData event(MobiusDeviceEvent::notification_received);
+        event.hasAddress = hasAddress;
+        memcpy(event.address, address, sizeof event.address);
+        MobiusDevice::_eventBus.publish(event);
+    }
+    // RX_DATA fragments are collected until the RX_FINAL fragment closes the frame
+    MobiusFrameAssembler::Result result = assembler.append(data, length, MobiusTransport::Channel::final == channel);
+    if (MobiusFrameAssembler::Result::incomplete == result) {
+        return;
+    }
+    if (MobiusFrameAssembler::Result::error == result) {
+        MOBIUS_LOGW("- Discarded malformed response");
+        return;
+    }
+    const MobiusFrame& response = assembler.getFrame();
+    if (!assembler.isCrcValid()) {
+        // not rejected, see responseSuccessful
+        MOBIUS_LOGD("- Response CRC does not match");
+    }
+    // match the confirm to its request by message ID
+    bool matched = false;
+    if (5 <= response.size && Mobius::OP_GROUP_CONFIRM == response.data[1]) {
+        uint16_t messageId = (response.data[4] << 8) + (response.data[3]);
+        // wakes the waiting request
+        matched = requests.complete(messageId, response.data, response.size);
+    }
+    if (!matched) {
+        MOBIUS_LOGW("- Received response with no matching request");
     }
 }
 
@@ -149,18 +511,39 @@ void MobiusDevice::notifyCallback(BLERemoteCharacteristic* responseCharacteristi
 /*!
  * Default constructor.
  */
-MobiusDevice::MobiusDevice() : MobiusDevice::MobiusDevice(nullptr) {}
+MobiusDevice::MobiusDevice() : MobiusDevice::MobiusDevice(MobiusDeviceHandle()) {}
 /*!
- * Main constructor to build a MobiusDevice for use.  While a public method, 
- * this should only be used by the MobiusDevice itself.
+ * Main constructor to build a MobiusDevice for use, connected by the
+ * address in the 'handle' (e.g. from a scan).
  */
-MobiusDevice::MobiusDevice(BLEAdvertisedDevice* device) {
-    _device = device;
-    _client = nullptr;
-    _requestCharacteristic   = nullptr;//TX_FINAL
-    _responseCharacteristic1 = nullptr;//RX_DATA
-    _responseCharacteristic2 = nullptr;//RX_FINAL
-    _messageId = 0;
+MobiusDevice::MobiusDevice(const MobiusDeviceHandle& handle) : _bleTransport(handle) {
+    _transport = nullptr;
+    _connectionCount = 0;
+    _cacheTtlMillis = 0;
+    _lastRoundTripMillis = 0;
+}
+/*!
+ * Constructor for a device reached through the given 'transport'.
+ */
+MobiusDevice::MobiusDevice(MobiusTransport* transport) : MobiusDevice::MobiusDevice() {
+    _transport = transport;
+}
+/*!
+ * Constructor for a device with a known address, connected without
+ * scanning for its advertisement.
+ */
+MobiusDevice::MobiusDevice(const BLEAddress& address) : MobiusDevice::MobiusDevice(MobiusDeviceHandle(address)) {}
+/*!
+ * Copy constructor, for the same device but not connected.
+ */
+MobiusDevice::MobiusDevice(const MobiusDevice& other) : MobiusDevice::MobiusDevice() {
+    *this = other;
+}
+/*!
+ * Move constructor, taking over the connection of 'other'.
+ */
+MobiusDevice::MobiusDevice(MobiusDevice&& other) : MobiusDevice::MobiusDevice() {
+    *this = std::move(other);
 }
 /*!
  * De-construct the class.
@@ -168,46 +551,69 @@ MobiusDevice::MobiusDevice(BLEAdvertisedDevice* device) {
 MobiusDevice::~MobiusDevice() {
     disconnect();
 }
+/*!
+ * Copy assignment, disconnects first and is then not connected.
+ */
+MobiusDevice& MobiusDevice::operator=(const MobiusDevice& other) {
+    if (this != &other) {
+        disconnect();
+        _bleTransport = other._bleTransport;
+        _transport = other._transport;
+        _cacheTtlMillis = other._cacheTtlMillis;
+        // the cached attributes and round trips belong to the connection
+        _cache.clear();
+        _rtt.reset();
+        _lastRoundTripMillis = 0;
+    }
+    return *this;
+}
+/*!
+ * Move assignment, disconnects first and takes over the connection of 'other'.
+ */
+MobiusDevice& MobiusDevice::operator=(MobiusDevice&& other) {
+    if (this != &other) {
+        disconnect();
+        // the session (and transport route) stays in place, only its owner changes
+        _bleTransport = std::move(other._bleTransport);
+        _transport = other._transport;
+        _session = std::move(other._session);
+        _connectionCount = other._connectionCount;
+        _cache = other._cache;
+        _cacheTtlMillis = other._cacheTtlMillis;
+        _rtt = other._rtt;
+        _lastRoundTripMillis = other._lastRoundTripMillis;
+        // operations of 'other' must not match this connection
+        other._connectionCount++;
+        other._cache.clear();
+    }
+    return *this;
+}
 
 /*!
  * @brief Connect to the device.
  * 
- * Connect to the device corresponding to the current BLEAdvertisedDevice and
- * verify it has the required BLE characteristics.
+ * Connect to the device through its transport (for BLE, the current
+ * address) and verify it has the required BLE characteristics.
  * 
  * @return true only if successfully connected
  */
 bool MobiusDevice::connect() {
-    // rest the message count/ID
-    // starting with 2, because why not?
-    _messageId = 2;
-    MobiusDevice::_listener->onEvent(MobiusDeviceEvent::connection_begin);
-    BLEClient* client  = BLEDevice::createClient();
-    std::string addressString = _device->getAddress().toString();
-    ESP_LOGD(LOG_TAG, "- Connecting to %s", addressString.c_str());
-    client->connect(_device);
-    
-    BLERemoteService* remoteService = client->getService(Mobius::GENERAL_SERVICE);
-    
-    if (nullptr == remoteService) {
-        ESP_LOGW(LOG_TAG, "- Failed to find service on %s", addressString.c_str());
-        client->disconnect();
-        NimBLEDevice::deleteClient(client);
-        MobiusDevice::_listener->onEvent(MobiusDeviceEvent::connection_failure);
+    // release any previous (possibly dropped) connection first
+    disconnect();
+    // the device may have changed while disconnected
+    _cache.clear();
+    _rtt.reset();
+    uint32_t startMillis = nowMillis();
+    publishEvent(MobiusDeviceEvent::connection_begin);
+    std::unique_ptr<Session> session(new Session(MobiusDevice::_windowSize, transport()->getAddress()));
+    if (transport()->connect(session.get())) {
+        _session = std::move(session);
+        _connectionCount++;
+        publishEvent(MobiusDeviceEvent::connection_successful, 0, nowMillis() - startMillis);
     } else {
-        // connected to the device with general service
-        if (connectToCharacteristics(remoteService)) {
-            _client = client;
-            _service = remoteService;
-            ESP_LOGD(LOG_TAG, "- Connected successfully to %s", addressString.c_str());
-            MobiusDevice::_listener->onEvent(MobiusDeviceEvent::connection_successful);
-        } else {
-            ESP_LOGW(LOG_TAG, "- Failed to connect to characteristics");
-            MobiusDevice::_listener->onEvent(MobiusDeviceEvent::connection_failure);
-            NimBLEDevice::deleteClient(client);
-        }
+        publishEvent(MobiusDeviceEvent::connection_failure, 0, nowMillis() - startMillis);
     }
-    return (nullptr != _client);
+    return (nullptr != _session);
 }
 /*!
  * @brief Disconnect from the device.
@@ -215,40 +621,31 @@ bool MobiusDevice::connect() {
  * Disconnect from the currently connected device.
  */
 void MobiusDevice::disconnect() {
-    if (_client) {
-        ESP_LOGD(LOG_TAG, "- Disconnecting from client");
-        _client->disconnect();
-        NimBLEDevice::deleteClient(_client);
-        // destroying a client destroys the services
-        // and destroying a service destroys the characteristics
-        _client = nullptr;
-        _service = nullptr;
-        _requestCharacteristic = nullptr;
-        _responseCharacteristic1 = nullptr;
-        _responseCharacteristic2 = nullptr;
+    if (_session) {
+        // the transport no longer delivers to the session once disconnected
+        transport()->disconnect();
+        _session.reset();
     }
 }
+/*!
+ * @brief Check the connection to the device.
+ *
+ * @return true only if connected and the link is still up
+ */
+bool MobiusDevice::isConnected() {
+    return _session && transport()->isConnected();
+}
 /*!
  * @brief Get the currently running scene.
  *
  * Query the device to determine the currently running scene.
  *
+ * @param forceRefresh true to always query the device (default false)
  * @return an unsigned short
  */
-uint16_t MobiusDevice::getCurrentScene() {
+uint16_t MobiusDevice::getCurrentScene(bool forceRefresh) {
     uint16_t scene = -1;
-    uint16_t bodySize;
-    uint16_t attSize = sizeof Mobius::ATTRIBUTE_CURRENT_SCENE;
-    uint8_t attributes[attSize];
-    memcpy(attributes, Mobius::ATTRIBUTE_CURRENT_SCENE, attSize);
-
-    uint8_t* body = getData(attributes, attSize, bodySize);
-    if (0 < bodySize) {
-        // data was retrieved
-        scene = body[7];
-        scene = (scene << 8) + (body[6]);
-    }
-    delete[] body;
+    get<Mobius::SceneAttribute>(scene, forceRefresh);
     return scene;
 }
 /*!
@@ -260,14 +657,7 @@ uint16_t MobiusDevice::getCurrentScene() {
  * @return true if the 'set' was successful
  */
 bool MobiusDevice::setScene(uint16_t sceneId) {
-    uint16_t attSize = sizeof Mobius::ATTRIBUTE_SCENE;
-    uint8_t attributes[attSize];
-    memcpy(attributes, Mobius::ATTRIBUTE_SCENE, attSize);
-    // update scene ID portion of the attribute
-    attributes[5] = lowByte(sceneId); // little endian
-    attributes[6] = highByte(sceneId);// little endian
-
-    return setData(attributes, attSize);
+    return set<Mobius::SceneAttribute>(sceneId);
 }
 /*!
  * @brief Set the default feed scene.
@@ -289,274 +679,523 @@ bool MobiusDevice::setFeedScene() {
  * @return true if the action was successful
  */
 bool MobiusDevice::runSchedule() {
-    uint16_t attSize = sizeof Mobius::ATTRIBUTE_OPERATION_STATE;
-    uint8_t attributes[attSize];
-    memcpy(attributes, Mobius::ATTRIBUTE_OPERATION_STATE, attSize);
-    // update which state to set
-    attributes[attSize-1] = Mobius::OPERATION_STATE_SCHEDULE;
-    
-    return setData(attributes, attSize);
+    return set<Mobius::OperationStateAttribute>(Mobius::OPERATION_STATE_SCHEDULE);
 }
-
-
-
 /*!
- * @brief Connect to relevant characteristics
- * 
- * Connect to the relevant characteristics on the given BLE service for sending
- * and receiving messages.
- * - REQUEST_CHARACTERISTIC must be found and writable
- * - RESPONSE_CHARACTERISTIC_1 must be found and subscribed to
- * - RESPONSE_CHARACTERISTIC_2 must be found and subscribed to
- *
- * @return true only if all the required characteristics are connected/ready
- */
-bool MobiusDevice::connectToCharacteristics(BLERemoteService* service) {
-    // setup the request characteristic
-    _requestCharacteristic = service->getCharacteristic(Mobius::REQUEST_CHARACTERISTIC);
-    bool hasRequestChar = _requestCharacteristic && _requestCharacteristic->canWriteNoResponse();
-    ESP_LOGD(LOG_TAG, "- hasRequestChar:%s", (hasRequestChar ? "true" : "false"));
-    // setup the first response characteristic (the one which is used)
-    _responseCharacteristic1 = service->getCharacteristic(Mobius::RESPONSE_CHARACTERISTIC_1);
-    bool hasResponseChar1 = _responseCharacteristic1 && _responseCharacteristic1->canNotify();
-    ESP_LOGD(LOG_TAG, "- hasResponseChar1:%s", (hasResponseChar1 ? "true" : "false"));
-    if (hasResponseChar1) {
-        // setup the notify callback so full responses can be read
-        _responseCharacteristic1->registerForNotify(notifyCallback);
-        //addressing issue in BLERemoteCharacteristic (missing response true)
-        // similar to https://github.com/nkolban/esp32-snippets/issues/397
-        uint8_t notificationOn[]={0x01, 0x00};
-        _responseCharacteristic1->getDescriptor(BLEUUID((uint16_t)0x2902))->writeValue(notificationOn, 2, true);
-    }
-    // setup the second response characteristic
-    _responseCharacteristic2 = service->getCharacteristic(Mobius::RESPONSE_CHARACTERISTIC_2);
-    bool hasResponseChar2 = _responseCharacteristic2 && _responseCharacteristic2->canNotify();
-    ESP_LOGD(LOG_TAG, "- hasResponseChar2:%s", (hasResponseChar2 ? "true" : "false"));
-    if (hasResponseChar2) {
-        // setup the notify callback so full responses can be read
-        _responseCharacteristic2->registerForNotify(notifyCallback);
-        //addressing issue in BLERemoteCharacteristic (missing response true)
-        // similar to https://github.com/nkolban/esp32-snippets/issues/397
-        uint8_t notificationOn[]={0x01, 0x00};
-        _responseCharacteristic2->getDescriptor(BLEUUID((uint16_t)0x2902))->writeValue(notificationOn, 2, true);
+ * @brief Send several attribute GETs or SETs in one request.
+ *
+ * @param batch MobiusAttributeBatch holding at least one attribute
+ * @return true if the response was valid and every attribute was successful
+ */
+bool MobiusDevice::sendBatch(MobiusAttributeBatch& batch) {
+    if (0 == batch.getCount()) {
+        return false;
     }
-    
-    return hasRequestChar && hasResponseChar1 && hasResponseChar2;
+    MobiusFrame request;
+    uint16_t reserved = (Mobius::OP_CODE_SET == batch.getOpCode()) ? 0x0800 : 0x0000;
+    if (!buildRequest(batch.getPayload(), batch.getPayloadSize(), batch.getOpCode(), reserved, request)) {
+        return false;
+    }
+    MobiusFrame& response = batch.getResponse();
+    response.size = 0;
+    bool received = sendRequest(request, response);
+
+    bool successful = received && batch.decodeResponse();
+    uint32_t now = nowMillis();
+    for (uint8_t i = 0; i < batch.getCount(); i++) {
+        const MobiusAttributeBatch::Result* result = batch.getResult(i);
+        if (Mobius::OP_CODE_GET == batch.getOpCode() && result->successful) {
+            _cache.store(result->attributeId, result->value, result->length, now);
+        } else {
+            _cache.invalidate(result->attributeId);
+        }
+    }
+    if (!successful) {
+        MobiusMetrics::increment(MobiusCounter::verification_failures);
+    }
+    uint16_t messageId = (request.data[4] << 8) + (request.data[3]);
+    publishEvent(successful ? MobiusDeviceEvent::response_successful : MobiusDeviceEvent::response_failure,
+                 messageId, _lastRoundTripMillis);
+    return successful;
 }
+
+
+
 /*!
  * Send a "set" request with the given 'data' (of size 'length').
  *
  * @return true if verification was requested and the response was valid,
  * or if verification was skipped
  */
-bool MobiusDevice::setData(uint8_t* data, uint16_t length, bool doVerification) {
+bool MobiusDevice::setData(const uint8_t* data, uint16_t length, bool doVerification) {
     // build a request to SET data on a device
-    uint16_t reqSize;
-    uint8_t* req = buildRequest(data, length, Mobius::OP_CODE_SET, 0x0800, reqSize);
-    uint16_t resSize;
-    _callMutex.lock();
-    uint8_t* res = sendRequest(req, reqSize, resSize);
+    MobiusFrame request;
+    MobiusFrame response;
+    if (!buildRequest(data, length, Mobius::OP_CODE_SET, 0x0800, request)) {
+        return false;
+    }
+    bool received = sendRequest(request, response);
 
     bool verified = false;
     // verify the response
-    if (0 < resSize && doVerification) {
-        verified = responseSuccessful(req, reqSize, res, resSize);
+    if (received && doVerification) {
+        verified = responseSuccessful(request, response);
     }
-    // cleanup sent request & returned response from memory
-    delete[] req;
-    delete[] res;
-    _callMutex.unlock();
     return verified || !doVerification;
 }
 /*!
  * Send a "get" request with the given 'data' (of size 'length') and parse
- * out the data portion of the response.
+ * out the data portion of the 'response'.
  * Sets the value in the given 'dataSize' address to the data's total size.
  *
- * @return the a pointer to the byte array (data)
+ * @return a pointer to the data within 'response'
  */
-uint8_t* MobiusDevice::getData(uint8_t* data, uint16_t length, uint16_t& dataSize) {
+const uint8_t* MobiusDevice::getData(const uint8_t* data, uint16_t length, MobiusFrame& response, uint16_t& dataSize) {
     // build a request to GET data on a device
-    uint16_t reqSize;
-    uint8_t* req = buildRequest(data, length, Mobius::OP_CODE_GET, 0x0000, reqSize);
-    uint16_t resSize;
-    _callMutex.lock();
-    uint8_t* res = sendRequest(req, reqSize, resSize);
-    // current assumes the response is for the current request
-    uint8_t* responseData = parseResponseData(res, resSize, dataSize);
-    // cleanup sent request & returned response from memory
-    delete[] req;
-    delete[] res;
-    _callMutex.unlock();
-    return responseData;
+    MobiusFrame request;
+    dataSize = 0;
+    if (!buildRequest(data, length, Mobius::OP_CODE_GET, 0x0000, request)) {
+        return response.data;
+    }
+    sendRequest(request, response);
+    return parseResponseData(response, dataSize);
+}
+/*!
+ * @brief Set how long read attribute values are reused.
+ *
+ * @param ttlMillis maximum age of a cached value (in milliseconds, 0 disables caching)
+ */
+void MobiusDevice::setCacheTtl(uint32_t ttlMillis) {
+    _cacheTtlMillis = ttlMillis;
+}
+/*!
+ * @brief Get the attribute cache (e.g. for its hit and miss counts).
+ *
+ * @return a MobiusAttributeCache
+ */
+const MobiusAttributeCache& MobiusDevice::getCache() const {
+    return _cache;
+}
+/*!
+ * @brief Get the round-trip times of the current connection.
+ *
+ * @return a MobiusRttEstimator
+ */
+const MobiusRttEstimator& MobiusDevice::getRoundTrip() const {
+    return _rtt;
+}
+/*!
+ * @brief Get the BLE address (and type) of the device.
+ *
+ * @param address set to the BLEAddress, only if the device has one
+ * @return false for devices without an address (e.g. other transports)
+ */
+bool MobiusDevice::getAddress(BLEAddress& address) const {
+    if (_transport || !_bleTransport.hasPeerAddress()) {
+        return false;
+    }
+    address = _bleTransport.getPeerAddress();
+    return true;
+}
+/*!
+ * @brief Get the handle of the device.
+ *
+ * @return the MobiusDeviceHandle, not valid for devices without an address
+ */
+MobiusDeviceHandle MobiusDevice::getHandle() const {
+    return _transport ? MobiusDeviceHandle() : _bleTransport.getHandle();
+}
+/*!
+ * Publish the 'event' about this device with its 'messageId' and the
+ * 'elapsedMillis' of the phase it ends.
+ */
+void MobiusDevice::publishEvent(MobiusDeviceEvent event, uint16_t messageId, uint32_t elapsedMillis) {
+    if (!MobiusDevice::_eventBus.isWanted(event)) {
+        return;
+    }
+    MobiusDeviceEventData data(event);
+    const uint8_t* address = transport()->getAddress();
+    if (address) {
+        data.hasAddress = true;
+        memcpy(data.address, address, sizeof data.address);
+    }
+    data.messageId = messageId;
+    data.elapsedMillis = elapsedMillis;
+    MobiusDevice::_eventBus.publish(data);
 }
 /*!
- * Build a byte array representing a Mobius request message.
- * Sets the value in the given 'requestSize' address to the request's total size.
+ * Get the transport in use, _bleTransport unless another was given.
+ */
+MobiusTransport* MobiusDevice::transport() {
+    return _transport ? _transport : &_bleTransport;
+}
+/*!
+ * Get the current time (in milliseconds).
+ */
+uint32_t MobiusDevice::nowMillis() {
+    return esp_timer_get_time() / 1000;
+}
+/*!
+ * Get the message ID for the next request.
  *
- * @return a pointer to the byte array (request)
+ * @return a uint16_t
  */
-uint8_t* MobiusDevice::buildRequest(uint8_t* data, uint16_t length, uint8_t opCode, uint16_t reserved, uint16_t& requestSize) {
-    requestSize = length + 11;
-    uint8_t* request = new uint8_t[requestSize];
+uint16_t MobiusDevice::nextMessageId() {
+    if (nullptr == _session) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(_session->messageIdMutex);
+    return _session->messageId++;
+}
+/*!
+ * Build a Mobius request message into the given 'request' frame.
+ *
+ * @return false if the data does not fit in a frame
+ */
+bool MobiusDevice::buildRequest(const uint8_t* data, uint16_t length, uint8_t opCode, uint16_t reserved, MobiusFrame& request) {
+    uint16_t requestSize = length + 11;
+    if (requestSize > MobiusFrame::CAPACITY) {
+        MOBIUS_LOGW("- request of %d bytes is too large", requestSize);
+        request.size = 0;
+        return false;
+    }
+    request.size = requestSize;
 
     // first byte is always 02
-    request[0] = 0x02;
+    request.data[0] = 0x02;
     // opGroup
-    request[1] = Mobius::OP_GROUP_REQUEST;  // C2CI_Request
+    request.data[1] = Mobius::OP_GROUP_REQUEST;  // C2CI_Request
     // opCode
-    request[2] = opCode;
+    request.data[2] = opCode;
     // mMessageId
-    request[3] = lowByte(_messageId); // little endian
-    request[4] = highByte(_messageId);// little endian
-    _messageId++;
+    uint16_t messageId = nextMessageId();
+    request.data[3] = lowByte(messageId); // little endian
+    request.data[4] = highByte(messageId);// little endian
     // mReserved
-    request[5] = highByte(reserved);
-    request[6] = lowByte(reserved);
+    request.data[5] = highByte(reserved);
+    request.data[6] = lowByte(reserved);
     // data size
-    request[7] = lowByte(length); // little endian
-    request[8] = highByte(length);// little endian
+    request.data[7] = lowByte(length); // little endian
+    request.data[8] = highByte(length);// little endian
     // data
-    for (uint16_t i = 0; i < length; i++) {
-        request[9 + i] = data[i];
-    }
+    memcpy(&request.data[9], data, length);
 
-    short crc = MobiusCRC::crc16(&request[1], requestSize - 3);
-    request[requestSize - 2] = (uint8_t)crc;// lowByte(length)
-    request[requestSize - 1] = (uint8_t)(crc >> 8); // highByte(length)
+    short crc = MobiusCRC::crc16(&request.data[1], requestSize - 3);
+    request.data[requestSize - 2] = (uint8_t)crc;// lowByte(length)
+    request.data[requestSize - 1] = (uint8_t)(crc >> 8); // highByte(length)
 
-    ESP_LOGW(LOG_TAG, "- built request is:");
-    ESP_LOG_BUFFER_HEXDUMP(LOG_TAG, request, requestSize, ESP_LOG_DEBUG);
-    return request;
+    MOBIUS_LOGD("- built request is:");
+    MOBIUS_LOG_HEXDUMP(request.data, requestSize);
+    return true;
 }
 /*!
- * Writes the given 'request' (of size 'length') to the request characteristic.
- * Sets the value in the given 'responseSize' address to the response's total size.
- * Max response size is currently 255.
+ * Writes the given 'request' to the request characteristic and waits
+ * for the 'response'.
  *
- * @return a pointer to the byte array (response)
+ * @return true only if a response was received
  */
-uint8_t* MobiusDevice::sendRequest(uint8_t* request, uint16_t length, uint16_t& responseSize) {
-    ESP_LOGD(LOG_TAG, "- data being sent:");
-    ESP_LOG_BUFFER_HEXDUMP(LOG_TAG, request, length, ESP_LOG_DEBUG);
-    // setup response info
-    responseSize = 0;
-    uint8_t* response = new uint8_t[0];
-    // get a copy of the request to write
-    uint8_t toSend[length];
-    memcpy(toSend, request, length);
-    
-    // reset the unread flag to avoid reading old data
-    _responseDataMutex.lock();
-    MobiusDevice::_responseUnread = false;
-    _responseDataMutex.unlock();
+bool MobiusDevice::sendRequest(const MobiusFrame& request, MobiusFrame& response) {
+    MobiusCompletion* completion = beginRequest(request);
+    return awaitResponse(request, completion, response);
+}
+/*!
+ * Writes the given 'request' to the request characteristic without waiting
+ * for the response.
+ *
+ * @return the in-flight completion to pass to awaitResponse, or nullptr on failure
+ */
+MobiusCompletion* MobiusDevice::beginRequest(const MobiusFrame& request) {
+    MobiusCompletion* completion = reserveRequest(request);
+    if (completion && !writeRequest(request, completion)) {
+        completion = nullptr;
+    }
+    return completion;
+}
+/*!
+ * Reserves an in-flight slot for the given 'request' without writing it.
+ *
+ * @return the completion to pass to writeRequest, or nullptr on failure
+ */
+MobiusCompletion* MobiusDevice::reserveRequest(const MobiusFrame& request) {
+    uint32_t startMillis = nowMillis();
+    uint16_t messageId = (request.data[4] << 8) + (request.data[3]);
+    if (nullptr == _session) {
+        MOBIUS_LOGW("- Not connected, unable to send the request");
+        publishEvent(MobiusDeviceEvent::request_failure, messageId);
+        return nullptr;
+    }
     
-    // do the actual writing to the characteristic
-    if (_requestCharacteristic->writeValue(toSend, length)) {
-        ESP_LOGD(LOG_TAG, "- data sent successfully");
-        MobiusDevice::_listener->onEvent(MobiusDeviceEvent::request_successful);
-        // look for a response
-        bool received = false;
-        ESP_LOGD(LOG_TAG, "- waiting for response");
-        // wait for at most 1 second, with 100 ms read/check delay
-        uint32_t oneSecond = 1000000;
-        uint32_t readDelay =  100000;
-        int64_t startMicro = esp_timer_get_time();
-        while (!received && oneSecond > (esp_timer_get_time() - startMicro)) {
-            // busy wait to avoid flooding with read requests and constant locking
-            int64_t delayStartMicro = esp_timer_get_time();
-            while(readDelay > (esp_timer_get_time() - delayStartMicro)) {}
-            
-            _responseDataMutex.lock();
-            if (MobiusDevice::_responseUnread) {
-                received = true;
-                delete[] response;
-                // new data to read
-                responseSize = _responseDataSize;
-                response = new uint8_t[responseSize];
-                memcpy(response, _responseData, responseSize);
-                // update as read
-                MobiusDevice::_responseUnread = false;
-                
-                ESP_LOGD(LOG_TAG, "- response data was received:");
-                ESP_LOG_BUFFER_HEXDUMP(LOG_TAG, response, responseSize, ESP_LOG_DEBUG);
+    // reserve an in-flight slot before writing so a fast response is not missed
+    MobiusCompletion* completion = _session->requests.acquire(messageId, 1000);
+    if (nullptr == completion) {
+        MOBIUS_LOGW("- Timed out waiting for a free request slot");
+        MobiusMetrics::increment(MobiusCounter::timeouts);
+        publishEvent(MobiusDeviceEvent::request_failure, messageId, nowMillis() - startMillis);
+    }
+    return completion;
+}
+/*!
+ * Writes the given 'request' reserved with reserveRequest, releasing
+ * the slot if the write fails.
+ *
+ * @return true only if the request was written
+ */
+bool MobiusDevice::writeRequest(const MobiusFrame& request, MobiusCompletion* completion) {
+    MOBIUS_LOGD("- data being sent:");
+    MOBIUS_LOG_HEXDUMP(request.data, request.size);
+    uint32_t startMillis = nowMillis();
+    uint16_t messageId = (request.data[4] << 8) + (request.data[3]);
+    int64_t phaseStart = MobiusMetrics::now();
+    // do the actual writing to the transport
+    if (transport()->write(request.data, request.size)) {
+        MobiusMetrics::record(MobiusPhase::write, phaseStart);
+        MOBIUS_LOGD("- data sent successfully");
+        publishEvent(MobiusDeviceEvent::request_successful, messageId, nowMillis() - startMillis);
+        return true;
+    }
+    MOBIUS_LOGW("- Failed to send the request");
+    publishEvent(MobiusDeviceEvent::request_failure, messageId, nowMillis() - startMillis);
+    _session->requests.release(completion);
+    return false;
+}
+/*!
+ * Waits for the 'response' of the 'request' started with beginRequest, resending
+ * it when the response timeout expires, and releases its in-flight slot.
+ *
+ * @return true only if a response was received
+ */
+bool MobiusDevice::awaitResponse(const MobiusFrame& request, MobiusCompletion* completion, MobiusFrame& response) {
+    // setup response info
+    response.size = 0;
+    bool received = false;
+    if (completion) {
+        uint8_t retransmissions = 0;
+        int64_t phaseStart = MobiusMetrics::now();
+        while (!received) {
+            // woken as soon as the response is received
+            uint32_t timeoutMillis = _rtt.getTimeoutMillis();
+            MOBIUS_LOGD("- waiting for response (%u ms)", (unsigned)timeoutMillis);
+            if (completion->wait(timeoutMillis)) {
+                MobiusMetrics::record(MobiusPhase::response, phaseStart);
+                received = completion->copyTo(response);
+                _lastRoundTripMillis = completion->getElapsedMillis();
+                if (0 == retransmissions) {
+                    // a response to a resent request can't be timed (Karn's rule)
+                    _rtt.addSample(completion->getElapsedMicros());
+                }
+                MOBIUS_LOGD("- response data was received:");
+                MOBIUS_LOG_HEXDUMP(response.data, response.size);
+                break;
+            }
+            MobiusMetrics::increment(MobiusCounter::timeouts);
+            _rtt.backoff();
+            if (retransmissions >= MobiusDevice::_maxRetransmissions) {
+                MOBIUS_LOGW("- Timed out waiting for the response");
+                break;
+            }
+            // the same message ID, so a late response to either attempt completes it
+            retransmissions++;
+            MobiusMetrics::increment(MobiusCounter::retries);
+            MOBIUS_LOGD("- resending the request");
+            if (!transport()->write(request.data, request.size)) {
+                MOBIUS_LOGW("- Failed to resend the request");
+                break;
             }
-            _responseDataMutex.unlock();
+        }
+        // free the slot so a late response is not handed to another request
+        _session->requests.release(completion);
+    }
+    return received;
+}
+/*!
+ * Writes the request of the 'operation' if there is room in the window,
+ * otherwise it stays queued. Fails the operation if not connected or
+ * the write fails.
+ *
+ * @return true only if the request was written
+ */
+bool MobiusDevice::beginAsync(MobiusOperation& operation) {
+    const MobiusFrame& request = operation._request;
+    uint16_t messageId = (request.data[4] << 8) + (request.data[3]);
+    if (nullptr == _session || operation._connection != _connectionCount) {
+        MOBIUS_LOGW("- Not connected, unable to send the request");
+        publishEvent(MobiusDeviceEvent::request_failure, messageId);
+        operation._state = MobiusOperation::State::failed;
+        return false;
+    }
+    // never wait for a slot, the executor tries again on its next poll
+    MobiusCompletion* completion = _session->requests.acquire(messageId, 0);
+    if (nullptr == completion) {
+        return false;
+    }
+    // wake the polling task as soon as the response is received
+    completion->setNotifyTask(xTaskGetCurrentTaskHandle());
+    MOBIUS_LOGD("- data being sent:");
+    MOBIUS_LOG_HEXDUMP(request.data, request.size);
+    int64_t phaseStart = MobiusMetrics::now();
+    if (!transport()->write(request.data, request.size)) {
+        MOBIUS_LOGW("- Failed to send the request");
+        publishEvent(MobiusDeviceEvent::request_failure, messageId);
+        _session->requests.release(completion);
+        operation._state = MobiusOperation::State::failed;
+        return false;
+    }
+    MobiusMetrics::record(MobiusPhase::write, phaseStart);
+    publishEvent(MobiusDeviceEvent::request_successful, messageId);
+    operation._completion = completion;
+    operation._deadlineMicros = esp_timer_get_time() + 1000 * (int64_t)_rtt.getTimeoutMillis();
+    operation._state = MobiusOperation::State::pending;
+    return true;
+}
+/*!
+ * Completes the pending 'operation' if its response was received, and
+ * otherwise resends or fails it once its response timeout expired.
+ *
+ * @return true once the operation is ready
+ */
+bool MobiusDevice::pollAsync(MobiusOperation& operation, int64_t nowMicros) {
+    if (nullptr == _session || operation._connection != _connectionCount) {
+        // disconnected, the session (and the slot) no longer exists
+        operation._completion = nullptr;
+        operation._state = MobiusOperation::State::failed;
+        return true;
+    }
+    const MobiusFrame& request = operation._request;
+    MobiusCompletion* completion = operation._completion;
+    if (!completion->wait(0)) {
+        if (nowMicros < operation._deadlineMicros) {
+            return false;
+        }
+        MobiusMetrics::increment(MobiusCounter::timeouts);
+        _rtt.backoff();
+        if (operation._retransmissions < MobiusDevice::_maxRetransmissions) {
+            // the same message ID, so a late response to either attempt completes it
+            operation._retransmissions++;
+            MobiusMetrics::increment(MobiusCounter::retries);
+            MOBIUS_LOGD("- resending the request");
+            if (transport()->write(request.data, request.size)) {
+                operation._deadlineMicros = nowMicros + 1000 * (int64_t)_rtt.getTimeoutMillis();
+                return false;
+            }
+            MOBIUS_LOGW("- Failed to resend the request");
+        } else {
+            MOBIUS_LOGW("- Timed out waiting for the response");
+        }
+        _session->requests.release(completion);
+        operation._completion = nullptr;
+        operation._state = MobiusOperation::State::failed;
+        uint16_t messageId = (request.data[4] << 8) + (request.data[3]);
+        publishEvent(MobiusDeviceEvent::response_failure, messageId);
+        return true;
+    }
+
+    MobiusFrame response;
+    completion->copyTo(response);
+    _lastRoundTripMillis = completion->getElapsedMillis();
+    MobiusMetrics::record(MobiusPhase::response, nowMicros - completion->getElapsedMicros());
+    if (0 == operation._retransmissions) {
+        // a response to a resent request can't be timed (Karn's rule)
+        _rtt.addSample(completion->getElapsedMicros());
+    }
+    _session->requests.release(completion);
+    operation._completion = nullptr;
+    MOBIUS_LOGD("- response data was received:");
+    MOBIUS_LOG_HEXDUMP(response.data, response.size);
+
+    bool successful;
+    if (Mobius::OP_CODE_SET == request.data[2]) {
+        successful = responseSuccessful(request, response);
+        // write-through, the device now holds the value
+        if (successful) {
+            _cache.store(operation._attributeId, &request.data[operation._valueOffset], operation._valueWidth, nowMillis());
+        } else {
+            _cache.invalidate(operation._attributeId);
         }
     } else {
-        ESP_LOGW(LOG_TAG, "- Failed to send the request");
-        MobiusDevice::_listener->onEvent(MobiusDeviceEvent::request_failure);
+        uint16_t bodySize;
+        const uint8_t* body = parseResponseData(response, bodySize);
+        successful = operation.decode(body, bodySize);
+        if (successful && operation._valueOffset + operation._valueWidth <= bodySize) {
+            _cache.store(operation._attributeId, &body[operation._valueOffset], operation._valueWidth, nowMillis());
+        }
     }
-    return response;
+    operation._state = successful ? MobiusOperation::State::successful : MobiusOperation::State::failed;
+    return true;
+}
+/*!
+ * Releases the in-flight slot of the pending 'operation'.
+ */
+void MobiusDevice::cancelAsync(MobiusOperation& operation) {
+    if (operation._completion && _session && operation._connection == _connectionCount) {
+        _session->requests.release(operation._completion);
+    }
+    operation._completion = nullptr;
 }
 /*!
  * Parse the response to get extract the data.
  * Sets the value in the given 'dataSize' address to the data's total size.
  *
- * @return a pointer to the byte array (data)
+ * @return a pointer to the data within 'response'
  */
-uint8_t* MobiusDevice::parseResponseData(uint8_t* response, uint16_t length, uint16_t& dataSize) {
+const uint8_t* MobiusDevice::parseResponseData(const MobiusFrame& response, uint16_t& dataSize) {
     // setup default data info
     dataSize = 0;
-    uint8_t* data = new uint8_t[0];
     // check response info
-    bool isValid = (length > 11);
-    isValid = isValid && (0x02 == response[0]);
-    isValid = isValid && (Mobius::OP_GROUP_CONFIRM == response[1]);
+    bool isValid = (response.size > 11);
+    isValid = isValid && (0x02 == response.data[0]);
+    isValid = isValid && (Mobius::OP_GROUP_CONFIRM == response.data[1]);
     if (isValid) {
-        // get the data 
-        dataSize = (response[8] << 8) + (response[7]);
-        // cleanup data and copy the data to be returned
-        delete[] data;
-        data = new uint8_t[dataSize];
-        memcpy(data, &response[9], dataSize);
-        ESP_LOGD(LOG_TAG, "- response data was valid and parsed into:");
-        ESP_LOG_BUFFER_HEXDUMP(LOG_TAG, data, dataSize, ESP_LOG_DEBUG);
+        // get the data, limited to what was actually received
+        dataSize = (response.data[8] << 8) + (response.data[7]);
+        if (dataSize > response.size - 11) {
+            dataSize = response.size - 11;
+        }
+        MOBIUS_LOGD("- response data was valid and parsed into:");
+        MOBIUS_LOG_HEXDUMP(&response.data[9], dataSize);
     } else {
-        ESP_LOGW(LOG_TAG, "- response data was invalid");
+        MOBIUS_LOGW("- response data was invalid");
     }
-    return data;
+    return &response.data[9];
 }
 /*!
- * Validate the given 'response' (of size 'resSize') for the given 'request' (of size 'reqSize').
+ * Validate the given 'response' for the given 'request'.
  *
  * @return true only if the response is a success message for the request
  */
-bool MobiusDevice::responseSuccessful(uint8_t* request, uint16_t reqSize, uint8_t* response, uint16_t resSize) {
+bool MobiusDevice::responseSuccessful(const MobiusFrame& request, const MobiusFrame& response) {
     bool idValid = false;
     bool dataSuccess = false;
-    bool lengthsValid = (reqSize > 11) && (resSize > 11);
+    bool lengthsValid = (request.size > 11) && (response.size > 11);
     if (lengthsValid) {
         // check first 5 bytes (which should match)
-        idValid = (request[0] == response[0]);
-        idValid = idValid && (response[1] == Mobius::OP_GROUP_CONFIRM); // C2CI_Confirm
-        idValid = idValid && (request[2] == response[2]);
-        idValid = idValid && (request[3] == response[3]);
-        idValid = idValid && (request[4] == response[4]);
+        idValid = (request.data[0] == response.data[0]);
+        idValid = idValid && (response.data[1] == Mobius::OP_GROUP_CONFIRM); // C2CI_Confirm
+        idValid = idValid && (request.data[2] == response.data[2]);
+        idValid = idValid && (request.data[3] == response.data[3]);
+        idValid = idValid && (request.data[4] == response.data[4]);
         // check the data
-        int dataSize = (response[8] << 8) + (response[7]);
-        uint8_t resData[dataSize];
-        dataSuccess = (3 == dataSize);
-        dataSuccess = dataSuccess && (0x00 == response[9]); // all response data starts with 0x00
+        int dataSize = (response.data[8] << 8) + (response.data[7]);
+        dataSuccess = (3 == dataSize) && (12 <= response.size);
+        dataSuccess = dataSuccess && (0x00 == response.data[9]); // all response data starts with 0x00
         for (int i = 0; dataSuccess && i < dataSize - 1; i++) {
-            resData[i] = response[10 + i];
-            dataSuccess = dataSuccess && response[10 + i] == Mobius::RESPONSE_DATA_SUCCESSFUL[i];
+            dataSuccess = dataSuccess && response.data[10 + i] == Mobius::RESPONSE_DATA_SUCCESSFUL[i];
         }
     }
     // check CRC of the response
     // skipping CRC validation for now because it seems to be different
     // Mobius app doesn't seem to be checking either
-    //  short crc = crc16(&response[1], resSize-3);
-    //  bool crcValid = (response[resSize-2] == (byte) crc) && (response[resSize-1] = (byte) (crc >> 8));
-    ESP_LOGD(LOG_TAG, "- lengthsValid: %s", (lengthsValid ? "true" : "false"));
-    ESP_LOGD(LOG_TAG, "- idValid: %s", (idValid ? "true" : "false"));
-    ESP_LOGD(LOG_TAG, "- idValiddataSuccess: %s", (dataSuccess ? "true" : "false"));
+    //  short crc = crc16(&response.data[1], response.size-3);
+    //  bool crcValid = (response.data[response.size-2] == (byte) crc) && (response.data[response.size-1] = (byte) (crc >> 8));
+    MOBIUS_LOGD("- lengthsValid: %s", (lengthsValid ? "true" : "false"));
+    MOBIUS_LOGD("- idValid: %s", (idValid ? "true" : "false"));
+    MOBIUS_LOGD("- idValiddataSuccess: %s", (dataSuccess ? "true" : "false"));
     // skipping the CRC validation for now
     bool responseSuccessful = lengthsValid && idValid /*&& crcValid*/ && dataSuccess;
-    if (responseSuccessful) {
-        MobiusDevice::_listener->onEvent(MobiusDeviceEvent::response_successful);
-    } else {
-        MobiusDevice::_listener->onEvent(MobiusDeviceEvent::response_failure);
+    if (!responseSuccessful) {
+        MobiusMetrics::increment(MobiusCounter::verification_failures);
     }
+    uint16_t messageId = (request.data[4] << 8) + (request.data[3]);
+    publishEvent(responseSuccessful ? MobiusDeviceEvent::response_successful : MobiusDeviceEvent::response_failure,
+                 messageId, _lastRoundTripMillis);
     return responseSuccessful;
 }
@@ -6,11 +6,37 @@
 #define _MobiusDevice_h
 
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/timers.h>
 #include <NimBLEDevice.h>
 #include <NimBLEScan.h>
 #include <NimBLEAdvertisedDevice.h>
 
 #include "MobiusDeviceEventListener.h"
+#include "MobiusEventBus.h"
+#include "MobiusAttribute.h"
+#include "MobiusAttributeBatch.h"
+#include "MobiusAttributeCache.h"
+#include "MobiusFrame.h"
+#include "MobiusFrameAssembler.h"
+#include "MobiusPresenceRegistry.h"
+#include "MobiusScanProfile.h"
+#include "MobiusRequestTable.h"
+#include "MobiusRttEstimator.h"
+#include "MobiusTransport.h"
+#include "MobiusNimBLETransport.h"
+#include "MobiusDeviceHandle.h"
+#include "MobiusFuture.h"
+
+/*!
+ * Number of distinct Mobius devices remembered during a single scan.
+ */
+#ifndef MOBIUS_MAX_SCAN_DEVICES
+#define MOBIUS_MAX_SCAN_DEVICES 16
+#endif
 
 /*!
  * @brief Namespace containing definitions specific for Mobius communication.
@@ -26,9 +52,12 @@ namespace Mobius {
     static const uint8_t OP_GROUP_CONFIRM = 0xdf; // C2CI_Confirm = -33
     static const uint8_t OP_CODE_GET = 0x17;      // GetC2AttrFsciRequest
     static const uint8_t OP_CODE_SET = 0x18;      // SetC2AttrFsciRequest
-    static const uint8_t ATTRIBUTE_SCENE[] =          { 0x91, 0x01, 0x00, 0x01, 0x04, 0xFF, 0xFF, 0x00, 0x00 }; // C2Attribute.CurrentScene = 401
-    static const uint8_t ATTRIBUTE_CURRENT_SCENE[]  = { 0x91, 0x01, 0x00, 0x01 }; // C2Attribute.CurrentScene = 401
-    static const uint8_t ATTRIBUTE_OPERATION_STATE[]= { 0x68, 0x00, 0x00, 0x01, 0x01, 0xFF }; // C2Attribute.OperationState = 104
+    typedef MobiusAttribute<401, uint16_t, 4> SceneAttribute;     // C2Attribute.CurrentScene = 401
+    typedef MobiusAttribute<104, uint8_t> OperationStateAttribute; // C2Attribute.OperationState = 104
+    // raw encodings of the attributes above, checked against them in MobiusDevice.cpp
+    static constexpr uint8_t ATTRIBUTE_SCENE[] =          { 0x91, 0x01, 0x00, 0x01, 0x04, 0xFF, 0xFF, 0x00, 0x00 }; // C2Attribute.CurrentScene = 401
+    static constexpr uint8_t ATTRIBUTE_CURRENT_SCENE[]  = { 0x91, 0x01, 0x00, 0x01 }; // C2Attribute.CurrentScene = 401
+    static constexpr uint8_t ATTRIBUTE_OPERATION_STATE[]= { 0x68, 0x00, 0x00, 0x01, 0x01, 0xFF }; // C2Attribute.OperationState = 104
     static const uint8_t RESPONSE_DATA_SUCCESSFUL[] = { 0xFF, 0xFF };
     static const uint8_t OPERATION_STATE_SCHEDULE = 0x03;
     static const uint16_t FEED_SCENE_ID = 1;
@@ -41,32 +70,211 @@ namespace Mobius {
   */
 class MobiusDevice {
 public:
+    /*!
+     * Callback receiving each Mobius device found while scanning.
+     */
+    typedef std::function<void(MobiusDevice& device)> ScanCallback;
+
     /*!
      * @brief Scan for Mobius devices
      * 
      * Performs a scan for nearby BLEDevices which have are advertising
      * the GENERAL_SERVICE (i.e. the "MOBIUS" service). Any found devices
-     * will be added the give 'deviceBuffer'. Once the 'expectedCount' is
-     * reached, scanning will cease regardless of how much time is left
-     * until 'scanDuration'.
+     * will be added the give 'deviceBuffer', up to its 'bufferSize'. Once
+     * the 'expectedCount' is reached (or the buffer is full), scanning will
+     * cease regardless of how much time is left until 'scanDuration'.
      * 
      * @param scanDuration maximum scan time (in seconds)
      * @param deviceBuffer buffer to hold all found devices
+     * @param bufferSize number of devices the buffer can hold
+     * @param expectedCount number of devices expected to be found
+     * @return number of found devices (number of MobiusDevice added)
+     */
+    static uint8_t scanForMobiusDevices(uint32_t scanDuration, MobiusDevice* deviceBuffer, uint8_t bufferSize, uint8_t expectedCount);
+
+    /*!
+     * @brief Scan for Mobius devices
+     * 
+     * Same as above with the buffer size taken from the 'deviceBuffer' array.
+     * 
+     * @param scanDuration maximum scan time (in seconds)
+     * @param deviceBuffer array to hold all found devices
      * @param expectedCount number of devices expected to be found (default 1)
      * @return number of found devices (number of MobiusDevice added)
      */
-    static uint8_t scanForMobiusDevices(uint32_t scanDuration, MobiusDevice* deviceBuffer, uint8_t expectedCount = 1);
+    template<size_t N>
+    static uint8_t scanForMobiusDevices(uint32_t scanDuration, MobiusDevice (&deviceBuffer)[N], uint8_t expectedCount = 1);
+
+    /*!
+     * @brief Start scanning for Mobius devices without blocking.
+     * 
+     * Each Mobius device is passed to the 'callback' as soon as its first
+     * advertisement is seen, once per address. The callback runs on the BLE
+     * host task so it should return quickly (e.g. copy the device into a
+     * queue). Scanning stops after 'scanDuration', after 'expectedCount'
+     * devices (if not 0) or when stopScan is called.
+     * 
+     * @param scanDuration maximum scan time (in seconds, 0 scans until stopped)
+     * @param callback called for each found MobiusDevice
+     * @param expectedCount number of devices after which to stop (default 0, no limit)
+     * @return true only if scanning was started
+     */
+    static bool startScan(uint32_t scanDuration, ScanCallback callback, uint8_t expectedCount = 0);
+
+    /*!
+     * @brief Stop a scan started with startScan.
+     */
+    static void stopScan();
+
+    /*!
+     * @brief Continuously track Mobius devices in range.
+     * 
+     * Starts a background scan which records every advertisement of a
+     * Mobius device (address, time and RSSI) in the 'registry'. Times are
+     * recorded in milliseconds since boot (the same as Arduino millis()).
+     * The scan runs until stopPresenceTracking is called.
+     * 
+     * @param registry MobiusPresenceRegistry to update
+     * @return true only if tracking was started
+     */
+    static bool startPresenceTracking(MobiusPresenceRegistry* registry);
+
+    /*!
+     * @brief Stop tracking Mobius devices in range.
+     */
+    static void stopPresenceTracking();
+
+    /*!
+     * @brief Set the scanning duty cycle profile.
+     * 
+     * Trades discovery latency against radio and CPU time. The profile
+     * applies to the next scan, and immediately to presence tracking.
+     * With the adaptive profile, presence tracking scans with the
+     * fast_discovery parameters until every expected device (see
+     * setExpectedDevices) is present, then drops to low_power until one
+     * of them goes missing.
+     * 
+     * @param profile MobiusScanProfile (default balanced)
+     */
+    static void setScanProfile(MobiusScanProfile profile);
+
+    /*!
+     * @brief Set the devices expected to be in range.
+     * 
+     * Used by the adaptive scan profile to decide when discovery is complete.
+     * 
+     * @param addresses array of expected device addresses
+     * @param count number of addresses in the array
+     */
+    static void setExpectedDevices(const BLEAddress* addresses, uint8_t count);
 
     /*!
      * @brief Prepares the MobiusDevice class for usage.
      * 
      * Prepares all internal services and utilities for handling
      * BLE communication with Mobius devices.
+     * 
+     * Events are delivered to the listener from a separate task, so a
+     * slow listener does not delay scanning, connecting or requests.
      *
      * @param optional MobiusDeviceEventListener to use for event listening
      */
     static void init(MobiusDeviceEventListener* listener = nullptr);
 
+    /*!
+     * @brief Add a listener for (some) events.
+     * 
+     * Several listeners may listen at once, e.g. an LED listener and a
+     * metrics listener. Events no listener wants are discarded before
+     * any work is done for them. For example, to only receive responses:
+     * 
+     *     MobiusDevice::addEventListener(&listener,
+     *         MobiusDeviceEventListener::mask(MobiusDeviceEvent::response_successful)
+     *         | MobiusDeviceEventListener::mask(MobiusDeviceEvent::response_failure));
+     * 
+     * @param listener MobiusDeviceEventListener
+     * @param mask events to receive (default ALL_EVENTS)
+     * @return false if MOBIUS_MAX_LISTENERS are already listening
+     */
+    static bool addEventListener(MobiusDeviceEventListener* listener, uint32_t mask = MobiusDeviceEventListener::ALL_EVENTS);
+
+    /*!
+     * @brief Remove a listener added with init or addEventListener.
+     * 
+     * @param listener MobiusDeviceEventListener
+     */
+    static void removeEventListener(MobiusDeviceEventListener* listener);
+
+    /*!
+     * @brief Set what happens to events when the listener falls behind.
+     * 
+     * @param policy MobiusEventOverflowPolicy (default drop_newest)
+     */
+    static void setEventOverflowPolicy(MobiusEventOverflowPolicy policy);
+
+    /*!
+     * @brief Get the number of events dropped because the listener fell behind.
+     * 
+     * @return a uint32_t
+     */
+    static uint32_t getDroppedEventCount();
+
+    /*!
+     * @brief Set the number of requests allowed in flight.
+     * 
+     * Requests sent while the window is full will wait for an earlier
+     * request to be confirmed. A window size of 1 sends strictly one
+     * request at a time.
+     *
+     * The window applies to each connected device and takes effect
+     * on the next connect.
+     *
+     * @param windowSize number of requests allowed in flight (1 to 8)
+     */
+    static void setWindowSize(uint8_t windowSize);
+
+    /*!
+     * @brief Set how often an unanswered request is sent again.
+     * 
+     * A request is resent with the same message ID when no response
+     * arrives within the response timeout (see getRoundTrip), so a lost
+     * notification costs one timeout rather than a failed command.
+     * Requests should be safe to repeat, as GETs and SETs are.
+     *
+     * @param retransmissions number of times a request is resent (default 1, 0 disables)
+     */
+    static void setMaxRetransmissions(uint8_t retransmissions);
+
+    /*!
+     * @brief Enable or disable caching of discovered attributes.
+     * 
+     * When enabled (the default) the BLE client of a disconnected device
+     * is kept along with its discovered service, characteristics and
+     * descriptors. Reconnecting to the same address then skips discovery
+     * and only subscribes, falling back to full discovery if the cached
+     * attributes fail. Idle clients are reused for other devices when no
+     * new client is available.
+     *
+     * @param enabled true to keep clients (and their attributes) between connections
+     */
+    static void setHandleCacheEnabled(bool enabled);
+
+    /*!
+     * @brief Set a new scene on several devices at once.
+     * 
+     * Sends a set scene request with the given 'sceneId' to each of the
+     * connected 'devices' before waiting for any response, so all devices
+     * are commanded in roughly the time of a single request.
+     * 
+     * Up to MOBIUS_FRAME_POOL_SIZE (8) devices are commanded at once, more
+     * are set in rounds. A device without a free frame counts as failed.
+     * 
+     * @param devices array of connected MobiusDevice
+     * @param count number of devices in the array
+     * @param sceneId scene to set on every device
+     * @return number of devices which successfully set the scene
+     */
+    static uint8_t setSceneOnAll(MobiusDevice* devices, uint8_t count, uint16_t sceneId);
 
 
     /*!
@@ -74,20 +282,54 @@ public:
      */
     MobiusDevice();
     /*!
-     * Main constructor to build a MobiusDevice for use.  While a public method,
-     * this should only be used by the MobiusDevice itself.
+     * Main constructor to build a MobiusDevice for use, connected by the
+     * address in the 'handle' (e.g. from a scan).
+     */
+    MobiusDevice(const MobiusDeviceHandle& handle);
+    /*!
+     * Constructor for a device reached through the given 'transport'
+     * (e.g. a MobiusSimulatedTransport). The transport must outlive
+     * the device.
+     */
+    MobiusDevice(MobiusTransport* transport);
+    /*!
+     * Constructor for a device with a known address (e.g. from a
+     * MobiusRoster), connected without scanning for its advertisement.
+     * The address must carry the right type, e.g.
+     * BLEAddress("c4:4f:33:0a:1b:2c", BLE_ADDR_RANDOM).
+     */
+    MobiusDevice(const BLEAddress& address);
+
+    /*!
+     * Copy constructor, for the same device but not connected. The
+     * connection belongs to one MobiusDevice, connect the copy to use it.
+     */
+    MobiusDevice(const MobiusDevice& other);
+    /*!
+     * Move constructor, taking over the connection (and cached attributes)
+     * of 'other', which is left not connected. Pending async operations
+     * of 'other' are not carried over.
      */
-    MobiusDevice(BLEAdvertisedDevice* device);
+    MobiusDevice(MobiusDevice&& other);
 
     /*!
      * De-construct the class.
      */
     ~MobiusDevice();
 
+    /*!
+     * Copy assignment, disconnects first and is then not connected.
+     */
+    MobiusDevice& operator=(const MobiusDevice& other);
+    /*!
+     * Move assignment, disconnects first and takes over the connection of 'other'.
+     */
+    MobiusDevice& operator=(MobiusDevice&& other);
+
     /*!
      * @brief Connect to the device.
      * 
-     * Connect to the device corresponding to the current BLEAdvertisedDevice and
+     * Connect to the device corresponding to the current address and
      * verify it has the required BLE characteristics.
      * 
      * @return true only if successfully connected
@@ -101,15 +343,24 @@ public:
      */
     void disconnect();
 
+    /*!
+     * @brief Check the connection to the device.
+     *
+     * @return true only if connected and the link is still up
+     */
+    bool isConnected();
+
     /*!
      * @brief Get the currently running scene.
      * 
      * Query the device to determine the currently running scene.
-     * Or 65535 (-1) if a failure occurs.
+     * Or 65535 (-1) if a failure occurs. Served from the attribute
+     * cache when enabled (see setCacheTtl).
      * 
+     * @param forceRefresh true to always query the device (default false)
      * @return a uint16_t
      */
-    uint16_t getCurrentScene();
+    uint16_t getCurrentScene(bool forceRefresh = false);
 
     /*!
      * @brief Set a new scene.
@@ -141,13 +392,115 @@ public:
      */
     bool runSchedule();
 
+    /*!
+     * @brief Send several attribute GETs or SETs in one request.
+     * 
+     * Sends all the attributes in the 'batch' in a single request and
+     * decodes the response into the batch's per-attribute results.
+     * 
+     * @param batch MobiusAttributeBatch holding at least one attribute
+     * @return true if the response was valid and every attribute was successful
+     */
+    bool sendBatch(MobiusAttributeBatch& batch);
+
+    /*!
+     * @brief Get the value of an attribute.
+     * 
+     * Works for any attribute declared as a MobiusAttribute, e.g.
+     * get<Mobius::OperationStateAttribute>(state). Served from the
+     * attribute cache when enabled (see setCacheTtl).
+     * 
+     * @param value set to the attribute value, only if successful
+     * @param forceRefresh true to always query the device (default false)
+     * @return true if the value was retrieved
+     */
+    template<typename Attribute>
+    bool get(typename Attribute::ValueType& value, bool forceRefresh = false);
+
+    /*!
+     * @brief Set the value of an attribute.
+     * 
+     * Works for any attribute declared as a MobiusAttribute and verifies
+     * the response indicates a successful set action.
+     * 
+     * @param value new attribute value
+     * @return true if the 'set' was successful
+     */
+    template<typename Attribute>
+    bool set(typename Attribute::ValueType value);
+
+    /*!
+     * @brief Set how long read attribute values are reused.
+     * 
+     * Values read from, or successfully written to, the device are cached.
+     * Reads within 'ttlMillis' of the last confirmed value are answered
+     * from the cache without a request. The cache is cleared on connect.
+     * Use a short time-to-live if the device schedule changes the values.
+     * 
+     * @param ttlMillis maximum age of a cached value (in milliseconds, 0 disables caching)
+     */
+    void setCacheTtl(uint32_t ttlMillis);
+
+    /*!
+     * @brief Get the attribute cache (e.g. for its hit and miss counts).
+     * 
+     * @return a MobiusAttributeCache
+     */
+    const MobiusAttributeCache& getCache() const;
+
+    /*!
+     * @brief Get the round-trip times of the current connection.
+     * 
+     * The response timeout adapts to the measured round trips (see
+     * MobiusRttEstimator), starting from MOBIUS_RTO_INITIAL_MILLIS on
+     * each connect. Also gives the min, max and average round-trip time.
+     * 
+     * @return a MobiusRttEstimator
+     */
+    const MobiusRttEstimator& getRoundTrip() const;
+
+    /*!
+     * @brief Get the BLE address (and type) of the device.
+     * 
+     * Store it (e.g. in a MobiusRoster) to connect without scanning next time.
+     * 
+     * @param address set to the BLEAddress, only if the device has one
+     * @return false for devices without an address (e.g. other transports)
+     */
+    bool getAddress(BLEAddress& address) const;
+
+    /*!
+     * @brief Get the handle of the device.
+     * 
+     * @return the MobiusDeviceHandle, not valid for devices without an address
+     */
+    MobiusDeviceHandle getHandle() const;
 
 private:
-    static MobiusDeviceEventListener* _listener;
-    static uint8_t* _responseData;
-    static size_t   _responseDataSize;
-    static bool     _responseUnread;
-    static void notifyCallback(BLERemoteCharacteristic* responseCharacteristic, uint8_t* pData, size_t length, bool isNotify);
+    friend class MobiusExecutor;
+    friend class MobiusDeviceGroup;
+
+    static MobiusEventBus _eventBus;
+    static uint8_t _windowSize;
+    static uint8_t _maxRetransmissions;
+    static BLEAdvertisedDeviceCallbacks* _scanCallbacks;
+    static MobiusScanProfile _scanProfile;
+    static BLEAddress _expectedAddresses[MOBIUS_PRESENCE_CAPACITY];
+    static uint8_t _expectedCount;
+    static bool _adaptiveLowPower;
+    static TimerHandle_t _adaptiveTimer;
+    // serializes restarts of the tracking scan (the adaptive timer restarts it too)
+    static std::mutex _trackingMutex;
+
+    /*!
+     * Apply the given scan 'parameters' to the BLEScan.
+     */
+    static void applyScanParameters(const MobiusScanParameters& parameters);
+
+    /*!
+     * Periodically switch the adaptive profile between fast and low power scanning.
+     */
+    static void adaptiveScanCheck(TimerHandle_t timer);
 
     /*!
      * A BLEAdvertisedDeviceCallbacks to count the number of Mobius devices
@@ -161,47 +514,93 @@ private:
          */
         static uint8_t _expectedDevices;
         static uint8_t _foundDevices;
+        /*!
+         * Receives each newly found Mobius device.
+         */
+        static ScanCallback _callback;
+        /*!
+         * Registry updated with every Mobius advertisement (if set).
+         */
+        static MobiusPresenceRegistry* _registry;
+        /*!
+         * Addresses already delivered during the current scan.
+         */
+        static BLEAddress _foundAddresses[MOBIUS_MAX_SCAN_DEVICES];
         /*!
          * Called for each advertising BLE server.
          */
-        void onResult(NimBLEAdvertisedDevice* advertisedDevice) override {
-            std::string deviceString = advertisedDevice->toString();
-            ESP_LOGD(LOG_TAG, "- BLE Advertised Device found: %s", deviceString.c_str());
-            // found a device, so check for the service
-            if (advertisedDevice->haveServiceUUID() && advertisedDevice->isAdvertisingService(Mobius::GENERAL_SERVICE)) {
-                // update the number of Mobius devices found
-                _foundDevices++;
-                ESP_LOGD(LOG_TAG, "- Mobius BLE device found: %s", deviceString.c_str());
-                if (_foundDevices >= _expectedDevices) {
-                    ESP_LOGD(LOG_TAG, "- Stopping scanner early");
-                    BLEDevice::getScan()->stop();
-                }
-            }
-        }
+        void onResult(NimBLEAdvertisedDevice* advertisedDevice) override;
     };
 
+    /*!
+     * Reset the scan state and set the 'callback' for found devices.
+     */
+    static void prepareScan(ScanCallback callback, uint8_t expectedCount);
 
-    BLEAdvertisedDevice* _device;
-    BLEClient* _client;
-    BLERemoteService* _service;
-    BLERemoteCharacteristic* _requestCharacteristic;  //TX_FINAL
-    BLERemoteCharacteristic* _responseCharacteristic1;//RX_DATA
-    BLERemoteCharacteristic* _responseCharacteristic2;//RX_FINAL
-    uint16_t _messageId;
+    /*!
+     * Clear the scan state once scanning has ended.
+     */
+    static void finishScan();
 
+    /*!
+     * Called by the BLEScan once a non-blocking scan has ended.
+     */
+    static void scanComplete(BLEScanResults results);
+
+
+    MobiusNimBLETransport _bleTransport;
+    MobiusTransport* _transport;
 
     /*!
-     * @brief Connect to relevant characteristics
-     * 
-     * Connect to the relevant characteristics on the given BLE service for sending
-     * and receiving messages.
-     * - REQUEST_CHARACTERISTIC must be found and writable
-     * - RESPONSE_CHARACTERISTIC_1 must be found and subscribed to
-     * - RESPONSE_CHARACTERISTIC_2 must be found and subscribed to
+     * Get the transport in use, _bleTransport unless another was given.
+     */
+    MobiusTransport* transport();
+
+    /*!
+     * Per-device response state for a connected device.
+     */
+    struct Session : public MobiusTransport::Receiver {
+        Session(uint8_t windowSize, const uint8_t* address);
+        /*!
+         * Collects the response fragments and completes the matching request.
+         */
+        void onReceive(MobiusTransport::Channel channel, const uint8_t* data, size_t length) override;
+        bool hasAddress;
+        uint8_t address[6];
+        MobiusRequestTable requests;
+        // only used from onReceive, which the transport never runs concurrently
+        MobiusFrameAssembler assembler;
+        std::mutex messageIdMutex;
+        // starting with 2, because why not?
+        uint16_t messageId = 2;
+    };
+    std::unique_ptr<Session> _session;
+    // counts successful connects, so operations can tell their session is gone
+    uint32_t _connectionCount;
+    MobiusAttributeCache _cache;
+    uint32_t _cacheTtlMillis;
+    MobiusRttEstimator _rtt;
+
+    uint32_t _lastRoundTripMillis;
+
+    /*!
+     * Get the current time (in milliseconds).
+     */
+    static uint32_t nowMillis();
+
+    /*!
+     * Publish the 'event' about this device with its 'messageId' and the
+     * 'elapsedMillis' of the phase it ends.
+     */
+    void publishEvent(MobiusDeviceEvent event, uint16_t messageId = 0, uint32_t elapsedMillis = 0);
+
+    /*!
+     * Get the message ID for the next request.
      *
-     * @return true only if all the required characteristics are connected/ready
+     * @return a uint16_t
      */
-    bool connectToCharacteristics(BLERemoteService* service);
+    uint16_t nextMessageId();
+
     
     /*!
      * Send a "set" request with the given 'data' (of size 'length').
@@ -209,48 +608,154 @@ private:
      * @return true if verification was requested and the response was valid,
      * or if verification was skipped
      */
-    bool setData(uint8_t* data, uint16_t length, bool doVerification = true);
+    bool setData(const uint8_t* data, uint16_t length, bool doVerification = true);
     
     /*!
      * Send a "get" request with the given 'data' (of size 'length') and parse
-     * out the data portion of the response.
+     * out the data portion of the 'response'.
      * Sets the value in the given 'dataSize' address to the data's total size.
      *
-     * @return the a pointer to the byte array (data)
+     * @return a pointer to the data within 'response'
      */
-    uint8_t* getData(uint8_t* data, uint16_t length, uint16_t& dataSize);
+    const uint8_t* getData(const uint8_t* data, uint16_t length, MobiusFrame& response, uint16_t& dataSize);
     
     /*!
-     * Build a byte array representing a Mobius request message.
-     * Sets the value in the given 'requestSize' address to the request's total size.
+     * Build a Mobius request message into the given 'request' frame.
      *
-     * @return a pointer to the byte array (request)
+     * @return false if the data does not fit in a frame
      */
-    uint8_t* buildRequest(uint8_t* data, uint16_t length, uint8_t opCode, uint16_t reserved, uint16_t& requestSize);
+    bool buildRequest(const uint8_t* data, uint16_t length, uint8_t opCode, uint16_t reserved, MobiusFrame& request);
     
     /*!
-     * Writes the given 'request' (of size 'length') to the request characteristic.
-     * Sets the value in the given 'responseSize' address to the response's total size.
-     * Max response size is currently 255.
+     * Writes the given 'request' to the request characteristic and waits
+     * for the 'response'.
      * 
-     * @return a pointer to the byte array (response)
+     * @return true only if a response was received
+     */
+    bool sendRequest(const MobiusFrame& request, MobiusFrame& response);
+
+    /*!
+     * Writes the given 'request' to the request characteristic without waiting
+     * for the response.
+     *
+     * @return the in-flight completion to pass to awaitResponse, or nullptr on failure
+     */
+    MobiusCompletion* beginRequest(const MobiusFrame& request);
+
+    /*!
+     * Reserves an in-flight slot for the given 'request' without writing it.
+     *
+     * @return the completion to pass to writeRequest, or nullptr on failure
+     */
+    MobiusCompletion* reserveRequest(const MobiusFrame& request);
+
+    /*!
+     * Writes the given 'request' reserved with reserveRequest, releasing
+     * the slot if the write fails.
+     *
+     * @return true only if the request was written
      */
-    uint8_t* sendRequest(uint8_t* request, uint16_t length, uint16_t& responseSize);
+    bool writeRequest(const MobiusFrame& request, MobiusCompletion* completion);
+
+    /*!
+     * Waits for the 'response' of the 'request' started with beginRequest, resending
+     * it when the response timeout expires, and releases its in-flight slot.
+     *
+     * @return true only if a response was received
+     */
+    bool awaitResponse(const MobiusFrame& request, MobiusCompletion* completion, MobiusFrame& response);
+
+    /*!
+     * Writes the request of the 'operation' if there is room in the window,
+     * otherwise it stays queued. Fails the operation if not connected or
+     * the write fails.
+     *
+     * @return true only if the request was written
+     */
+    bool beginAsync(MobiusOperation& operation);
+
+    /*!
+     * Completes the pending 'operation' if its response was received, and
+     * otherwise resends or fails it once its response timeout expired.
+     *
+     * @return true once the operation is ready
+     */
+    bool pollAsync(MobiusOperation& operation, int64_t nowMicros);
+
+    /*!
+     * Releases the in-flight slot of the pending 'operation'.
+     */
+    void cancelAsync(MobiusOperation& operation);
     
     /*!
      * Parse the response to get extract the data.
      * Sets the value in the given 'dataSize' address to the data's total size.
      * 
-     * @return a pointer to the byte array (data)
+     * @return a pointer to the data within 'response'
      */
-    uint8_t* parseResponseData(uint8_t* response, uint16_t length, uint16_t& dataSize);
+    const uint8_t* parseResponseData(const MobiusFrame& response, uint16_t& dataSize);
     
     /*!
-     * Validate the given 'response' (of size 'resSize') for the given 'request' (of size 'reqSize').
+     * Validate the given 'response' for the given 'request'.
      *
      * @return true only if the response is a success message for the request
      */
-    bool responseSuccessful(uint8_t* request, uint16_t reqSize, uint8_t* response, uint16_t resSize);
+    bool responseSuccessful(const MobiusFrame& request, const MobiusFrame& response);
 };
 
+/*!
+ * @brief Scan for Mobius devices
+ *
+ * Same as above with the buffer size taken from the 'deviceBuffer' array.
+ */
+template<size_t N>
+uint8_t MobiusDevice::scanForMobiusDevices(uint32_t scanDuration, MobiusDevice (&deviceBuffer)[N], uint8_t expectedCount) {
+    static_assert(N <= UINT8_MAX, "deviceBuffer is larger than the maximum count");
+    return scanForMobiusDevices(scanDuration, deviceBuffer, (uint8_t)N, expectedCount);
+}
+
+/*!
+ * @brief Get the value of an attribute.
+ *
+ * @param value set to the attribute value, only if successful
+ * @return true if the value was retrieved
+ */
+template<typename Attribute>
+bool MobiusDevice::get(typename Attribute::ValueType& value, bool forceRefresh) {
+    uint8_t cached[Attribute::VALUE_WIDTH];
+    if (!forceRefresh && 0 < _cacheTtlMillis
+        && _cache.lookup(Attribute::ATTRIBUTE_ID, cached, Attribute::VALUE_WIDTH, nowMillis(), _cacheTtlMillis)) {
+        value = Attribute::decode(cached);
+        return true;
+    }
+    constexpr typename Attribute::Descriptor descriptor = Attribute::descriptor();
+    uint16_t bodySize;
+    MobiusFrame response;
+    const uint8_t* body = getData(descriptor.bytes, sizeof descriptor.bytes, response, bodySize);
+    bool found = Attribute::parse(body, bodySize, value);
+    if (found && Attribute::BODY_VALUE_OFFSET + Attribute::VALUE_WIDTH <= bodySize) {
+        _cache.store(Attribute::ATTRIBUTE_ID, &body[Attribute::BODY_VALUE_OFFSET], Attribute::VALUE_WIDTH, nowMillis());
+    }
+    return found;
+}
+
+/*!
+ * @brief Set the value of an attribute.
+ *
+ * @param value new attribute value
+ * @return true if the 'set' was successful
+ */
+template<typename Attribute>
+bool MobiusDevice::set(typename Attribute::ValueType value) {
+    const typename Attribute::Encoded attribute = Attribute::encode(value);
+    bool successful = setData(attribute.bytes, sizeof attribute.bytes);
+    // write-through, the device now holds the value
+    if (successful) {
+        _cache.store(Attribute::ATTRIBUTE_ID, &attribute.bytes[Attribute::DESCRIPTOR_SIZE + 1], Attribute::VALUE_WIDTH, nowMillis());
+    } else {
+        _cache.invalidate(Attribute::ATTRIBUTE_ID);
+    }
+    return successful;
+}
+
 #endif
@@ -5,6 +5,8 @@
 #ifndef _MobiusDeviceEventListener_h
 #define _MobiusDeviceEventListener_h
 
+#include <cstdint>
+
 /*!
  * @brief enum for possible MobiusDevice events.
  */
@@ -20,15 +22,48 @@ enum class MobiusDeviceEvent { scanning_begin, // scanning is about to start
                                response_failure    // response indicated a failure
                                };
 
+/*!
+ * @brief Details of a MobiusDeviceEvent.
+ */
+struct MobiusDeviceEventData {
+    MobiusDeviceEvent event;
+    bool hasAddress = false;   // false for events not about a single device (e.g. scanning)
+    uint8_t address[6] = {};   // native address of the device
+    uint16_t messageId = 0;    // ID of the request or response (0 if none)
+    uint32_t timestampMillis = 0; // time the event was published
+    uint32_t elapsedMillis = 0;   // duration of the phase ending with this event (connecting, writing a request, round trip)
+
+    MobiusDeviceEventData(MobiusDeviceEvent event = MobiusDeviceEvent::scanning_begin) : event(event) {}
+};
+
 /*!
  * @brief Mobius interface for listening to MobiusDeviceEvents.
  * 
  * Implementations of this interface must handle MobiusDeviceEvents
- * when they are fired/triggered. Any blocking or errors will
- * affect the source MobiusDevice.
+ * when they are fired/triggered. Events are delivered one at a time
+ * from the MobiusEventBus task, so blocking delays later events but
+ * not the source MobiusDevice.
+ * 
+ * Implement onEvent(MobiusDeviceEvent) for just the event, or
+ * onEvent(const MobiusDeviceEventData&) for its details as well.
  */
 class MobiusDeviceEventListener {
 public:
+    /*!
+     * Mask selecting every event.
+     */
+    static const uint32_t ALL_EVENTS = 0xFFFFFFFF;
+
+    /*!
+     * @brief Get the mask bit of an event, combine with | to listen to several events.
+     * 
+     * @param event MobiusDeviceEvent
+     * @return a uint32_t
+     */
+    static constexpr uint32_t mask(MobiusDeviceEvent event) {
+        return 1UL << (uint8_t)event;
+    }
+
     MobiusDeviceEventListener(){}
     virtual ~MobiusDeviceEventListener(){}
 
@@ -37,6 +72,17 @@ public:
      * 
      * @param event MobiusDeviceEvent
      */
-    virtual void onEvent(MobiusDeviceEvent event) = 0;
+    virtual void onEvent(MobiusDeviceEvent /*event*/) {}
+
+    /*!
+     * @brief Handle a MobiusDeviceEvent with its details.
+     * 
+     * By default only passes the event to onEvent(MobiusDeviceEvent).
+     * 
+     * @param data MobiusDeviceEventData
+     */
+    virtual void onEvent(const MobiusDeviceEventData& data) {
+        onEvent(data.event);
+    }
 };
 #endif
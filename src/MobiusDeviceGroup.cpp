@@ -0,0 +1,197 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <esp_timer.h>
+#include "MobiusDeviceGroup.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include <esp32-hal-log.h>
+#define LOG_TAG ""
+#else
+#include <esp_log.h>
+static const char* LOG_TAG = "MobiusDeviceGroup";
+#endif
+#include "MobiusLog.h"
+
+/*!
+ * Default constructor.
+ */
+MobiusDeviceGroup::MobiusDeviceGroup() {
+    _count = 0;
+    _writeSkewMicros = 0;
+    _confirmSkewMicros = 0;
+}
+
+/*!
+ * @brief Add a member.
+ *
+ * @param device MobiusDevice to add
+ * @return false if the device could not be added
+ */
+bool MobiusDeviceGroup::add(MobiusDevice* device) {
+    if (nullptr == device || _count >= MAX_DEVICES) {
+        return false;
+    }
+    _devices[_count++] = device;
+    return true;
+}
+
+/*!
+ * @brief Get the number of members.
+ *
+ * @return a uint8_t
+ */
+uint8_t MobiusDeviceGroup::getCount() const {
+    return _count;
+}
+
+/*!
+ * @brief Connect every member which is not connected.
+ *
+ * @return number of connected members
+ */
+uint8_t MobiusDeviceGroup::connect() {
+    uint8_t connected = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_devices[i]->isConnected() || _devices[i]->connect()) {
+            connected++;
+        }
+    }
+    MOBIUS_LOGD("- Connected %d of %d members", connected, _count);
+    return connected;
+}
+
+/*!
+ * @brief Disconnect every member.
+ */
+void MobiusDeviceGroup::disconnect() {
+    for (uint8_t i = 0; i < _count; i++) {
+        _devices[i]->disconnect();
+    }
+}
+
+/*!
+ * @brief Set a new scene on every connected member.
+ *
+ * @param sceneId scene to set
+ * @return number of members which confirmed the scene
+ */
+uint8_t MobiusDeviceGroup::setScene(uint16_t sceneId) {
+    return set<Mobius::SceneAttribute>(sceneId);
+}
+
+/*!
+ * @brief Set the default feed scene on every connected member.
+ *
+ * @return number of members which confirmed the scene
+ */
+uint8_t MobiusDeviceGroup::setFeedScene() {
+    return setScene(Mobius::FEED_SCENE_ID);
+}
+
+/*!
+ * @brief Run the schedule on every connected member.
+ *
+ * @return number of members which confirmed
+ */
+uint8_t MobiusDeviceGroup::runSchedule() {
+    return set<Mobius::OperationStateAttribute>(Mobius::OPERATION_STATE_SCHEDULE);
+}
+
+/*!
+ * @brief Get the time from the first to the last write of the last change.
+ *
+ * @return skew (in microseconds)
+ */
+uint32_t MobiusDeviceGroup::getWriteSkewMicros() const {
+    return _writeSkewMicros;
+}
+
+/*!
+ * @brief Get the time from the first to the last confirm of the last change.
+ *
+ * @return skew (in microseconds)
+ */
+uint32_t MobiusDeviceGroup::getConfirmSkewMicros() const {
+    return _confirmSkewMicros;
+}
+
+/*!
+ * Set the encoded attribute 'data' (of size 'length', ending with the
+ * value of 'valueWidth' bytes) on every connected member.
+ *
+ * @return number of members which confirmed
+ */
+uint8_t MobiusDeviceGroup::burst(const uint8_t* data, uint16_t length, uint16_t attributeId, uint8_t valueWidth) {
+    MobiusFrame* requests[MAX_DEVICES];
+    MobiusCompletion* completions[MAX_DEVICES];
+    int64_t reservedMicros[MAX_DEVICES];
+    int64_t confirmedMicros[MAX_DEVICES];
+    // build every request and reserve every slot first, so the burst is only writes
+    for (uint8_t i = 0; i < _count; i++) {
+        completions[i] = nullptr;
+        confirmedMicros[i] = 0;
+        requests[i] = MobiusFramePool::acquire();
+        if (nullptr == requests[i]) {
+            MOBIUS_LOGW("- No free frame for member %d", i);
+        } else if (_devices[i]->buildRequest(data, length, Mobius::OP_CODE_SET, 0x0800, *requests[i])) {
+            completions[i] = _devices[i]->reserveRequest(*requests[i]);
+            reservedMicros[i] = esp_timer_get_time();
+        }
+    }
+
+    int64_t firstWriteMicros = 0;
+    int64_t lastWriteMicros = 0;
+    uint32_t timeoutMillis = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (completions[i] && !_devices[i]->writeRequest(*requests[i], completions[i])) {
+            completions[i] = nullptr;
+        } else if (completions[i]) {
+            lastWriteMicros = esp_timer_get_time();
+            firstWriteMicros = firstWriteMicros ? firstWriteMicros : lastWriteMicros;
+            uint32_t memberTimeout = _devices[i]->_rtt.getTimeoutMillis();
+            timeoutMillis = (memberTimeout > timeoutMillis) ? memberTimeout : timeoutMillis;
+        }
+    }
+    _writeSkewMicros = (uint32_t)(lastWriteMicros - firstWriteMicros);
+
+    // time every confirm as it arrives, as collecting them in turn would
+    // delay the later members by the time spent on the earlier ones
+    int64_t deadlineMicros = lastWriteMicros + 1000 * (int64_t)timeoutMillis;
+    for (uint8_t i = 0; i < _count; i++) {
+        int64_t remainingMicros = deadlineMicros - esp_timer_get_time();
+        uint32_t waitMillis = (remainingMicros > 0) ? (uint32_t)((remainingMicros + 999) / 1000) : 0;
+        if (completions[i] && completions[i]->wait(waitMillis)) {
+            confirmedMicros[i] = reservedMicros[i] + completions[i]->getElapsedMicros();
+        }
+    }
+
+    // then collect (resending the late ones) and verify the responses
+    uint8_t successCount = 0;
+    int64_t firstConfirmMicros = 0;
+    int64_t lastConfirmMicros = 0;
+    MobiusFrame response;
+    for (uint8_t i = 0; i < _count; i++) {
+        MobiusDevice* device = _devices[i];
+        bool successful = completions[i] && device->awaitResponse(*requests[i], completions[i], response)
+            && device->responseSuccessful(*requests[i], response);
+        if (successful) {
+            successCount++;
+            int64_t confirmed = confirmedMicros[i] ? confirmedMicros[i] : esp_timer_get_time();
+            firstConfirmMicros = (0 == firstConfirmMicros || confirmed < firstConfirmMicros) ? confirmed : firstConfirmMicros;
+            lastConfirmMicros = (confirmed > lastConfirmMicros) ? confirmed : lastConfirmMicros;
+            // write-through, the device now holds the value
+            device->_cache.store(attributeId, &data[length - valueWidth], valueWidth, MobiusDevice::nowMillis());
+        } else {
+            device->_cache.invalidate(attributeId);
+        }
+        if (requests[i]) {
+            MobiusFramePool::release(requests[i]);
+        }
+    }
+    _confirmSkewMicros = (uint32_t)(lastConfirmMicros - firstConfirmMicros);
+    MOBIUS_LOGD("- Set attribute %d on %d of %d members (write skew %u us, confirm skew %u us)",
+                attributeId, successCount, _count, (unsigned)_writeSkewMicros, (unsigned)_confirmSkewMicros);
+    return successCount;
+}
@@ -0,0 +1,149 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusDeviceGroup_h
+#define _MobiusDeviceGroup_h
+
+#include <cstdint>
+
+#include "MobiusDevice.h"
+
+/*!
+ * @brief Changes several MobiusDevices at (nearly) the same time.
+ *
+ * Members are connected up front with connect (or kept connected by a
+ * MobiusConnectionManager). Each change then builds every request and
+ * reserves every in-flight slot first, writes all the requests in one
+ * burst and only then waits for the confirms, so the members change
+ * within a few write times of each other rather than a round trip (or
+ * a connect) apart.
+ *
+ *     MobiusDeviceGroup tank;
+ *     tank.add(&pump1);
+ *     tank.add(&pump2);
+ *     tank.connect();
+ *     uint8_t changed = tank.setFeedScene();
+ *     uint32_t skew = tank.getConfirmSkewMicros();
+ *
+ * After each change the skew between the members is reported as the time
+ * from the first to the last write and from the first to the last confirm.
+ */
+class MobiusDeviceGroup {
+public:
+    /*!
+     * Maximum number of devices in a group.
+     */
+    static const uint8_t MAX_DEVICES = MOBIUS_MAX_SESSIONS;
+
+    /*!
+     * Default constructor.
+     */
+    MobiusDeviceGroup();
+
+    /*!
+     * @brief Add a member.
+     *
+     * The 'device' must outlive the group.
+     *
+     * @param device MobiusDevice to add
+     * @return false if the device could not be added
+     */
+    bool add(MobiusDevice* device);
+
+    /*!
+     * @brief Get the number of members.
+     *
+     * @return a uint8_t
+     */
+    uint8_t getCount() const;
+
+    /*!
+     * @brief Connect every member which is not connected.
+     *
+     * @return number of connected members
+     */
+    uint8_t connect();
+
+    /*!
+     * @brief Disconnect every member.
+     */
+    void disconnect();
+
+    /*!
+     * @brief Set the value of an attribute on every connected member.
+     *
+     * Works for any attribute declared as a MobiusAttribute.
+     *
+     * @param value new attribute value
+     * @return number of members which confirmed the value
+     */
+    template<typename Attribute>
+    uint8_t set(typename Attribute::ValueType value);
+
+    /*!
+     * @brief Set a new scene on every connected member.
+     *
+     * @param sceneId scene to set
+     * @return number of members which confirmed the scene
+     */
+    uint8_t setScene(uint16_t sceneId);
+
+    /*!
+     * @brief Set the default feed scene on every connected member.
+     *
+     * @return number of members which confirmed the scene
+     */
+    uint8_t setFeedScene();
+
+    /*!
+     * @brief Run the schedule on every connected member.
+     *
+     * @return number of members which confirmed
+     */
+    uint8_t runSchedule();
+
+    /*!
+     * @brief Get the time from the first to the last write of the last change.
+     *
+     * @return skew (in microseconds)
+     */
+    uint32_t getWriteSkewMicros() const;
+
+    /*!
+     * @brief Get the time from the first to the last confirm of the last change.
+     *
+     * Only members which confirmed are counted.
+     *
+     * @return skew (in microseconds)
+     */
+    uint32_t getConfirmSkewMicros() const;
+
+private:
+    MobiusDevice* _devices[MAX_DEVICES];
+    uint8_t _count;
+    uint32_t _writeSkewMicros;
+    uint32_t _confirmSkewMicros;
+
+    /*!
+     * Set the encoded attribute 'data' (of size 'length', ending with the
+     * value of 'valueWidth' bytes) on every connected member.
+     *
+     * @return number of members which confirmed
+     */
+    uint8_t burst(const uint8_t* data, uint16_t length, uint16_t attributeId, uint8_t valueWidth);
+};
+
+/*!
+ * @brief Set the value of an attribute on every connected member.
+ *
+ * @param value new attribute value
+ * @return number of members which confirmed the value
+ */
+template<typename Attribute>
+uint8_t MobiusDeviceGroup::set(typename Attribute::ValueType value) {
+    const typename Attribute::Encoded attribute = Attribute::encode(value);
+    return burst(attribute.bytes, sizeof attribute.bytes, Attribute::ATTRIBUTE_ID, Attribute::VALUE_WIDTH);
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusDeviceHandle_h
+#define _MobiusDeviceHandle_h
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <NimBLEDevice.h>
+
+/*!
+ * @brief Identity of a Mobius device, its BLE address and address type.
+ *
+ * Small and trivially copyable, so it may be stored (e.g. by a
+ * MobiusRoster), copied and compared freely. A MobiusDevice built from
+ * a handle connects by address, without the advertisement.
+ */
+struct MobiusDeviceHandle {
+    /*!
+     * Address bytes as stored by NimBLE (least significant byte first).
+     */
+    uint8_t address[6];
+    /*!
+     * Address type, e.g. BLE_ADDR_PUBLIC or BLE_ADDR_RANDOM.
+     */
+    uint8_t type;
+
+    /*!
+     * Default constructor, for no device.
+     */
+    MobiusDeviceHandle() : address(), type(0) {}
+
+    /*!
+     * Constructor for the device with the given 'bleAddress' (including its type).
+     */
+    explicit MobiusDeviceHandle(const BLEAddress& bleAddress) : type(bleAddress.getType()) {
+        memcpy(address, bleAddress.getNative(), sizeof address);
+    }
+
+    /*!
+     * @brief Check whether the handle refers to a device.
+     *
+     * @return false for the default (all zero) address
+     */
+    bool isValid() const {
+        static const uint8_t NONE[6] = {};
+        return 0 != memcmp(address, NONE, sizeof address);
+    }
+
+    /*!
+     * @brief Get the BLE address (including its type).
+     *
+     * @return a BLEAddress
+     */
+    BLEAddress toAddress() const {
+        ble_addr_t bleAddress;
+        bleAddress.type = type;
+        memcpy(bleAddress.val, address, sizeof bleAddress.val);
+        return BLEAddress(bleAddress);
+    }
+
+    /*!
+     * @brief Check whether both handles refer to the same address.
+     *
+     * The type is not compared, as it describes the same address.
+     */
+    bool operator==(const MobiusDeviceHandle& other) const {
+        return 0 == memcmp(address, other.address, sizeof address);
+    }
+
+    bool operator!=(const MobiusDeviceHandle& other) const {
+        return !(*this == other);
+    }
+};
+
+static_assert(std::is_trivially_copyable<MobiusDeviceHandle>::value, "MobiusDeviceHandle must stay trivially copyable");
+static_assert(7 == sizeof(MobiusDeviceHandle), "MobiusDeviceHandle is the address and its type");
+
+#endif
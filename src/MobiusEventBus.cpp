@@ -0,0 +1,207 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <esp_timer.h>
+#include "MobiusEventBus.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include <esp32-hal-log.h>
+#define LOG_TAG ""
+#else
+#include <esp_log.h>
+static const char* LOG_TAG = "MobiusEventBus";
+#endif
+#include "MobiusLog.h"
+
+/*!
+ * Main constructor.
+ *
+ * @param policy MobiusEventOverflowPolicy (default drop_newest)
+ */
+MobiusEventBus::MobiusEventBus(MobiusEventOverflowPolicy policy)
+    : _mask(0), _policy(policy), _dropCount(0), _task(nullptr) {}
+
+/*!
+ * @brief Subscribe a listener to events.
+ *
+ * @param listener MobiusDeviceEventListener
+ * @param mask events to receive (default ALL_EVENTS)
+ * @return false if MOBIUS_MAX_LISTENERS are already subscribed
+ */
+bool MobiusEventBus::addListener(MobiusDeviceEventListener* listener, uint32_t mask) {
+    std::lock_guard<std::mutex> lock(_subscriptionsMutex);
+    Subscription* subscription = nullptr;
+    for (uint8_t i = 0; i < MOBIUS_MAX_LISTENERS; i++) {
+        if (listener == _subscriptions[i].listener) {
+            subscription = &_subscriptions[i];
+            break;
+        } else if (!subscription && nullptr == _subscriptions[i].listener) {
+            subscription = &_subscriptions[i];
+        }
+    }
+    if (nullptr == listener || nullptr == subscription) {
+        return false;
+    }
+    subscription->listener = listener;
+    subscription->mask = mask;
+    uint32_t combined = 0;
+    for (uint8_t i = 0; i < MOBIUS_MAX_LISTENERS; i++) {
+        combined |= _subscriptions[i].mask;
+    }
+    _mask.store(combined);
+    return true;
+}
+
+/*!
+ * @brief Unsubscribe a listener.
+ *
+ * @param listener MobiusDeviceEventListener
+ */
+void MobiusEventBus::removeListener(MobiusDeviceEventListener* listener) {
+    std::lock_guard<std::mutex> lock(_subscriptionsMutex);
+    uint32_t combined = 0;
+    for (uint8_t i = 0; i < MOBIUS_MAX_LISTENERS; i++) {
+        if (listener == _subscriptions[i].listener) {
+            _subscriptions[i] = Subscription();
+        }
+        combined |= _subscriptions[i].mask;
+    }
+    _mask.store(combined);
+}
+
+/*!
+ * @brief Set what happens to an event published to a full queue.
+ *
+ * @param policy MobiusEventOverflowPolicy
+ */
+void MobiusEventBus::setOverflowPolicy(MobiusEventOverflowPolicy policy) {
+    _policy.store(policy);
+}
+
+/*!
+ * @brief Start the dispatcher task.
+ *
+ * @param priority FreeRTOS priority of the dispatcher task (default 1)
+ * @return true if the task is running
+ */
+bool MobiusEventBus::start(UBaseType_t priority) {
+    if (nullptr != _task.load()) {
+        return true;
+    }
+    TaskHandle_t task = nullptr;
+    if (pdPASS != xTaskCreate(taskMain, "MobiusEvents", 4096, this, priority, &task)) {
+        MOBIUS_LOGW("- Failed to create the event task, delivering events directly");
+        return false;
+    }
+    _task.store(task);
+    return true;
+}
+
+/*!
+ * @brief Stop the dispatcher task, events are then delivered directly.
+ */
+void MobiusEventBus::stop() {
+    TaskHandle_t task = _task.exchange(nullptr);
+    if (nullptr != task) {
+        // the task delivers what is queued and then ends itself,
+        // so it is never deleted in the middle of a listener call
+        xTaskNotifyGive(task);
+    }
+}
+
+/*!
+ * @brief Publish an event to the listeners.
+ *
+ * @param data MobiusDeviceEventData
+ * @return false if this event was dropped
+ */
+bool MobiusEventBus::publish(MobiusDeviceEventData data) {
+    if (!isWanted(data.event)) {
+        return true;
+    }
+    data.timestampMillis = esp_timer_get_time() / 1000;
+    TaskHandle_t task = _task.load();
+    if (nullptr == task) {
+        deliver(data);
+        return true;
+    }
+    bool queued = _queue.push(data);
+    if (!queued) {
+        _dropCount++;
+        if (MobiusEventOverflowPolicy::drop_oldest == _policy.load()) {
+            // make room by dropping the oldest event, then retry once
+            MobiusDeviceEventData oldest;
+            _queue.pop(oldest);
+            queued = _queue.push(data);
+            if (!queued) {
+                _dropCount++;
+            }
+        }
+    }
+    xTaskNotifyGive(task);
+    return queued;
+}
+
+/*!
+ * @brief Check whether any listener wants an event.
+ *
+ * @param event MobiusDeviceEvent
+ * @return true if at least one listener subscribed to the event
+ */
+bool MobiusEventBus::isWanted(MobiusDeviceEvent event) const {
+    return 0 != (_mask.load() & MobiusDeviceEventListener::mask(event));
+}
+
+/*!
+ * @brief Get the number of events dropped because the queue was full.
+ *
+ * @return a uint32_t
+ */
+uint32_t MobiusEventBus::getDropCount() const {
+    return _dropCount.load();
+}
+
+/*!
+ * Deliver queued events until stopped.
+ */
+void MobiusEventBus::taskMain(void* bus) {
+    MobiusEventBus* self = static_cast<MobiusEventBus*>(bus);
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    do {
+        // sleep until an event is published (or stop is called)
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self->drain();
+    } while (task == self->_task.load());
+    vTaskDelete(nullptr);
+}
+
+/*!
+ * Deliver all queued events to the listeners.
+ */
+void MobiusEventBus::drain() {
+    MobiusDeviceEventData data;
+    while (_queue.pop(data)) {
+        deliver(data);
+    }
+}
+
+/*!
+ * Deliver an event to each listener wanting it.
+ */
+void MobiusEventBus::deliver(const MobiusDeviceEventData& data) {
+    // copy the subscriptions so listeners run without holding the lock
+    Subscription subscriptions[MOBIUS_MAX_LISTENERS];
+    {
+        std::lock_guard<std::mutex> lock(_subscriptionsMutex);
+        for (uint8_t i = 0; i < MOBIUS_MAX_LISTENERS; i++) {
+            subscriptions[i] = _subscriptions[i];
+        }
+    }
+    uint32_t bit = MobiusDeviceEventListener::mask(data.event);
+    for (uint8_t i = 0; i < MOBIUS_MAX_LISTENERS; i++) {
+        if (subscriptions[i].listener && (subscriptions[i].mask & bit)) {
+            subscriptions[i].listener->onEvent(data);
+        }
+    }
+}
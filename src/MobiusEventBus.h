@@ -0,0 +1,158 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusEventBus_h
+#define _MobiusEventBus_h
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "MobiusDeviceEventListener.h"
+#include "MobiusEventQueue.h"
+
+/*!
+ * Number of events which may wait for the dispatcher (a power of 2).
+ */
+#ifndef MOBIUS_EVENT_QUEUE_SIZE
+#define MOBIUS_EVENT_QUEUE_SIZE 32
+#endif
+
+/*!
+ * Number of listeners which may subscribe to a MobiusEventBus.
+ */
+#ifndef MOBIUS_MAX_LISTENERS
+#define MOBIUS_MAX_LISTENERS 4
+#endif
+
+/*!
+ * @brief enum for what happens to an event published to a full queue.
+ */
+enum class MobiusEventOverflowPolicy { drop_newest, // the published event is dropped
+                                       drop_oldest  // the oldest waiting event is dropped to make room
+                                       };
+
+/*!
+ * @brief Delivers MobiusDeviceEvents to listeners from a separate task.
+ * 
+ * Each listener subscribes with a mask of the events it wants. Events
+ * no listener wants are discarded when published, the rest are added to
+ * a bounded lock-free queue and the dispatcher task is woken to pass
+ * them to each interested listener. A slow listener
+ * (e.g. one blinking LEDs) therefore never delays scanning, connecting
+ * or requests. When the queue is full events are dropped according to
+ * the overflow policy and counted.
+ * 
+ * Until started (or after stopping) events are delivered directly.
+ */
+class MobiusEventBus {
+public:
+    /*!
+     * Main constructor.
+     * 
+     * @param policy MobiusEventOverflowPolicy (default drop_newest)
+     */
+    MobiusEventBus(MobiusEventOverflowPolicy policy = MobiusEventOverflowPolicy::drop_newest);
+
+    /*!
+     * @brief Subscribe a listener to events.
+     * 
+     * Adding a listener again replaces its mask.
+     * 
+     * @param listener MobiusDeviceEventListener
+     * @param mask events to receive (see MobiusDeviceEventListener::mask, default ALL_EVENTS)
+     * @return false if MOBIUS_MAX_LISTENERS are already subscribed
+     */
+    bool addListener(MobiusDeviceEventListener* listener, uint32_t mask = MobiusDeviceEventListener::ALL_EVENTS);
+
+    /*!
+     * @brief Unsubscribe a listener.
+     * 
+     * @param listener MobiusDeviceEventListener
+     */
+    void removeListener(MobiusDeviceEventListener* listener);
+
+    /*!
+     * @brief Set what happens to an event published to a full queue.
+     * 
+     * @param policy MobiusEventOverflowPolicy
+     */
+    void setOverflowPolicy(MobiusEventOverflowPolicy policy);
+
+    /*!
+     * @brief Start the dispatcher task.
+     * 
+     * @param priority FreeRTOS priority of the dispatcher task (default 1)
+     * @return true if the task is running
+     */
+    bool start(UBaseType_t priority = 1);
+
+    /*!
+     * @brief Stop the dispatcher task, events are then delivered directly.
+     */
+    void stop();
+
+    /*!
+     * @brief Publish an event to the listeners.
+     * 
+     * The timestamp of the event is set when published. Under the
+     * drop_oldest policy a full queue drops the oldest waiting event
+     * instead, so this event is still delivered.
+     * 
+     * @param data MobiusDeviceEventData
+     * @return false if this event was dropped
+     */
+    bool publish(MobiusDeviceEventData data);
+
+    /*!
+     * @brief Check whether any listener wants an event.
+     * 
+     * Allows skipping the cost of preparing the event's details.
+     * 
+     * @param event MobiusDeviceEvent
+     * @return true if at least one listener subscribed to the event
+     */
+    bool isWanted(MobiusDeviceEvent event) const;
+
+    /*!
+     * @brief Get the number of events dropped because the queue was full.
+     * 
+     * @return a uint32_t
+     */
+    uint32_t getDropCount() const;
+
+private:
+    struct Subscription {
+        MobiusDeviceEventListener* listener = nullptr;
+        uint32_t mask = 0;
+    };
+
+    MobiusEventQueue<MobiusDeviceEventData, MOBIUS_EVENT_QUEUE_SIZE> _queue;
+    Subscription _subscriptions[MOBIUS_MAX_LISTENERS];
+    std::mutex _subscriptionsMutex;
+    // combined mask of all subscriptions
+    std::atomic<uint32_t> _mask;
+    std::atomic<MobiusEventOverflowPolicy> _policy;
+    std::atomic<uint32_t> _dropCount;
+    std::atomic<TaskHandle_t> _task;
+
+    /*!
+     * Deliver queued events until stopped.
+     */
+    static void taskMain(void* bus);
+
+    /*!
+     * Deliver all queued events to the listeners.
+     */
+    void drain();
+
+    /*!
+     * Deliver an event to each listener wanting it.
+     */
+    void deliver(const MobiusDeviceEventData& data);
+};
+
+#endif
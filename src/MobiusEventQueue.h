@@ -0,0 +1,102 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusEventQueue_h
+#define _MobiusEventQueue_h
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+/*!
+ * @brief Bounded lock-free multi-producer multi-consumer queue.
+ * 
+ * Each cell carries a sequence number which tells producers and
+ * consumers whether it is free or holds a value (D. Vyukov's bounded
+ * MPMC queue). Pushing and popping never block or allocate; a full
+ * queue simply rejects the push.
+ * 
+ * @tparam T value type (copyable and default constructible)
+ * @tparam N number of cells (a power of 2)
+ */
+template<typename T, size_t N>
+class MobiusEventQueue {
+    static_assert(2 <= N && 0 == (N & (N - 1)), "MobiusEventQueue size must be a power of 2");
+
+public:
+    MobiusEventQueue() : _enqueuePosition(0), _dequeuePosition(0) {
+        for (size_t i = 0; i < N; i++) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MobiusEventQueue(const MobiusEventQueue&) = delete;
+    MobiusEventQueue& operator=(const MobiusEventQueue&) = delete;
+
+    /*!
+     * @brief Add a value to the back of the queue.
+     * 
+     * @return false if the queue is full
+     */
+    bool push(const T& value) {
+        size_t position = _enqueuePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = _cells[position & (N - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+            if (0 == difference) {
+                // the cell is free, claim it
+                if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // the cell still holds a value from the previous lap
+                return false;
+            } else {
+                position = _enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /*!
+     * @brief Take the value from the front of the queue.
+     * 
+     * @return false if the queue is empty
+     */
+    bool pop(T& value) {
+        size_t position = _dequeuePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = _cells[position & (N - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+            if (0 == difference) {
+                // the cell holds a value, claim it
+                if (_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    value = cell.value;
+                    cell.sequence.store(position + N, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // the cell has not been filled yet
+                return false;
+            } else {
+                position = _dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    Cell _cells[N];
+    std::atomic<size_t> _enqueuePosition;
+    std::atomic<size_t> _dequeuePosition;
+};
+
+#endif
@@ -0,0 +1,197 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include "MobiusExecutor.h"
+#include <esp_timer.h>
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include <esp32-hal-log.h>
+#define LOG_TAG ""
+#else
+#include <esp_log.h>
+static const char* LOG_TAG = "MobiusExecutor";
+#endif
+#include "MobiusLog.h"
+
+/*!
+ * Longest sleep while an operation waits for room in a window (in milliseconds).
+ */
+static const uint32_t QUEUED_RETRY_MILLIS = 10;
+
+/*!
+ * Default constructor.
+ */
+MobiusExecutor::MobiusExecutor() : _count(0) {}
+
+/*!
+ * De-construct the class, cancelling any outstanding operations.
+ */
+MobiusExecutor::~MobiusExecutor() {
+    while (0 < _count) {
+        cancel(*_operations[_count - 1]);
+    }
+}
+
+/*!
+ * @brief Start reading the currently running scene.
+ *
+ * @param device connected MobiusDevice
+ * @param future receives the scene
+ * @return false if the operation could not be started
+ */
+bool MobiusExecutor::getCurrentScene(MobiusDevice& device, MobiusFuture<uint16_t>& future) {
+    return get<Mobius::SceneAttribute>(device, future);
+}
+
+/*!
+ * @brief Start setting a new scene.
+ *
+ * @param device connected MobiusDevice
+ * @param sceneId scene to set
+ * @param future completes once the device confirmed the scene
+ * @return false if the operation could not be started
+ */
+bool MobiusExecutor::setScene(MobiusDevice& device, uint16_t sceneId, MobiusFuture<void>& future) {
+    return set<Mobius::SceneAttribute>(device, sceneId, future);
+}
+
+/*!
+ * @brief Start running the schedule.
+ *
+ * @param device connected MobiusDevice
+ * @param future completes once the device confirmed
+ * @return false if the operation could not be started
+ */
+bool MobiusExecutor::runSchedule(MobiusDevice& device, MobiusFuture<void>& future) {
+    return set<Mobius::OperationStateAttribute>(device, Mobius::OPERATION_STATE_SCHEDULE, future);
+}
+
+/*!
+ * @brief Stop an outstanding operation, it returns to idle.
+ *
+ * A response which still arrives is dropped.
+ *
+ * @param operation MobiusOperation started by this executor
+ */
+void MobiusExecutor::cancel(MobiusOperation& operation) {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (&operation == _operations[i]) {
+            operation._device->cancelAsync(operation);
+            operation._state = MobiusOperation::State::idle;
+            remove(i);
+            return;
+        }
+    }
+}
+
+/*!
+ * @brief Progress the outstanding operations without waiting.
+ *
+ * @return number of operations still outstanding
+ */
+uint8_t MobiusExecutor::poll() {
+    int64_t nowMicros = esp_timer_get_time();
+    uint8_t i = 0;
+    while (i < _count) {
+        MobiusOperation* operation = _operations[i];
+        if (MobiusOperation::State::queued == operation->_state) {
+            operation->_device->beginAsync(*operation);
+        } else if (MobiusOperation::State::pending == operation->_state) {
+            operation->_device->pollAsync(*operation, nowMicros);
+        }
+        if (operation->isReady()) {
+            remove(i);
+        } else {
+            i++;
+        }
+    }
+    return _count;
+}
+
+/*!
+ * @brief Progress the outstanding operations until one completes.
+ *
+ * @param timeoutMillis longest time to wait (in milliseconds)
+ * @return number of operations still outstanding
+ */
+uint8_t MobiusExecutor::run(uint32_t timeoutMillis) {
+    int64_t endMicros = esp_timer_get_time() + 1000 * (int64_t)timeoutMillis;
+    uint8_t outstanding = _count;
+    uint8_t pending = poll();
+    while (0 < pending && pending == outstanding) {
+        int64_t nowMicros = esp_timer_get_time();
+        if (endMicros <= nowMicros) {
+            break;
+        }
+        // sleep until the earliest response timeout, unless a response wakes the task first
+        int64_t wakeMicros = endMicros;
+        for (uint8_t i = 0; i < _count; i++) {
+            int64_t dueMicros = (MobiusOperation::State::queued == _operations[i]->_state)
+                ? nowMicros + 1000 * (int64_t)QUEUED_RETRY_MILLIS
+                : _operations[i]->_deadlineMicros;
+            if (dueMicros < wakeMicros) {
+                wakeMicros = dueMicros;
+            }
+        }
+        uint32_t sleepMillis = (wakeMicros > nowMicros) ? (uint32_t)((wakeMicros - nowMicros + 999) / 1000) : 0;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleepMillis) + 1);
+        pending = poll();
+    }
+    return pending;
+}
+
+/*!
+ * @brief Get the number of outstanding operations.
+ *
+ * @return a uint8_t
+ */
+uint8_t MobiusExecutor::getPendingCount() const {
+    return _count;
+}
+
+/*!
+ * Remove the operation at 'index', keeping the rest in the order started
+ * so queued requests to a device are written in that order.
+ */
+void MobiusExecutor::remove(uint8_t index) {
+    _count--;
+    for (uint8_t i = index; i < _count; i++) {
+        _operations[i] = _operations[i + 1];
+    }
+}
+
+/*!
+ * Build the request for the 'operation' and write it when the window allows.
+ *
+ * @return false if the operation could not be started
+ */
+bool MobiusExecutor::start(MobiusDevice& device, MobiusOperation& operation, const uint8_t* data, uint16_t length, uint8_t opCode) {
+    if (MobiusOperation::State::queued == operation._state || MobiusOperation::State::pending == operation._state) {
+        MOBIUS_LOGW("- Operation is already outstanding");
+        return false;
+    }
+    if (MOBIUS_EXECUTOR_CAPACITY <= _count) {
+        MOBIUS_LOGW("- No room for another operation");
+        return false;
+    }
+    operation._device = &device;
+    operation._connection = device._connectionCount;
+    operation._completion = nullptr;
+    operation._retransmissions = 0;
+    uint16_t reserved = (Mobius::OP_CODE_SET == opCode) ? 0x0800 : 0x0000;
+    if (!device.isConnected() || !device.buildRequest(data, length, opCode, reserved, operation._request)) {
+        MOBIUS_LOGW("- Unable to start the operation");
+        operation._state = MobiusOperation::State::failed;
+        return false;
+    }
+    operation._state = MobiusOperation::State::queued;
+    _operations[_count++] = &operation;
+    device.beginAsync(operation);
+    if (operation.isReady()) {
+        // the write failed, nothing is outstanding
+        _count--;
+        return false;
+    }
+    return true;
+}
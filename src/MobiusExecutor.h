@@ -0,0 +1,201 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusExecutor_h
+#define _MobiusExecutor_h
+
+#include <cstdint>
+#include <cstddef>
+
+#include "MobiusDevice.h"
+#include "MobiusFuture.h"
+
+/*!
+ * Number of operations an executor can have outstanding.
+ */
+#ifndef MOBIUS_EXECUTOR_CAPACITY
+#define MOBIUS_EXECUTOR_CAPACITY 32
+#endif
+
+/*!
+ * @brief Runs MobiusDevice requests without blocking.
+ *
+ * Each request is written as soon as the device's window allows and
+ * completes in a MobiusFuture owned by the caller, so a single task can
+ * have many requests outstanding across several connected devices.
+ * Responses wake the task running the executor, which checks for them
+ * (and resends requests which timed out) in poll or run.
+ *
+ *     MobiusExecutor executor;
+ *     MobiusFuture<void> pump1Set, pump2Set;
+ *     executor.setScene(pump1, 5, pump1Set);
+ *     executor.setScene(pump2, 5, pump2Set);
+ *     while (0 < executor.run(100)) {
+ *         // other work
+ *     }
+ *
+ * An executor is not thread safe, only use it (and its futures) from a
+ * single task. The devices must already be connected, as connecting
+ * blocks.
+ */
+class MobiusExecutor {
+public:
+    MobiusExecutor();
+
+    /*!
+     * De-construct the class, cancelling any outstanding operations.
+     */
+    ~MobiusExecutor();
+
+    /*!
+     * @brief Start reading an attribute.
+     *
+     * Works for any attribute declared as a MobiusAttribute. Completes
+     * straight away when the device's attribute cache holds the value
+     * (see MobiusDevice::setCacheTtl).
+     *
+     * @param device connected MobiusDevice
+     * @param future receives the value, must stay in place until ready
+     * @return false if the operation could not be started
+     */
+    template<typename Attribute>
+    bool get(MobiusDevice& device, MobiusFuture<typename Attribute::ValueType>& future);
+
+    /*!
+     * @brief Start writing an attribute.
+     *
+     * Works for any attribute declared as a MobiusAttribute.
+     *
+     * @param device connected MobiusDevice
+     * @param value new attribute value
+     * @param future completes once the device confirmed the value
+     * @return false if the operation could not be started
+     */
+    template<typename Attribute>
+    bool set(MobiusDevice& device, typename Attribute::ValueType value, MobiusFuture<void>& future);
+
+    /*!
+     * @brief Start reading the currently running scene.
+     *
+     * @param device connected MobiusDevice
+     * @param future receives the scene
+     * @return false if the operation could not be started
+     */
+    bool getCurrentScene(MobiusDevice& device, MobiusFuture<uint16_t>& future);
+
+    /*!
+     * @brief Start setting a new scene.
+     *
+     * @param device connected MobiusDevice
+     * @param sceneId scene to set
+     * @param future completes once the device confirmed the scene
+     * @return false if the operation could not be started
+     */
+    bool setScene(MobiusDevice& device, uint16_t sceneId, MobiusFuture<void>& future);
+
+    /*!
+     * @brief Start running the schedule.
+     *
+     * @param device connected MobiusDevice
+     * @param future completes once the device confirmed
+     * @return false if the operation could not be started
+     */
+    bool runSchedule(MobiusDevice& device, MobiusFuture<void>& future);
+
+    /*!
+     * @brief Stop an outstanding operation, it returns to idle.
+     *
+     * @param operation MobiusOperation started by this executor
+     */
+    void cancel(MobiusOperation& operation);
+
+    /*!
+     * @brief Progress the outstanding operations without waiting.
+     *
+     * Completes operations whose response arrived, resends or fails
+     * those whose response timeout expired and writes those waiting
+     * for room in their device's window.
+     *
+     * @return number of operations still outstanding
+     */
+    uint8_t poll();
+
+    /*!
+     * @brief Progress the outstanding operations until one completes.
+     *
+     * Sleeps between responses, so the task uses no CPU while waiting.
+     *
+     * @param timeoutMillis longest time to wait (in milliseconds)
+     * @return number of operations still outstanding
+     */
+    uint8_t run(uint32_t timeoutMillis);
+
+    /*!
+     * @brief Get the number of outstanding operations.
+     *
+     * @return a uint8_t
+     */
+    uint8_t getPendingCount() const;
+
+private:
+    MobiusOperation* _operations[MOBIUS_EXECUTOR_CAPACITY];
+    uint8_t _count;
+
+    /*!
+     * Build the request for the 'operation' and write it when the window allows.
+     *
+     * @return false if the operation could not be started
+     */
+    bool start(MobiusDevice& device, MobiusOperation& operation, const uint8_t* data, uint16_t length, uint8_t opCode);
+
+    /*!
+     * Remove the operation at 'index', keeping the order of the rest.
+     */
+    void remove(uint8_t index);
+};
+
+/*!
+ * @brief Start reading an attribute.
+ *
+ * @param device connected MobiusDevice
+ * @param future receives the value, must stay in place until ready
+ * @return false if the operation could not be started
+ */
+template<typename Attribute>
+bool MobiusExecutor::get(MobiusDevice& device, MobiusFuture<typename Attribute::ValueType>& future) {
+    future._parser = &Attribute::parse;
+    future._attributeId = Attribute::ATTRIBUTE_ID;
+    future._valueWidth = Attribute::VALUE_WIDTH;
+    future._valueOffset = Attribute::BODY_VALUE_OFFSET;
+    uint8_t cached[Attribute::VALUE_WIDTH];
+    if (MobiusOperation::State::queued != future._state && MobiusOperation::State::pending != future._state
+        && 0 < device._cacheTtlMillis
+        && device._cache.lookup(Attribute::ATTRIBUTE_ID, cached, Attribute::VALUE_WIDTH, MobiusDevice::nowMillis(), device._cacheTtlMillis)) {
+        future._value = Attribute::decode(cached);
+        future._state = MobiusOperation::State::successful;
+        return true;
+    }
+    constexpr typename Attribute::Descriptor descriptor = Attribute::descriptor();
+    return start(device, future, descriptor.bytes, sizeof descriptor.bytes, Mobius::OP_CODE_GET);
+}
+
+/*!
+ * @brief Start writing an attribute.
+ *
+ * @param device connected MobiusDevice
+ * @param value new attribute value
+ * @param future completes once the device confirmed the value
+ * @return false if the operation could not be started
+ */
+template<typename Attribute>
+bool MobiusExecutor::set(MobiusDevice& device, typename Attribute::ValueType value, MobiusFuture<void>& future) {
+    const typename Attribute::Encoded attribute = Attribute::encode(value);
+    future._attributeId = Attribute::ATTRIBUTE_ID;
+    future._valueWidth = Attribute::VALUE_WIDTH;
+    // header, descriptor, value length
+    future._valueOffset = 9 + Attribute::DESCRIPTOR_SIZE + 1;
+    return start(device, future, attribute.bytes, sizeof attribute.bytes, Mobius::OP_CODE_SET);
+}
+
+#endif
@@ -0,0 +1,61 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <cstring>
+#include "MobiusFrame.h"
+
+static_assert(MOBIUS_FRAME_POOL_SIZE <= 32, "MobiusFramePool tracks frames in a 32 bit mask");
+
+MobiusFrame MobiusFramePool::_frames[MOBIUS_FRAME_POOL_SIZE];
+std::atomic<uint32_t> MobiusFramePool::_inUse(0);
+
+/*!
+ * @brief Replace the contents with the given 'bytes' (of size 'length').
+ *
+ * @return false if the bytes did not fit and were truncated
+ */
+bool MobiusFrame::assign(const uint8_t* bytes, size_t length) {
+    bool fits = (length <= CAPACITY);
+    size = fits ? length : CAPACITY;
+    memcpy(data, bytes, size);
+    return fits;
+}
+
+/*!
+ * @brief Take a free frame from the pool.
+ *
+ * @return an empty frame, or nullptr if the pool is exhausted
+ */
+MobiusFrame* MobiusFramePool::acquire() {
+    uint32_t inUse = _inUse.load();
+    uint8_t i = 0;
+    while (i < MOBIUS_FRAME_POOL_SIZE) {
+        uint32_t bit = (1UL << i);
+        if (inUse & bit) {
+            i++;
+        } else if (_inUse.compare_exchange_weak(inUse, inUse | bit)) {
+            _frames[i].size = 0;
+            return &_frames[i];
+        } else {
+            // another task changed the pool ('inUse' was reloaded), search again
+            i = 0;
+        }
+    }
+    return nullptr;
+}
+
+/*!
+ * @brief Return a frame to the pool.
+ *
+ * @param frame previously returned by acquire (nullptr is ignored)
+ */
+void MobiusFramePool::release(MobiusFrame* frame) {
+    if (nullptr == frame) {
+        return;
+    }
+    ptrdiff_t index = frame - _frames;
+    if (0 <= index && index < MOBIUS_FRAME_POOL_SIZE) {
+        _inUse.fetch_and(~(1UL << index));
+    }
+}
@@ -0,0 +1,74 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusFrame_h
+#define _MobiusFrame_h
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+/*!
+ * Maximum size (in bytes) of a single Mobius request or response.
+ */
+#ifndef MOBIUS_FRAME_CAPACITY
+#define MOBIUS_FRAME_CAPACITY 256
+#endif
+
+/*!
+ * Number of frames held by the MobiusFramePool.
+ */
+#ifndef MOBIUS_FRAME_POOL_SIZE
+#define MOBIUS_FRAME_POOL_SIZE 8
+#endif
+
+/*!
+ * @brief Fixed capacity buffer for a Mobius request or response.
+ * 
+ * Frames are plain values so they may live on the stack, inside other
+ * objects or in the MobiusFramePool without any heap allocation.
+ */
+struct MobiusFrame {
+    static const uint16_t CAPACITY = MOBIUS_FRAME_CAPACITY;
+
+    uint8_t data[CAPACITY];
+    uint16_t size = 0;
+
+    /*!
+     * @brief Replace the contents with the given 'bytes' (of size 'length').
+     * 
+     * @return false if the bytes did not fit and were truncated
+     */
+    bool assign(const uint8_t* bytes, size_t length);
+};
+
+/*!
+ * @brief Static pool of MobiusFrames.
+ * 
+ * Provides frames for callers which need more than fit comfortably on
+ * the stack (e.g. one request per device). Acquiring and releasing is
+ * lock-free and never allocates.
+ */
+class MobiusFramePool {
+public:
+    /*!
+     * @brief Take a free frame from the pool.
+     * 
+     * @return an empty frame, or nullptr if the pool is exhausted
+     */
+    static MobiusFrame* acquire();
+
+    /*!
+     * @brief Return a frame to the pool.
+     * 
+     * @param frame previously returned by acquire (nullptr is ignored)
+     */
+    static void release(MobiusFrame* frame);
+
+private:
+    static MobiusFrame _frames[MOBIUS_FRAME_POOL_SIZE];
+    static std::atomic<uint32_t> _inUse;
+};
+
+#endif
@@ -0,0 +1,134 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <cstring>
+#include <esp_timer.h>
+#include "MobiusFrameAssembler.h"
+#include "MobiusCRC.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include <esp32-hal-log.h>
+#define LOG_TAG ""
+#else
+#include <esp_log.h>
+static const char* LOG_TAG = "MobiusFrameAssembler";
+#endif
+#include "MobiusLog.h"
+
+/*!
+ * @brief Discard any partially assembled frame.
+ */
+void MobiusFrameAssembler::reset() {
+    _frame.size = 0;
+    _expectedSize = 0;
+    _crcOffset = 1;
+    _crc = MobiusCRC::init();
+    _done = false;
+}
+
+/*!
+ * @brief Append a fragment to the frame.
+ *
+ * @param data fragment bytes
+ * @param length number of fragment bytes
+ * @param final true if the fragment was received on RX_FINAL
+ * @return Result of the frame so far
+ */
+MobiusFrameAssembler::Result MobiusFrameAssembler::append(const uint8_t* data, size_t length, bool final) {
+    int64_t nowMicros = esp_timer_get_time();
+    if (_done) {
+        reset();
+    } else if (0 < _frame.size) {
+        // the rest of a partial frame may have been lost, but a continuation
+        // may start with the same bytes, so only one which doesn't fit is a frame start
+        bool isFrameStart = (2 <= length) && (START_BYTE == data[0]) && (CONFIRM_GROUP == data[1])
+            && (0 == _expectedSize || _frame.size + length > _expectedSize);
+        bool isLate = (nowMicros - _lastFragmentMicros) > (int64_t)_fragmentTimeoutMillis * 1000;
+        if (isFrameStart || isLate) {
+            MOBIUS_LOGW("- Discarding a partial frame of %u bytes", _frame.size);
+            reset();
+        }
+    }
+    _lastFragmentMicros = nowMicros;
+    if (length > (size_t)(MobiusFrame::CAPACITY - _frame.size)) {
+        MOBIUS_LOGW("- Frame exceeds %u bytes", MobiusFrame::CAPACITY);
+        _done = true;
+        return Result::error;
+    }
+    memcpy(&_frame.data[_frame.size], data, length);
+    _frame.size += length;
+
+    if (0 < _frame.size && START_BYTE != _frame.data[0]) {
+        MOBIUS_LOGW("- Frame has invalid start byte 0x%02x", _frame.data[0]);
+        _done = true;
+        return Result::error;
+    }
+    if (0 == _expectedSize && HEADER_SIZE <= _frame.size) {
+        uint16_t dataSize = (_frame.data[8] << 8) + (_frame.data[7]);
+        _expectedSize = HEADER_SIZE + dataSize + CRC_SIZE;
+    }
+    if (0 < _expectedSize && _expectedSize < _frame.size) {
+        MOBIUS_LOGW("- Frame is longer than its length field (%u > %u)", _frame.size, _expectedSize);
+        _done = true;
+        return Result::error;
+    }
+    updateCrc();
+
+    if (!final) {
+        return Result::incomplete;
+    }
+    _done = true;
+    if (_expectedSize != _frame.size) {
+        MOBIUS_LOGW("- Frame is shorter than its length field (%u)", _frame.size);
+        return Result::error;
+    }
+    return Result::complete;
+}
+
+/*!
+ * @brief Set the longest time between two fragments of a frame.
+ *
+ * @param timeoutMillis fragment timeout (in milliseconds, default MOBIUS_FRAGMENT_TIMEOUT_MILLIS)
+ */
+void MobiusFrameAssembler::setFragmentTimeout(uint32_t timeoutMillis) {
+    _fragmentTimeoutMillis = timeoutMillis;
+}
+
+/*!
+ * @brief Get the assembled frame.
+ *
+ * @return the frame, only valid after a complete result
+ */
+const MobiusFrame& MobiusFrameAssembler::getFrame() const {
+    return _frame;
+}
+
+/*!
+ * @brief Check the CRC of the assembled frame.
+ *
+ * @return true if the trailing CRC matches the frame contents
+ */
+bool MobiusFrameAssembler::isCrcValid() const {
+    if (0 == _expectedSize || _expectedSize != _frame.size) {
+        return false;
+    }
+    uint16_t crc = MobiusCRC::final(_crc);
+    return (_frame.data[_frame.size - 2] == (uint8_t)crc) && (_frame.data[_frame.size - 1] == (uint8_t)(crc >> 8));
+}
+
+/*!
+ * Add the newly received bytes covered by the CRC.
+ */
+void MobiusFrameAssembler::updateCrc() {
+    // the CRC covers everything between the start byte and the CRC itself,
+    // until the header is complete only the header is known to be covered
+    uint16_t end = (0 < _expectedSize) ? (_expectedSize - CRC_SIZE) : HEADER_SIZE;
+    if (end > _frame.size) {
+        end = _frame.size;
+    }
+    if (end > _crcOffset) {
+        _crc = MobiusCRC::update(_crc, &_frame.data[_crcOffset], end - _crcOffset);
+        _crcOffset = end;
+    }
+}
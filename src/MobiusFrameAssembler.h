@@ -0,0 +1,105 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusFrameAssembler_h
+#define _MobiusFrameAssembler_h
+
+#include <cstdint>
+#include <cstddef>
+#include "MobiusFrame.h"
+
+/*!
+ * Longest time between two fragments of a frame (in milliseconds), after
+ * which a partially assembled frame is discarded.
+ */
+#ifndef MOBIUS_FRAGMENT_TIMEOUT_MILLIS
+#define MOBIUS_FRAGMENT_TIMEOUT_MILLIS 1000
+#endif
+
+/*!
+ * @brief Reassembles a Mobius response from its notification fragments.
+ * 
+ * Responses which do not fit in one notification are sent as fragments
+ * on RX_DATA followed by the last fragment on RX_FINAL. Fragments are
+ * appended into a fixed capacity MobiusFrame. The length field (bytes 7-8)
+ * is checked as soon as the header has arrived, and the CRC is computed
+ * incrementally over the bytes it covers.
+ * 
+ * A partial frame whose remaining fragments were lost is discarded when
+ * the start of the next frame arrives (0x02 followed by the confirm op
+ * group, in a fragment which can't continue the partial frame), or when
+ * no fragment arrived for the fragment timeout.
+ * 
+ * Not thread safe, each connection should have its own assembler.
+ */
+class MobiusFrameAssembler {
+public:
+    /*!
+     * @brief enum for the state after appending a fragment.
+     */
+    enum class Result { incomplete, // more fragments are expected
+                        complete,   // the frame is available from getFrame
+                        error       // the frame was malformed and discarded
+                        };
+
+    /*!
+     * @brief Discard any partially assembled frame.
+     */
+    void reset();
+
+    /*!
+     * @brief Append a fragment to the frame.
+     * 
+     * After a complete or error result the next fragment starts a new frame,
+     * as does a frame start or a late fragment while a frame is partial.
+     * 
+     * @param data fragment bytes
+     * @param length number of fragment bytes
+     * @param final true if the fragment was received on RX_FINAL
+     * @return Result of the frame so far
+     */
+    Result append(const uint8_t* data, size_t length, bool final);
+
+    /*!
+     * @brief Set the longest time between two fragments of a frame.
+     * 
+     * @param timeoutMillis fragment timeout (in milliseconds, default MOBIUS_FRAGMENT_TIMEOUT_MILLIS)
+     */
+    void setFragmentTimeout(uint32_t timeoutMillis);
+
+    /*!
+     * @brief Get the assembled frame.
+     * 
+     * @return the frame, only valid after a complete result
+     */
+    const MobiusFrame& getFrame() const;
+
+    /*!
+     * @brief Check the CRC of the assembled frame.
+     * 
+     * @return true if the trailing CRC matches the frame contents
+     */
+    bool isCrcValid() const;
+
+private:
+    static const uint16_t HEADER_SIZE = 9;
+    static const uint16_t CRC_SIZE = 2;
+    static const uint8_t START_BYTE = 0x02;
+    static const uint8_t CONFIRM_GROUP = 0xdf;
+
+    MobiusFrame _frame;
+    uint16_t _expectedSize = 0;
+    uint16_t _crcOffset = 1;
+    uint16_t _crc = 0xFFFF;
+    bool _done = false;
+    int64_t _lastFragmentMicros = 0;
+    uint32_t _fragmentTimeoutMillis = MOBIUS_FRAGMENT_TIMEOUT_MILLIS;
+
+    /*!
+     * Add the newly received bytes covered by the CRC.
+     */
+    void updateCrc();
+};
+
+#endif
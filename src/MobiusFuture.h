@@ -0,0 +1,137 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusFuture_h
+#define _MobiusFuture_h
+
+#include <cstdint>
+#include <cstddef>
+
+#include "MobiusFrame.h"
+
+class MobiusDevice;
+class MobiusCompletion;
+
+/*!
+ * @brief A request started by a MobiusExecutor.
+ *
+ * Holds the request and its progress until the response is received,
+ * the request fails or it is cancelled. Owned by the caller, and must
+ * not be moved or destroyed while pending.
+ */
+class MobiusOperation {
+public:
+    /*!
+     * @brief enum for the progress of an operation.
+     */
+    enum class State { idle,      // not started (or cancelled)
+                       queued,    // waiting for room in the device's window
+                       pending,   // written, waiting for the response
+                       successful,// completed successfully
+                       failed     // no (valid) response
+                       };
+
+    MobiusOperation() : _state(State::idle), _device(nullptr), _connection(0), _completion(nullptr),
+                        _deadlineMicros(0), _retransmissions(0), _attributeId(0), _valueWidth(0), _valueOffset(0) {}
+    virtual ~MobiusOperation() {}
+
+    /*!
+     * @brief Get the progress of the operation.
+     *
+     * @return a State
+     */
+    State getState() const { return _state; }
+
+    /*!
+     * @brief Check whether the operation has finished.
+     *
+     * @return true once successful or failed
+     */
+    bool isReady() const { return State::successful == _state || State::failed == _state; }
+
+    /*!
+     * @brief Check whether the operation finished successfully.
+     *
+     * @return true only if successful
+     */
+    bool isSuccessful() const { return State::successful == _state; }
+
+protected:
+    /*!
+     * Decode the value from the data of a GET confirm.
+     *
+     * @return true if the data held the value
+     */
+    virtual bool decode(const uint8_t* /*body*/, uint16_t /*bodySize*/) { return true; }
+
+private:
+    friend class MobiusDevice;
+    friend class MobiusExecutor;
+
+    State _state;
+    MobiusDevice* _device;
+    // the device connection the request was written to
+    uint32_t _connection;
+    MobiusCompletion* _completion;
+    MobiusFrame _request;
+    int64_t _deadlineMicros;
+    uint8_t _retransmissions;
+    // attribute cached once confirmed, its value is at _valueOffset
+    // in the GET confirm data or the SET request
+    uint16_t _attributeId;
+    uint8_t _valueWidth;
+    uint8_t _valueOffset;
+};
+
+/*!
+ * @brief The result of an attribute GET started by a MobiusExecutor.
+ *
+ *     MobiusFuture<uint16_t> scene;
+ *     executor.getCurrentScene(device, scene);
+ *     while (!scene.isReady()) {
+ *         executor.run(100);
+ *     }
+ *     if (scene.isSuccessful()) {
+ *         // use scene.getValue()
+ *     }
+ *
+ * @tparam T value type of the attribute
+ */
+template<typename T>
+class MobiusFuture : public MobiusOperation {
+public:
+    /*!
+     * Decodes the value from the data of a GET confirm, e.g. MobiusAttribute::parse.
+     */
+    typedef bool (*Parser)(const uint8_t* body, uint16_t bodySize, T& value);
+
+    MobiusFuture() : _parser(nullptr), _value() {}
+
+    /*!
+     * @brief Get the value read from the device.
+     *
+     * @return the value, only meaningful once successful
+     */
+    T getValue() const { return _value; }
+
+protected:
+    bool decode(const uint8_t* body, uint16_t bodySize) override {
+        return _parser && _parser(body, bodySize, _value);
+    }
+
+private:
+    friend class MobiusExecutor;
+
+    Parser _parser;
+    T _value;
+};
+
+/*!
+ * @brief The result of an attribute SET started by a MobiusExecutor.
+ */
+template<>
+class MobiusFuture<void> : public MobiusOperation {
+};
+
+#endif
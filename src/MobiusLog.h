@@ -0,0 +1,62 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusLog_h
+#define _MobiusLog_h
+
+/*!
+ * Logging for the library with the level chosen at compile time.
+ *
+ * Each MOBIUS_LOGx(format, ...) site is wrapped in a constant condition,
+ * so when its level is above MOBIUS_LOG_LEVEL neither the message nor its
+ * arguments (e.g. toString() calls) are evaluated and the compiler removes
+ * the site entirely. Enabled sites log through the matching ESP_LOGx macro.
+ *
+ * The including file must define LOG_TAG, as each library file already does.
+ */
+#define MOBIUS_LOG_LEVEL_NONE    0
+#define MOBIUS_LOG_LEVEL_ERROR   1
+#define MOBIUS_LOG_LEVEL_WARN    2
+#define MOBIUS_LOG_LEVEL_INFO    3
+#define MOBIUS_LOG_LEVEL_DEBUG   4
+#define MOBIUS_LOG_LEVEL_VERBOSE 5
+
+/*!
+ * Highest level logged by the library. Defaults to the Arduino core debug
+ * level, or to the ESP-IDF local level, when either is set.
+ */
+#ifndef MOBIUS_LOG_LEVEL
+#if defined(CORE_DEBUG_LEVEL)
+#define MOBIUS_LOG_LEVEL CORE_DEBUG_LEVEL
+#elif defined(LOG_LOCAL_LEVEL)
+#define MOBIUS_LOG_LEVEL LOG_LOCAL_LEVEL
+#else
+#define MOBIUS_LOG_LEVEL MOBIUS_LOG_LEVEL_WARN
+#endif
+#endif
+
+#define MOBIUS_LOG_AT(level, logMacro, ...) \
+    do { \
+        if ((int)(MOBIUS_LOG_LEVEL) >= (level)) { \
+            logMacro(LOG_TAG, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define MOBIUS_LOGE(...) MOBIUS_LOG_AT(MOBIUS_LOG_LEVEL_ERROR, ESP_LOGE, __VA_ARGS__)
+#define MOBIUS_LOGW(...) MOBIUS_LOG_AT(MOBIUS_LOG_LEVEL_WARN, ESP_LOGW, __VA_ARGS__)
+#define MOBIUS_LOGI(...) MOBIUS_LOG_AT(MOBIUS_LOG_LEVEL_INFO, ESP_LOGI, __VA_ARGS__)
+#define MOBIUS_LOGD(...) MOBIUS_LOG_AT(MOBIUS_LOG_LEVEL_DEBUG, ESP_LOGD, __VA_ARGS__)
+#define MOBIUS_LOGV(...) MOBIUS_LOG_AT(MOBIUS_LOG_LEVEL_VERBOSE, ESP_LOGV, __VA_ARGS__)
+
+/*!
+ * Hex dump 'length' bytes of 'buffer' at the DEBUG level.
+ */
+#define MOBIUS_LOG_HEXDUMP(buffer, length) \
+    do { \
+        if ((int)(MOBIUS_LOG_LEVEL) >= MOBIUS_LOG_LEVEL_DEBUG) { \
+            ESP_LOG_BUFFER_HEXDUMP(LOG_TAG, (buffer), (length), ESP_LOG_DEBUG); \
+        } \
+    } while (0)
+
+#endif
@@ -0,0 +1,274 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include "MobiusMetrics.h"
+
+MobiusMetrics::AtomicHistogram MobiusMetrics::_histograms[MobiusMetrics::PHASES];
+std::atomic<uint32_t> MobiusMetrics::_counters[MobiusMetrics::COUNTERS];
+
+/*
+ * Upper bound (in microseconds) of histogram bucket 'index'
+ */
+static uint32_t bucketLimit(uint8_t index) {
+    return (index < 32) ? (1UL << index) : UINT32_MAX;
+}
+
+/*
+ * Append formatted text at 'length' in 'buffer', truncating (but always
+ * terminating) when the buffer is full
+ */
+static void appendText(char* buffer, size_t size, size_t& length, const char* format, ...) {
+    if (length + 1 >= size) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(&buffer[length], size - length, format, args);
+    va_end(args);
+    if (0 < written) {
+        length += ((size_t)written < size - length) ? (size_t)written : size - length - 1;
+    }
+}
+
+/*!
+ * @brief Get the duration below which the given 'percent' of samples fall.
+ *
+ * @return upper bound of the bucket (in microseconds), 0 if empty
+ */
+uint32_t MobiusMetrics::Histogram::getPercentileMicros(uint8_t percent) const {
+    if (0 == count) {
+        return 0;
+    }
+    // samples needed to reach the percentile, rounded up
+    uint64_t target = ((uint64_t)count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (uint8_t i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target && 0 < seen) {
+            // the last bucket is open ended
+            return (BUCKETS - 1 == i) ? maxMicros : bucketLimit(i);
+        }
+    }
+    return maxMicros;
+}
+
+/*!
+ * @brief Get the mean duration.
+ *
+ * @return mean (in microseconds), 0 if empty
+ */
+uint32_t MobiusMetrics::Histogram::getMeanMicros() const {
+    if (0 == count) {
+        return 0;
+    }
+    if (totalMicros < UINT32_MAX) {
+        return totalMicros / count;
+    }
+    // a bucket's durations are taken as the middle of its range (3/4 of its upper bound)
+    uint64_t estimate = 0;
+    for (uint8_t i = 1; i < BUCKETS - 1; i++) {
+        estimate += (uint64_t)buckets[i] * (bucketLimit(i) - (bucketLimit(i) >> 2));
+    }
+    estimate += (uint64_t)buckets[BUCKETS - 1] * maxMicros;
+    return (uint32_t)(estimate / count);
+}
+
+/*!
+ * @brief Record a phase which started at 'startMicros' and ends now.
+ *
+ * @param phase MobiusPhase
+ * @param startMicros time returned by now when the phase started
+ */
+void MobiusMetrics::record(MobiusPhase phase, int64_t startMicros) {
+#if MOBIUS_METRICS_ENABLED
+    int64_t duration = now() - startMicros;
+    recordDuration(phase, (duration > UINT32_MAX) ? UINT32_MAX : (uint32_t)duration);
+#else
+    (void)phase;
+    (void)startMicros;
+#endif
+}
+
+/*!
+ * @brief Record a phase of the given duration.
+ *
+ * @param phase MobiusPhase
+ * @param durationMicros duration (in microseconds)
+ */
+void MobiusMetrics::recordDuration(MobiusPhase phase, uint32_t durationMicros) {
+#if MOBIUS_METRICS_ENABLED
+    if (PHASES <= (uint8_t)phase) {
+        return;
+    }
+    AtomicHistogram& histogram = _histograms[(uint8_t)phase];
+    // the bucket is the number of significant bits, capped at the last bucket
+    uint8_t bucket = 0;
+    for (uint32_t remaining = durationMicros; 0 < remaining && bucket < BUCKETS - 1; remaining >>= 1) {
+        bucket++;
+    }
+    histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    // a 64-bit atomic needs a lock on 32-bit targets, so the total saturates instead
+    uint32_t total = histogram.totalMicros.load(std::memory_order_relaxed);
+    uint32_t sum;
+    do {
+        sum = (UINT32_MAX - total > durationMicros) ? total + durationMicros : UINT32_MAX;
+    } while (total != sum && !histogram.totalMicros.compare_exchange_weak(total, sum, std::memory_order_relaxed));
+    uint32_t max = histogram.maxMicros.load(std::memory_order_relaxed);
+    while (max < durationMicros && !histogram.maxMicros.compare_exchange_weak(max, durationMicros, std::memory_order_relaxed)) {
+        // 'max' was reloaded, try again while still larger
+    }
+#else
+    (void)phase;
+    (void)durationMicros;
+#endif
+}
+
+/*!
+ * @brief Increment a counter.
+ *
+ * @param counter MobiusCounter
+ */
+void MobiusMetrics::increment(MobiusCounter counter) {
+#if MOBIUS_METRICS_ENABLED
+    if ((uint8_t)counter < COUNTERS) {
+        _counters[(uint8_t)counter].fetch_add(1, std::memory_order_relaxed);
+    }
+#else
+    (void)counter;
+#endif
+}
+
+/*!
+ * @brief Get a copy of the histogram of a phase.
+ *
+ * @param phase MobiusPhase
+ * @return a Histogram
+ */
+MobiusMetrics::Histogram MobiusMetrics::getHistogram(MobiusPhase phase) {
+    Histogram copy = {};
+    if ((uint8_t)phase < PHASES) {
+        AtomicHistogram& histogram = _histograms[(uint8_t)phase];
+        copy.count = histogram.count.load(std::memory_order_relaxed);
+        copy.totalMicros = histogram.totalMicros.load(std::memory_order_relaxed);
+        copy.maxMicros = histogram.maxMicros.load(std::memory_order_relaxed);
+        for (uint8_t i = 0; i < BUCKETS; i++) {
+            copy.buckets[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    return copy;
+}
+
+/*!
+ * @brief Get the value of a counter.
+ *
+ * @param counter MobiusCounter
+ * @return a uint32_t
+ */
+uint32_t MobiusMetrics::getCount(MobiusCounter counter) {
+    return ((uint8_t)counter < COUNTERS) ? _counters[(uint8_t)counter].load(std::memory_order_relaxed) : 0;
+}
+
+/*!
+ * @brief Write all histograms and counters as text.
+ *
+ * @param buffer receives the text (always terminated)
+ * @param size size of the buffer
+ * @return length of the text, truncated if the buffer was too small
+ */
+size_t MobiusMetrics::snapshot(char* buffer, size_t size) {
+    if (0 == size) {
+        return 0;
+    }
+    size_t length = 0;
+    buffer[0] = '\0';
+    for (uint8_t p = 0; p < PHASES; p++) {
+        Histogram histogram = getHistogram((MobiusPhase)p);
+        appendText(buffer, size, length, "%s n=%u mean=%u p50=%u p99=%u max=%u", getPhaseName((MobiusPhase)p),
+                   (unsigned)histogram.count, (unsigned)histogram.getMeanMicros(), (unsigned)histogram.getPercentileMicros(50),
+                   (unsigned)histogram.getPercentileMicros(99), (unsigned)histogram.maxMicros);
+        for (uint8_t i = 0; i < BUCKETS - 1; i++) {
+            if (histogram.buckets[i]) {
+                appendText(buffer, size, length, " %u:%u", (unsigned)bucketLimit(i), (unsigned)histogram.buckets[i]);
+            }
+        }
+        if (histogram.buckets[BUCKETS - 1]) {
+            appendText(buffer, size, length, " inf:%u", (unsigned)histogram.buckets[BUCKETS - 1]);
+        }
+        appendText(buffer, size, length, "\n");
+    }
+    for (uint8_t c = 0; c < COUNTERS; c++) {
+        appendText(buffer, size, length, "%s=%u%s", getCounterName((MobiusCounter)c), (unsigned)getCount((MobiusCounter)c),
+                   (COUNTERS - 1 == c) ? "\n" : " ");
+    }
+    return length;
+}
+
+/*!
+ * @brief Clear all histograms and counters.
+ */
+void MobiusMetrics::reset() {
+    for (uint8_t p = 0; p < PHASES; p++) {
+        AtomicHistogram& histogram = _histograms[p];
+        histogram.count.store(0, std::memory_order_relaxed);
+        histogram.totalMicros.store(0, std::memory_order_relaxed);
+        histogram.maxMicros.store(0, std::memory_order_relaxed);
+        for (uint8_t i = 0; i < BUCKETS; i++) {
+            histogram.buckets[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    for (uint8_t c = 0; c < COUNTERS; c++) {
+        _counters[c].store(0, std::memory_order_relaxed);
+    }
+}
+
+/*!
+ * @brief Get the name of a phase.
+ *
+ * @return a C string
+ */
+const char* MobiusMetrics::getPhaseName(MobiusPhase phase) {
+    switch (phase) {
+        case MobiusPhase::connect:
+            return "connect";
+        case MobiusPhase::discovery:
+            return "discovery";
+        case MobiusPhase::subscribe:
+            return "subscribe";
+        case MobiusPhase::write:
+            return "write";
+        case MobiusPhase::response:
+            return "response";
+        case MobiusPhase::queue_wait:
+            return "queue_wait";
+        default:
+            return "unknown";
+    }
+}
+
+/*!
+ * @brief Get the name of a counter.
+ *
+ * @return a C string
+ */
+const char* MobiusMetrics::getCounterName(MobiusCounter counter) {
+    switch (counter) {
+        case MobiusCounter::timeouts:
+            return "timeouts";
+        case MobiusCounter::verification_failures:
+            return "verification_failures";
+        case MobiusCounter::retries:
+            return "retries";
+        case MobiusCounter::coalesced:
+            return "coalesced";
+        case MobiusCounter::deduplicated:
+            return "deduplicated";
+        case MobiusCounter::dropped:
+            return "dropped";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,189 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusMetrics_h
+#define _MobiusMetrics_h
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <esp_timer.h>
+
+/*!
+ * Set to 0 to compile out all metrics recording.
+ */
+#ifndef MOBIUS_METRICS_ENABLED
+#define MOBIUS_METRICS_ENABLED 1
+#endif
+
+/*!
+ * @brief enum for the timed phases of MobiusDevice operations.
+ */
+enum class MobiusPhase { connect,   // BLE client connect
+                         discovery, // finding the Mobius service
+                         subscribe, // finding the characteristics and enabling notifications
+                         write,     // writing a request
+                         response,  // waiting for the response notification
+                         queue_wait,// a command waiting in a MobiusCommandQueue
+                         count      // number of phases (not a phase)
+                         };
+
+/*!
+ * @brief enum for the counted MobiusDevice occurrences.
+ */
+enum class MobiusCounter { timeouts,              // no free request slot or no response in time
+                           verification_failures, // a response did not indicate success
+                           retries,               // an operation was attempted again
+                           coalesced,             // a queued SET was replaced by a newer one
+                           deduplicated,          // a GET was merged into a queued one
+                           dropped,               // a command was dropped from a full queue
+                           count                  // number of counters (not a counter)
+                           };
+
+/*!
+ * @brief Latency histograms and counters for MobiusDevice operations.
+ * 
+ * Each phase is recorded into a histogram of power of 2 microsecond
+ * buckets (bucket i counts durations below 2^i us, the last bucket
+ * everything from 2^23 us, about 8.4 s). Recording is a few relaxed 32-bit atomic updates, so
+ * metrics may be left on in production; define MOBIUS_METRICS_ENABLED
+ * as 0 to remove them completely.
+ */
+class MobiusMetrics {
+public:
+    static const uint8_t BUCKETS = 25;
+
+    /*!
+     * @brief Copy of the histogram of a phase.
+     */
+    struct Histogram {
+        uint32_t count;
+        uint32_t totalMicros; // sum of all durations, stays at UINT32_MAX once reached
+        uint32_t maxMicros;
+        uint32_t buckets[BUCKETS];
+
+        /*!
+         * @brief Get the mean duration.
+         * 
+         * Estimated from the buckets once the total has saturated.
+         * 
+         * @return mean (in microseconds), 0 if empty
+         */
+        uint32_t getMeanMicros() const;
+
+        /*!
+         * @brief Get the duration below which the given 'percent' of samples fall.
+         * 
+         * @return upper bound of the bucket (in microseconds), 0 if empty
+         */
+        uint32_t getPercentileMicros(uint8_t percent) const;
+    };
+
+    /*!
+     * @brief Get the current time to pass to record.
+     * 
+     * Always 0 when MOBIUS_METRICS_ENABLED is 0, so timing a phase
+     * costs nothing.
+     * 
+     * @return time (in microseconds)
+     */
+    static int64_t now() {
+#if MOBIUS_METRICS_ENABLED
+        return esp_timer_get_time();
+#else
+        return 0;
+#endif
+    }
+
+    /*!
+     * @brief Record a phase which started at 'startMicros' and ends now.
+     * 
+     * @param phase MobiusPhase
+     * @param startMicros time returned by now when the phase started
+     */
+    static void record(MobiusPhase phase, int64_t startMicros);
+
+    /*!
+     * @brief Record a phase of the given duration.
+     * 
+     * @param phase MobiusPhase
+     * @param durationMicros duration (in microseconds)
+     */
+    static void recordDuration(MobiusPhase phase, uint32_t durationMicros);
+
+    /*!
+     * @brief Increment a counter.
+     * 
+     * @param counter MobiusCounter
+     */
+    static void increment(MobiusCounter counter);
+
+    /*!
+     * @brief Get a copy of the histogram of a phase.
+     * 
+     * @param phase MobiusPhase
+     * @return a Histogram
+     */
+    static Histogram getHistogram(MobiusPhase phase);
+
+    /*!
+     * @brief Get the value of a counter.
+     * 
+     * @param counter MobiusCounter
+     * @return a uint32_t
+     */
+    static uint32_t getCount(MobiusCounter counter);
+
+    /*!
+     * @brief Write all histograms and counters as text.
+     * 
+     * One line per phase with its count, mean, p50, p99, max and the
+     * non-empty buckets (as upper bound in us:count, inf for the last
+     * bucket), all in microseconds, then one line of
+     * counters, e.g.
+     * 
+     *     write n=12 mean=2210 p50=2048 p99=4096 max=3100 2048:11 4096:1
+     *     timeouts=0 verification_failures=1 retries=2 coalesced=0 deduplicated=0 dropped=0
+     * 
+     * @param buffer receives the text (always terminated)
+     * @param size size of the buffer
+     * @return length of the text, truncated if the buffer was too small
+     */
+    static size_t snapshot(char* buffer, size_t size);
+
+    /*!
+     * @brief Clear all histograms and counters.
+     */
+    static void reset();
+
+    /*!
+     * @brief Get the name of a phase.
+     * 
+     * @return a C string
+     */
+    static const char* getPhaseName(MobiusPhase phase);
+
+    /*!
+     * @brief Get the name of a counter.
+     * 
+     * @return a C string
+     */
+    static const char* getCounterName(MobiusCounter counter);
+
+private:
+    static const uint8_t PHASES = (uint8_t)MobiusPhase::count;
+    static const uint8_t COUNTERS = (uint8_t)MobiusCounter::count;
+
+    struct AtomicHistogram {
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> totalMicros;
+        std::atomic<uint32_t> maxMicros;
+        std::atomic<uint32_t> buckets[BUCKETS];
+    };
+
+    static AtomicHistogram _histograms[PHASES];
+    static std::atomic<uint32_t> _counters[COUNTERS];
+};
+
+#endif
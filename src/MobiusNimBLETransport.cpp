@@ -0,0 +1,383 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include "MobiusNimBLETransport.h"
+#include "MobiusDevice.h"
+#include "MobiusMetrics.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include <esp32-hal-log.h>
+#define LOG_TAG ""
+#else
+#include <esp_log.h>
+static const char* LOG_TAG = "MobiusNimBLETransport";
+#endif
+#include "MobiusLog.h"
+
+// initialize static variables
+bool MobiusNimBLETransport::_handleCacheEnabled = true;
+MobiusNimBLETransport::Route MobiusNimBLETransport::_routes[MOBIUS_MAX_SESSIONS];
+std::mutex MobiusNimBLETransport::_routesMutex;
+
+/*!
+ * @brief Enable or disable caching of discovered attributes.
+ *
+ * @param enabled true to keep clients (and their attributes) between connections
+ */
+void MobiusNimBLETransport::setHandleCacheEnabled(bool enabled) {
+    MobiusNimBLETransport::_handleCacheEnabled = enabled;
+}
+
+/*!
+ * Default constructor, for no device.
+ */
+MobiusNimBLETransport::MobiusNimBLETransport() : MobiusNimBLETransport(MobiusDeviceHandle()) {}
+
+/*!
+ * Main constructor.
+ *
+ * @param handle MobiusDeviceHandle of the device to connect to
+ */
+MobiusNimBLETransport::MobiusNimBLETransport(const MobiusDeviceHandle& handle) {
+    _handle = handle;
+    _client = nullptr;
+    _requestCharacteristic   = nullptr;//TX_FINAL
+    _responseCharacteristic1 = nullptr;//RX_DATA
+    _responseCharacteristic2 = nullptr;//RX_FINAL
+}
+
+/*!
+ * Constructor for a device with a known address, connected without
+ * waiting for an advertisement.
+ *
+ * @param address BLEAddress (including its type) of the device
+ */
+MobiusNimBLETransport::MobiusNimBLETransport(const BLEAddress& address) : MobiusNimBLETransport(MobiusDeviceHandle(address)) {}
+
+/*!
+ * Copy constructor, for the same device but not connected.
+ */
+MobiusNimBLETransport::MobiusNimBLETransport(const MobiusNimBLETransport& other) : MobiusNimBLETransport(other._handle) {}
+
+/*!
+ * Move constructor, taking over the connection of 'other'.
+ */
+MobiusNimBLETransport::MobiusNimBLETransport(MobiusNimBLETransport&& other) : MobiusNimBLETransport(other._handle) {
+    takeConnection(other);
+}
+
+/*!
+ * Destructor, disconnects from the device.
+ */
+MobiusNimBLETransport::~MobiusNimBLETransport() {
+    disconnect();
+}
+
+/*!
+ * Copy assignment, disconnects first and is then not connected.
+ */
+MobiusNimBLETransport& MobiusNimBLETransport::operator=(const MobiusNimBLETransport& other) {
+    if (this != &other) {
+        disconnect();
+        _handle = other._handle;
+    }
+    return *this;
+}
+
+/*!
+ * Move assignment, disconnects first and takes over the connection of 'other'.
+ */
+MobiusNimBLETransport& MobiusNimBLETransport::operator=(MobiusNimBLETransport&& other) {
+    if (this != &other) {
+        disconnect();
+        _handle = other._handle;
+        takeConnection(other);
+    }
+    return *this;
+}
+
+/*!
+ * @brief Get the device to connect to.
+ *
+ * @return the MobiusDeviceHandle, only valid if hasPeerAddress
+ */
+const MobiusDeviceHandle& MobiusNimBLETransport::getHandle() const {
+    return _handle;
+}
+
+/*!
+ * @brief Get the BLE address (and type) of the device.
+ *
+ * @return the BLEAddress, only meaningful if hasPeerAddress
+ */
+BLEAddress MobiusNimBLETransport::getPeerAddress() const {
+    return _handle.toAddress();
+}
+
+/*!
+ * @brief Check whether the transport has a device to connect to.
+ *
+ * @return true if constructed with a device or address
+ */
+bool MobiusNimBLETransport::hasPeerAddress() const {
+    return _handle.isValid();
+}
+
+/*!
+ * @brief Connect to the device.
+ *
+ * Connect to the device's address (advertised or known) and verify it
+ * has the required BLE characteristics.
+ *
+ * @param receiver Receiver for the response fragments until disconnected
+ * @return true only if the link is ready for requests
+ */
+bool MobiusNimBLETransport::connect(Receiver* receiver) {
+    if (!hasPeerAddress()) {
+        return false;
+    }
+    const BLEAddress address = getPeerAddress();
+    // a previous client for this address still holds the discovered attributes
+    BLEClient* client = nullptr;
+    if (MobiusNimBLETransport::_handleCacheEnabled) {
+        client = BLEDevice::getClientByPeerAddress(address);
+    }
+    bool cached = (nullptr != client);
+    if (!cached) {
+        client = BLEDevice::createClient();
+    }
+    if (nullptr == client) {
+        // all clients are in use, so reuse one whose device is not connected
+        client = BLEDevice::getDisconnectedClient();
+    }
+    if (nullptr == client) {
+        MOBIUS_LOGW("- No client available for %s", address.toString().c_str());
+        return false;
+    }
+    MOBIUS_LOGD("- Connecting to %s (cached:%s)", address.toString().c_str(), (cached ? "true" : "false"));
+    // route notifications before subscribing so none are missed
+    addRoute(client, receiver);
+    // keep the attributes when cached so discovery is skipped
+    int64_t phaseStart = MobiusMetrics::now();
+    // the address carries its type, so no advertisement is needed
+    client->connect(address, !cached);
+    MobiusMetrics::record(MobiusPhase::connect, phaseStart);
+
+    BLERemoteService* remoteService = discoverService(client);
+    bool ready = remoteService && connectToCharacteristics(remoteService);
+    if (!ready && cached && client->isConnected()) {
+        // the cached attributes failed, fall back to full discovery
+        MOBIUS_LOGD("- Cached attributes failed, discovering %s", address.toString().c_str());
+        MobiusMetrics::increment(MobiusCounter::retries);
+        client->deleteServices();
+        remoteService = discoverService(client);
+        ready = remoteService && connectToCharacteristics(remoteService);
+    }
+
+    if (nullptr == remoteService) {
+        MOBIUS_LOGW("- Failed to find service on %s", address.toString().c_str());
+    } else if (!ready) {
+        MOBIUS_LOGW("- Failed to connect to characteristics");
+    }
+    if (ready) {
+        // connected to the device with general service
+        _client = client;
+        MOBIUS_LOGD("- Connected successfully to %s", address.toString().c_str());
+    } else {
+        removeRoute(client);
+        client->disconnect();
+        NimBLEDevice::deleteClient(client);
+    }
+    return ready;
+}
+
+/*!
+ * @brief Disconnect from the device.
+ */
+void MobiusNimBLETransport::disconnect() {
+    if (_client) {
+        MOBIUS_LOGD("- Disconnecting from client");
+        removeRoute(_client);
+        _client->disconnect();
+        if (!MobiusNimBLETransport::_handleCacheEnabled) {
+            // destroying a client destroys the services
+            // and destroying a service destroys the characteristics
+            NimBLEDevice::deleteClient(_client);
+        }
+        // otherwise the client (and attributes) is kept for the next connect
+        _client = nullptr;
+        _requestCharacteristic = nullptr;
+        _responseCharacteristic1 = nullptr;
+        _responseCharacteristic2 = nullptr;
+    }
+}
+
+/*!
+ * @brief Check the link to the device.
+ *
+ * @return true only if connected and the link is still up
+ */
+bool MobiusNimBLETransport::isConnected() {
+    return _client && _client->isConnected();
+}
+
+/*!
+ * @brief Write a request to the request characteristic.
+ *
+ * @param data request bytes
+ * @param length number of request bytes
+ * @return true only if the request was sent
+ */
+bool MobiusNimBLETransport::write(const uint8_t* data, size_t length) {
+    return _requestCharacteristic && _requestCharacteristic->writeValue(data, length);
+}
+
+/*!
+ * @brief Get the address of the device.
+ *
+ * @return the 6 address bytes, or nullptr without a device
+ */
+const uint8_t* MobiusNimBLETransport::getAddress() const {
+    return hasPeerAddress() ? _handle.address : nullptr;
+}
+
+/*!
+ * Take over the client (and characteristics) of 'other', which is left not connected.
+ * The route of the client is kept, it leads to the same receiver.
+ */
+void MobiusNimBLETransport::takeConnection(MobiusNimBLETransport& other) {
+    _client = other._client;
+    _requestCharacteristic = other._requestCharacteristic;
+    _responseCharacteristic1 = other._responseCharacteristic1;
+    _responseCharacteristic2 = other._responseCharacteristic2;
+    other._client = nullptr;
+    other._requestCharacteristic = nullptr;
+    other._responseCharacteristic1 = nullptr;
+    other._responseCharacteristic2 = nullptr;
+}
+
+/*!
+ * Route notifications from the 'client' to the 'receiver'.
+ */
+void MobiusNimBLETransport::addRoute(BLEClient* client, Receiver* receiver) {
+    std::lock_guard<std::mutex> lock(_routesMutex);
+    Route* route = nullptr;
+    for (uint8_t i = 0; i < MOBIUS_MAX_SESSIONS; i++) {
+        if (client == _routes[i].client) {
+            route = &_routes[i];
+            break;
+        } else if (!route && nullptr == _routes[i].client) {
+            route = &_routes[i];
+        }
+    }
+    if (nullptr == route) {
+        MOBIUS_LOGW("- No room to route the notifications");
+        return;
+    }
+    route->client = client;
+    route->receiver = receiver;
+}
+
+/*!
+ * Stop routing notifications from the 'client'.
+ */
+void MobiusNimBLETransport::removeRoute(BLEClient* client) {
+    std::lock_guard<std::mutex> lock(_routesMutex);
+    for (uint8_t i = 0; i < MOBIUS_MAX_SESSIONS; i++) {
+        if (client == _routes[i].client) {
+            _routes[i] = Route();
+        }
+    }
+}
+
+/*!
+ * Receives notify messages from devices and hands them to the receiver of the
+ * characteristic's client. Fragments from 'RESPONSE_CHARACTERISTIC_1' are on the
+ * data channel and the fragment from 'RESPONSE_CHARACTERISTIC_2' on the final channel.
+ */
+void MobiusNimBLETransport::notifyCallback(BLERemoteCharacteristic* responseCharacteristic, uint8_t* pData, size_t length, bool /*isNotify*/) {
+    BLEClient* client = responseCharacteristic->getRemoteService()->getClient();
+    BLEUUID uuid = responseCharacteristic->getUUID();
+    MOBIUS_LOGD("- Received response from characteristic %s", uuid.toString().c_str());
+
+    MOBIUS_LOG_HEXDUMP(pData, length);
+    bool final = uuid.equals(Mobius::RESPONSE_CHARACTERISTIC_2);
+    if (!final && !uuid.equals(Mobius::RESPONSE_CHARACTERISTIC_1)) {
+        MOBIUS_LOGW("- Received unexpected response on %s", uuid.toString().c_str());
+        return;
+    }
+    // hold the lock so the receiver can't be deleted while receiving
+    std::lock_guard<std::mutex> lock(_routesMutex);
+    Receiver* receiver = nullptr;
+    for (uint8_t i = 0; !receiver && i < MOBIUS_MAX_SESSIONS; i++) {
+        if (client == _routes[i].client) {
+            receiver = _routes[i].receiver;
+        }
+    }
+    if (!receiver) {
+        MOBIUS_LOGW("- Received response with no matching receiver");
+        return;
+    }
+    receiver->onReceive(final ? Channel::final : Channel::data, pData, length);
+}
+
+/*!
+ * Find the GENERAL_SERVICE on the connected 'client'.
+ *
+ * @return the service, or nullptr if not found
+ */
+BLERemoteService* MobiusNimBLETransport::discoverService(BLEClient* client) {
+    int64_t phaseStart = MobiusMetrics::now();
+    BLERemoteService* service = client->getService(Mobius::GENERAL_SERVICE);
+    MobiusMetrics::record(MobiusPhase::discovery, phaseStart);
+    return service;
+}
+
+/*!
+ * @brief Connect to relevant characteristics
+ *
+ * Connect to the relevant characteristics on the given BLE service for sending
+ * and receiving messages.
+ * - REQUEST_CHARACTERISTIC must be found and writable
+ * - RESPONSE_CHARACTERISTIC_1 must be found and subscribed to
+ * - RESPONSE_CHARACTERISTIC_2 must be found and subscribed to
+ *
+ * @return true only if all the required characteristics are connected/ready
+ */
+bool MobiusNimBLETransport::connectToCharacteristics(BLERemoteService* service) {
+    int64_t phaseStart = MobiusMetrics::now();
+    // setup the request characteristic
+    _requestCharacteristic = service->getCharacteristic(Mobius::REQUEST_CHARACTERISTIC);
+    bool hasRequestChar = _requestCharacteristic && _requestCharacteristic->canWriteNoResponse();
+    MOBIUS_LOGD("- hasRequestChar:%s", (hasRequestChar ? "true" : "false"));
+    // setup the first response characteristic (the one which is used)
+    _responseCharacteristic1 = service->getCharacteristic(Mobius::RESPONSE_CHARACTERISTIC_1);
+    bool hasResponseChar1 = _responseCharacteristic1 && _responseCharacteristic1->canNotify();
+    MOBIUS_LOGD("- hasResponseChar1:%s", (hasResponseChar1 ? "true" : "false"));
+    if (hasResponseChar1) {
+        // setup the notify callback so full responses can be read
+        _responseCharacteristic1->registerForNotify(notifyCallback);
+        //addressing issue in BLERemoteCharacteristic (missing response true)
+        // similar to https://github.com/nkolban/esp32-snippets/issues/397
+        uint8_t notificationOn[]={0x01, 0x00};
+        BLERemoteDescriptor* descriptor = _responseCharacteristic1->getDescriptor(BLEUUID((uint16_t)0x2902));
+        hasResponseChar1 = descriptor && descriptor->writeValue(notificationOn, 2, true);
+    }
+    // setup the second response characteristic
+    _responseCharacteristic2 = service->getCharacteristic(Mobius::RESPONSE_CHARACTERISTIC_2);
+    bool hasResponseChar2 = _responseCharacteristic2 && _responseCharacteristic2->canNotify();
+    MOBIUS_LOGD("- hasResponseChar2:%s", (hasResponseChar2 ? "true" : "false"));
+    if (hasResponseChar2) {
+        // setup the notify callback so full responses can be read
+        _responseCharacteristic2->registerForNotify(notifyCallback);
+        //addressing issue in BLERemoteCharacteristic (missing response true)
+        // similar to https://github.com/nkolban/esp32-snippets/issues/397
+        uint8_t notificationOn[]={0x01, 0x00};
+        BLERemoteDescriptor* descriptor = _responseCharacteristic2->getDescriptor(BLEUUID((uint16_t)0x2902));
+        hasResponseChar2 = descriptor && descriptor->writeValue(notificationOn, 2, true);
+    }
+    MobiusMetrics::record(MobiusPhase::subscribe, phaseStart);
+
+    return hasRequestChar && hasResponseChar1 && hasResponseChar2;
+}
@@ -0,0 +1,182 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusNimBLETransport_h
+#define _MobiusNimBLETransport_h
+
+#include <cstdint>
+#include <mutex>
+#include <NimBLEDevice.h>
+
+#include "MobiusTransport.h"
+#include "MobiusDeviceHandle.h"
+
+#ifdef CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#define MOBIUS_MAX_SESSIONS CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#else
+#define MOBIUS_MAX_SESSIONS 3
+#endif
+
+/*!
+ * @brief MobiusTransport carried over BLE by NimBLE.
+ *
+ * Connects to the device's address, finds the GENERAL_SERVICE and its
+ * characteristics, writes requests to REQUEST_CHARACTERISTIC and routes
+ * the notifications of both response characteristics to the Receiver.
+ *
+ * Only the device's MobiusDeviceHandle is kept, not its advertisement.
+ * The client (and its characteristics) belongs to one transport, so a
+ * copy refers to the same device without being connected, while a move
+ * takes over the connection. The transport disconnects when destroyed.
+ */
+class MobiusNimBLETransport : public MobiusTransport {
+public:
+    /*!
+     * @brief Enable or disable caching of discovered attributes.
+     *
+     * When enabled (the default) the BLE client of a disconnected device
+     * is kept along with its discovered service, characteristics and
+     * descriptors. Reconnecting to the same address then skips discovery
+     * and only subscribes, falling back to full discovery if the cached
+     * attributes fail. Idle clients are reused for other devices when no
+     * new client is available.
+     *
+     * @param enabled true to keep clients (and their attributes) between connections
+     */
+    static void setHandleCacheEnabled(bool enabled);
+
+    /*!
+     * Default constructor, for no device.
+     */
+    MobiusNimBLETransport();
+
+    /*!
+     * Main constructor.
+     *
+     * @param handle MobiusDeviceHandle of the device to connect to
+     */
+    MobiusNimBLETransport(const MobiusDeviceHandle& handle);
+
+    /*!
+     * Constructor for a device with a known address, connected without
+     * waiting for an advertisement.
+     *
+     * @param address BLEAddress (including its type) of the device
+     */
+    MobiusNimBLETransport(const BLEAddress& address);
+
+    /*!
+     * Copy constructor, for the same device but not connected.
+     */
+    MobiusNimBLETransport(const MobiusNimBLETransport& other);
+
+    /*!
+     * Move constructor, taking over the connection of 'other'.
+     */
+    MobiusNimBLETransport(MobiusNimBLETransport&& other);
+
+    /*!
+     * Destructor, disconnects from the device.
+     */
+    ~MobiusNimBLETransport();
+
+    /*!
+     * Copy assignment, disconnects first and is then not connected.
+     */
+    MobiusNimBLETransport& operator=(const MobiusNimBLETransport& other);
+
+    /*!
+     * Move assignment, disconnects first and takes over the connection of 'other'.
+     */
+    MobiusNimBLETransport& operator=(MobiusNimBLETransport&& other);
+
+    /*!
+     * @brief Get the device to connect to.
+     *
+     * @return the MobiusDeviceHandle, only valid if hasPeerAddress
+     */
+    const MobiusDeviceHandle& getHandle() const;
+
+    /*!
+     * @brief Get the BLE address (and type) of the device.
+     *
+     * @return the BLEAddress, only meaningful if hasPeerAddress
+     */
+    BLEAddress getPeerAddress() const;
+
+    /*!
+     * @brief Check whether the transport has a device to connect to.
+     *
+     * @return true if constructed with a device or address
+     */
+    bool hasPeerAddress() const;
+
+    bool connect(Receiver* receiver) override;
+    void disconnect() override;
+    bool isConnected() override;
+    bool write(const uint8_t* data, size_t length) override;
+    const uint8_t* getAddress() const override;
+
+private:
+    static bool _handleCacheEnabled;
+
+    /*!
+     * Receivers of the connected clients, used to route notifications.
+     */
+    struct Route {
+        BLEClient* client = nullptr;
+        Receiver* receiver = nullptr;
+    };
+    static Route _routes[MOBIUS_MAX_SESSIONS];
+    static std::mutex _routesMutex;
+
+    /*!
+     * Route notifications from the 'client' to the 'receiver'.
+     */
+    static void addRoute(BLEClient* client, Receiver* receiver);
+
+    /*!
+     * Stop routing notifications from the 'client'.
+     */
+    static void removeRoute(BLEClient* client);
+
+    /*!
+     * Receives notify messages from devices and hands them to the receiver
+     * of the characteristic's client.
+     */
+    static void notifyCallback(BLERemoteCharacteristic* responseCharacteristic, uint8_t* pData, size_t length, bool isNotify);
+
+    MobiusDeviceHandle _handle;
+    BLEClient* _client;
+    BLERemoteCharacteristic* _requestCharacteristic;  //TX_FINAL
+    BLERemoteCharacteristic* _responseCharacteristic1;//RX_DATA
+    BLERemoteCharacteristic* _responseCharacteristic2;//RX_FINAL
+
+    /*!
+     * Take over the client (and characteristics) of 'other', which is left not connected.
+     */
+    void takeConnection(MobiusNimBLETransport& other);
+
+    /*!
+     * Find the GENERAL_SERVICE on the connected 'client'.
+     *
+     * @return the service, or nullptr if not found
+     */
+    BLERemoteService* discoverService(BLEClient* client);
+
+    /*!
+     * @brief Connect to relevant characteristics
+     *
+     * Connect to the relevant characteristics on the given BLE service for sending
+     * and receiving messages.
+     * - REQUEST_CHARACTERISTIC must be found and writable
+     * - RESPONSE_CHARACTERISTIC_1 must be found and subscribed to
+     * - RESPONSE_CHARACTERISTIC_2 must be found and subscribed to
+     *
+     * @return true only if all the required characteristics are connected/ready
+     */
+    bool connectToCharacteristics(BLERemoteService* service);
+};
+
+#endif
@@ -0,0 +1,173 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <cstring>
+#include "MobiusPresenceRegistry.h"
+
+/*!
+ * @brief Get the most recent RSSI reading.
+ */
+int8_t MobiusPresenceRegistry::Entry::getLastRssi() const {
+    if (0 == rssiCount) {
+        return RSSI_UNKNOWN;
+    }
+    return rssi[(rssiIndex + MOBIUS_RSSI_HISTORY - 1) % MOBIUS_RSSI_HISTORY];
+}
+
+/*!
+ * @brief Get the average of the RSSI readings.
+ */
+int8_t MobiusPresenceRegistry::Entry::getAverageRssi() const {
+    if (0 == rssiCount) {
+        return RSSI_UNKNOWN;
+    }
+    int sum = 0;
+    for (uint8_t i = 0; i < rssiCount; i++) {
+        sum += rssi[i];
+    }
+    return (int8_t)(sum / rssiCount);
+}
+
+/*!
+ * Main constructor.
+ *
+ * @param staleMillis time after which an unseen device is no longer present
+ */
+MobiusPresenceRegistry::MobiusPresenceRegistry(uint32_t staleMillis) : _count(0), _staleMillis(staleMillis) {}
+
+/*!
+ * @brief Record an advertisement from a device.
+ *
+ * @param address 6 byte device address
+ * @param addressType BLE address type
+ * @param rssi signal strength of the advertisement
+ * @param nowMillis current time (in milliseconds)
+ */
+void MobiusPresenceRegistry::record(const uint8_t* address, uint8_t addressType, int8_t rssi, uint32_t nowMillis) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    int index = findIndex(address);
+    if (0 > index) {
+        if (_count < MOBIUS_PRESENCE_CAPACITY) {
+            index = _count++;
+        } else {
+            // replace the least recently seen device
+            index = 0;
+            for (uint8_t i = 1; i < _count; i++) {
+                if ((nowMillis - _entries[i].lastSeenMillis) > (nowMillis - _entries[index].lastSeenMillis)) {
+                    index = i;
+                }
+            }
+        }
+        Entry& entry = _entries[index];
+        memcpy(entry.address, address, sizeof entry.address);
+        entry.rssiIndex = 0;
+        entry.rssiCount = 0;
+    }
+    Entry& entry = _entries[index];
+    entry.addressType = addressType;
+    entry.lastSeenMillis = nowMillis;
+    entry.rssi[entry.rssiIndex] = rssi;
+    entry.rssiIndex = (entry.rssiIndex + 1) % MOBIUS_RSSI_HISTORY;
+    if (entry.rssiCount < MOBIUS_RSSI_HISTORY) {
+        entry.rssiCount++;
+    }
+}
+
+/*!
+ * @brief Check whether a device was seen within the stale time.
+ *
+ * @param address 6 byte device address
+ * @param nowMillis current time (in milliseconds)
+ * @return true only if the device is present
+ */
+bool MobiusPresenceRegistry::isPresent(const uint8_t* address, uint32_t nowMillis) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    int index = findIndex(address);
+    return (0 <= index) && ((nowMillis - _entries[index].lastSeenMillis) <= _staleMillis);
+}
+
+/*!
+ * @brief Get a copy of the entry for a device.
+ *
+ * @param address 6 byte device address
+ * @param entry receives the entry
+ * @return false if the device is not tracked
+ */
+bool MobiusPresenceRegistry::getEntry(const uint8_t* address, Entry& entry) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    int index = findIndex(address);
+    if (0 > index) {
+        return false;
+    }
+    entry = _entries[index];
+    return true;
+}
+
+/*!
+ * @brief Get the average RSSI of a device.
+ *
+ * @param address 6 byte device address
+ * @return the average RSSI, or RSSI_UNKNOWN if the device is not tracked
+ */
+int8_t MobiusPresenceRegistry::getAverageRssi(const uint8_t* address) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    int index = findIndex(address);
+    return (0 > index) ? RSSI_UNKNOWN : _entries[index].getAverageRssi();
+}
+
+/*!
+ * @brief Remove devices not seen within the stale time.
+ *
+ * @param nowMillis current time (in milliseconds)
+ * @return number of devices removed
+ */
+uint8_t MobiusPresenceRegistry::expire(uint32_t nowMillis) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint8_t removed = 0;
+    uint8_t i = 0;
+    while (i < _count) {
+        if ((nowMillis - _entries[i].lastSeenMillis) > _staleMillis) {
+            // move the last entry into the gap
+            _entries[i] = _entries[--_count];
+            removed++;
+        } else {
+            i++;
+        }
+    }
+    return removed;
+}
+
+/*!
+ * @brief Copy the tracked devices into 'buffer'.
+ *
+ * @param buffer array to receive the entries
+ * @param bufferSize number of entries the buffer can hold
+ * @return number of entries copied
+ */
+uint8_t MobiusPresenceRegistry::getEntries(Entry* buffer, uint8_t bufferSize) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint8_t count = (_count < bufferSize) ? _count : bufferSize;
+    memcpy(buffer, _entries, count * sizeof(Entry));
+    return count;
+}
+
+/*!
+ * @brief Get the number of tracked devices.
+ */
+uint8_t MobiusPresenceRegistry::getCount() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _count;
+}
+
+/*!
+ * Find the index of a device, or -1 if not tracked.
+ */
+int MobiusPresenceRegistry::findIndex(const uint8_t* address) {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (0 == memcmp(_entries[i].address, address, sizeof _entries[i].address)) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,142 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusPresenceRegistry_h
+#define _MobiusPresenceRegistry_h
+
+#include <cstdint>
+#include <mutex>
+
+/*!
+ * Number of devices tracked by a MobiusPresenceRegistry.
+ */
+#ifndef MOBIUS_PRESENCE_CAPACITY
+#define MOBIUS_PRESENCE_CAPACITY 16
+#endif
+
+/*!
+ * Number of RSSI readings kept per tracked device.
+ */
+#ifndef MOBIUS_RSSI_HISTORY
+#define MOBIUS_RSSI_HISTORY 8
+#endif
+
+/*!
+ * @brief Registry of Mobius devices currently in range.
+ * 
+ * Keeps a fixed size table with the address, last seen time and recent
+ * RSSI readings of each device advertising the Mobius service. The table
+ * is fed from the scan callbacks (see MobiusDevice::startPresenceTracking)
+ * or directly through record, and entries not seen within the stale time
+ * are aged out.
+ */
+class MobiusPresenceRegistry {
+public:
+    /*!
+     * Value returned for the RSSI of an unknown device.
+     */
+    static const int8_t RSSI_UNKNOWN = INT8_MIN;
+
+    /*!
+     * @brief A tracked device.
+     */
+    struct Entry {
+        uint8_t address[6];
+        uint8_t addressType;
+        uint32_t lastSeenMillis;
+        int8_t rssi[MOBIUS_RSSI_HISTORY]; // ring buffer of readings
+        uint8_t rssiIndex;                // next position to write
+        uint8_t rssiCount;                // number of valid readings
+
+        /*!
+         * @brief Get the most recent RSSI reading.
+         */
+        int8_t getLastRssi() const;
+
+        /*!
+         * @brief Get the average of the RSSI readings.
+         */
+        int8_t getAverageRssi() const;
+    };
+
+    /*!
+     * Main constructor.
+     * 
+     * @param staleMillis time after which an unseen device is no longer present
+     */
+    MobiusPresenceRegistry(uint32_t staleMillis = 30000);
+
+    /*!
+     * @brief Record an advertisement from a device.
+     * 
+     * When the table is full the least recently seen device is replaced.
+     * 
+     * @param address 6 byte device address
+     * @param addressType BLE address type
+     * @param rssi signal strength of the advertisement
+     * @param nowMillis current time (in milliseconds)
+     */
+    void record(const uint8_t* address, uint8_t addressType, int8_t rssi, uint32_t nowMillis);
+
+    /*!
+     * @brief Check whether a device was seen within the stale time.
+     * 
+     * @param address 6 byte device address
+     * @param nowMillis current time (in milliseconds)
+     * @return true only if the device is present
+     */
+    bool isPresent(const uint8_t* address, uint32_t nowMillis);
+
+    /*!
+     * @brief Get a copy of the entry for a device.
+     * 
+     * @param address 6 byte device address
+     * @param entry receives the entry
+     * @return false if the device is not tracked
+     */
+    bool getEntry(const uint8_t* address, Entry& entry);
+
+    /*!
+     * @brief Get the average RSSI of a device.
+     * 
+     * @param address 6 byte device address
+     * @return the average RSSI, or RSSI_UNKNOWN if the device is not tracked
+     */
+    int8_t getAverageRssi(const uint8_t* address);
+
+    /*!
+     * @brief Remove devices not seen within the stale time.
+     * 
+     * @param nowMillis current time (in milliseconds)
+     * @return number of devices removed
+     */
+    uint8_t expire(uint32_t nowMillis);
+
+    /*!
+     * @brief Copy the tracked devices into 'buffer'.
+     * 
+     * @param buffer array to receive the entries
+     * @param bufferSize number of entries the buffer can hold
+     * @return number of entries copied
+     */
+    uint8_t getEntries(Entry* buffer, uint8_t bufferSize);
+
+    /*!
+     * @brief Get the number of tracked devices.
+     */
+    uint8_t getCount();
+
+private:
+    std::mutex _mutex;
+    Entry _entries[MOBIUS_PRESENCE_CAPACITY];
+    uint8_t _count;
+    uint32_t _staleMillis;
+
+    /*!
+     * Find the index of a device, or -1 if not tracked.
+     */
+    int findIndex(const uint8_t* address);
+};
+
+#endif
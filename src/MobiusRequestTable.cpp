@@ -0,0 +1,112 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <chrono>
+#include "MobiusRequestTable.h"
+
+/*!
+ * Main constructor.
+ *
+ * @param windowSize number of requests allowed in flight (default 4)
+ */
+MobiusRequestTable::MobiusRequestTable(uint8_t windowSize) : _windowSize(1), _inFlight(0) {
+    setWindowSize(windowSize);
+}
+
+/*!
+ * @brief Set the number of requests allowed in flight.
+ *
+ * @param windowSize number of requests allowed in flight
+ */
+void MobiusRequestTable::setWindowSize(uint8_t windowSize) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (windowSize < 1) {
+            windowSize = 1;
+        } else if (windowSize > MAX_WINDOW_SIZE) {
+            windowSize = MAX_WINDOW_SIZE;
+        }
+        _windowSize = windowSize;
+    }
+    // a larger window may allow waiting requests to proceed
+    _slotReleased.notify_all();
+}
+
+/*!
+ * @brief Get the number of requests allowed in flight.
+ *
+ * @return a uint8_t
+ */
+uint8_t MobiusRequestTable::getWindowSize() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _windowSize;
+}
+
+/*!
+ * @brief Reserve a slot for the request with the given 'messageId'.
+ *
+ * @param messageId ID of the request being sent
+ * @param timeoutMillis maximum time to wait for a free slot (in milliseconds)
+ * @return the slot's completion, or nullptr if no slot became free
+ */
+MobiusCompletion* MobiusRequestTable::acquire(uint16_t messageId, uint32_t timeoutMillis) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    bool available = _slotReleased.wait_for(lock, std::chrono::milliseconds(timeoutMillis),
+                                            [this] { return _inFlight < _windowSize; });
+    if (!available) {
+        return nullptr;
+    }
+    for (uint8_t i = 0; i < MAX_WINDOW_SIZE; i++) {
+        Slot& slot = _slots[i];
+        if (!slot.inUse) {
+            slot.inUse = true;
+            slot.messageId = messageId;
+            slot.completion.reset();
+            _inFlight++;
+            return &slot.completion;
+        }
+    }
+    return nullptr;
+}
+
+/*!
+ * @brief Complete the in-flight request with the given 'messageId'.
+ *
+ * @param messageId ID of the confirmed request
+ * @param data bytes of the response
+ * @param length size of the byte array
+ * @return true only if a matching request was in flight
+ */
+bool MobiusRequestTable::complete(uint16_t messageId, const uint8_t* data, size_t length) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (uint8_t i = 0; i < MAX_WINDOW_SIZE; i++) {
+        Slot& slot = _slots[i];
+        if (slot.inUse && messageId == slot.messageId) {
+            slot.completion.complete(data, length);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * @brief Release the slot of an acquired completion.
+ *
+ * @param completion previously returned by acquire
+ */
+void MobiusRequestTable::release(MobiusCompletion* completion) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (uint8_t i = 0; i < MAX_WINDOW_SIZE; i++) {
+            Slot& slot = _slots[i];
+            if (slot.inUse && completion == &slot.completion) {
+                slot.inUse = false;
+                slot.completion.reset();
+                _inFlight--;
+                break;
+            }
+        }
+    }
+    _slotReleased.notify_one();
+}
@@ -0,0 +1,99 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusRequestTable_h
+#define _MobiusRequestTable_h
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <condition_variable>
+
+#include "MobiusCompletion.h"
+
+/*!
+ * @brief Table of in-flight Mobius requests keyed by message ID.
+ * 
+ * Each request written to a device reserves a slot for its message ID
+ * (bytes 3-4 of the request). Confirm messages are matched back to the
+ * waiting request by the same ID, which allows up to 'windowSize'
+ * requests to be outstanding at once.
+ */
+class MobiusRequestTable {
+public:
+    /*!
+     * Maximum number of requests which may be in flight.
+     */
+    static const uint8_t MAX_WINDOW_SIZE = 8;
+
+    /*!
+     * Main constructor.
+     *
+     * @param windowSize number of requests allowed in flight (default 4)
+     */
+    MobiusRequestTable(uint8_t windowSize = 4);
+
+    /*!
+     * @brief Set the number of requests allowed in flight.
+     * 
+     * Values are clamped to the range [1, MAX_WINDOW_SIZE]. A window
+     * size of 1 strictly serializes requests.
+     * 
+     * @param windowSize number of requests allowed in flight
+     */
+    void setWindowSize(uint8_t windowSize);
+
+    /*!
+     * @brief Get the number of requests allowed in flight.
+     * 
+     * @return a uint8_t
+     */
+    uint8_t getWindowSize();
+
+    /*!
+     * @brief Reserve a slot for the request with the given 'messageId'.
+     * 
+     * Blocks while the window is full.
+     * 
+     * @param messageId ID of the request being sent
+     * @param timeoutMillis maximum time to wait for a free slot (in milliseconds)
+     * @return the slot's completion, or nullptr if no slot became free
+     */
+    MobiusCompletion* acquire(uint16_t messageId, uint32_t timeoutMillis);
+
+    /*!
+     * @brief Complete the in-flight request with the given 'messageId'.
+     * 
+     * @param messageId ID of the confirmed request
+     * @param data bytes of the response
+     * @param length size of the byte array
+     * @return true only if a matching request was in flight
+     */
+    bool complete(uint16_t messageId, const uint8_t* data, size_t length);
+
+    /*!
+     * @brief Release the slot of an acquired completion.
+     * 
+     * @param completion previously returned by acquire
+     */
+    void release(MobiusCompletion* completion);
+
+private:
+    /*!
+     * A single in-flight request.
+     */
+    struct Slot {
+        bool inUse = false;
+        uint16_t messageId = 0;
+        MobiusCompletion completion;
+    };
+
+    std::mutex _mutex;
+    std::condition_variable _slotReleased;
+    Slot _slots[MAX_WINDOW_SIZE];
+    uint8_t _windowSize;
+    uint8_t _inFlight;
+};
+
+#endif
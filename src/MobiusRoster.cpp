@@ -0,0 +1,246 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <cstdio>
+#include "MobiusRoster.h"
+
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include <esp32-hal-log.h>
+#define LOG_TAG ""
+#else
+#include <esp_log.h>
+static const char* LOG_TAG = "MobiusRoster";
+#endif
+#include "MobiusLog.h"
+
+#if defined(ESP_PLATFORM)
+#include <nvs.h>
+
+/*
+ * Key of the addresses within the NVS namespace
+ */
+static const char* ROSTER_KEY = "roster";
+#endif
+
+/*!
+ * Main constructor.
+ *
+ * @param name NVS namespace (or file name) to persist to, at most 15 characters
+ */
+MobiusRoster::MobiusRoster(const char* name) {
+    _name = name;
+    _count = 0;
+}
+
+/*!
+ * @brief Load the persisted addresses, replacing the current ones.
+ *
+ * @return false if nothing was persisted, or it was corrupt (the roster is then empty)
+ */
+bool MobiusRoster::load() {
+    _count = 0;
+    size_t size = sizeof _entries;
+#if defined(ESP_PLATFORM)
+    nvs_handle handle;
+    if (ESP_OK != nvs_open(_name, NVS_READONLY, &handle)) {
+        return false;
+    }
+    bool loaded = (ESP_OK == nvs_get_blob(handle, ROSTER_KEY, _entries, &size));
+    nvs_close(handle);
+#else
+    FILE* file = fopen(_name, "rb");
+    if (nullptr == file) {
+        return false;
+    }
+    size = fread(_entries, 1, size, file);
+    bool loaded = (0 == ferror(file));
+    fclose(file);
+#endif
+    // a partial entry or an empty address means the roster is corrupt
+    bool isValid = loaded && (0 == size % sizeof(MobiusDeviceHandle));
+    for (size_t i = 0; isValid && i < size / sizeof(MobiusDeviceHandle); i++) {
+        isValid = _entries[i].isValid();
+    }
+    if (loaded && !isValid) {
+        MOBIUS_LOGW("- Ignoring a corrupt roster of %d bytes", (int)size);
+    }
+    if (isValid) {
+        _count = size / sizeof(MobiusDeviceHandle);
+    }
+    MOBIUS_LOGD("- Loaded %d addresses", _count);
+    return isValid;
+}
+
+/*!
+ * @brief Persist the current addresses.
+ *
+ * @return true only if saved
+ */
+bool MobiusRoster::save() {
+    size_t size = _count * sizeof(MobiusDeviceHandle);
+#if defined(ESP_PLATFORM)
+    nvs_handle handle;
+    if (ESP_OK != nvs_open(_name, NVS_READWRITE, &handle)) {
+        MOBIUS_LOGW("- Failed to open the roster");
+        return false;
+    }
+    bool saved = (ESP_OK == nvs_set_blob(handle, ROSTER_KEY, _entries, size)) && (ESP_OK == nvs_commit(handle));
+    nvs_close(handle);
+#else
+    FILE* file = fopen(_name, "wb");
+    if (nullptr == file) {
+        MOBIUS_LOGW("- Failed to open the roster");
+        return false;
+    }
+    bool saved = (size == fwrite(_entries, 1, size, file));
+    saved = (0 == fclose(file)) && saved;
+#endif
+    if (!saved) {
+        MOBIUS_LOGW("- Failed to save the roster");
+    }
+    return saved;
+}
+
+/*!
+ * @brief Add an address, unless already known.
+ *
+ * @param address BLEAddress (including its type)
+ * @return false if the roster is full
+ */
+bool MobiusRoster::add(const BLEAddress& address) {
+    int index = find(address);
+    if (0 > index) {
+        if (_count >= MOBIUS_ROSTER_CAPACITY) {
+            return false;
+        }
+        index = _count++;
+    }
+    // a known address takes the latest type
+    _entries[index] = MobiusDeviceHandle(address);
+    return true;
+}
+
+/*!
+ * @brief Remove an address.
+ *
+ * @param address BLEAddress to remove
+ * @return true if it was known
+ */
+bool MobiusRoster::remove(const BLEAddress& address) {
+    int index = find(address);
+    if (0 > index) {
+        return false;
+    }
+    // keep the roster order
+    _count--;
+    for (uint8_t i = index; i < _count; i++) {
+        _entries[i] = _entries[i + 1];
+    }
+    return true;
+}
+
+/*!
+ * @brief Remove all addresses.
+ */
+void MobiusRoster::clear() {
+    _count = 0;
+}
+
+/*!
+ * @brief Check whether an address is known.
+ *
+ * @param address BLEAddress to look for
+ * @return true if known
+ */
+bool MobiusRoster::contains(const BLEAddress& address) const {
+    return 0 <= find(address);
+}
+
+/*!
+ * @brief Get the number of known addresses.
+ *
+ * @return a uint8_t
+ */
+uint8_t MobiusRoster::getCount() const {
+    return _count;
+}
+
+/*!
+ * @brief Get a known address.
+ *
+ * @param index position in the roster (below getCount)
+ * @return the BLEAddress (including its type)
+ */
+BLEAddress MobiusRoster::getAddress(uint8_t index) const {
+    return _entries[index].toAddress();
+}
+
+/*!
+ * @brief Connect to the known devices, scanning only if needed.
+ *
+ * @param scanDuration longest fallback scan (in seconds, 0 never scans)
+ * @param deviceBuffer buffer to hold the devices
+ * @param bufferSize number of devices the buffer can hold
+ * @return number of devices in the buffer (check isConnected for each)
+ */
+uint8_t MobiusRoster::connectAll(uint32_t scanDuration, MobiusDevice* deviceBuffer, uint8_t bufferSize) {
+    // connect straight to each known address first
+    uint8_t count = 0;
+    uint8_t connectedCount = 0;
+    for (; count < _count && count < bufferSize; count++) {
+        deviceBuffer[count] = MobiusDevice(_entries[count]);
+        if (deviceBuffer[count].connect()) {
+            connectedCount++;
+        }
+    }
+    MOBIUS_LOGD("- Connected %d of %d known devices", connectedCount, count);
+    if (0 == scanDuration || (0 < count && connectedCount == count)) {
+        return count;
+    }
+
+    // scan for the devices which did not respond (or any, for an empty roster)
+    MobiusDevice found[MOBIUS_ROSTER_CAPACITY];
+    uint8_t expected = (0 < _count) ? _count : bufferSize;
+    uint8_t foundCount = MobiusDevice::scanForMobiusDevices(scanDuration, found, MOBIUS_ROSTER_CAPACITY, expected);
+    bool changed = false;
+    for (uint8_t i = 0; i < foundCount; i++) {
+        BLEAddress address;
+        if (!found[i].getAddress(address)) {
+            continue;
+        }
+        int index = find(address);
+        if (0 <= index && index < count && !deviceBuffer[index].isConnected()) {
+            // connect as advertised, its type may have changed
+            deviceBuffer[index] = found[i];
+            deviceBuffer[index].connect();
+            changed = changed || (address.getType() != _entries[index].type);
+            add(address);
+        } else if (0 > index && count < bufferSize && add(address)) {
+            deviceBuffer[count] = found[i];
+            deviceBuffer[count].connect();
+            count++;
+            changed = true;
+        }
+    }
+    if (changed) {
+        save();
+    }
+    return count;
+}
+
+/*!
+ * Find the position of the 'address'.
+ *
+ * @return the index, or -1 if not known
+ */
+int MobiusRoster::find(const BLEAddress& address) const {
+    MobiusDeviceHandle handle(address);
+    for (uint8_t i = 0; i < _count; i++) {
+        if (handle == _entries[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,148 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusRoster_h
+#define _MobiusRoster_h
+
+#include <cstdint>
+#include <cstddef>
+
+#include "MobiusDevice.h"
+
+/*!
+ * Number of device addresses a roster can hold.
+ */
+#ifndef MOBIUS_ROSTER_CAPACITY
+#define MOBIUS_ROSTER_CAPACITY 8
+#endif
+
+/*!
+ * @brief Persisted list of known Mobius device addresses.
+ *
+ * Lets a device connect straight after boot instead of scanning first.
+ * The roster is kept in NVS (with Preferences) on the ESP32, or in a
+ * file named after the roster elsewhere (e.g. host builds).
+ *
+ *     MobiusRoster roster;
+ *     MobiusDevice pumps[2];
+ *     roster.load();
+ *     // connects the known pumps, scanning only for those which don't respond
+ *     uint8_t count = roster.connectAll(5, pumps);
+ *
+ * Devices found by the fallback scan are added to the roster (and saved),
+ * so the first boot scans once and later boots don't scan at all.
+ */
+class MobiusRoster {
+public:
+    /*!
+     * Main constructor.
+     *
+     * @param name NVS namespace (or file name) to persist to, at most 15 characters
+     */
+    MobiusRoster(const char* name = "mobius");
+
+    /*!
+     * @brief Load the persisted addresses, replacing the current ones.
+     *
+     * @return false if nothing was persisted, or it was corrupt (the roster is then empty)
+     */
+    bool load();
+
+    /*!
+     * @brief Persist the current addresses.
+     *
+     * @return true only if saved
+     */
+    bool save();
+
+    /*!
+     * @brief Add an address, unless already known.
+     *
+     * @param address BLEAddress (including its type)
+     * @return false if the roster is full
+     */
+    bool add(const BLEAddress& address);
+
+    /*!
+     * @brief Remove an address.
+     *
+     * @param address BLEAddress to remove
+     * @return true if it was known
+     */
+    bool remove(const BLEAddress& address);
+
+    /*!
+     * @brief Remove all addresses.
+     */
+    void clear();
+
+    /*!
+     * @brief Check whether an address is known.
+     *
+     * @param address BLEAddress to look for
+     * @return true if known
+     */
+    bool contains(const BLEAddress& address) const;
+
+    /*!
+     * @brief Get the number of known addresses.
+     *
+     * @return a uint8_t
+     */
+    uint8_t getCount() const;
+
+    /*!
+     * @brief Get a known address.
+     *
+     * @param index position in the roster (below getCount)
+     * @return the BLEAddress (including its type)
+     */
+    BLEAddress getAddress(uint8_t index) const;
+
+    /*!
+     * @brief Connect to the known devices, scanning only if needed.
+     *
+     * Each known address is connected directly, in roster order. If any
+     * fails (or the roster is empty) a scan of up to 'scanDuration' looks
+     * for the missing devices, which are then connected as advertised.
+     * Devices the scan finds which aren't known yet are added, as long as
+     * there is room in the 'deviceBuffer', and the roster is saved.
+     *
+     * @param scanDuration longest fallback scan (in seconds, 0 never scans)
+     * @param deviceBuffer buffer to hold the devices
+     * @param bufferSize number of devices the buffer can hold
+     * @return number of devices in the buffer (check isConnected for each)
+     */
+    uint8_t connectAll(uint32_t scanDuration, MobiusDevice* deviceBuffer, uint8_t bufferSize);
+
+    /*!
+     * @brief Connect to the known devices, scanning only if needed.
+     *
+     * Same as above with the buffer size taken from the 'deviceBuffer' array.
+     *
+     * @param scanDuration longest fallback scan (in seconds, 0 never scans)
+     * @param deviceBuffer array to hold the devices
+     * @return number of devices in the buffer (check isConnected for each)
+     */
+    template<size_t N>
+    uint8_t connectAll(uint32_t scanDuration, MobiusDevice (&deviceBuffer)[N]) {
+        static_assert(N <= UINT8_MAX, "deviceBuffer is larger than the maximum count");
+        return connectAll(scanDuration, deviceBuffer, (uint8_t)N);
+    }
+
+private:
+    const char* _name;
+    // persisted as is, the handles are trivially copyable
+    MobiusDeviceHandle _entries[MOBIUS_ROSTER_CAPACITY];
+    uint8_t _count;
+
+    /*!
+     * Find the position of the 'address'.
+     *
+     * @return the index, or -1 if not known
+     */
+    int find(const BLEAddress& address) const;
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <mutex>
+#include "MobiusRttEstimator.h"
+
+MobiusRttEstimator::MobiusRttEstimator() {
+    reset();
+}
+
+MobiusRttEstimator::MobiusRttEstimator(const MobiusRttEstimator& other) {
+    std::lock_guard<std::mutex> lock(other._mutex);
+    copySamples(other);
+}
+
+MobiusRttEstimator& MobiusRttEstimator::operator=(const MobiusRttEstimator& other) {
+    if (this != &other) {
+        std::lock(_mutex, other._mutex);
+        std::lock_guard<std::mutex> lock(_mutex, std::adopt_lock);
+        std::lock_guard<std::mutex> otherLock(other._mutex, std::adopt_lock);
+        copySamples(other);
+    }
+    return *this;
+}
+
+/*!
+ * @brief Add a measured round trip.
+ *
+ * @param rttMicros time from writing the request to its response (in microseconds)
+ */
+void MobiusRttEstimator::addSample(uint32_t rttMicros) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (0 == _count) {
+        _smoothedMicros = rttMicros;
+        _varianceMicros = rttMicros / 2;
+        _minMicros = rttMicros;
+        _maxMicros = rttMicros;
+    } else {
+        // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, then SRTT = 7/8 SRTT + 1/8 R
+        uint32_t deviation = (_smoothedMicros > rttMicros) ? _smoothedMicros - rttMicros : rttMicros - _smoothedMicros;
+        _varianceMicros = _varianceMicros - (_varianceMicros >> 2) + (deviation >> 2);
+        _smoothedMicros = _smoothedMicros - (_smoothedMicros >> 3) + (rttMicros >> 3);
+        _minMicros = (rttMicros < _minMicros) ? rttMicros : _minMicros;
+        _maxMicros = (rttMicros > _maxMicros) ? rttMicros : _maxMicros;
+    }
+    _totalMicros += rttMicros;
+    _count++;
+    _backoffShift = 0;
+}
+
+/*!
+ * @brief Double the timeout after it expired, until the next sample.
+ */
+void MobiusRttEstimator::backoff() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // doubling past the maximum changes nothing
+    if (((uint32_t)MOBIUS_RTO_MIN_MILLIS << _backoffShift) < MOBIUS_RTO_MAX_MILLIS) {
+        _backoffShift++;
+    }
+}
+
+/*!
+ * @brief Forget all samples, the timeout returns to MOBIUS_RTO_INITIAL_MILLIS.
+ */
+void MobiusRttEstimator::reset() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _smoothedMicros = 0;
+    _varianceMicros = 0;
+    _minMicros = 0;
+    _maxMicros = 0;
+    _totalMicros = 0;
+    _count = 0;
+    _backoffShift = 0;
+}
+
+/*!
+ * @brief Get the time to wait for a response.
+ *
+ * @return response timeout (in milliseconds)
+ */
+uint32_t MobiusRttEstimator::getTimeoutMillis() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // RTO = SRTT + 4 * RTTVAR, rounded up to whole milliseconds
+    uint64_t timeoutMillis = MOBIUS_RTO_INITIAL_MILLIS;
+    if (0 < _count) {
+        timeoutMillis = ((uint64_t)_smoothedMicros + 4 * (uint64_t)_varianceMicros + 999) / 1000;
+    }
+    if (timeoutMillis < MOBIUS_RTO_MIN_MILLIS) {
+        timeoutMillis = MOBIUS_RTO_MIN_MILLIS;
+    }
+    // the clamped timeout is doubled, so every backoff waits longer
+    timeoutMillis <<= _backoffShift;
+    if (timeoutMillis > MOBIUS_RTO_MAX_MILLIS) {
+        timeoutMillis = MOBIUS_RTO_MAX_MILLIS;
+    }
+    return (uint32_t)timeoutMillis;
+}
+
+/*!
+ * @brief Get the smoothed round-trip time.
+ *
+ * @return SRTT (in milliseconds), 0 without samples
+ */
+uint32_t MobiusRttEstimator::getSmoothedMillis() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _smoothedMicros / 1000;
+}
+
+/*!
+ * @brief Get the shortest round-trip time.
+ *
+ * @return minimum RTT (in milliseconds), 0 without samples
+ */
+uint32_t MobiusRttEstimator::getMinMillis() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _minMicros / 1000;
+}
+
+/*!
+ * @brief Get the longest round-trip time.
+ *
+ * @return maximum RTT (in milliseconds), 0 without samples
+ */
+uint32_t MobiusRttEstimator::getMaxMillis() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _maxMicros / 1000;
+}
+
+/*!
+ * @brief Get the mean of all round-trip times.
+ *
+ * @return average RTT (in milliseconds), 0 without samples
+ */
+uint32_t MobiusRttEstimator::getAverageMillis() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (0 == _count) ? 0 : (uint32_t)(_totalMicros / _count / 1000);
+}
+
+/*!
+ * @brief Get the number of samples added since the last reset.
+ *
+ * @return a uint32_t
+ */
+uint32_t MobiusRttEstimator::getSampleCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _count;
+}
+
+/*!
+ * Copy the samples of 'other' (its lock is held).
+ */
+void MobiusRttEstimator::copySamples(const MobiusRttEstimator& other) {
+    _smoothedMicros = other._smoothedMicros;
+    _varianceMicros = other._varianceMicros;
+    _minMicros = other._minMicros;
+    _maxMicros = other._maxMicros;
+    _totalMicros = other._totalMicros;
+    _count = other._count;
+    _backoffShift = other._backoffShift;
+}
@@ -0,0 +1,128 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusRttEstimator_h
+#define _MobiusRttEstimator_h
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+/*!
+ * Response timeout used before the first round trip is measured (in milliseconds).
+ */
+#ifndef MOBIUS_RTO_INITIAL_MILLIS
+#define MOBIUS_RTO_INITIAL_MILLIS 1000
+#endif
+
+/*!
+ * Shortest response timeout (in milliseconds).
+ */
+#ifndef MOBIUS_RTO_MIN_MILLIS
+#define MOBIUS_RTO_MIN_MILLIS 200
+#endif
+
+/*!
+ * Longest response timeout, including backoff (in milliseconds).
+ */
+#ifndef MOBIUS_RTO_MAX_MILLIS
+#define MOBIUS_RTO_MAX_MILLIS 4000
+#endif
+
+/*!
+ * @brief Round-trip time estimator for a connection.
+ * 
+ * Derives the response timeout from the measured round trips the same
+ * way TCP derives its retransmission timeout (RFC 6298): a smoothed RTT
+ * and RTT variance give a timeout of SRTT + 4 * RTTVAR, clamped between
+ * MOBIUS_RTO_MIN_MILLIS and MOBIUS_RTO_MAX_MILLIS. Each expired timeout
+ * doubles the timeout until the next sample.
+ * 
+ * Only requests answered without a retransmission should be sampled
+ * (Karn's rule), as a response can't be matched to a single attempt.
+ * 
+ * Copying an estimator copies its samples, not its lock.
+ */
+class MobiusRttEstimator {
+public:
+    MobiusRttEstimator();
+    MobiusRttEstimator(const MobiusRttEstimator& other);
+    MobiusRttEstimator& operator=(const MobiusRttEstimator& other);
+
+    /*!
+     * @brief Add a measured round trip.
+     * 
+     * @param rttMicros time from writing the request to its response (in microseconds)
+     */
+    void addSample(uint32_t rttMicros);
+
+    /*!
+     * @brief Double the timeout after it expired, until the next sample.
+     */
+    void backoff();
+
+    /*!
+     * @brief Forget all samples, the timeout returns to MOBIUS_RTO_INITIAL_MILLIS.
+     */
+    void reset();
+
+    /*!
+     * @brief Get the time to wait for a response.
+     * 
+     * @return response timeout (in milliseconds)
+     */
+    uint32_t getTimeoutMillis() const;
+
+    /*!
+     * @brief Get the smoothed round-trip time.
+     * 
+     * @return SRTT (in milliseconds), 0 without samples
+     */
+    uint32_t getSmoothedMillis() const;
+
+    /*!
+     * @brief Get the shortest round-trip time.
+     * 
+     * @return minimum RTT (in milliseconds), 0 without samples
+     */
+    uint32_t getMinMillis() const;
+
+    /*!
+     * @brief Get the longest round-trip time.
+     * 
+     * @return maximum RTT (in milliseconds), 0 without samples
+     */
+    uint32_t getMaxMillis() const;
+
+    /*!
+     * @brief Get the mean of all round-trip times.
+     * 
+     * @return average RTT (in milliseconds), 0 without samples
+     */
+    uint32_t getAverageMillis() const;
+
+    /*!
+     * @brief Get the number of samples added since the last reset.
+     * 
+     * @return a uint32_t
+     */
+    uint32_t getSampleCount() const;
+
+private:
+    uint32_t _smoothedMicros;
+    uint32_t _varianceMicros;
+    uint32_t _minMicros;
+    uint32_t _maxMicros;
+    uint64_t _totalMicros;
+    uint32_t _count;
+    uint8_t _backoffShift;
+    mutable std::mutex _mutex;
+
+    /*!
+     * Copy the samples of 'other' (its lock is held).
+     */
+    void copySamples(const MobiusRttEstimator& other);
+};
+
+#endif
@@ -0,0 +1,33 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include "MobiusScanProfile.h"
+
+/*!
+ * @brief Get the parameters for the given 'profile'.
+ *
+ * @param profile MobiusScanProfile
+ * @return the MobiusScanParameters
+ */
+MobiusScanParameters MobiusScanParameters::forProfile(MobiusScanProfile profile) {
+    switch (profile) {
+    case MobiusScanProfile::fast_discovery:
+    case MobiusScanProfile::adaptive:
+        return { 100, 100, true };
+    case MobiusScanProfile::balanced:
+        return { 1349, 449, true };
+    case MobiusScanProfile::low_power:
+        return { 5120, 100, false };
+    }
+    return { 1349, 449, true };
+}
+
+/*!
+ * @brief Get the fraction of time spent scanning.
+ *
+ * @return duty cycle between 0 and 1
+ */
+float MobiusScanParameters::getDutyCycle() const {
+    return (0 == intervalMillis) ? 0.0f : (float)windowMillis / intervalMillis;
+}
@@ -0,0 +1,45 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusScanProfile_h
+#define _MobiusScanProfile_h
+
+#include <cstdint>
+
+/*!
+ * @brief enum for the scanning duty cycle profiles.
+ */
+enum class MobiusScanProfile { fast_discovery, // continuous active scanning, quickest discovery
+                               balanced,       // active scanning for a third of the time (the default)
+                               low_power,      // passive scanning for a small part of the time
+                               adaptive        // fast_discovery until all expected devices are present, then low_power
+                               };
+
+/*!
+ * @brief BLE scan parameters for a MobiusScanProfile.
+ */
+struct MobiusScanParameters {
+    uint16_t intervalMillis; // time between the start of each scan window
+    uint16_t windowMillis;   // time spent scanning in each interval
+    bool activeScan;         // request scan responses from devices
+
+    /*!
+     * @brief Get the parameters for the given 'profile'.
+     * 
+     * The adaptive profile starts with the fast_discovery parameters.
+     * 
+     * @param profile MobiusScanProfile
+     * @return the MobiusScanParameters
+     */
+    static MobiusScanParameters forProfile(MobiusScanProfile profile);
+
+    /*!
+     * @brief Get the fraction of time spent scanning.
+     * 
+     * @return duty cycle between 0 and 1
+     */
+    float getDutyCycle() const;
+};
+
+#endif
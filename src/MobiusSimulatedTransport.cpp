@@ -0,0 +1,456 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#include <cstring>
+#include <esp_timer.h>
+#include "MobiusSimulatedTransport.h"
+#include "MobiusDevice.h"
+#include "MobiusCRC.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include <esp32-hal-log.h>
+#define LOG_TAG ""
+#else
+#include <esp_log.h>
+static const char* LOG_TAG = "MobiusSimulatedTransport";
+#endif
+#include "MobiusLog.h"
+
+/*!
+ * Main constructor.
+ *
+ * @param address 6 address bytes reported for events (default none)
+ */
+MobiusSimulatedTransport::MobiusSimulatedTransport(const uint8_t* address)
+    : _receiver(nullptr), _connected(false), _inRange(true), _hasAddress(nullptr != address),
+      _latencyMillis(0), _jitterMillis(0), _lossPercent(0), _random(1), _fragmentSize(0),
+      _requestCount(0), _lostCount(0), _task(nullptr), _taskRunning(false) {
+    memset(_address, 0, sizeof _address);
+    if (address) {
+        memcpy(_address, address, sizeof _address);
+    }
+    setAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, 0, Mobius::SceneAttribute::VALUE_WIDTH);
+    setAttribute(Mobius::OperationStateAttribute::ATTRIBUTE_ID, 0, Mobius::OperationStateAttribute::VALUE_WIDTH);
+}
+
+/*!
+ * De-construct the class.
+ */
+MobiusSimulatedTransport::~MobiusSimulatedTransport() {
+    disconnect();
+    TaskHandle_t task = _task.exchange(nullptr);
+    if (nullptr != task) {
+        // the task ends itself, wait so it never touches a destroyed transport
+        xTaskNotifyGive(task);
+        while (_taskRunning.load()) {
+            vTaskDelay(1);
+        }
+    }
+}
+
+/*!
+ * @brief Set the time between a request and its response.
+ *
+ * @param latencyMillis response delay (in milliseconds, 0 answers during write)
+ * @param jitterMillis most extra delay of a response (in milliseconds, default 0)
+ */
+void MobiusSimulatedTransport::setLatency(uint32_t latencyMillis, uint32_t jitterMillis) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _latencyMillis = latencyMillis;
+        _jitterMillis = jitterMillis;
+    }
+    if (0 < latencyMillis && nullptr == _task.load()) {
+        TaskHandle_t task = nullptr;
+        _taskRunning.store(true);
+        if (pdPASS != xTaskCreate(taskMain, "MobiusSimulated", 4096, this, 1, &task)) {
+            MOBIUS_LOGW("- Failed to create the response task, answering without delay");
+            _taskRunning.store(false);
+            std::lock_guard<std::mutex> lock(_mutex);
+            _latencyMillis = 0;
+            return;
+        }
+        _task.store(task);
+        xTaskNotifyGive(task);
+    }
+}
+
+/*!
+ * @brief Set the share of responses which are lost.
+ *
+ * @param percent chance of losing each response (0 to 100)
+ */
+void MobiusSimulatedTransport::setLossRate(uint8_t percent) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _lossPercent = (100 < percent) ? 100 : percent;
+}
+
+/*!
+ * @brief Restart the repeatable sequence of losses and jitter.
+ *
+ * @param seed start of the sequence (0 is taken as 1)
+ */
+void MobiusSimulatedTransport::setSeed(uint32_t seed) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // xorshift never leaves 0
+    _random = (0 == seed) ? 1 : seed;
+}
+
+/*!
+ * @brief Set the size of the response fragments.
+ *
+ * @param fragmentSize bytes per fragment (0 sends each response whole)
+ */
+void MobiusSimulatedTransport::setFragmentSize(uint16_t fragmentSize) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _fragmentSize = fragmentSize;
+}
+
+/*!
+ * @brief Move the device in or out of range.
+ *
+ * @param inRange true if the device can be reached
+ */
+void MobiusSimulatedTransport::setInRange(bool inRange) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _inRange = inRange;
+    if (!inRange) {
+        // the link drops, responses still on their way are lost
+        _connected = false;
+        _receiver = nullptr;
+        for (uint8_t i = 0; i < MOBIUS_SIMULATED_PENDING; i++) {
+            _pending[i].used = false;
+        }
+    }
+}
+
+/*!
+ * @brief Set (or add) an attribute.
+ *
+ * @param attributeId C2 attribute ID
+ * @param value attribute value
+ * @param width number of value bytes on the wire (1 to 4)
+ * @return false if there is no room for another attribute
+ */
+bool MobiusSimulatedTransport::setAttribute(uint16_t attributeId, uint32_t value, uint8_t width) {
+    if (0 == width || sizeof Attribute::value < width) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    Attribute* attribute = findAttribute(attributeId);
+    for (uint8_t i = 0; !attribute && i < MOBIUS_SIMULATED_ATTRIBUTES; i++) {
+        if (0 == _attributes[i].width) {
+            attribute = &_attributes[i];
+        }
+    }
+    if (nullptr == attribute) {
+        return false;
+    }
+    attribute->id = attributeId;
+    attribute->width = width;
+    for (uint8_t i = 0; i < sizeof attribute->value; i++) {
+        attribute->value[i] = (uint8_t)(value >> (8 * i)); // little endian
+    }
+    return true;
+}
+
+/*!
+ * @brief Get the current value of an attribute.
+ *
+ * @param attributeId C2 attribute ID
+ * @param value set to the attribute value, only if found
+ * @return true if the attribute exists
+ */
+bool MobiusSimulatedTransport::getAttribute(uint16_t attributeId, uint32_t& value) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Attribute* attribute = findAttribute(attributeId);
+    if (nullptr == attribute) {
+        return false;
+    }
+    value = 0;
+    for (uint8_t i = 0; i < attribute->width; i++) {
+        value |= (uint32_t)attribute->value[i] << (8 * i);
+    }
+    return true;
+}
+
+/*!
+ * @brief Get the number of requests received.
+ *
+ * @return a uint32_t
+ */
+uint32_t MobiusSimulatedTransport::getRequestCount() const {
+    return _requestCount.load();
+}
+
+/*!
+ * @brief Get the number of responses lost on purpose.
+ *
+ * @return a uint32_t
+ */
+uint32_t MobiusSimulatedTransport::getLostCount() const {
+    return _lostCount.load();
+}
+
+/*!
+ * @brief Connect to the simulated device.
+ *
+ * @param receiver Receiver for the response fragments until disconnected
+ * @return true only if the device is in range
+ */
+bool MobiusSimulatedTransport::connect(Receiver* receiver) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _connected = _inRange;
+    _receiver = _connected ? receiver : nullptr;
+    return _connected;
+}
+
+/*!
+ * @brief Disconnect from the simulated device.
+ */
+void MobiusSimulatedTransport::disconnect() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _connected = false;
+    _receiver = nullptr;
+    for (uint8_t i = 0; i < MOBIUS_SIMULATED_PENDING; i++) {
+        _pending[i].used = false;
+    }
+}
+
+/*!
+ * @brief Check the link to the simulated device.
+ *
+ * @return true only if connected and in range
+ */
+bool MobiusSimulatedTransport::isConnected() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _connected;
+}
+
+/*!
+ * @brief Write a request to the simulated device.
+ *
+ * @param data request bytes
+ * @param length number of request bytes
+ * @return true only if connected
+ */
+bool MobiusSimulatedTransport::write(const uint8_t* data, size_t length) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_connected) {
+        return false;
+    }
+    _requestCount++;
+    MobiusFrame response;
+    if (!handleRequest(data, length, response)) {
+        return true;
+    }
+    if (0 < _lossPercent && nextRandom() % 100 < _lossPercent) {
+        _lostCount++;
+        return true;
+    }
+    if (0 == _latencyMillis) {
+        deliver(response);
+        return true;
+    }
+    for (uint8_t i = 0; i < MOBIUS_SIMULATED_PENDING; i++) {
+        if (!_pending[i].used) {
+            _pending[i].used = true;
+            uint32_t delayMillis = _latencyMillis + ((0 < _jitterMillis) ? nextRandom() % (_jitterMillis + 1) : 0);
+            _pending[i].dueMicros = esp_timer_get_time() + 1000 * (int64_t)delayMillis;
+            _pending[i].response = response;
+            TaskHandle_t task = _task.load();
+            if (nullptr != task) {
+                xTaskNotifyGive(task);
+            }
+            return true;
+        }
+    }
+    // more requests in flight than a device would take, so it is dropped
+    MOBIUS_LOGW("- No room for the delayed response");
+    _lostCount++;
+    return true;
+}
+
+/*!
+ * @brief Get the address of the simulated device.
+ *
+ * @return the 6 address bytes, or nullptr if none was given
+ */
+const uint8_t* MobiusSimulatedTransport::getAddress() const {
+    return _hasAddress ? _address : nullptr;
+}
+
+/*!
+ * Find the attribute with the 'attributeId'.
+ *
+ * @return the attribute, or nullptr if not found
+ */
+MobiusSimulatedTransport::Attribute* MobiusSimulatedTransport::findAttribute(uint16_t attributeId) {
+    for (uint8_t i = 0; i < MOBIUS_SIMULATED_ATTRIBUTES; i++) {
+        if (0 != _attributes[i].width && attributeId == _attributes[i].id) {
+            return &_attributes[i];
+        }
+    }
+    return nullptr;
+}
+
+/*!
+ * Build the confirm for the 'request' into 'response'.
+ *
+ * GET data is a list of descriptors (id, 0x00, 0x01) answered with each
+ * known attribute and its value. SET data is a list of descriptors with
+ * a value length and value, answered with RESPONSE_DATA_SUCCESSFUL once
+ * every attribute is known and the value fits.
+ *
+ * @return false if the request is not answered
+ */
+bool MobiusSimulatedTransport::handleRequest(const uint8_t* request, size_t length, MobiusFrame& response) {
+    // check the frame
+    bool isValid = (11 <= length) && (length <= MobiusFrame::CAPACITY);
+    isValid = isValid && (0x02 == request[0]) && (Mobius::OP_GROUP_REQUEST == request[1]);
+    uint16_t dataSize = isValid ? (request[8] << 8) + request[7] : 0;
+    isValid = isValid && (11 + (size_t)dataSize == length);
+    if (isValid) {
+        uint16_t crc = MobiusCRC::crc16(&request[1], length - 3);
+        isValid = ((uint8_t)crc == request[length - 2]) && ((uint8_t)(crc >> 8) == request[length - 1]);
+    }
+    if (!isValid) {
+        MOBIUS_LOGW("- Ignoring malformed request");
+        return false;
+    }
+    uint8_t opCode = request[2];
+    const uint8_t* data = &request[9];
+    uint8_t* body = &response.data[9];
+    uint16_t bodySize = 0;
+    body[bodySize++] = 0x00; // all response data starts with 0x00
+    if (Mobius::OP_CODE_GET == opCode) {
+        for (uint16_t offset = 0; offset + 4 <= dataSize; offset += 4) {
+            Attribute* attribute = findAttribute((data[offset + 1] << 8) + data[offset]);
+            if (attribute && 9 + bodySize + 5 + attribute->width + 2 <= MobiusFrame::CAPACITY) {
+                memcpy(&body[bodySize], &data[offset], 4);
+                body[bodySize + 4] = attribute->width;
+                memcpy(&body[bodySize + 5], attribute->value, attribute->width);
+                bodySize += 5 + attribute->width;
+            }
+        }
+    } else if (Mobius::OP_CODE_SET == opCode) {
+        bool successful = true;
+        uint16_t offset = 0;
+        while (successful && offset + 5 <= dataSize) {
+            Attribute* attribute = findAttribute((data[offset + 1] << 8) + data[offset]);
+            uint8_t valueLength = data[offset + 4];
+            successful = attribute && (offset + 5 + valueLength <= dataSize);
+            if (successful) {
+                // wider values are zero padded, so only the attribute's bytes are kept
+                memset(attribute->value, 0, sizeof attribute->value);
+                memcpy(attribute->value, &data[offset + 5], (valueLength < attribute->width) ? valueLength : attribute->width);
+            }
+            offset += 5 + valueLength;
+        }
+        if (successful) {
+            memcpy(&body[bodySize], Mobius::RESPONSE_DATA_SUCCESSFUL, sizeof Mobius::RESPONSE_DATA_SUCCESSFUL);
+            bodySize += sizeof Mobius::RESPONSE_DATA_SUCCESSFUL;
+        } else {
+            body[0] = 0x01;
+        }
+    } else {
+        MOBIUS_LOGW("- Ignoring request with op code 0x%02x", opCode);
+        return false;
+    }
+    // header, same op code and message ID as the request
+    response.data[0] = 0x02;
+    response.data[1] = Mobius::OP_GROUP_CONFIRM;
+    response.data[2] = opCode;
+    response.data[3] = request[3];
+    response.data[4] = request[4];
+    response.data[5] = 0x00;
+    response.data[6] = 0x00;
+    response.data[7] = (uint8_t)bodySize; // little endian
+    response.data[8] = (uint8_t)(bodySize >> 8);
+    response.size = 9 + bodySize + 2;
+    uint16_t crc = MobiusCRC::crc16(&response.data[1], response.size - 3);
+    response.data[response.size - 2] = (uint8_t)crc;
+    response.data[response.size - 1] = (uint8_t)(crc >> 8);
+    return true;
+}
+
+/*!
+ * Get the next number of the repeatable random sequence.
+ */
+uint32_t MobiusSimulatedTransport::nextRandom() {
+    // xorshift, repeatable for a given seed
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random;
+}
+
+/*!
+ * Hand the 'response' to the receiver in fragments.
+ */
+void MobiusSimulatedTransport::deliver(const MobiusFrame& response) {
+    if (!_connected || nullptr == _receiver) {
+        return;
+    }
+    uint16_t fragmentSize = (0 == _fragmentSize) ? response.size : _fragmentSize;
+    uint16_t offset = 0;
+    while (response.size - offset > fragmentSize) {
+        _receiver->onReceive(Channel::data, &response.data[offset], fragmentSize);
+        offset += fragmentSize;
+    }
+    _receiver->onReceive(Channel::final, &response.data[offset], response.size - offset);
+}
+
+/*!
+ * Deliver the pending responses which are due.
+ *
+ * @return ticks until the next pending response is due (portMAX_DELAY if none)
+ */
+TickType_t MobiusSimulatedTransport::deliverDue() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    int64_t now = esp_timer_get_time();
+    int64_t nextDue = INT64_MAX;
+    bool delivered;
+    do {
+        // oldest first, so responses keep their order
+        Pending* due = nullptr;
+        for (uint8_t i = 0; i < MOBIUS_SIMULATED_PENDING; i++) {
+            if (_pending[i].used && _pending[i].dueMicros <= now
+                && (!due || _pending[i].dueMicros < due->dueMicros)) {
+                due = &_pending[i];
+            }
+        }
+        delivered = (nullptr != due);
+        if (delivered) {
+            due->used = false;
+            deliver(due->response);
+        }
+    } while (delivered);
+    for (uint8_t i = 0; i < MOBIUS_SIMULATED_PENDING; i++) {
+        if (_pending[i].used && _pending[i].dueMicros < nextDue) {
+            nextDue = _pending[i].dueMicros;
+        }
+    }
+    if (INT64_MAX == nextDue) {
+        return portMAX_DELAY;
+    }
+    TickType_t ticks = pdMS_TO_TICKS((nextDue - now + 999) / 1000);
+    return (0 == ticks) ? 1 : ticks;
+}
+
+/*!
+ * Deliver delayed responses until destroyed.
+ */
+void MobiusSimulatedTransport::taskMain(void* transport) {
+    MobiusSimulatedTransport* self = static_cast<MobiusSimulatedTransport*>(transport);
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    TickType_t wait = portMAX_DELAY;
+    do {
+        // sleep until the next response is due (or a request or stop arrives)
+        ulTaskNotifyTake(pdTRUE, wait);
+        wait = self->deliverDue();
+    } while (task == self->_task.load());
+    self->_taskRunning.store(false);
+    vTaskDelete(nullptr);
+}
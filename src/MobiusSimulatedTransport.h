@@ -0,0 +1,219 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusSimulatedTransport_h
+#define _MobiusSimulatedTransport_h
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "MobiusTransport.h"
+#include "MobiusFrame.h"
+
+/*!
+ * Number of attributes a simulated device can hold.
+ */
+#ifndef MOBIUS_SIMULATED_ATTRIBUTES
+#define MOBIUS_SIMULATED_ATTRIBUTES 8
+#endif
+
+/*!
+ * Number of delayed responses a simulated device can hold at once.
+ */
+#ifndef MOBIUS_SIMULATED_PENDING
+#define MOBIUS_SIMULATED_PENDING 8
+#endif
+
+/*!
+ * @brief MobiusTransport answered by an in-process simulated Mobius device.
+ *
+ * Lets the request, response and timing code run without a device, e.g.
+ *
+ *     MobiusSimulatedTransport simulated;
+ *     simulated.setLatency(20);
+ *     MobiusDevice device(&simulated);
+ *     device.connect();
+ *     device.setScene(5); // simulated.getAttribute(401, ...) is now 5
+ *
+ * The simulated device checks each C2 request (start byte, op group,
+ * length and CRC), applies GETs and SETs to its attributes and answers
+ * with a confirm. Requests it can't handle are not answered, as with a
+ * real device. Responses can be delayed, lost, and split into fragments
+ * to exercise the receive path.
+ *
+ * The scene (401, 4 bytes) and operation state (104, 1 byte) attributes
+ * start at 0; others can be added with setAttribute.
+ */
+class MobiusSimulatedTransport : public MobiusTransport {
+public:
+    /*!
+     * Main constructor.
+     *
+     * @param address 6 address bytes reported for events (default none)
+     */
+    MobiusSimulatedTransport(const uint8_t* address = nullptr);
+
+    /*!
+     * De-construct the class.
+     */
+    ~MobiusSimulatedTransport();
+
+    /*!
+     * @brief Set the time between a request and its response.
+     *
+     * Each response is delayed by 'latencyMillis' plus a random share of
+     * 'jitterMillis', so responses may overtake each other. Delayed
+     * responses are delivered from a separate task.
+     *
+     * @param latencyMillis response delay (in milliseconds, 0 answers during write)
+     * @param jitterMillis most extra delay of a response (in milliseconds, default 0)
+     */
+    void setLatency(uint32_t latencyMillis, uint32_t jitterMillis = 0);
+
+    /*!
+     * @brief Set the share of responses which are lost.
+     *
+     * @param percent chance of losing each response (0 to 100)
+     */
+    void setLossRate(uint8_t percent);
+
+    /*!
+     * @brief Restart the repeatable sequence of losses and jitter.
+     *
+     * Simulated devices given different seeds lose and delay different
+     * responses.
+     *
+     * @param seed start of the sequence (0 is taken as 1)
+     */
+    void setSeed(uint32_t seed);
+
+    /*!
+     * @brief Set the size of the response fragments.
+     *
+     * Responses longer than 'fragmentSize' are split into RX_DATA fragments
+     * followed by the last fragment on RX_FINAL.
+     *
+     * @param fragmentSize bytes per fragment (0 sends each response whole)
+     */
+    void setFragmentSize(uint16_t fragmentSize);
+
+    /*!
+     * @brief Move the device in or out of range.
+     *
+     * Out of range, connecting fails and an existing link drops.
+     *
+     * @param inRange true if the device can be reached
+     */
+    void setInRange(bool inRange);
+
+    /*!
+     * @brief Set (or add) an attribute.
+     *
+     * @param attributeId C2 attribute ID
+     * @param value attribute value
+     * @param width number of value bytes on the wire (1 to 4)
+     * @return false if there is no room for another attribute
+     */
+    bool setAttribute(uint16_t attributeId, uint32_t value, uint8_t width);
+
+    /*!
+     * @brief Get the current value of an attribute.
+     *
+     * @param attributeId C2 attribute ID
+     * @param value set to the attribute value, only if found
+     * @return true if the attribute exists
+     */
+    bool getAttribute(uint16_t attributeId, uint32_t& value);
+
+    /*!
+     * @brief Get the number of requests received.
+     *
+     * @return a uint32_t
+     */
+    uint32_t getRequestCount() const;
+
+    /*!
+     * @brief Get the number of responses lost on purpose.
+     *
+     * @return a uint32_t
+     */
+    uint32_t getLostCount() const;
+
+    bool connect(Receiver* receiver) override;
+    void disconnect() override;
+    bool isConnected() override;
+    bool write(const uint8_t* data, size_t length) override;
+    const uint8_t* getAddress() const override;
+
+private:
+    struct Attribute {
+        uint16_t id = 0;
+        uint8_t width = 0; // 0 when unused
+        uint8_t value[4] = {};
+    };
+    struct Pending {
+        bool used = false;
+        int64_t dueMicros = 0;
+        MobiusFrame response;
+    };
+
+    std::mutex _mutex;
+    Receiver* _receiver;
+    bool _connected;
+    bool _inRange;
+    bool _hasAddress;
+    uint8_t _address[6];
+    uint32_t _latencyMillis;
+    uint32_t _jitterMillis;
+    uint8_t _lossPercent;
+    uint32_t _random;
+    uint16_t _fragmentSize;
+    Attribute _attributes[MOBIUS_SIMULATED_ATTRIBUTES];
+    Pending _pending[MOBIUS_SIMULATED_PENDING];
+    std::atomic<uint32_t> _requestCount;
+    std::atomic<uint32_t> _lostCount;
+    std::atomic<TaskHandle_t> _task;
+    std::atomic<bool> _taskRunning;
+
+    /*!
+     * Find the attribute with the 'attributeId'.
+     *
+     * @return the attribute, or nullptr if not found
+     */
+    Attribute* findAttribute(uint16_t attributeId);
+
+    /*!
+     * Build the confirm for the 'request' into 'response'.
+     *
+     * @return false if the request is not answered
+     */
+    bool handleRequest(const uint8_t* request, size_t length, MobiusFrame& response);
+
+    /*!
+     * Get the next number of the repeatable random sequence.
+     */
+    uint32_t nextRandom();
+
+    /*!
+     * Hand the 'response' to the receiver in fragments.
+     */
+    void deliver(const MobiusFrame& response);
+
+    /*!
+     * Deliver the pending responses which are due.
+     *
+     * @return ticks until the next pending response is due (portMAX_DELAY if none)
+     */
+    TickType_t deliverDue();
+
+    /*!
+     * Deliver delayed responses until destroyed.
+     */
+    static void taskMain(void* transport);
+};
+
+#endif
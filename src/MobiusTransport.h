@@ -0,0 +1,91 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library.
+ */
+
+#ifndef _MobiusTransport_h
+#define _MobiusTransport_h
+
+#include <cstdint>
+#include <cstddef>
+
+/*!
+ * @brief Link to a single Mobius device.
+ *
+ * A MobiusDevice sends requests and receives responses through a
+ * transport, so the request framing, matching and timing do not depend
+ * on how the bytes are carried. MobiusNimBLETransport carries them over
+ * BLE, while MobiusSimulatedTransport answers them in process.
+ *
+ * Requests are written whole. Responses arrive as fragments on the data
+ * channel (RX_DATA) followed by the last fragment on the final channel
+ * (RX_FINAL), and are delivered to the Receiver given to connect.
+ */
+class MobiusTransport {
+public:
+    /*!
+     * @brief enum for the channel a response fragment arrived on.
+     */
+    enum class Channel { data, // RX_DATA, more fragments follow
+                         final // RX_FINAL, last fragment of the response
+                         };
+
+    /*!
+     * @brief Receives the response fragments of a connected transport.
+     *
+     * Fragments of one transport are delivered one at a time, never
+     * concurrently, and never after disconnect has returned.
+     */
+    class Receiver {
+    public:
+        virtual ~Receiver() {}
+
+        /*!
+         * @brief Called for each received fragment.
+         *
+         * @param channel Channel the fragment arrived on
+         * @param data fragment bytes (only valid during the call)
+         * @param length number of fragment bytes
+         */
+        virtual void onReceive(Channel channel, const uint8_t* data, size_t length) = 0;
+    };
+
+    virtual ~MobiusTransport() {}
+
+    /*!
+     * @brief Connect to the device.
+     *
+     * @param receiver Receiver for the response fragments until disconnected
+     * @return true only if the link is ready for requests
+     */
+    virtual bool connect(Receiver* receiver) = 0;
+
+    /*!
+     * @brief Disconnect from the device.
+     */
+    virtual void disconnect() = 0;
+
+    /*!
+     * @brief Check the link to the device.
+     *
+     * @return true only if connected and the link is still up
+     */
+    virtual bool isConnected() = 0;
+
+    /*!
+     * @brief Write a request to the device.
+     *
+     * @param data request bytes
+     * @param length number of request bytes
+     * @return true only if the request was sent
+     */
+    virtual bool write(const uint8_t* data, size_t length) = 0;
+
+    /*!
+     * @brief Get the address of the device.
+     *
+     * @return the 6 address bytes (least significant first), or nullptr if unknown
+     */
+    virtual const uint8_t* getAddress() const = 0;
+};
+
+#endif
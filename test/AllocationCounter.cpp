@@ -0,0 +1,84 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "AllocationCounter.h"
+
+static std::atomic<uint64_t> allocations(0);
+static std::atomic<int64_t> live(0);
+static std::atomic<int64_t> liveBytes(0);
+
+// each allocation is preceded by its size, keeping the alignment of malloc
+static const size_t HEADER_SIZE = alignof(std::max_align_t);
+
+uint64_t AllocationCounter::getAllocations() {
+    return allocations.load();
+}
+
+int64_t AllocationCounter::getLive() {
+    return live.load();
+}
+
+int64_t AllocationCounter::getLiveBytes() {
+    return liveBytes.load();
+}
+
+/*
+ * Allocate 'size' bytes and count them, nullptr if out of memory
+ */
+static void* countedAllocate(size_t size) {
+    char* memory = static_cast<char*>(malloc(HEADER_SIZE + size));
+    if (nullptr == memory) {
+        return nullptr;
+    }
+    *reinterpret_cast<size_t*>(memory) = size;
+    allocations++;
+    live++;
+    liveBytes += size;
+    return memory + HEADER_SIZE;
+}
+
+void* operator new(size_t size) {
+    void* memory = countedAllocate(size);
+    if (nullptr == memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* memory) noexcept {
+    if (nullptr != memory) {
+        char* block = static_cast<char*>(memory) - HEADER_SIZE;
+        live--;
+        liveBytes -= *reinterpret_cast<size_t*>(block);
+        free(block);
+    }
+}
+
+void operator delete[](void* memory) noexcept {
+    operator delete(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    operator delete(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    operator delete(memory);
+}
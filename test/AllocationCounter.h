@@ -0,0 +1,34 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#ifndef _AllocationCounter_h
+#define _AllocationCounter_h
+
+#include <cstdint>
+
+/*!
+ * @brief Counts the heap allocations of the test executable.
+ *
+ * The global operator new and delete are replaced, so every allocation
+ * made through them (from any thread) is counted.
+ */
+class AllocationCounter {
+public:
+    /*!
+     * Get the number of allocations so far.
+     */
+    static uint64_t getAllocations();
+
+    /*!
+     * Get the number of allocations not yet freed.
+     */
+    static int64_t getLive();
+
+    /*!
+     * Get the number of bytes allocated and not yet freed.
+     */
+    static int64_t getLiveBytes();
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include "MobiusTest.h"
+#include "AllocationCounter.h"
+#include "MobiusAttributeBatch.h"
+#include "MobiusDevice.h"
+#include "MobiusExecutor.h"
+#include "MobiusSimulatedTransport.h"
+
+static const uint32_t ROUND_TRIPS = 100;
+
+/*!
+ * Count the allocations of 'ROUND_TRIPS' setScene and getCurrentScene round trips.
+ */
+static uint64_t countRoundTripAllocations(MobiusDevice& device, uint32_t& failures) {
+    uint64_t before = AllocationCounter::getAllocations();
+    for (uint32_t i = 0; i < ROUND_TRIPS; i++) {
+        failures += device.setScene((uint16_t)i) ? 0 : 1;
+        failures += ((uint16_t)i == device.getCurrentScene(true)) ? 0 : 1;
+    }
+    return AllocationCounter::getAllocations() - before;
+}
+
+MOBIUS_TEST(Allocation, roundTripDoesNotAllocate) {
+    MobiusSimulatedTransport simulated;
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    // the first round trip may set up static state
+    CHECK(device.setScene(1));
+    uint32_t failures = 0;
+    uint64_t allocations = countRoundTripAllocations(device, failures);
+    device.disconnect();
+    CHECK_EQ(0, failures);
+    CHECK_EQ(0, allocations);
+}
+
+MOBIUS_TEST(Allocation, fragmentedDelayedRoundTripDoesNotAllocate) {
+    MobiusSimulatedTransport simulated;
+    simulated.setLatency(1);
+    simulated.setFragmentSize(5);
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    CHECK(device.setScene(1));
+    uint32_t failures = 0;
+    uint64_t allocations = countRoundTripAllocations(device, failures);
+    device.disconnect();
+    CHECK_EQ(0, failures);
+    CHECK_EQ(0, allocations);
+}
+
+MOBIUS_TEST(Allocation, batchDoesNotAllocate) {
+    MobiusSimulatedTransport simulated;
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    MobiusAttributeBatch batch;
+    uint64_t before = AllocationCounter::getAllocations();
+    batch.addGet<Mobius::SceneAttribute>();
+    batch.addGet<Mobius::OperationStateAttribute>();
+    bool sent = device.sendBatch(batch);
+    uint64_t allocations = AllocationCounter::getAllocations() - before;
+    device.disconnect();
+    CHECK(sent);
+    CHECK_EQ(0, allocations);
+}
+
+MOBIUS_TEST(Allocation, counterCountsAllocations) {
+    uint64_t before = AllocationCounter::getAllocations();
+    int64_t liveBefore = AllocationCounter::getLive();
+    int64_t bytesBefore = AllocationCounter::getLiveBytes();
+    int* value = new int(1);
+    CHECK_EQ(1, AllocationCounter::getAllocations() - before);
+    CHECK_EQ(1, AllocationCounter::getLive() - liveBefore);
+    CHECK_EQ((int64_t)sizeof(int), AllocationCounter::getLiveBytes() - bytesBefore);
+    delete value;
+    CHECK_EQ(0, AllocationCounter::getLive() - liveBefore);
+    CHECK_EQ(0, AllocationCounter::getLiveBytes() - bytesBefore);
+}
+
+MOBIUS_TEST(Allocation, executorOperationsDoNotAllocate) {
+    static const uint8_t outstanding[] = { 1, 4, 8 };
+    MobiusSimulatedTransport simulated;
+    simulated.setLatency(5);
+    // every operation in flight at once
+    MobiusDevice::setWindowSize(8);
+    MobiusDevice device(&simulated);
+    bool isConnected = device.connect();
+    MobiusDevice::setWindowSize(4);
+    CHECK(isConnected);
+    MobiusExecutor executor;
+    for (uint8_t count : outstanding) {
+        MobiusFuture<uint16_t> scenes[8];
+        int64_t bytes = AllocationCounter::getLiveBytes();
+        uint64_t allocations = AllocationCounter::getAllocations();
+        for (uint8_t i = 0; i < count; i++) {
+            CHECK(executor.getCurrentScene(device, scenes[i]));
+        }
+        CHECK_EQ(count, executor.getPendingCount());
+        int64_t heapBytes = AllocationCounter::getLiveBytes() - bytes;
+        while (0 < executor.run(50)) {
+        }
+        uint64_t heapAllocations = AllocationCounter::getAllocations() - allocations;
+        // the futures belong to the caller, the executor only holds pointers to them
+        fprintf(stderr, "  %u outstanding: %lld heap bytes per operation, %u byte future\n", count,
+                (long long)(heapBytes / count), (unsigned)sizeof scenes[0]);
+        CHECK_EQ(0, heapBytes);
+        CHECK_EQ(0, heapAllocations);
+        for (uint8_t i = 0; i < count; i++) {
+            CHECK(scenes[i].isSuccessful());
+        }
+    }
+    device.disconnect();
+}
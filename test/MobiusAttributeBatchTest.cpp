@@ -0,0 +1,168 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <cstring>
+#include "MobiusTest.h"
+#include "MobiusAttributeBatch.h"
+#include "MobiusDevice.h"
+#include "MobiusSimulatedTransport.h"
+
+typedef MobiusAttribute<510, uint8_t, 1> ByteAttribute;
+typedef MobiusAttribute<511, uint16_t, 2> WordAttribute;
+typedef MobiusAttribute<512, uint32_t, 4> LongAttribute;
+
+/*!
+ * Write a confirm of 'opCode' holding the 'body' into 'response'.
+ */
+static void writeConfirm(uint8_t opCode, const uint8_t* body, uint16_t bodySize, MobiusFrame& response) {
+    response.data[0] = 0x02;
+    response.data[1] = Mobius::OP_GROUP_CONFIRM;
+    response.data[2] = opCode;
+    memset(&response.data[3], 0, 4);
+    response.data[7] = (uint8_t)bodySize;
+    response.data[8] = (uint8_t)(bodySize >> 8);
+    memcpy(&response.data[9], body, bodySize);
+    response.size = 9 + bodySize + 2;
+    // the batch doesn't check the CRC, the device did
+    response.data[response.size - 2] = 0x00;
+    response.data[response.size - 1] = 0x00;
+}
+
+MOBIUS_TEST(AttributeBatch, matchesGetResultsById) {
+    MobiusAttributeBatch batch;
+    CHECK(batch.addGet<ByteAttribute>());
+    CHECK(batch.addGet<WordAttribute>());
+    CHECK(batch.addGet<LongAttribute>());
+    CHECK_EQ(Mobius::OP_CODE_GET, batch.getOpCode());
+    CHECK_EQ(12, batch.getPayloadSize());
+    // returned in a different order than requested
+    static const uint8_t body[] = { 0x00,
+        0xff, 0x01, 0x00, 0x01, 2, 0x34, 0x12,
+        0x00, 0x02, 0x00, 0x01, 4, 0x78, 0x56, 0x34, 0x12,
+        0xfe, 0x01, 0x00, 0x01, 1, 0x2a };
+    writeConfirm(Mobius::OP_CODE_GET, body, sizeof body, batch.getResponse());
+    CHECK(batch.decodeResponse());
+    uint8_t byteValue = 0;
+    uint16_t wordValue = 0;
+    uint32_t longValue = 0;
+    CHECK(batch.getValue<ByteAttribute>(byteValue));
+    CHECK(batch.getValue<WordAttribute>(wordValue));
+    CHECK(batch.getValue<LongAttribute>(longValue));
+    CHECK_EQ(0x2a, byteValue);
+    CHECK_EQ(0x1234, wordValue);
+    CHECK_EQ(0x12345678u, longValue);
+    // results keep the order the attributes were added in
+    CHECK_EQ(ByteAttribute::ATTRIBUTE_ID, batch.getResult(0)->attributeId);
+    CHECK_EQ(LongAttribute::ATTRIBUTE_ID, batch.getResult(2)->attributeId);
+    CHECK(nullptr == batch.getResult(3));
+}
+
+MOBIUS_TEST(AttributeBatch, truncatedBodyFailsTheMissingAttributes) {
+    MobiusAttributeBatch batch;
+    CHECK(batch.addGet<ByteAttribute>());
+    CHECK(batch.addGet<LongAttribute>());
+    // the long value is cut short
+    static const uint8_t body[] = { 0x00,
+        0xfe, 0x01, 0x00, 0x01, 1, 0x2a,
+        0x00, 0x02, 0x00, 0x01, 4, 0x78, 0x56 };
+    writeConfirm(Mobius::OP_CODE_GET, body, sizeof body, batch.getResponse());
+    CHECK(!batch.decodeResponse());
+    uint8_t byteValue = 0;
+    uint32_t longValue = 0;
+    CHECK(batch.getValue<ByteAttribute>(byteValue));
+    CHECK_EQ(0x2a, byteValue);
+    CHECK(!batch.getValue<LongAttribute>(longValue));
+    CHECK(!batch.findResult(LongAttribute::ATTRIBUTE_ID)->successful);
+
+    // a length field beyond the received frame is clamped to it
+    MobiusFrame& response = batch.getResponse();
+    response.data[7] = 0xff;
+    CHECK(!batch.decodeResponse());
+    CHECK(batch.getValue<ByteAttribute>(byteValue));
+    CHECK(!batch.getValue<LongAttribute>(longValue));
+
+    // no attribute data at all
+    static const uint8_t empty[] = { 0x00 };
+    writeConfirm(Mobius::OP_CODE_GET, empty, sizeof empty, response);
+    CHECK(!batch.decodeResponse());
+    CHECK(!batch.getValue<ByteAttribute>(byteValue));
+    response.size = 9;
+    CHECK(!batch.decodeResponse());
+}
+
+MOBIUS_TEST(AttributeBatch, ignoresUnknownAttributeIds) {
+    MobiusAttributeBatch batch;
+    CHECK(batch.addGet<ByteAttribute>());
+    CHECK(batch.addGet<WordAttribute>());
+    // an attribute which wasn't asked for, and no word attribute
+    static const uint8_t body[] = { 0x00,
+        0x39, 0x05, 0x00, 0x01, 2, 0xaa, 0xbb,
+        0xfe, 0x01, 0x00, 0x01, 1, 0x07 };
+    writeConfirm(Mobius::OP_CODE_GET, body, sizeof body, batch.getResponse());
+    CHECK(!batch.decodeResponse());
+    CHECK(nullptr == batch.findResult(0x0539));
+    uint8_t byteValue = 0;
+    uint16_t wordValue = 0;
+    CHECK(batch.getValue<ByteAttribute>(byteValue));
+    CHECK_EQ(0x07, byteValue);
+    CHECK(!batch.getValue<WordAttribute>(wordValue));
+}
+
+MOBIUS_TEST(AttributeBatch, setStatusAppliesToEveryAttribute) {
+    MobiusAttributeBatch batch;
+    CHECK(batch.addSet<ByteAttribute>(1));
+    CHECK(batch.addSet<WordAttribute>(2));
+    CHECK(batch.addSet<LongAttribute>(3));
+    CHECK(!batch.addGet<ByteAttribute>());
+    CHECK_EQ(Mobius::OP_CODE_SET, batch.getOpCode());
+
+    static const uint8_t successful[] = { 0x00, 0xff, 0xff };
+    writeConfirm(Mobius::OP_CODE_SET, successful, sizeof successful, batch.getResponse());
+    CHECK(batch.decodeResponse());
+    for (uint8_t i = 0; i < batch.getCount(); i++) {
+        CHECK(batch.getResult(i)->successful);
+    }
+
+    static const uint8_t failed[] = { 0x00, 0x01, 0x00 };
+    writeConfirm(Mobius::OP_CODE_SET, failed, sizeof failed, batch.getResponse());
+    CHECK(!batch.decodeResponse());
+    for (uint8_t i = 0; i < batch.getCount(); i++) {
+        CHECK(!batch.getResult(i)->successful);
+    }
+
+    // a confirm to a GET doesn't answer a SET
+    writeConfirm(Mobius::OP_CODE_GET, successful, sizeof successful, batch.getResponse());
+    CHECK(!batch.decodeResponse());
+}
+
+MOBIUS_TEST(AttributeBatch, sendsInOneRoundTrip) {
+    MobiusSimulatedTransport simulated;
+    simulated.setAttribute(ByteAttribute::ATTRIBUTE_ID, 0, 1);
+    simulated.setAttribute(WordAttribute::ATTRIBUTE_ID, 0, 2);
+    simulated.setAttribute(LongAttribute::ATTRIBUTE_ID, 0, 4);
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+
+    MobiusAttributeBatch batch;
+    CHECK(batch.addSet<ByteAttribute>(0x11));
+    CHECK(batch.addSet<WordAttribute>(0x2222));
+    CHECK(batch.addSet<LongAttribute>(0x33333333));
+    uint32_t requests = simulated.getRequestCount();
+    CHECK(device.sendBatch(batch));
+    CHECK_EQ(requests + 1, simulated.getRequestCount());
+
+    batch.clear();
+    CHECK(batch.addGet<ByteAttribute>());
+    CHECK(batch.addGet<WordAttribute>());
+    CHECK(batch.addGet<LongAttribute>());
+    CHECK(device.sendBatch(batch));
+    CHECK_EQ(requests + 2, simulated.getRequestCount());
+    uint8_t byteValue = 0;
+    uint16_t wordValue = 0;
+    uint32_t longValue = 0;
+    CHECK(batch.getValue<ByteAttribute>(byteValue) && 0x11 == byteValue);
+    CHECK(batch.getValue<WordAttribute>(wordValue) && 0x2222 == wordValue);
+    CHECK(batch.getValue<LongAttribute>(longValue) && 0x33333333u == longValue);
+    device.disconnect();
+}
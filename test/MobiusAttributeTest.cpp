@@ -0,0 +1,95 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <cstring>
+#include <limits>
+#include "MobiusTest.h"
+#include "MobiusAttribute.h"
+#include "MobiusDevice.h"
+
+/*!
+ * Build the data of a GET confirm from a SET encoding of the attribute.
+ */
+template<typename Attribute>
+static uint16_t buildBody(const typename Attribute::Encoded& encoded, uint8_t* body) {
+    body[0] = 0x00;
+    memcpy(&body[1], encoded.bytes, sizeof encoded.bytes);
+    return 1 + sizeof encoded.bytes;
+}
+
+/*!
+ * Encode, parse and decode each value of 'values', all of which fit the attribute.
+ */
+template<typename Attribute>
+static bool roundTrips(const typename Attribute::ValueType* values, size_t count) {
+    typedef typename Attribute::ValueType T;
+    for (size_t i = 0; i < count; i++) {
+        const typename Attribute::Encoded encoded = Attribute::encode(values[i]);
+        if (Attribute::ENCODED_SIZE != sizeof encoded.bytes || Attribute::VALUE_WIDTH != encoded.bytes[4]
+            || (uint8_t)(Attribute::ATTRIBUTE_ID & 0xff) != encoded.bytes[0]
+            || (uint8_t)(Attribute::ATTRIBUTE_ID >> 8) != encoded.bytes[1]) {
+            return false;
+        }
+        if (values[i] != Attribute::decode(&encoded.bytes[5])) {
+            return false;
+        }
+        uint8_t body[16];
+        uint16_t bodySize = buildBody<Attribute>(encoded, body);
+        T parsed = 0;
+        if (!Attribute::parse(body, bodySize, parsed) || values[i] != parsed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+MOBIUS_TEST(Attribute, roundTripsEveryWidth) {
+    static const uint8_t bytes[] = { 0, 1, 0x7f, 0x80, 0xff };
+    static const uint16_t words[] = { 0, 1, 0x00ff, 0x0100, 0x8000, 0xffff };
+    static const uint32_t longs[] = { 0, 1, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000, 0x80000000, 0xffffffff };
+    CHECK((roundTrips<MobiusAttribute<600, uint8_t> >(bytes, sizeof bytes / sizeof bytes[0])));
+    CHECK((roundTrips<MobiusAttribute<601, uint16_t> >(words, sizeof words / sizeof words[0])));
+    CHECK((roundTrips<MobiusAttribute<602, uint32_t> >(longs, sizeof longs / sizeof longs[0])));
+    // zero padded on the wire
+    CHECK((roundTrips<MobiusAttribute<603, uint8_t, 2> >(bytes, sizeof bytes / sizeof bytes[0])));
+    CHECK((roundTrips<Mobius::SceneAttribute>(words, sizeof words / sizeof words[0])));
+    CHECK((roundTrips<Mobius::OperationStateAttribute>(bytes, sizeof bytes / sizeof bytes[0])));
+}
+
+MOBIUS_TEST(Attribute, encodesLittleEndianWithPadding) {
+    const Mobius::SceneAttribute::Encoded encoded = Mobius::SceneAttribute::encode(0xbeef);
+    static const uint8_t expected[] = { 0x91, 0x01, 0x00, 0x01, 4, 0xef, 0xbe, 0x00, 0x00 };
+    CHECK_EQ(sizeof expected, sizeof encoded.bytes);
+    CHECK(0 == memcmp(expected, encoded.bytes, sizeof expected));
+    const Mobius::SceneAttribute::Descriptor descriptor = Mobius::SceneAttribute::descriptor();
+    CHECK(0 == memcmp(expected, descriptor.bytes, sizeof descriptor.bytes));
+    // padding bytes beyond the value type are ignored when decoding
+    static const uint8_t wide[] = { 0x34, 0x12, 0xff, 0xff };
+    CHECK_EQ(0x1234, Mobius::SceneAttribute::decode(wide));
+    // a value wider than the wire keeps its low bytes
+    typedef MobiusAttribute<604, uint32_t, 2> NarrowAttribute;
+    const NarrowAttribute::Encoded narrow = NarrowAttribute::encode(0x12345678);
+    CHECK_EQ(0x78, narrow.bytes[5]);
+    CHECK_EQ(0x56, narrow.bytes[6]);
+    CHECK_EQ(0x5678u, NarrowAttribute::decode(&narrow.bytes[5]));
+}
+
+MOBIUS_TEST(Attribute, parseRejectsOtherData) {
+    typedef MobiusAttribute<605, uint16_t> WordAttribute;
+    uint8_t body[16];
+    uint16_t bodySize = buildBody<WordAttribute>(WordAttribute::encode(0x4321), body);
+    uint16_t value = 7;
+    // short body
+    CHECK(!WordAttribute::parse(body, bodySize - 1, value));
+    CHECK(!WordAttribute::parse(body, 0, value));
+    // another attribute
+    CHECK(!(MobiusAttribute<606, uint16_t>::parse(body, bodySize, value)));
+    // not starting with 0x00
+    body[0] = 0x01;
+    CHECK(!WordAttribute::parse(body, bodySize, value));
+    CHECK_EQ(7, value);
+    body[0] = 0x00;
+    CHECK(WordAttribute::parse(body, bodySize, value));
+    CHECK_EQ(0x4321, value);
+}
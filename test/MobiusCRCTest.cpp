@@ -0,0 +1,76 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <cstring>
+#include "MobiusTest.h"
+#include "MobiusCRC.h"
+
+/*!
+ * CRC-16/CCITT-FALSE one bit at a time, as the reference.
+ */
+static uint16_t bitwiseCrc(uint16_t crc, const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/*!
+ * Fill 'data' with a repeatable pseudo random sequence.
+ */
+static void fillRandom(uint8_t* data, size_t length, uint32_t seed) {
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+MOBIUS_TEST(CRC, tableMatchesPolynomial) {
+    for (int b = 0; b < 256; b++) {
+        uint8_t byte = (uint8_t)b;
+        // the table entry is the CRC of the byte from a zero register
+        CHECK_EQ(bitwiseCrc(0, &byte, 1), Mobius::CRC16_TABLE[b]);
+    }
+}
+
+MOBIUS_TEST(CRC, knownVectors) {
+    const char* check = "123456789";
+    CHECK_EQ(0x29B1, MobiusCRC::crc16((const uint8_t*)check, strlen(check)));
+    CHECK_EQ(0xFFFF, MobiusCRC::crc16(nullptr, 0));
+    // the bytes covered by the CRC of a GET current scene request
+    static const uint8_t request[] = { 0xde, 0x17, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x91, 0x01, 0x00, 0x01 };
+    CHECK_EQ(bitwiseCrc(0xFFFF, request, sizeof request), MobiusCRC::crc16(request, sizeof request));
+}
+
+MOBIUS_TEST(CRC, slicesMatchBytewise) {
+    static uint8_t data[4096 + 7];
+    fillRandom(data, sizeof data, 7);
+    static const size_t lengths[] = { 0, 1, 3, 4, 5, 7, 8, 9, 10, 15, 16, 17, 31, 64, 255, 256, 1000, 4096 };
+    for (size_t length : lengths) {
+        // every alignment of the data
+        for (size_t offset = 0; offset < 8; offset++) {
+            uint16_t expected = bitwiseCrc(MobiusCRC::init(), &data[offset], length);
+            CHECK_EQ(expected, MobiusCRC::updateBytewise(MobiusCRC::init(), &data[offset], length));
+            CHECK_EQ(expected, MobiusCRC::updateSlice4(MobiusCRC::init(), &data[offset], length));
+            CHECK_EQ(expected, MobiusCRC::update(MobiusCRC::init(), &data[offset], length));
+        }
+    }
+}
+
+MOBIUS_TEST(CRC, incrementalMatchesWhole) {
+    uint8_t data[300];
+    fillRandom(data, sizeof data, 11);
+    uint16_t whole = MobiusCRC::crc16(data, sizeof data);
+    for (size_t split = 0; split <= sizeof data; split += 13) {
+        uint16_t crc = MobiusCRC::init();
+        crc = MobiusCRC::update(crc, data, split);
+        crc = MobiusCRC::updateSlice4(crc, &data[split], (sizeof data - split) / 2);
+        size_t done = split + (sizeof data - split) / 2;
+        crc = MobiusCRC::updateBytewise(crc, &data[done], sizeof data - done);
+        CHECK_EQ(whole, MobiusCRC::final(crc));
+    }
+}
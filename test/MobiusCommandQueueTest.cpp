@@ -0,0 +1,179 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "MobiusTest.h"
+#include "MobiusCommandQueue.h"
+#include "MobiusMetrics.h"
+#include "MobiusSimulatedTransport.h"
+
+// an attribute of its own, so its SETs are neither coalesced nor merged with the scene
+typedef MobiusAttribute<500, uint8_t> TestAttribute;
+
+/*!
+ * A request as written to the device.
+ */
+struct RecordedRequest {
+    uint8_t opCode;
+    uint16_t attributeId;
+    uint8_t value; // first value byte of a SET
+};
+
+/*!
+ * Simulated device recording the requests written to it, in order.
+ */
+struct RecordingTransport : MobiusTransport {
+    MobiusSimulatedTransport simulated;
+    std::mutex mutex;
+    RecordedRequest requests[16];
+    uint8_t count = 0;
+
+    bool connect(Receiver* receiver) override { return simulated.connect(receiver); }
+    void disconnect() override { simulated.disconnect(); }
+    bool isConnected() override { return simulated.isConnected(); }
+    const uint8_t* getAddress() const override { return simulated.getAddress(); }
+
+    bool write(const uint8_t* data, size_t length) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (15 <= length && count < 16) {
+                // header, then the descriptor (ID first), the value width and the value
+                requests[count++] = { data[2], (uint16_t)(data[9] | (data[10] << 8)), data[14] };
+            }
+        }
+        return simulated.write(data, length);
+    }
+};
+
+/*!
+ * Wait up to 'timeoutMillis' for the 'counter' to reach 'count'.
+ */
+static bool awaitCount(const std::atomic<uint32_t>& counter, uint32_t count, uint32_t timeoutMillis) {
+    for (uint32_t waited = 0; counter.load() < count && waited < timeoutMillis; waited++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return counter.load() >= count;
+}
+
+/*!
+ * Wait up to 'timeoutMillis' for the 'flag' to be set.
+ */
+static bool awaitFlag(const std::atomic<bool>& flag, uint32_t timeoutMillis) {
+    for (uint32_t waited = 0; !flag.load() && waited < timeoutMillis; waited++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return flag.load();
+}
+
+MOBIUS_TEST(CommandQueue, callbackMayStopQueue) {
+    MobiusSimulatedTransport simulated;
+    MobiusDevice device(&simulated);
+    MobiusCommandQueue queue(&device);
+    std::atomic<bool> stopped(false);
+    CHECK(queue.start());
+    CHECK(queue.setScene(5, MobiusPriority::normal, [&queue, &stopped](MobiusCommandStatus /*status*/, uint32_t /*value*/) {
+        // would wait for its own task to end
+        queue.stop();
+        stopped = true;
+    }));
+    CHECK(awaitFlag(stopped, 2000));
+    // the queue can be started again
+    std::atomic<bool> sent(false);
+    CHECK(queue.start());
+    CHECK(queue.setScene(6, MobiusPriority::normal, [&sent](MobiusCommandStatus status, uint32_t /*value*/) {
+        sent = MobiusCommandStatus::successful == status;
+    }));
+    CHECK(awaitFlag(sent, 2000));
+    queue.stop();
+    device.disconnect();
+}
+
+MOBIUS_TEST(CommandQueue, sendsHighestPriorityFirst) {
+    RecordingTransport transport;
+    MobiusDevice device(&transport);
+    MobiusCommandQueue queue(&device);
+    std::atomic<uint32_t> done(0);
+    MobiusCommandQueue::Callback count = [&done](MobiusCommandStatus /*status*/, uint32_t /*value*/) { done++; };
+    // queued before starting, so all of them wait together
+    CHECK(queue.runSchedule(MobiusPriority::low, count));
+    CHECK(queue.getCurrentScene(count));
+    CHECK(queue.enqueueSet<TestAttribute>(7, MobiusPriority::normal, count));
+    CHECK(queue.setScene(9, MobiusPriority::high, count));
+    CHECK_EQ(4, queue.getDepth());
+    CHECK(queue.start());
+    CHECK(awaitCount(done, 4, 2000));
+    queue.stop();
+    // high, normal, then the low ones in the order queued
+    CHECK_EQ(4, transport.count);
+    CHECK_EQ(Mobius::OP_CODE_SET, transport.requests[0].opCode);
+    CHECK_EQ(Mobius::SceneAttribute::ATTRIBUTE_ID, transport.requests[0].attributeId);
+    CHECK_EQ(9, transport.requests[0].value);
+    CHECK_EQ(TestAttribute::ATTRIBUTE_ID, transport.requests[1].attributeId);
+    CHECK_EQ(7, transport.requests[1].value);
+    CHECK_EQ(Mobius::OperationStateAttribute::ATTRIBUTE_ID, transport.requests[2].attributeId);
+    CHECK_EQ(Mobius::OPERATION_STATE_SCHEDULE, transport.requests[2].value);
+    CHECK_EQ(Mobius::OP_CODE_GET, transport.requests[3].opCode);
+    CHECK_EQ(Mobius::SceneAttribute::ATTRIBUTE_ID, transport.requests[3].attributeId);
+    device.disconnect();
+}
+
+MOBIUS_TEST(CommandQueue, coalescesSetsOfAnAttribute) {
+    RecordingTransport transport;
+    MobiusDevice device(&transport);
+    MobiusCommandQueue queue(&device);
+    std::atomic<uint32_t> superseded(0);
+    std::atomic<uint32_t> successful(0);
+    MobiusCommandQueue::Callback outcome = [&superseded, &successful](MobiusCommandStatus status, uint32_t /*value*/) {
+        superseded += (MobiusCommandStatus::superseded == status) ? 1 : 0;
+        successful += (MobiusCommandStatus::successful == status) ? 1 : 0;
+    };
+    uint32_t coalesced = MobiusMetrics::getCount(MobiusCounter::coalesced);
+    CHECK(queue.setScene(1, MobiusPriority::normal, outcome));
+    CHECK(queue.setScene(2, MobiusPriority::normal, outcome));
+    CHECK(queue.setScene(3, MobiusPriority::normal, outcome));
+    // the earlier values are reported superseded straight away
+    CHECK_EQ(2, superseded.load());
+    CHECK_EQ(1, queue.getDepth());
+    CHECK_EQ(coalesced + 2, MobiusMetrics::getCount(MobiusCounter::coalesced));
+    CHECK(queue.start());
+    CHECK(awaitCount(successful, 1, 2000));
+    queue.stop();
+    // only the last value is sent
+    CHECK_EQ(1, transport.count);
+    CHECK_EQ(Mobius::OP_CODE_SET, transport.requests[0].opCode);
+    CHECK_EQ(3, transport.requests[0].value);
+    device.disconnect();
+}
+
+MOBIUS_TEST(CommandQueue, deduplicatesGetsOfAnAttribute) {
+    RecordingTransport transport;
+    transport.simulated.setAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, 42, Mobius::SceneAttribute::VALUE_WIDTH);
+    MobiusDevice device(&transport);
+    MobiusCommandQueue queue(&device);
+    std::atomic<uint32_t> received(0);
+    std::atomic<uint32_t> scenes(0);
+    MobiusCommandQueue::Callback read = [&received, &scenes](MobiusCommandStatus status, uint32_t scene) {
+        if (MobiusCommandStatus::successful == status) {
+            scenes += scene;
+            received++;
+        }
+    };
+    uint32_t deduplicated = MobiusMetrics::getCount(MobiusCounter::deduplicated);
+    CHECK(queue.getCurrentScene(read));
+    CHECK(queue.getCurrentScene(read));
+    CHECK(queue.getCurrentScene(read));
+    CHECK_EQ(1, queue.getDepth());
+    CHECK_EQ(deduplicated + 2, MobiusMetrics::getCount(MobiusCounter::deduplicated));
+    CHECK(queue.start());
+    CHECK(awaitCount(received, 3, 2000));
+    queue.stop();
+    // one GET answers all three callers
+    CHECK_EQ(1, transport.count);
+    CHECK_EQ(Mobius::OP_CODE_GET, transport.requests[0].opCode);
+    CHECK_EQ(3 * 42, scenes.load());
+    device.disconnect();
+}
@@ -0,0 +1,82 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <chrono>
+#include <thread>
+#include <esp_timer.h>
+#include "MobiusTest.h"
+#include "MobiusCompletion.h"
+#include "MobiusDevice.h"
+#include "MobiusSimulatedTransport.h"
+
+static const uint8_t RESPONSE[] = { 0x02, 0xdf, 0x18, 0x01, 0x00 };
+
+MOBIUS_TEST(Completion, wakesWaiterWhenCompleted) {
+    MobiusCompletion completion;
+    completion.reset();
+    std::thread responder([&completion] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        completion.complete(RESPONSE, sizeof RESPONSE);
+    });
+    int64_t start = esp_timer_get_time();
+    bool completed = completion.wait(1000);
+    int64_t waitedMicros = esp_timer_get_time() - start;
+    responder.join();
+    CHECK(completed);
+    // woken by the response, not by a poll interval
+    CHECK(waitedMicros < 50000);
+    MobiusFrame response;
+    CHECK(completion.copyTo(response));
+    CHECK_EQ(sizeof RESPONSE, response.size);
+}
+
+MOBIUS_TEST(Completion, waitTimesOut) {
+    MobiusCompletion completion;
+    completion.reset();
+    int64_t start = esp_timer_get_time();
+    CHECK(!completion.wait(20));
+    CHECK(20000 <= esp_timer_get_time() - start);
+    MobiusFrame response;
+    CHECK(!completion.copyTo(response));
+}
+
+MOBIUS_TEST(Completion, notifiesTask) {
+    MobiusCompletion completion;
+    completion.reset();
+    completion.setNotifyTask(xTaskGetCurrentTaskHandle());
+    std::thread responder([&completion] {
+        completion.complete(RESPONSE, sizeof RESPONSE);
+    });
+    CHECK(0 < ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000)));
+    responder.join();
+}
+
+/*!
+ * Get the average round trip of 'count' setScene (in microseconds), 0 if any fails.
+ */
+static int64_t averageRoundTripMicros(MobiusDevice& device, uint32_t count) {
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < count; i++) {
+        if (!device.setScene((uint16_t)i)) {
+            return 0;
+        }
+    }
+    return (esp_timer_get_time() - start) / count;
+}
+
+MOBIUS_TEST(Completion, roundTripTracksLatency) {
+    static const uint32_t latencies[] = { 5, 15, 40 };
+    for (uint32_t latencyMillis : latencies) {
+        MobiusSimulatedTransport simulated;
+        simulated.setLatency(latencyMillis);
+        MobiusDevice device(&simulated);
+        CHECK(device.connect());
+        int64_t roundTripMicros = averageRoundTripMicros(device, 10);
+        device.disconnect();
+        fprintf(stderr, "  %u ms latency, %lld us round trip\n", latencyMillis, (long long)roundTripMicros);
+        CHECK((int64_t)latencyMillis * 1000 <= roundTripMicros);
+        // well below the 100 ms the response was once polled at
+        CHECK(roundTripMicros < (int64_t)latencyMillis * 1000 + 20000);
+    }
+}
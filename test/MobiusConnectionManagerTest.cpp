@@ -0,0 +1,101 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "MobiusTest.h"
+#include "MobiusConnectionManager.h"
+#include "MobiusSimulatedTransport.h"
+
+/*!
+ * Transport counting the connect attempts to a simulated device.
+ */
+struct CountingTransport : MobiusTransport {
+    MobiusSimulatedTransport simulated;
+    std::atomic<uint32_t> connects{0};
+
+    bool connect(Receiver* receiver) override {
+        connects++;
+        return simulated.connect(receiver);
+    }
+    void disconnect() override { simulated.disconnect(); }
+    bool isConnected() override { return simulated.isConnected(); }
+    bool write(const uint8_t* data, size_t length) override { return simulated.write(data, length); }
+    const uint8_t* getAddress() const override { return simulated.getAddress(); }
+};
+
+/*!
+ * Wait up to 'timeoutMillis' for 'count' connect attempts.
+ */
+static bool waitForConnects(CountingTransport& transport, uint32_t count, uint32_t timeoutMillis) {
+    for (uint32_t waited = 0; transport.connects.load() < count && waited < timeoutMillis; waited += 10) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return transport.connects.load() >= count;
+}
+
+MOBIUS_TEST(ConnectionManager, reconnectsDroppedLink) {
+    CountingTransport transport;
+    MobiusDevice device(&transport);
+    MobiusConnectionManager manager(0, 50, 400);
+    CHECK(manager.add(&device));
+    CHECK(manager.start());
+    CHECK(manager.waitForConnection(&device, 1000));
+    CHECK_EQ(1, transport.connects.load());
+
+    // the link drops and attempts fail while out of range
+    transport.simulated.setInRange(false);
+    CHECK(waitForConnects(transport, 3, 2000));
+    CHECK(!device.isConnected());
+    transport.simulated.setInRange(true);
+    CHECK(manager.waitForConnection(&device, 2000));
+    uint32_t connects = transport.connects.load();
+
+    // a connected device is left alone
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    CHECK_EQ(connects, transport.connects.load());
+    CHECK(manager.sendWhenConnected(&device, [](MobiusDevice& connected) { return connected.setScene(6); }, 1000));
+    manager.stop();
+    device.disconnect();
+}
+
+MOBIUS_TEST(ConnectionManager, backsOffExponentially) {
+    CountingTransport transport;
+    transport.simulated.setInRange(false);
+    MobiusDevice device(&transport);
+    // attempts at 0, 200, 600 and 1400 ms, then every 800 ms
+    MobiusConnectionManager manager(0, 200, 800);
+    CHECK(manager.add(&device));
+    CHECK(manager.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1700));
+    manager.stop();
+    uint32_t connects = transport.connects.load();
+    fprintf(stderr, "  %u attempts in 1700 ms\n", connects);
+    CHECK(3 <= connects && connects <= 5);
+}
+
+MOBIUS_TEST(ConnectionManager, reconnectsAfterFailedKeepAlive) {
+    CountingTransport transport;
+    MobiusDevice device(&transport);
+    MobiusConnectionManager manager(100, 50, 400);
+    CHECK(manager.add(&device));
+    CHECK(manager.start());
+    CHECK(manager.waitForConnection(&device, 1000));
+    // keep-alives are answered
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    CHECK_EQ(1, transport.connects.load());
+    CHECK(2 <= transport.simulated.getRequestCount());
+
+    // the link stays up, but nothing is answered
+    MobiusDevice::setMaxRetransmissions(0);
+    transport.simulated.setLossRate(100);
+    bool reconnected = waitForConnects(transport, 2, 3000);
+    transport.simulated.setLossRate(0);
+    MobiusDevice::setMaxRetransmissions(1);
+    CHECK(reconnected);
+    CHECK(manager.waitForConnection(&device, 1000));
+    manager.stop();
+    device.disconnect();
+}
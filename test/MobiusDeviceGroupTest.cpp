@@ -0,0 +1,88 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <esp_timer.h>
+#include "MobiusTest.h"
+#include "MobiusDeviceGroup.h"
+#include "MobiusSimulatedTransport.h"
+
+static const uint8_t DEVICE_COUNT = MobiusDeviceGroup::MAX_DEVICES;
+static const uint32_t LATENCY_MILLIS = 20;
+static const uint32_t JITTER_MILLIS = 10;
+
+/*!
+ * Simulated tank of DEVICE_COUNT pumps, each with its own jitter.
+ */
+struct SimulatedTank {
+    MobiusSimulatedTransport simulated[DEVICE_COUNT];
+    MobiusDevice devices[DEVICE_COUNT];
+
+    SimulatedTank() {
+        for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+            simulated[i].setLatency(LATENCY_MILLIS, JITTER_MILLIS);
+            simulated[i].setSeed(i + 1);
+            devices[i] = MobiusDevice(&simulated[i]);
+        }
+    }
+};
+
+MOBIUS_TEST(DeviceGroup, switchesMembersTogether) {
+    SimulatedTank tank;
+    MobiusDeviceGroup group;
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        CHECK(group.add(&tank.devices[i]));
+    }
+    CHECK(!group.add(&tank.devices[0]));
+    CHECK_EQ(DEVICE_COUNT, group.connect());
+    CHECK_EQ(DEVICE_COUNT, group.setFeedScene());
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        uint32_t scene = 0;
+        CHECK(tank.simulated[i].getAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, scene));
+        CHECK_EQ(Mobius::FEED_SCENE_ID, scene);
+    }
+    // the writes leave together, the confirms only differ by the jitter
+    CHECK(group.getWriteSkewMicros() < 2000);
+    CHECK(group.getConfirmSkewMicros() <= (JITTER_MILLIS + 5) * 1000);
+    group.disconnect();
+}
+
+MOBIUS_TEST(DeviceGroup, spreadsLessThanLoop) {
+    SimulatedTank tank;
+    MobiusDeviceGroup group;
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        CHECK(group.add(&tank.devices[i]));
+    }
+    CHECK_EQ(DEVICE_COUNT, group.connect());
+    // one after another, each member changes a round trip after the one before
+    int64_t firstMicros = 0;
+    int64_t lastMicros = 0;
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        CHECK(tank.devices[i].setScene(7));
+        lastMicros = esp_timer_get_time();
+        firstMicros = (0 == i) ? lastMicros : firstMicros;
+    }
+    uint32_t loopSpreadMicros = (uint32_t)(lastMicros - firstMicros);
+
+    CHECK_EQ(DEVICE_COUNT, group.setScene(8));
+    uint32_t groupSpreadMicros = group.getConfirmSkewMicros();
+    fprintf(stderr, "  spread of %u members: loop %u us, group %u us\n",
+            (unsigned)DEVICE_COUNT, (unsigned)loopSpreadMicros, (unsigned)groupSpreadMicros);
+    CHECK((DEVICE_COUNT - 1) * LATENCY_MILLIS * 1000 <= loopSpreadMicros);
+    CHECK(groupSpreadMicros < loopSpreadMicros / 2);
+    group.disconnect();
+}
+
+MOBIUS_TEST(DeviceGroup, countsOnlyConfirmingMembers) {
+    SimulatedTank tank;
+    MobiusDeviceGroup group;
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        CHECK(group.add(&tank.devices[i]));
+    }
+    tank.simulated[1].setInRange(false);
+    CHECK_EQ(DEVICE_COUNT - 1, group.connect());
+    CHECK_EQ(DEVICE_COUNT - 1, group.setScene(9));
+    uint32_t scene = 0;
+    CHECK(!tank.simulated[1].getAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, scene) || 9 != scene);
+    group.disconnect();
+}
@@ -0,0 +1,339 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <esp_timer.h>
+#include "MobiusTest.h"
+#include "MobiusDevice.h"
+#include "MobiusEventBus.h"
+#include "MobiusSimulatedTransport.h"
+
+static const uint32_t LISTENER_DELAY_MILLIS = 20;
+static const uint32_t LATENCY_MILLIS = 5;
+static const uint8_t REQUESTS = 10;
+
+/*!
+ * Listener taking LISTENER_DELAY_MILLIS for every event, like one blinking LEDs.
+ */
+struct SlowListener : MobiusDeviceEventListener {
+    std::atomic<uint32_t> received{0};
+
+    void onEvent(const MobiusDeviceEventData& /*data*/) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(LISTENER_DELAY_MILLIS));
+        received++;
+    }
+};
+
+/*!
+ * Listener keeping the details of every event.
+ */
+struct RecordingListener : MobiusDeviceEventListener {
+    std::mutex mutex;
+    std::vector<MobiusDeviceEventData> events;
+
+    void onEvent(const MobiusDeviceEventData& data) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(data);
+    }
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return events.size();
+    }
+
+    std::vector<MobiusDeviceEventData> take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<MobiusDeviceEventData> taken;
+        taken.swap(events);
+        return taken;
+    }
+};
+
+/*!
+ * Wait up to 'timeoutMillis' for the 'listener' to have recorded 'count' events.
+ */
+static bool awaitRecorded(RecordingListener& listener, size_t count, uint32_t timeoutMillis) {
+    int64_t deadline = esp_timer_get_time() + timeoutMillis * 1000LL;
+    while (listener.count() < count && esp_timer_get_time() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return listener.count() >= count;
+}
+
+/*!
+ * Wait up to 'timeoutMillis' for the 'listener' to receive 'count' events.
+ */
+static bool awaitReceived(const SlowListener& listener, uint32_t count, uint32_t timeoutMillis) {
+    int64_t deadline = esp_timer_get_time() + timeoutMillis * 1000LL;
+    while (listener.received.load() < count && esp_timer_get_time() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return listener.received.load() >= count;
+}
+
+/*!
+ * Average time (in microseconds) of setting a scene on the 'device'.
+ */
+static int64_t averageRequestMicros(MobiusDevice& device) {
+    int64_t start = esp_timer_get_time();
+    for (uint8_t i = 0; i < REQUESTS; i++) {
+        if (!device.setScene(i + 1)) {
+            return -1;
+        }
+    }
+    return (esp_timer_get_time() - start) / REQUESTS;
+}
+
+/*!
+ * Listener keeping the message IDs, which blocks in its first event until released.
+ */
+struct GateListener : MobiusDeviceEventListener {
+    std::atomic<bool> entered{false};
+    std::atomic<bool> released{false};
+    std::mutex mutex;
+    std::vector<uint16_t> messageIds;
+
+    void onEvent(const MobiusDeviceEventData& data) override {
+        entered = true;
+        while (!released.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        messageIds.push_back(data.messageId);
+    }
+};
+
+/*!
+ * Publish 'count' events (message IDs 1 to 'count') to the started 'bus'
+ * while its 'listener' is blocked in event 0.
+ *
+ * @return number of publishes which returned true
+ */
+static uint32_t publishWhileBlocked(MobiusEventBus& bus, GateListener& listener, uint16_t count) {
+    MobiusDeviceEventData data(MobiusDeviceEvent::notification_received);
+    bus.publish(data);
+    while (!listener.entered.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    uint32_t accepted = 0;
+    for (uint16_t i = 1; i <= count; i++) {
+        data.messageId = i;
+        accepted += bus.publish(data) ? 1 : 0;
+    }
+    listener.released = true;
+    return accepted;
+}
+
+/*!
+ * Wait up to 'timeoutMillis' for the 'listener' to receive 'count' events.
+ */
+static bool awaitMessageIds(GateListener& listener, size_t count, uint32_t timeoutMillis) {
+    int64_t deadline = esp_timer_get_time() + timeoutMillis * 1000LL;
+    while (esp_timer_get_time() < deadline) {
+        {
+            std::lock_guard<std::mutex> lock(listener.mutex);
+            if (listener.messageIds.size() >= count) {
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+// buses and listeners outlive their dispatcher tasks
+static SlowListener busListener;
+static MobiusEventBus bus;
+static SlowListener overflowListener;
+static MobiusEventBus overflowBus;
+static SlowListener deviceListener;
+static RecordingListener requestListener;
+static RecordingListener responseListener;
+static RecordingListener everythingListener;
+static MobiusEventBus maskBus;
+static GateListener newestListener;
+static MobiusEventBus newestBus(MobiusEventOverflowPolicy::drop_newest);
+static GateListener oldestListener;
+static MobiusEventBus oldestBus(MobiusEventOverflowPolicy::drop_oldest);
+static RecordingListener detailsListener;
+
+MOBIUS_TEST(EventBus, publishDoesNotWaitForListener) {
+    CHECK(bus.addListener(&busListener));
+    CHECK(bus.start());
+    int64_t start = esp_timer_get_time();
+    for (uint8_t i = 0; i < 5; i++) {
+        CHECK(bus.publish(MobiusDeviceEventData(MobiusDeviceEvent::request_successful)));
+    }
+    // far less than a single listener call
+    CHECK(esp_timer_get_time() - start < LISTENER_DELAY_MILLIS * 1000 / 2);
+    CHECK(awaitReceived(busListener, 5, 1000));
+    CHECK_EQ(0, bus.getDropCount());
+}
+
+MOBIUS_TEST(EventBus, fullQueueDropsAndCounts) {
+    CHECK(overflowBus.addListener(&overflowListener));
+    CHECK(overflowBus.start());
+    const uint32_t published = MOBIUS_EVENT_QUEUE_SIZE + 10;
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < published; i++) {
+        accepted += overflowBus.publish(MobiusDeviceEventData(MobiusDeviceEvent::response_successful)) ? 1 : 0;
+    }
+    // the listener is still busy with the first event, the rest wait or are dropped
+    CHECK(0 < overflowBus.getDropCount());
+    CHECK_EQ(published, accepted + overflowBus.getDropCount());
+    CHECK(awaitReceived(overflowListener, accepted, 5000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2 * LISTENER_DELAY_MILLIS));
+    CHECK_EQ(accepted, overflowListener.received.load());
+}
+
+MOBIUS_TEST(EventBus, dropNewestRejectsTheNewEvents) {
+    CHECK(newestBus.addListener(&newestListener));
+    CHECK(newestBus.start());
+    const uint16_t published = MOBIUS_EVENT_QUEUE_SIZE + 10;
+    CHECK_EQ(MOBIUS_EVENT_QUEUE_SIZE, publishWhileBlocked(newestBus, newestListener, published));
+    CHECK_EQ(10, newestBus.getDropCount());
+    CHECK(awaitMessageIds(newestListener, 1 + MOBIUS_EVENT_QUEUE_SIZE, 1000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::lock_guard<std::mutex> lock(newestListener.mutex);
+    CHECK_EQ(1u + MOBIUS_EVENT_QUEUE_SIZE, newestListener.messageIds.size());
+    // the first events were kept
+    for (uint16_t i = 0; i <= MOBIUS_EVENT_QUEUE_SIZE; i++) {
+        CHECK_EQ(i, newestListener.messageIds[i]);
+    }
+}
+
+MOBIUS_TEST(EventBus, dropOldestKeepsTheNewEvents) {
+    CHECK(oldestBus.addListener(&oldestListener));
+    CHECK(oldestBus.start());
+    const uint16_t published = MOBIUS_EVENT_QUEUE_SIZE + 10;
+    // every new event is queued
+    CHECK_EQ(published, publishWhileBlocked(oldestBus, oldestListener, published));
+    CHECK_EQ(10, oldestBus.getDropCount());
+    CHECK(awaitMessageIds(oldestListener, 1 + MOBIUS_EVENT_QUEUE_SIZE, 1000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::lock_guard<std::mutex> lock(oldestListener.mutex);
+    CHECK_EQ(1u + MOBIUS_EVENT_QUEUE_SIZE, oldestListener.messageIds.size());
+    // the event being delivered, then the last events
+    CHECK_EQ(0, oldestListener.messageIds[0]);
+    for (uint16_t i = 1; i <= MOBIUS_EVENT_QUEUE_SIZE; i++) {
+        CHECK_EQ(10 + i, oldestListener.messageIds[i]);
+    }
+}
+
+MOBIUS_TEST(EventBus, slowListenerKeepsRequestLatency) {
+    MobiusSimulatedTransport simulated;
+    simulated.setLatency(LATENCY_MILLIS);
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    // no listener yet, so no event is published
+    int64_t withoutListener = averageRequestMicros(device);
+    CHECK(0 < withoutListener);
+
+    MobiusDevice::init(&deviceListener);
+    int64_t withListener = averageRequestMicros(device);
+    CHECK(0 < withListener);
+    // every request publishes several events, delivered inline each would add LISTENER_DELAY_MILLIS
+    CHECK(withListener < withoutListener + LISTENER_DELAY_MILLIS * 1000 / 4);
+    CHECK(awaitReceived(deviceListener, REQUESTS, 5000));
+    fprintf(stderr, "  request without listener %lld us, with slow listener %lld us\n",
+            (long long)withoutListener, (long long)withListener);
+    device.disconnect();
+    MobiusDevice::removeEventListener(&deviceListener);
+}
+
+MOBIUS_TEST(EventBus, listenerMasksFilterEvents) {
+    CHECK(!maskBus.isWanted(MobiusDeviceEvent::request_successful));
+    CHECK(maskBus.addListener(&requestListener, MobiusDeviceEventListener::mask(MobiusDeviceEvent::request_successful)
+                                                | MobiusDeviceEventListener::mask(MobiusDeviceEvent::request_failure)));
+    CHECK(maskBus.addListener(&responseListener, MobiusDeviceEventListener::mask(MobiusDeviceEvent::response_successful)));
+    CHECK(maskBus.isWanted(MobiusDeviceEvent::request_failure));
+    CHECK(!maskBus.isWanted(MobiusDeviceEvent::scanning_begin));
+
+    // delivered directly until started, then from the dispatcher task
+    for (int started = 0; started < 2; started++) {
+        if (started) {
+            CHECK(maskBus.addListener(&everythingListener));
+            CHECK(maskBus.start());
+        }
+        static const MobiusDeviceEvent events[] = { MobiusDeviceEvent::scanning_begin, MobiusDeviceEvent::request_successful,
+                                                    MobiusDeviceEvent::response_successful, MobiusDeviceEvent::request_failure,
+                                                    MobiusDeviceEvent::response_failure };
+        for (MobiusDeviceEvent event : events) {
+            CHECK(maskBus.publish(MobiusDeviceEventData(event)));
+        }
+        CHECK(awaitRecorded(requestListener, 2, 1000));
+        CHECK(awaitRecorded(responseListener, 1, 1000));
+        std::vector<MobiusDeviceEventData> requests = requestListener.take();
+        std::vector<MobiusDeviceEventData> responses = responseListener.take();
+        CHECK_EQ(2u, requests.size());
+        CHECK(MobiusDeviceEvent::request_successful == requests[0].event);
+        CHECK(MobiusDeviceEvent::request_failure == requests[1].event);
+        CHECK_EQ(1u, responses.size());
+        CHECK(MobiusDeviceEvent::response_successful == responses[0].event);
+    }
+    CHECK(awaitRecorded(everythingListener, 5, 1000));
+    CHECK_EQ(5u, everythingListener.take().size());
+
+    // a listener added again only has its new mask
+    CHECK(maskBus.addListener(&responseListener, MobiusDeviceEventListener::mask(MobiusDeviceEvent::response_failure)));
+    maskBus.removeListener(&everythingListener);
+    CHECK(maskBus.publish(MobiusDeviceEventData(MobiusDeviceEvent::response_successful)));
+    CHECK(maskBus.publish(MobiusDeviceEventData(MobiusDeviceEvent::response_failure)));
+    CHECK(awaitRecorded(responseListener, 1, 1000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::vector<MobiusDeviceEventData> responses = responseListener.take();
+    CHECK_EQ(1u, responses.size());
+    CHECK(MobiusDeviceEvent::response_failure == responses[0].event);
+    CHECK_EQ(0u, everythingListener.count());
+    CHECK_EQ(0, maskBus.getDropCount());
+}
+
+MOBIUS_TEST(EventBus, eventsCarryRequestDetails) {
+    static const uint8_t address[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+    MobiusSimulatedTransport simulated(address);
+    simulated.setLatency(LATENCY_MILLIS);
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    CHECK(MobiusDevice::addEventListener(&detailsListener, MobiusDeviceEventListener::mask(MobiusDeviceEvent::request_successful)
+                                                         | MobiusDeviceEventListener::mask(MobiusDeviceEvent::response_successful)));
+    uint32_t before = esp_timer_get_time() / 1000;
+    CHECK(device.setScene(7));
+    CHECK(device.setScene(8));
+    uint32_t after = esp_timer_get_time() / 1000;
+    // events of the devices of earlier tests may still be queued behind the slow listener
+    std::vector<MobiusDeviceEventData> events;
+    int64_t deadline = esp_timer_get_time() + 2000000;
+    while (events.size() < 4 && esp_timer_get_time() < deadline) {
+        for (const MobiusDeviceEventData& data : detailsListener.take()) {
+            if (data.hasAddress) {
+                events.push_back(data);
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    MobiusDevice::removeEventListener(&detailsListener);
+    device.disconnect();
+    CHECK_EQ(4u, events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        const MobiusDeviceEventData& data = events[i];
+        // each request then its response, with the same message ID
+        CHECK(((0 == i % 2) ? MobiusDeviceEvent::request_successful : MobiusDeviceEvent::response_successful) == data.event);
+        CHECK(0 != data.messageId);
+        CHECK_EQ(events[i - i % 2].messageId, data.messageId);
+        CHECK(data.hasAddress);
+        CHECK(0 == memcmp(address, data.address, sizeof address));
+        CHECK(before <= data.timestampMillis && data.timestampMillis <= after);
+        if (MobiusDeviceEvent::response_successful == data.event) {
+            // the round trip includes the latency
+            CHECK(LATENCY_MILLIS <= data.elapsedMillis);
+            CHECK(events[i - 1].timestampMillis <= data.timestampMillis);
+        }
+    }
+    CHECK(events[0].messageId != events[2].messageId);
+}
@@ -0,0 +1,146 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <esp_timer.h>
+#include "MobiusTest.h"
+#include "MobiusDevice.h"
+#include "MobiusExecutor.h"
+#include "MobiusSimulatedTransport.h"
+
+static const uint8_t DEVICE_COUNT = MOBIUS_MAX_SESSIONS;
+static const uint8_t GETS_PER_DEVICE = 4;
+static const uint32_t LATENCY_MILLIS = 20;
+
+/*!
+ * Run the 'executor' until nothing is outstanding or 'timeoutMillis' passed.
+ */
+static bool runAll(MobiusExecutor& executor, uint32_t timeoutMillis) {
+    int64_t deadline = esp_timer_get_time() + timeoutMillis * 1000LL;
+    while (0 < executor.run(50)) {
+        if (esp_timer_get_time() > deadline) {
+            return false;
+        }
+    }
+    return true;
+}
+
+MOBIUS_TEST(Executor, fansOutAcrossDevices) {
+    MobiusSimulatedTransport simulated[DEVICE_COUNT];
+    MobiusDevice devices[DEVICE_COUNT];
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        simulated[i].setLatency(LATENCY_MILLIS);
+        simulated[i].setAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, 10 + i, Mobius::SceneAttribute::VALUE_WIDTH);
+        devices[i] = MobiusDevice(&simulated[i]);
+        CHECK(devices[i].connect());
+    }
+    // every request of every device outstanding at once, from this single task
+    MobiusExecutor executor;
+    MobiusFuture<uint16_t> scenes[DEVICE_COUNT][GETS_PER_DEVICE];
+    int64_t start = esp_timer_get_time();
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        for (uint8_t j = 0; j < GETS_PER_DEVICE; j++) {
+            CHECK(executor.getCurrentScene(devices[i], scenes[i][j]));
+        }
+    }
+    CHECK_EQ(DEVICE_COUNT * GETS_PER_DEVICE, executor.getPendingCount());
+    CHECK(runAll(executor, 2000));
+    int64_t elapsedMicros = esp_timer_get_time() - start;
+    // about one round trip, not one per request
+    CHECK(elapsedMicros < 3 * LATENCY_MILLIS * 1000);
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        for (uint8_t j = 0; j < GETS_PER_DEVICE; j++) {
+            CHECK(scenes[i][j].isSuccessful());
+            CHECK_EQ(10 + i, scenes[i][j].getValue());
+        }
+        CHECK_EQ(GETS_PER_DEVICE, simulated[i].getRequestCount());
+    }
+
+    MobiusFuture<void> sets[DEVICE_COUNT];
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        CHECK(executor.setScene(devices[i], 20 + i, sets[i]));
+    }
+    CHECK(runAll(executor, 2000));
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        CHECK(sets[i].isSuccessful());
+        uint32_t scene = 0;
+        CHECK(simulated[i].getAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, scene));
+        CHECK_EQ(20 + i, scene);
+        devices[i].disconnect();
+    }
+}
+
+MOBIUS_TEST(Executor, queuesBeyondWindow) {
+    MobiusSimulatedTransport simulated;
+    simulated.setLatency(LATENCY_MILLIS);
+    MobiusDevice device(&simulated);
+    MobiusDevice::setWindowSize(2);
+    bool isConnected = device.connect();
+    MobiusExecutor executor;
+    MobiusFuture<uint16_t> scenes[5];
+    bool isStarted = isConnected;
+    for (uint8_t i = 0; i < 5 && isStarted; i++) {
+        isStarted = executor.getCurrentScene(device, scenes[i]);
+    }
+    MobiusOperation::State lastState = scenes[4].getState();
+    bool isDone = runAll(executor, 2000);
+    MobiusDevice::setWindowSize(4);
+    CHECK(isStarted);
+    // only the window is written, the rest waits
+    CHECK(MobiusOperation::State::queued == lastState);
+    CHECK(isDone);
+    for (uint8_t i = 0; i < 5; i++) {
+        CHECK(scenes[i].isSuccessful());
+    }
+    CHECK_EQ(5, simulated.getRequestCount());
+    device.disconnect();
+}
+
+MOBIUS_TEST(Executor, failsUnansweredAndCancels) {
+    MobiusSimulatedTransport simulated;
+    simulated.setLatency(LATENCY_MILLIS);
+    simulated.setLossRate(100);
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    MobiusExecutor executor;
+    MobiusFuture<void> lost;
+    CHECK(executor.setScene(device, 3, lost));
+    CHECK(runAll(executor, 5000));
+    CHECK(!lost.isSuccessful());
+    CHECK(MobiusOperation::State::failed == lost.getState());
+    // sent once and resent once
+    CHECK_EQ(2, simulated.getRequestCount());
+
+    MobiusFuture<uint16_t> cancelled;
+    CHECK(executor.getCurrentScene(device, cancelled));
+    CHECK_EQ(1, executor.getPendingCount());
+    executor.cancel(cancelled);
+    CHECK_EQ(0, executor.getPendingCount());
+    CHECK(MobiusOperation::State::idle == cancelled.getState());
+
+    simulated.setLossRate(0);
+    MobiusFuture<uint16_t> answered;
+    CHECK(executor.getCurrentScene(device, answered));
+    CHECK(runAll(executor, 2000));
+    CHECK(answered.isSuccessful());
+    device.disconnect();
+}
+
+MOBIUS_TEST(Executor, refusesBeyondCapacity) {
+    MobiusSimulatedTransport simulated;
+    simulated.setLatency(LATENCY_MILLIS);
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    MobiusExecutor executor;
+    MobiusFuture<uint16_t> scenes[MOBIUS_EXECUTOR_CAPACITY + 1];
+    for (uint8_t i = 0; i < MOBIUS_EXECUTOR_CAPACITY; i++) {
+        CHECK(executor.getCurrentScene(device, scenes[i]));
+    }
+    CHECK(!executor.getCurrentScene(device, scenes[MOBIUS_EXECUTOR_CAPACITY]));
+    CHECK_EQ(MOBIUS_EXECUTOR_CAPACITY, executor.getPendingCount());
+    CHECK(runAll(executor, 5000));
+    for (uint8_t i = 0; i < MOBIUS_EXECUTOR_CAPACITY; i++) {
+        CHECK(scenes[i].isSuccessful());
+    }
+    device.disconnect();
+}
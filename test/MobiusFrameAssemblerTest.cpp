@@ -0,0 +1,147 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include "MobiusTest.h"
+#include "MobiusCRC.h"
+#include "MobiusFrameAssembler.h"
+
+/*!
+ * Build a confirm with 'dataSize' data bytes into 'frame'.
+ */
+static void buildConfirm(uint16_t dataSize, uint16_t messageId, MobiusFrame& frame) {
+    frame.data[0] = 0x02;
+    frame.data[1] = 0xdf;
+    frame.data[2] = 0x17;
+    frame.data[3] = (uint8_t)messageId;
+    frame.data[4] = (uint8_t)(messageId >> 8);
+    frame.data[5] = 0x00;
+    frame.data[6] = 0x00;
+    frame.data[7] = (uint8_t)dataSize;
+    frame.data[8] = (uint8_t)(dataSize >> 8);
+    for (uint16_t i = 0; i < dataSize; i++) {
+        frame.data[9 + i] = (uint8_t)(i * 7 + messageId);
+    }
+    frame.size = 9 + dataSize + 2;
+    uint16_t crc = MobiusCRC::crc16(&frame.data[1], frame.size - 3);
+    frame.data[frame.size - 2] = (uint8_t)crc;
+    frame.data[frame.size - 1] = (uint8_t)(crc >> 8);
+}
+
+/*!
+ * Append the 'frame' in fragments of 'fragmentSize', the last one final.
+ */
+static MobiusFrameAssembler::Result appendFragments(MobiusFrameAssembler& assembler, const MobiusFrame& frame,
+                                                    uint16_t fragmentSize, uint16_t count = 0xffff) {
+    MobiusFrameAssembler::Result result = MobiusFrameAssembler::Result::incomplete;
+    uint16_t appended = 0;
+    for (uint16_t offset = 0; offset < frame.size && appended < count; offset += fragmentSize, appended++) {
+        uint16_t length = (frame.size - offset < fragmentSize) ? frame.size - offset : fragmentSize;
+        result = assembler.append(&frame.data[offset], length, offset + length == frame.size);
+    }
+    return result;
+}
+
+MOBIUS_TEST(FrameAssembler, reassemblesEveryFragmentSize) {
+    static const uint16_t dataSizes[] = { 0, 1, 5, 20, 64, 200, MobiusFrame::CAPACITY - 11 };
+    MobiusFrameAssembler assembler;
+    for (uint16_t dataSize : dataSizes) {
+        MobiusFrame frame;
+        buildConfirm(dataSize, dataSize, frame);
+        for (uint16_t fragmentSize = 1; fragmentSize <= frame.size; fragmentSize++) {
+            CHECK(MobiusFrameAssembler::Result::complete == appendFragments(assembler, frame, fragmentSize));
+            CHECK(assembler.isCrcValid());
+            CHECK_EQ(frame.size, assembler.getFrame().size);
+            CHECK(0 == memcmp(frame.data, assembler.getFrame().data, frame.size));
+        }
+    }
+}
+
+MOBIUS_TEST(FrameAssembler, detectsCorruption) {
+    MobiusFrameAssembler assembler;
+    MobiusFrame frame;
+    buildConfirm(30, 1, frame);
+    frame.data[20] ^= 0x10;
+    CHECK(MobiusFrameAssembler::Result::complete == appendFragments(assembler, frame, 20));
+    CHECK(!assembler.isCrcValid());
+
+    // the length field says more than arrived
+    buildConfirm(30, 2, frame);
+    frame.size -= 5;
+    CHECK(MobiusFrameAssembler::Result::error == appendFragments(assembler, frame, 20));
+
+    // the length field says less than arrived
+    buildConfirm(30, 3, frame);
+    frame.data[7] = 10;
+    CHECK(MobiusFrameAssembler::Result::error == appendFragments(assembler, frame, 20));
+
+    // not a frame start
+    buildConfirm(30, 4, frame);
+    frame.data[0] = 0x03;
+    CHECK(MobiusFrameAssembler::Result::error == appendFragments(assembler, frame, 20));
+
+    // the next frame is still assembled
+    buildConfirm(30, 5, frame);
+    CHECK(MobiusFrameAssembler::Result::complete == appendFragments(assembler, frame, 20));
+    CHECK(assembler.isCrcValid());
+}
+
+MOBIUS_TEST(FrameAssembler, newFrameDiscardsStalePartial) {
+    MobiusFrameAssembler assembler;
+    MobiusFrame lost;
+    buildConfirm(60, 1, lost);
+    // the last fragment is lost, the next frame's first one doesn't fit in its place
+    CHECK(MobiusFrameAssembler::Result::incomplete == appendFragments(assembler, lost, 20, 3));
+    MobiusFrame next;
+    buildConfirm(30, 2, next);
+    CHECK(MobiusFrameAssembler::Result::complete == appendFragments(assembler, next, 20));
+    CHECK(assembler.isCrcValid());
+    CHECK_EQ(2, assembler.getFrame().data[3]);
+}
+
+MOBIUS_TEST(FrameAssembler, dataStartingWithStartByteIsKept) {
+    MobiusFrameAssembler assembler;
+    MobiusFrame frame;
+    buildConfirm(40, 1, frame);
+    // the second fragment starts with 0x02, but not a confirm
+    frame.data[20] = 0x02;
+    frame.data[21] = 0x17;
+    uint16_t crc = MobiusCRC::crc16(&frame.data[1], frame.size - 3);
+    frame.data[frame.size - 2] = (uint8_t)crc;
+    frame.data[frame.size - 1] = (uint8_t)(crc >> 8);
+    CHECK(MobiusFrameAssembler::Result::complete == appendFragments(assembler, frame, 20));
+    CHECK(assembler.isCrcValid());
+}
+
+MOBIUS_TEST(FrameAssembler, continuationLikeFrameStartIsKept) {
+    MobiusFrameAssembler assembler;
+    MobiusFrame frame;
+    buildConfirm(40, 1, frame);
+    // the second fragment starts like a confirm, but fits the frame
+    frame.data[20] = 0x02;
+    frame.data[21] = 0xdf;
+    uint16_t crc = MobiusCRC::crc16(&frame.data[1], frame.size - 3);
+    frame.data[frame.size - 2] = (uint8_t)crc;
+    frame.data[frame.size - 1] = (uint8_t)(crc >> 8);
+    CHECK(MobiusFrameAssembler::Result::complete == appendFragments(assembler, frame, 20));
+    CHECK(assembler.isCrcValid());
+    CHECK_EQ(frame.size, assembler.getFrame().size);
+}
+
+MOBIUS_TEST(FrameAssembler, lateFragmentDiscardsStalePartial) {
+    MobiusFrameAssembler assembler;
+    assembler.setFragmentTimeout(20);
+    MobiusFrame frame;
+    buildConfirm(60, 1, frame);
+    CHECK(MobiusFrameAssembler::Result::incomplete == appendFragments(assembler, frame, 20, 1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    // the rest arrives too late, so it is no longer part of a frame
+    MobiusFrameAssembler::Result result = assembler.append(&frame.data[20], 20, false);
+    CHECK(MobiusFrameAssembler::Result::error == result);
+    // fragments in time are assembled
+    CHECK(MobiusFrameAssembler::Result::complete == appendFragments(assembler, frame, 20));
+    CHECK(assembler.isCrcValid());
+}
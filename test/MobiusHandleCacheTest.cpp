@@ -0,0 +1,82 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <esp_timer.h>
+#include "MobiusTest.h"
+#include "MobiusDevice.h"
+#include "MobiusHostDevice.h"
+
+// each test uses its own address, as clients are kept between tests
+static const char* ADDRESSES[] = { "c4:4f:33:0a:1b:01", "c4:4f:33:0a:1b:02", "c4:4f:33:0a:1b:03", "c4:4f:33:0a:1b:04" };
+
+static NimBLEAddress pumpAddress(uint8_t index) {
+    return NimBLEAddress(std::string(ADDRESSES[index]));
+}
+
+MOBIUS_TEST(HandleCache, reconnectSkipsDiscovery) {
+    MobiusHostDevice pump(ADDRESSES[0]);
+    MobiusDevice device(pumpAddress(0));
+    CHECK(device.connect());
+    uint32_t discoveries = pump.peripheral.getDiscoveryCount();
+    CHECK(0 < discoveries);
+    CHECK(device.setScene(3));
+    device.disconnect();
+
+    CHECK(device.connect());
+    CHECK_EQ(2, pump.peripheral.getConnectCount());
+    CHECK_EQ(discoveries, pump.peripheral.getDiscoveryCount());
+    CHECK(device.setScene(4));
+    uint32_t scene = 0;
+    CHECK(pump.simulated.getAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, scene));
+    CHECK_EQ(4, scene);
+    device.disconnect();
+}
+
+MOBIUS_TEST(HandleCache, changedHandlesFallBackToDiscovery) {
+    MobiusHostDevice pump(ADDRESSES[1]);
+    MobiusDevice device(pumpAddress(1));
+    CHECK(device.connect());
+    uint32_t discoveries = pump.peripheral.getDiscoveryCount();
+    device.disconnect();
+
+    // e.g. after a firmware update
+    pump.peripheral.changeHandles();
+    CHECK(device.connect());
+    CHECK(discoveries < pump.peripheral.getDiscoveryCount());
+    CHECK(device.setScene(5));
+    device.disconnect();
+}
+
+MOBIUS_TEST(HandleCache, disabledCacheDiscoversEveryTime) {
+    MobiusHostDevice pump(ADDRESSES[2]);
+    MobiusDevice::setHandleCacheEnabled(false);
+    MobiusDevice device(pumpAddress(2));
+    bool connected = device.connect();
+    uint32_t discoveries = pump.peripheral.getDiscoveryCount();
+    device.disconnect();
+    bool reconnected = device.connect();
+    uint32_t rediscoveries = pump.peripheral.getDiscoveryCount() - discoveries;
+    device.disconnect();
+    MobiusDevice::setHandleCacheEnabled(true);
+    CHECK(connected && reconnected);
+    CHECK_EQ(discoveries, rediscoveries);
+}
+
+MOBIUS_TEST(HandleCache, cachedReconnectIsFaster) {
+    MobiusHostDevice pump(ADDRESSES[3]);
+    pump.peripheral.connectDelayMillis = 5;
+    pump.peripheral.discoveryDelayMillis = 20;
+    MobiusDevice device(pumpAddress(3));
+    int64_t start = esp_timer_get_time();
+    CHECK(device.connect());
+    int64_t coldMicros = esp_timer_get_time() - start;
+    device.disconnect();
+    start = esp_timer_get_time();
+    CHECK(device.connect());
+    int64_t warmMicros = esp_timer_get_time() - start;
+    device.disconnect();
+    fprintf(stderr, "  cold connect %lld us, cached %lld us\n", (long long)coldMicros, (long long)warmMicros);
+    // discovery (two 20 ms round trips) is skipped
+    CHECK(warmMicros + 30000 < coldMicros);
+}
@@ -0,0 +1,32 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include "MobiusHostDevice.h"
+#include "MobiusDevice.h"
+
+MobiusHostDevice::MobiusHostDevice(const char* address, uint8_t type)
+    : peripheral(NimBLEAddress(std::string(address), type)) {
+    peripheral.name = "MOBIUS";
+    std::vector<NimBLEHostPeripheral::Characteristic> characteristics;
+    characteristics.push_back({Mobius::REQUEST_CHARACTERISTIC, true, false});
+    characteristics.push_back({Mobius::RESPONSE_CHARACTERISTIC_1, false, true});
+    characteristics.push_back({Mobius::RESPONSE_CHARACTERISTIC_2, false, true});
+    peripheral.addService(Mobius::GENERAL_SERVICE, characteristics);
+    simulated.connect(this);
+    peripheral.onWrite = [this](const NimBLEUUID& characteristic, const uint8_t* data, size_t length) {
+        if (characteristic.equals(Mobius::REQUEST_CHARACTERISTIC)) {
+            simulated.write(data, length);
+        }
+    };
+}
+
+MobiusHostDevice::~MobiusHostDevice() {
+    peripheral.onWrite = nullptr;
+    simulated.disconnect();
+}
+
+void MobiusHostDevice::onReceive(MobiusTransport::Channel channel, const uint8_t* data, size_t length) {
+    bool final = (MobiusTransport::Channel::final == channel);
+    peripheral.notify(final ? Mobius::RESPONSE_CHARACTERISTIC_2 : Mobius::RESPONSE_CHARACTERISTIC_1, data, length);
+}
@@ -0,0 +1,40 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#ifndef _MobiusHostDevice_h
+#define _MobiusHostDevice_h
+
+#include <NimBLEDevice.h>
+#include "MobiusSimulatedTransport.h"
+
+/*!
+ * @brief A simulated Mobius device on the host BLE.
+ *
+ * A NimBLEHostPeripheral offering the Mobius service, whose requests are
+ * answered by a MobiusSimulatedTransport and notified back on RX_DATA and
+ * RX_FINAL. MobiusDevices reach it through MobiusNimBLETransport, so
+ * scanning, connecting and discovery run as with a real device.
+ */
+class MobiusHostDevice : public MobiusTransport::Receiver {
+public:
+    /*!
+     * Main constructor.
+     *
+     * @param address address string (most significant byte first)
+     * @param type BLE_ADDR_PUBLIC or BLE_ADDR_RANDOM (default public)
+     */
+    MobiusHostDevice(const char* address, uint8_t type = BLE_ADDR_PUBLIC);
+
+    /*!
+     * De-construct the class.
+     */
+    ~MobiusHostDevice();
+
+    NimBLEHostPeripheral peripheral;
+    MobiusSimulatedTransport simulated;
+
+    void onReceive(MobiusTransport::Channel channel, const uint8_t* data, size_t length) override;
+};
+
+#endif
@@ -0,0 +1,95 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <cstring>
+#include "MobiusTest.h"
+#include "MobiusMetrics.h"
+
+MOBIUS_TEST(Metrics, histogramCountsKnownSamples) {
+    MobiusMetrics::reset();
+    static const uint32_t samples[] = { 100, 100, 100, 1000, 3000 };
+    for (uint32_t sample : samples) {
+        MobiusMetrics::recordDuration(MobiusPhase::write, sample);
+    }
+    MobiusMetrics::Histogram histogram = MobiusMetrics::getHistogram(MobiusPhase::write);
+    CHECK_EQ(5u, histogram.count);
+    CHECK_EQ(4300u, histogram.totalMicros);
+    CHECK_EQ(3000u, histogram.maxMicros);
+    CHECK_EQ(860u, histogram.getMeanMicros());
+    // bucket i counts durations below 2^i
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < MobiusMetrics::BUCKETS; i++) {
+        total += histogram.buckets[i];
+    }
+    CHECK_EQ(5u, total);
+    CHECK_EQ(3u, histogram.buckets[7]);
+    CHECK_EQ(1u, histogram.buckets[10]);
+    CHECK_EQ(1u, histogram.buckets[12]);
+    CHECK_EQ(128u, histogram.getPercentileMicros(50));
+    CHECK_EQ(1024u, histogram.getPercentileMicros(80));
+    CHECK_EQ(4096u, histogram.getPercentileMicros(99));
+
+    // bucket edges
+    MobiusMetrics::recordDuration(MobiusPhase::response, 0);
+    MobiusMetrics::recordDuration(MobiusPhase::response, 1);
+    MobiusMetrics::recordDuration(MobiusPhase::response, 127);
+    MobiusMetrics::recordDuration(MobiusPhase::response, 128);
+    histogram = MobiusMetrics::getHistogram(MobiusPhase::response);
+    CHECK_EQ(1u, histogram.buckets[0]);
+    CHECK_EQ(1u, histogram.buckets[1]);
+    CHECK_EQ(1u, histogram.buckets[7]);
+    CHECK_EQ(1u, histogram.buckets[8]);
+    CHECK_EQ(64u, histogram.getMeanMicros());
+
+    // other phases are untouched
+    CHECK_EQ(0u, MobiusMetrics::getHistogram(MobiusPhase::connect).count);
+    CHECK_EQ(0u, MobiusMetrics::getHistogram(MobiusPhase::connect).getMeanMicros());
+    CHECK_EQ(0u, MobiusMetrics::getHistogram(MobiusPhase::connect).getPercentileMicros(50));
+}
+
+MOBIUS_TEST(Metrics, saturatedTotalEstimatesMean) {
+    MobiusMetrics::reset();
+    // beyond the last bucket, and more than a 32-bit total
+    MobiusMetrics::recordDuration(MobiusPhase::connect, 4000000000u);
+    MobiusMetrics::recordDuration(MobiusPhase::connect, 4000000000u);
+    MobiusMetrics::recordDuration(MobiusPhase::connect, 1000);
+    MobiusMetrics::Histogram histogram = MobiusMetrics::getHistogram(MobiusPhase::connect);
+    CHECK_EQ(UINT32_MAX, histogram.totalMicros);
+    CHECK_EQ(2u, histogram.buckets[MobiusMetrics::BUCKETS - 1]);
+    // the open ended bucket counts as the max, the other as 3/4 of its bound
+    CHECK_EQ((uint32_t)((2 * 4000000000ULL + 768) / 3), histogram.getMeanMicros());
+    CHECK_EQ(4000000000u, histogram.getPercentileMicros(99));
+}
+
+MOBIUS_TEST(Metrics, snapshotExportsHistogramsAndCounters) {
+    MobiusMetrics::reset();
+    static const uint32_t samples[] = { 100, 100, 100, 1000, 3000 };
+    for (uint32_t sample : samples) {
+        MobiusMetrics::recordDuration(MobiusPhase::write, sample);
+    }
+    MobiusMetrics::recordDuration(MobiusPhase::queue_wait, 50000000);
+    MobiusMetrics::increment(MobiusCounter::retries);
+    MobiusMetrics::increment(MobiusCounter::retries);
+    MobiusMetrics::increment(MobiusCounter::dropped);
+    CHECK_EQ(2u, MobiusMetrics::getCount(MobiusCounter::retries));
+
+    char text[1024];
+    size_t length = MobiusMetrics::snapshot(text, sizeof text);
+    CHECK_EQ(strlen(text), length);
+    CHECK(nullptr != strstr(text, "connect n=0 mean=0 p50=0 p99=0 max=0\n"));
+    CHECK(nullptr != strstr(text, "write n=5 mean=860 p50=128 p99=4096 max=3000 128:3 1024:1 4096:1\n"));
+    CHECK(nullptr != strstr(text, "queue_wait n=1 mean=50000000 p50=50000000 p99=50000000 max=50000000 inf:1\n"));
+    CHECK(nullptr != strstr(text, "timeouts=0 verification_failures=0 retries=2 coalesced=0 deduplicated=0 dropped=1\n"));
+
+    // a small buffer truncates, always terminated
+    char small[16];
+    length = MobiusMetrics::snapshot(small, sizeof small);
+    CHECK_EQ(sizeof small - 1, length);
+    CHECK_EQ(length, strlen(small));
+    CHECK(0 == strncmp(text, small, length));
+
+    MobiusMetrics::reset();
+    CHECK_EQ(0u, MobiusMetrics::getHistogram(MobiusPhase::write).count);
+    CHECK_EQ(0u, MobiusMetrics::getCount(MobiusCounter::retries));
+}
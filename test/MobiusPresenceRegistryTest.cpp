@@ -0,0 +1,155 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include "MobiusTest.h"
+#include "MobiusPresenceRegistry.h"
+
+/*!
+ * An advertisement of the scripted feed.
+ */
+struct Advertisement {
+    uint32_t atMillis;
+    uint8_t device;
+    int8_t rssi;
+};
+
+/*!
+ * Address of the scripted 'device'.
+ */
+static void deviceAddress(uint8_t device, uint8_t* address) {
+    static const uint8_t base[6] = { 0x10, 0x20, 0x30, 0x40, 0x50, 0x00 };
+    for (int i = 0; i < 6; i++) {
+        address[i] = base[i];
+    }
+    address[5] = device;
+}
+
+/*!
+ * Record the advertisements of 'feed' from 'next' up to and including 'untilMillis'.
+ */
+static void replay(MobiusPresenceRegistry& registry, const Advertisement* feed, size_t count, size_t& next,
+                   uint32_t untilMillis) {
+    for (; next < count && feed[next].atMillis <= untilMillis; next++) {
+        uint8_t address[6];
+        deviceAddress(feed[next].device, address);
+        registry.record(address, 0, feed[next].rssi, feed[next].atMillis);
+    }
+}
+
+static const Advertisement FEED[] = {
+    { 0, 1, -60 },
+    { 100, 2, -80 },
+    { 1000, 1, -50 },
+    { 1200, 2, -70 },
+    { 2500, 1, -40 },
+    // device 2 falls silent, device 3 appears
+    { 3000, 3, -90 },
+    { 4000, 1, -40 },
+};
+static const size_t FEED_SIZE = sizeof FEED / sizeof FEED[0];
+
+MOBIUS_TEST(PresenceRegistry, devicesAppearAndRefresh) {
+    MobiusPresenceRegistry registry(2000);
+    uint8_t first[6], second[6], third[6];
+    deviceAddress(1, first);
+    deviceAddress(2, second);
+    deviceAddress(3, third);
+    size_t next = 0;
+
+    replay(registry, FEED, FEED_SIZE, next, 100);
+    CHECK_EQ(2, registry.getCount());
+    CHECK(registry.isPresent(first, 100));
+    CHECK(registry.isPresent(second, 100));
+    CHECK(!registry.isPresent(third, 100));
+    CHECK_EQ(MobiusPresenceRegistry::RSSI_UNKNOWN, registry.getAverageRssi(third));
+
+    replay(registry, FEED, FEED_SIZE, next, 2500);
+    CHECK_EQ(2, registry.getCount());
+    MobiusPresenceRegistry::Entry entry;
+    CHECK(registry.getEntry(first, entry));
+    CHECK_EQ(2500u, entry.lastSeenMillis);
+    CHECK_EQ(3, entry.rssiCount);
+    CHECK_EQ(-40, entry.getLastRssi());
+    CHECK_EQ(-50, entry.getAverageRssi());
+    CHECK_EQ(-75, registry.getAverageRssi(second));
+}
+
+MOBIUS_TEST(PresenceRegistry, unseenDevicesExpire) {
+    MobiusPresenceRegistry registry(2000);
+    uint8_t first[6], second[6], third[6];
+    deviceAddress(1, first);
+    deviceAddress(2, second);
+    deviceAddress(3, third);
+    size_t next = 0;
+
+    replay(registry, FEED, FEED_SIZE, next, 3000);
+    // last seen at 1200, stale but still tracked until expired
+    CHECK(registry.isPresent(second, 3200));
+    CHECK(!registry.isPresent(second, 3201));
+    CHECK_EQ(0, registry.expire(3200));
+    CHECK_EQ(3, registry.getCount());
+
+    replay(registry, FEED, FEED_SIZE, next, 4000);
+    CHECK_EQ(1, registry.expire(4000));
+    CHECK_EQ(2, registry.getCount());
+    MobiusPresenceRegistry::Entry entry;
+    CHECK(!registry.getEntry(second, entry));
+    CHECK(registry.isPresent(first, 4000));
+    CHECK(registry.isPresent(third, 4000));
+
+    // everything goes silent
+    CHECK_EQ(1, registry.expire(5001));
+    CHECK(registry.getEntry(first, entry));
+    CHECK_EQ(1, registry.expire(6001));
+    CHECK_EQ(0, registry.getCount());
+}
+
+MOBIUS_TEST(PresenceRegistry, fullRegistryReplacesLeastRecentlySeen) {
+    MobiusPresenceRegistry registry(60000);
+    uint8_t address[6];
+    for (uint8_t device = 0; device < MOBIUS_PRESENCE_CAPACITY; device++) {
+        deviceAddress(device, address);
+        registry.record(address, 0, -60, 1000 + device * 10);
+    }
+    // the first device refreshes, so the second is the least recently seen
+    deviceAddress(0, address);
+    registry.record(address, 0, -60, 2000);
+    CHECK_EQ(MOBIUS_PRESENCE_CAPACITY, registry.getCount());
+
+    deviceAddress(MOBIUS_PRESENCE_CAPACITY, address);
+    registry.record(address, 0, -55, 2100);
+    CHECK_EQ(MOBIUS_PRESENCE_CAPACITY, registry.getCount());
+    MobiusPresenceRegistry::Entry entry;
+    CHECK(registry.getEntry(address, entry));
+    CHECK_EQ(1, entry.rssiCount);
+    CHECK_EQ(-55, entry.getLastRssi());
+    deviceAddress(1, address);
+    CHECK(!registry.getEntry(address, entry));
+    deviceAddress(0, address);
+    CHECK(registry.getEntry(address, entry));
+
+    MobiusPresenceRegistry::Entry entries[MOBIUS_PRESENCE_CAPACITY];
+    CHECK_EQ(4, registry.getEntries(entries, 4));
+    CHECK_EQ(MOBIUS_PRESENCE_CAPACITY, registry.getEntries(entries, MOBIUS_PRESENCE_CAPACITY));
+}
+
+MOBIUS_TEST(PresenceRegistry, keepsRecentRssiAcrossClockWrap) {
+    MobiusPresenceRegistry registry(1000);
+    uint8_t address[6];
+    deviceAddress(7, address);
+    // readings straddle the wrap of the millisecond clock
+    uint32_t nowMillis = UINT32_MAX - 500;
+    for (int i = 0; i < MOBIUS_RSSI_HISTORY + 2; i++) {
+        registry.record(address, 0, (int8_t)(-100 + 10 * (i % 2)), nowMillis);
+        nowMillis += 100;
+    }
+    MobiusPresenceRegistry::Entry entry;
+    CHECK(registry.getEntry(address, entry));
+    CHECK_EQ(MOBIUS_RSSI_HISTORY, entry.rssiCount);
+    CHECK_EQ(-90, entry.getLastRssi());
+    CHECK_EQ(-95, entry.getAverageRssi());
+    CHECK(registry.isPresent(address, nowMillis));
+    CHECK_EQ(0, registry.expire(nowMillis));
+    CHECK_EQ(1, registry.expire(nowMillis + 1000));
+}
@@ -0,0 +1,106 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <atomic>
+#include <thread>
+#include "MobiusTest.h"
+#include "MobiusDevice.h"
+#include "MobiusRequestTable.h"
+#include "MobiusSimulatedTransport.h"
+
+MOBIUS_TEST(RequestTable, matchesConfirmsOutOfOrder) {
+    MobiusRequestTable table(4);
+    MobiusCompletion* completions[4];
+    for (uint16_t i = 0; i < 4; i++) {
+        completions[i] = table.acquire(100 + i, 100);
+        CHECK(nullptr != completions[i]);
+    }
+    static const uint16_t order[] = { 3, 1, 2, 0 };
+    for (uint16_t i : order) {
+        uint8_t data[] = { 0x02, 0xdf, 0x17, (uint8_t)(100 + i), 0x00 };
+        CHECK(table.complete(100 + i, data, sizeof data));
+    }
+    for (uint16_t i = 0; i < 4; i++) {
+        MobiusFrame response;
+        CHECK(completions[i]->wait(0));
+        CHECK(completions[i]->copyTo(response));
+        CHECK_EQ(100 + i, response.data[3]);
+        table.release(completions[i]);
+    }
+}
+
+MOBIUS_TEST(RequestTable, dropsUnmatchedConfirms) {
+    MobiusRequestTable table(2);
+    MobiusCompletion* completion = table.acquire(7, 100);
+    CHECK(nullptr != completion);
+    uint8_t data[] = { 0x02, 0xdf };
+    CHECK(!table.complete(8, data, sizeof data));
+    CHECK(!completion->wait(0));
+    table.release(completion);
+    // a late confirm is not handed to the next request
+    CHECK(!table.complete(7, data, sizeof data));
+    completion = table.acquire(9, 100);
+    CHECK(nullptr != completion);
+    CHECK(!completion->wait(0));
+    table.release(completion);
+}
+
+MOBIUS_TEST(RequestTable, windowLimitsRequestsInFlight) {
+    MobiusRequestTable table(2);
+    MobiusCompletion* first = table.acquire(1, 100);
+    MobiusCompletion* second = table.acquire(2, 100);
+    CHECK(nullptr != first && nullptr != second);
+    CHECK(nullptr == table.acquire(3, 20));
+    std::thread releaser([&table, first] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        table.release(first);
+    });
+    MobiusCompletion* third = table.acquire(3, 1000);
+    releaser.join();
+    CHECK(nullptr != third);
+    table.release(second);
+    table.release(third);
+}
+
+typedef MobiusAttribute<500, uint8_t, 1> FirstAttribute;
+typedef MobiusAttribute<501, uint8_t, 1> SecondAttribute;
+typedef MobiusAttribute<502, uint8_t, 1> ThirdAttribute;
+typedef MobiusAttribute<503, uint8_t, 1> FourthAttribute;
+
+/*!
+ * Read 'Attribute' 'count' times, counting the reads which didn't give 'expected'.
+ */
+template<typename Attribute>
+static void readRepeatedly(MobiusDevice& device, uint8_t expected, uint32_t count, std::atomic<uint32_t>& mismatches) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t value = 0;
+        if (!device.get<Attribute>(value, true) || expected != value) {
+            mismatches++;
+        }
+    }
+}
+
+MOBIUS_TEST(RequestTable, deviceMatchesOvertakingResponses) {
+    MobiusSimulatedTransport simulated;
+    // responses overtake each other
+    simulated.setLatency(1, 20);
+    simulated.setAttribute(FirstAttribute::ATTRIBUTE_ID, 11, 1);
+    simulated.setAttribute(SecondAttribute::ATTRIBUTE_ID, 22, 1);
+    simulated.setAttribute(ThirdAttribute::ATTRIBUTE_ID, 33, 1);
+    simulated.setAttribute(FourthAttribute::ATTRIBUTE_ID, 44, 1);
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    std::atomic<uint32_t> mismatches(0);
+    std::thread first([&] { readRepeatedly<FirstAttribute>(device, 11, 20, mismatches); });
+    std::thread second([&] { readRepeatedly<SecondAttribute>(device, 22, 20, mismatches); });
+    std::thread third([&] { readRepeatedly<ThirdAttribute>(device, 33, 20, mismatches); });
+    std::thread fourth([&] { readRepeatedly<FourthAttribute>(device, 44, 20, mismatches); });
+    first.join();
+    second.join();
+    third.join();
+    fourth.join();
+    device.disconnect();
+    CHECK_EQ(0, mismatches.load());
+    CHECK_EQ(80, simulated.getRequestCount());
+}
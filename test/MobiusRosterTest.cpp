@@ -0,0 +1,141 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <cstdio>
+#include <string>
+#include "MobiusTest.h"
+#include "MobiusRoster.h"
+
+/*!
+ * Address of the 'index'th test device, random when 'isRandom'.
+ */
+static BLEAddress testAddress(uint8_t index, bool isRandom = false) {
+    char text[18];
+    snprintf(text, sizeof text, "c4:4f:33:0b:4d:%02x", index + 1);
+    return BLEAddress(std::string(text), isRandom ? BLE_ADDR_RANDOM : BLE_ADDR_PUBLIC);
+}
+
+/*!
+ * Write 'size' bytes of 'data' as the roster file 'name'.
+ */
+static bool writeFile(const char* name, const void* data, size_t size) {
+    FILE* file = fopen(name, "wb");
+    if (nullptr == file) {
+        return false;
+    }
+    bool written = (size == fwrite(data, 1, size, file));
+    return (0 == fclose(file)) && written;
+}
+
+MOBIUS_TEST(Roster, savesAndLoadsAddresses) {
+    static const char* name = "roster_round_trip";
+    remove(name);
+    MobiusRoster roster(name);
+    CHECK(!roster.load());
+    CHECK(roster.add(testAddress(0)));
+    CHECK(roster.add(testAddress(1, true)));
+    CHECK(roster.add(testAddress(2)));
+    // a known address only takes the latest type
+    CHECK(roster.add(testAddress(0, true)));
+    CHECK_EQ(3, roster.getCount());
+    CHECK(roster.save());
+
+    MobiusRoster loaded(name);
+    CHECK(loaded.load());
+    CHECK_EQ(3, loaded.getCount());
+    for (uint8_t i = 0; i < 3; i++) {
+        CHECK(testAddress(i) == loaded.getAddress(i));
+    }
+    CHECK_EQ(BLE_ADDR_RANDOM, loaded.getAddress(0).getType());
+    CHECK_EQ(BLE_ADDR_RANDOM, loaded.getAddress(1).getType());
+    CHECK_EQ(BLE_ADDR_PUBLIC, loaded.getAddress(2).getType());
+
+    // loading replaces the current addresses
+    loaded.clear();
+    CHECK(loaded.add(testAddress(5)));
+    CHECK(loaded.load());
+    CHECK_EQ(3, loaded.getCount());
+    CHECK(!loaded.contains(testAddress(5)));
+
+    // an empty roster round trips too
+    loaded.clear();
+    CHECK(loaded.save());
+    CHECK(roster.load());
+    CHECK_EQ(0, roster.getCount());
+    remove(name);
+}
+
+MOBIUS_TEST(Roster, fullRosterRejectsNewAddresses) {
+    static const char* name = "roster_full";
+    remove(name);
+    MobiusRoster roster(name);
+    for (uint8_t i = 0; i < MOBIUS_ROSTER_CAPACITY; i++) {
+        CHECK(roster.add(testAddress(i)));
+    }
+    CHECK(!roster.add(testAddress(MOBIUS_ROSTER_CAPACITY)));
+    // known addresses can still be updated
+    CHECK(roster.add(testAddress(0, true)));
+    CHECK_EQ(MOBIUS_ROSTER_CAPACITY, roster.getCount());
+    CHECK(roster.save());
+
+    MobiusRoster loaded(name);
+    CHECK(loaded.load());
+    CHECK_EQ(MOBIUS_ROSTER_CAPACITY, loaded.getCount());
+    CHECK(testAddress(MOBIUS_ROSTER_CAPACITY - 1) == loaded.getAddress(MOBIUS_ROSTER_CAPACITY - 1));
+    CHECK(!loaded.contains(testAddress(MOBIUS_ROSTER_CAPACITY)));
+    remove(name);
+}
+
+MOBIUS_TEST(Roster, corruptFilesLoadEmpty) {
+    static const char* name = "roster_corrupt";
+    MobiusRoster roster(name);
+    CHECK(roster.add(testAddress(0)));
+    CHECK(roster.add(testAddress(1)));
+    CHECK(roster.save());
+
+    // cut short within the second entry
+    MobiusDeviceHandle handles[2] = { MobiusDeviceHandle(testAddress(0)), MobiusDeviceHandle(testAddress(1)) };
+    CHECK(writeFile(name, handles, sizeof handles - 3));
+    CHECK(!roster.load());
+    CHECK_EQ(0, roster.getCount());
+
+    // an empty address
+    handles[1] = MobiusDeviceHandle();
+    CHECK(writeFile(name, handles, sizeof handles));
+    CHECK(!roster.load());
+    CHECK_EQ(0, roster.getCount());
+
+    // an empty file is a valid empty roster
+    CHECK(writeFile(name, handles, 0));
+    CHECK(roster.load());
+    CHECK_EQ(0, roster.getCount());
+    remove(name);
+}
+
+MOBIUS_TEST(Roster, removeKeepsOrder) {
+    static const char* name = "roster_remove";
+    remove(name);
+    MobiusRoster roster(name);
+    for (uint8_t i = 0; i < 4; i++) {
+        CHECK(roster.add(testAddress(i)));
+    }
+    CHECK(roster.remove(testAddress(1)));
+    CHECK(!roster.remove(testAddress(1)));
+    CHECK(!roster.contains(testAddress(1)));
+    CHECK_EQ(3, roster.getCount());
+    CHECK(testAddress(0) == roster.getAddress(0));
+    CHECK(testAddress(2) == roster.getAddress(1));
+    CHECK(testAddress(3) == roster.getAddress(2));
+    CHECK(roster.save());
+
+    MobiusRoster loaded(name);
+    CHECK(loaded.load());
+    CHECK_EQ(3, loaded.getCount());
+    CHECK(testAddress(3) == loaded.getAddress(2));
+    // the freed slot takes a new address
+    CHECK(loaded.remove(testAddress(3)));
+    CHECK(loaded.add(testAddress(7)));
+    CHECK(testAddress(7) == loaded.getAddress(2));
+    remove(name);
+}
@@ -0,0 +1,163 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include "MobiusTest.h"
+#include "MobiusDevice.h"
+#include "MobiusMetrics.h"
+#include "MobiusRttEstimator.h"
+#include "MobiusSimulatedTransport.h"
+
+// the deadline every request had before the estimator
+static const uint32_t FIXED_TIMEOUT_MILLIS = 1000;
+static const uint32_t REQUESTS = 2000;
+static const uint8_t MAX_ATTEMPTS = 8;
+
+/*!
+ * A link with round trips between 'minMillis' and 'maxMillis' losing
+ * 'lossPercent' of the responses, in virtual time.
+ */
+struct ModelLink {
+    uint32_t minMillis;
+    uint32_t maxMillis;
+    uint8_t lossPercent;
+    uint32_t random;
+
+    ModelLink(uint32_t minMillis, uint32_t maxMillis, uint8_t lossPercent)
+        : minMillis(minMillis), maxMillis(maxMillis), lossPercent(lossPercent), random(1) {}
+
+    uint32_t next() {
+        // xorshift32, like the simulated transport
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        return random;
+    }
+};
+
+/*!
+ * Outcome of sending REQUESTS requests over a ModelLink.
+ */
+struct ModelResult {
+    uint64_t elapsedMillis = 0;
+    uint32_t completed = 0;
+    uint32_t falseTimeouts = 0; // the response was still on its way
+    uint32_t timeouts = 0;
+
+    uint32_t getThroughput() const {
+        // completed requests per virtual minute
+        return (uint32_t)(completed * 60000ULL / (elapsedMillis ? elapsedMillis : 1));
+    }
+};
+
+/*!
+ * Send REQUESTS requests over the 'link', waiting FIXED_TIMEOUT_MILLIS for
+ * each response unless an 'estimator' sets the timeout.
+ */
+static ModelResult runModel(ModelLink link, MobiusRttEstimator* estimator) {
+    ModelResult result;
+    for (uint32_t i = 0; i < REQUESTS; i++) {
+        for (uint8_t attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+            uint32_t rttMillis = link.minMillis + link.next() % (link.maxMillis - link.minMillis + 1);
+            bool lost = link.next() % 100 < link.lossPercent;
+            uint32_t timeoutMillis = estimator ? estimator->getTimeoutMillis() : FIXED_TIMEOUT_MILLIS;
+            if (!lost && rttMillis <= timeoutMillis) {
+                result.elapsedMillis += rttMillis;
+                result.completed++;
+                if (estimator && 0 == attempt) {
+                    estimator->addSample(rttMillis * 1000);
+                }
+                break;
+            }
+            result.elapsedMillis += timeoutMillis;
+            result.timeouts++;
+            result.falseTimeouts += lost ? 0 : 1;
+            if (estimator) {
+                estimator->backoff();
+            }
+        }
+    }
+    return result;
+}
+
+MOBIUS_TEST(RttEstimator, followsRfc6298) {
+    MobiusRttEstimator estimator;
+    CHECK_EQ(MOBIUS_RTO_INITIAL_MILLIS, estimator.getTimeoutMillis());
+    // SRTT = R, RTTVAR = R/2, RTO = SRTT + 4 RTTVAR
+    estimator.addSample(100000);
+    CHECK_EQ(300, estimator.getTimeoutMillis());
+    estimator.addSample(100000);
+    CHECK_EQ(100, estimator.getSmoothedMillis());
+    // the minimum applies to a steady link
+    for (uint8_t i = 0; i < 50; i++) {
+        estimator.addSample(20000);
+    }
+    CHECK_EQ(MOBIUS_RTO_MIN_MILLIS, estimator.getTimeoutMillis());
+    estimator.backoff();
+    CHECK_EQ(2 * MOBIUS_RTO_MIN_MILLIS, estimator.getTimeoutMillis());
+    for (uint8_t i = 0; i < 10; i++) {
+        estimator.backoff();
+    }
+    CHECK_EQ(MOBIUS_RTO_MAX_MILLIS, estimator.getTimeoutMillis());
+    // a sample ends the backoff
+    estimator.addSample(20000);
+    CHECK_EQ(MOBIUS_RTO_MIN_MILLIS, estimator.getTimeoutMillis());
+    CHECK_EQ(20, estimator.getMinMillis());
+    CHECK_EQ(100, estimator.getMaxMillis());
+    CHECK_EQ(53, estimator.getSampleCount());
+}
+
+MOBIUS_TEST(RttEstimator, detectsLossSoonerOnGoodLink) {
+    // a quick link losing some responses
+    ModelLink link(20, 60, 10);
+    ModelResult fixed = runModel(link, nullptr);
+    MobiusRttEstimator estimator;
+    ModelResult adaptive = runModel(link, &estimator);
+    fprintf(stderr, "  fixed: %u/min, %u false timeouts; adaptive: %u/min, %u false timeouts\n",
+            (unsigned)fixed.getThroughput(), (unsigned)fixed.falseTimeouts,
+            (unsigned)adaptive.getThroughput(), (unsigned)adaptive.falseTimeouts);
+    CHECK_EQ(REQUESTS, fixed.completed);
+    CHECK_EQ(REQUESTS, adaptive.completed);
+    CHECK_EQ(0, fixed.falseTimeouts);
+    CHECK_EQ(0, adaptive.falseTimeouts);
+    // a lost response is noticed after 200 ms rather than 1 s
+    CHECK(adaptive.getThroughput() > 2 * fixed.getThroughput());
+}
+
+MOBIUS_TEST(RttEstimator, avoidsFalseTimeoutsOnCongestedLink) {
+    // several connected pumps sharing the radio, round trips around the fixed deadline
+    ModelLink link(600, 1400, 0);
+    ModelResult fixed = runModel(link, nullptr);
+    MobiusRttEstimator estimator;
+    ModelResult adaptive = runModel(link, &estimator);
+    fprintf(stderr, "  fixed: %u/min, %u false timeouts; adaptive: %u/min, %u false timeouts\n",
+            (unsigned)fixed.getThroughput(), (unsigned)fixed.falseTimeouts,
+            (unsigned)adaptive.getThroughput(), (unsigned)adaptive.falseTimeouts);
+    CHECK_EQ(REQUESTS, adaptive.completed);
+    // about half the responses arrive after the fixed deadline
+    CHECK(fixed.falseTimeouts > REQUESTS / 4);
+    CHECK(adaptive.falseTimeouts < REQUESTS / 100);
+    CHECK(adaptive.getThroughput() > fixed.getThroughput());
+}
+
+MOBIUS_TEST(RttEstimator, deviceTimesJitteryLink) {
+    MobiusSimulatedTransport simulated;
+    simulated.setLatency(20, 20);
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    uint32_t timeouts = MobiusMetrics::getCount(MobiusCounter::timeouts);
+    for (uint8_t i = 0; i < 20; i++) {
+        CHECK(device.setScene(i + 1));
+    }
+    // no response took longer than the timeout
+    CHECK_EQ(timeouts, MobiusMetrics::getCount(MobiusCounter::timeouts));
+    const MobiusRttEstimator& rtt = device.getRoundTrip();
+    CHECK_EQ(20, rtt.getSampleCount());
+    CHECK(20 <= rtt.getMinMillis());
+    CHECK(rtt.getMinMillis() <= rtt.getAverageMillis());
+    CHECK(rtt.getAverageMillis() <= rtt.getMaxMillis());
+    CHECK(rtt.getMaxMillis() < 100);
+    // well below the fixed deadline
+    CHECK(rtt.getTimeoutMillis() < FIXED_TIMEOUT_MILLIS);
+    device.disconnect();
+}
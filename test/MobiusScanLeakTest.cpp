@@ -0,0 +1,78 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include "MobiusTest.h"
+#include "AllocationCounter.h"
+#include "MobiusDevice.h"
+#include "MobiusHostDevice.h"
+
+static const uint32_t CYCLES = 2000;
+static const uint32_t WARM_UP_CYCLES = 10;
+
+/*!
+ * Listener ignoring every event, so nothing is logged.
+ */
+struct QuietListener : MobiusDeviceEventListener {
+};
+
+static QuietListener listener;
+
+/*!
+ * Scan for the single pump, connect to it, set a scene and disconnect.
+ */
+static bool cycle(uint16_t sceneId) {
+    MobiusDevice found[1];
+    if (1 != MobiusDevice::scanForMobiusDevices(1, found)) {
+        return false;
+    }
+    // a copy shares nothing with the device found
+    MobiusDevice device = found[0];
+    bool isSet = device.connect() && device.setScene(sceneId);
+    device.disconnect();
+    return isSet;
+}
+
+MOBIUS_TEST(ScanLeak, scanConnectCyclesDoNotLeak) {
+    MobiusDevice::init(&listener);
+    MobiusHostDevice pump("c4:4f:33:0b:2c:01");
+    // the first cycles create the client and fill the caches
+    for (uint32_t i = 0; i < WARM_UP_CYCLES; i++) {
+        CHECK(cycle(i + 1));
+    }
+    int64_t live = AllocationCounter::getLive();
+    uint64_t allocations = AllocationCounter::getAllocations();
+    for (uint32_t i = 0; i < CYCLES; i++) {
+        CHECK(cycle(i % 1000 + 1));
+    }
+    fprintf(stderr, "  %u cycles: %llu allocations, %lld still live\n", (unsigned)CYCLES,
+            (unsigned long long)(AllocationCounter::getAllocations() - allocations),
+            (long long)(AllocationCounter::getLive() - live));
+    CHECK_EQ(live, AllocationCounter::getLive());
+    uint32_t scene = 0;
+    CHECK(pump.simulated.getAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, scene));
+    CHECK_EQ((CYCLES - 1) % 1000 + 1, scene);
+}
+
+MOBIUS_TEST(ScanLeak, copiedDevicesDoNotLeak) {
+    MobiusHostDevice pump("c4:4f:33:0b:2c:02");
+    int64_t live = AllocationCounter::getLive();
+    for (uint32_t i = 0; i < CYCLES; i++) {
+        MobiusDevice devices[2];
+        devices[0] = MobiusDevice(NimBLEAddress(std::string("c4:4f:33:0b:2c:02")));
+        devices[1] = devices[0];
+        MobiusDevice moved(std::move(devices[1]));
+        devices[0] = std::move(moved);
+    }
+    CHECK_EQ(live, AllocationCounter::getLive());
+}
+
+MOBIUS_TEST(ScanLeak, deviceSizeIsPinned) {
+    // a scanned device holds a 7 byte handle rather than an advertisement copy
+    CHECK_EQ(7u, sizeof(MobiusDeviceHandle));
+    fprintf(stderr, "  MobiusDevice %u bytes: transport %u, cache %u, round trip %u\n", (unsigned)sizeof(MobiusDevice),
+            (unsigned)sizeof(MobiusNimBLETransport), (unsigned)sizeof(MobiusAttributeCache),
+            (unsigned)sizeof(MobiusRttEstimator));
+    // host build (64-bit pointers); update deliberately when a member is added
+    CHECK_EQ(272u, sizeof(MobiusDevice));
+}
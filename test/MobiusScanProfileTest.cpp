@@ -0,0 +1,101 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "MobiusTest.h"
+#include "MobiusDevice.h"
+#include "MobiusHostDevice.h"
+#include "MobiusScanProfile.h"
+
+/*!
+ * Listener ignoring every event, so nothing is logged.
+ */
+struct QuietListener : MobiusDeviceEventListener {
+};
+
+static QuietListener listener;
+
+/*!
+ * Wait until the scanner is scanning again with the given scan 'interval'.
+ */
+static bool awaitInterval(uint16_t interval, uint32_t timeoutMillis) {
+    BLEScan* scanner = BLEDevice::getScan();
+    for (uint32_t waited = 0; waited < timeoutMillis; waited += 10) {
+        // the parameters change just before the scan restarts
+        if (interval == scanner->getInterval() && scanner->isScanning()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+MOBIUS_TEST(ScanProfile, forProfileGivesScanParameters) {
+    MobiusScanParameters fast = MobiusScanParameters::forProfile(MobiusScanProfile::fast_discovery);
+    CHECK_EQ(100, fast.intervalMillis);
+    CHECK_EQ(100, fast.windowMillis);
+    CHECK(fast.activeScan);
+    MobiusScanParameters balanced = MobiusScanParameters::forProfile(MobiusScanProfile::balanced);
+    CHECK_EQ(1349, balanced.intervalMillis);
+    CHECK_EQ(449, balanced.windowMillis);
+    CHECK(balanced.activeScan);
+    MobiusScanParameters lowPower = MobiusScanParameters::forProfile(MobiusScanProfile::low_power);
+    CHECK_EQ(5120, lowPower.intervalMillis);
+    CHECK_EQ(100, lowPower.windowMillis);
+    CHECK(!lowPower.activeScan);
+    // adaptive starts out as fast_discovery
+    MobiusScanParameters adaptive = MobiusScanParameters::forProfile(MobiusScanProfile::adaptive);
+    CHECK_EQ(fast.intervalMillis, adaptive.intervalMillis);
+    CHECK_EQ(fast.windowMillis, adaptive.windowMillis);
+    CHECK(adaptive.activeScan);
+
+    CHECK(1.0f == fast.getDutyCycle());
+    CHECK(balanced.getDutyCycle() < fast.getDutyCycle());
+    CHECK(lowPower.getDutyCycle() < balanced.getDutyCycle());
+    MobiusScanParameters none = { 0, 0, false };
+    CHECK(0.0f == none.getDutyCycle());
+}
+
+MOBIUS_TEST(ScanProfile, setScanProfileAppliesParameters) {
+    MobiusDevice::init(&listener);
+    BLEScan* scanner = BLEDevice::getScan();
+    MobiusDevice::setScanProfile(MobiusScanProfile::low_power);
+    CHECK_EQ(5120, scanner->getInterval());
+    CHECK_EQ(100, scanner->getWindow());
+    CHECK(!scanner->getActiveScan());
+    MobiusDevice::setScanProfile(MobiusScanProfile::balanced);
+    CHECK_EQ(1349, scanner->getInterval());
+    CHECK_EQ(449, scanner->getWindow());
+    CHECK(scanner->getActiveScan());
+}
+
+MOBIUS_TEST(ScanProfile, adaptiveSwitchesWithPresence) {
+    static const char* address = "c4:4f:33:0b:3c:01";
+    MobiusPresenceRegistry registry(300);
+    std::unique_ptr<MobiusHostDevice> pump(new MobiusHostDevice(address));
+    BLEAddress expected[] = { BLEAddress(std::string(address)) };
+    MobiusDevice::setExpectedDevices(expected, 1);
+    MobiusDevice::setScanProfile(MobiusScanProfile::adaptive);
+    CHECK_EQ(100, BLEDevice::getScan()->getInterval());
+    CHECK(MobiusDevice::startPresenceTracking(&registry));
+
+    // the expected pump is present, so scanning slows down
+    CHECK(awaitInterval(5120, 5000));
+    CHECK(!BLEDevice::getScan()->getActiveScan());
+
+    // it stops advertising, so scanning speeds up to find it again
+    pump.reset();
+    CHECK(awaitInterval(100, 5000));
+    CHECK(BLEDevice::getScan()->getActiveScan());
+
+    // and slows down again once it's back
+    pump.reset(new MobiusHostDevice(address));
+    CHECK(awaitInterval(5120, 5000));
+
+    MobiusDevice::stopPresenceTracking();
+    MobiusDevice::setScanProfile(MobiusScanProfile::balanced);
+    CHECK_EQ(1349, BLEDevice::getScan()->getInterval());
+}
@@ -0,0 +1,79 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "MobiusTest.h"
+#include "AllocationCounter.h"
+#include "MobiusDevice.h"
+#include "MobiusHostDevice.h"
+
+/*!
+ * Listener ignoring every event, so nothing is logged.
+ */
+struct QuietListener : MobiusDeviceEventListener {
+};
+
+static QuietListener listener;
+
+MOBIUS_TEST(Scan, initReusesTheScanCallbacks) {
+    MobiusDevice::init(&listener);
+    NimBLEAdvertisedDeviceCallbacks* callbacks = BLEDevice::getScan()->getAdvertisedDeviceCallbacks();
+    CHECK(nullptr != callbacks);
+    int64_t live = AllocationCounter::getLive();
+    for (int i = 0; i < 10; i++) {
+        MobiusDevice::init(&listener);
+    }
+    CHECK(callbacks == BLEDevice::getScan()->getAdvertisedDeviceCallbacks());
+    CHECK_EQ(live, AllocationCounter::getLive());
+}
+
+MOBIUS_TEST(Scan, deliversEachAddressOnce) {
+    MobiusHostDevice first("c4:4f:33:0b:5e:01");
+    MobiusHostDevice second("c4:4f:33:0b:5e:02");
+    MobiusHostDevice third("c4:4f:33:0b:5e:03");
+    BLEScan* scanner = BLEDevice::getScan();
+    // every advertisement is repeated, as for presence tracking
+    scanner->setAdvertisedDeviceCallbacks(scanner->getAdvertisedDeviceCallbacks(), true);
+    std::atomic<uint32_t> found(0);
+    CHECK(MobiusDevice::startScan(0, [&found](MobiusDevice&) { found++; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    MobiusDevice::stopScan();
+    scanner->setAdvertisedDeviceCallbacks(scanner->getAdvertisedDeviceCallbacks(), false);
+    CHECK(!scanner->isScanning());
+    CHECK_EQ(3u, found.load());
+}
+
+MOBIUS_TEST(Scan, fillsNoMoreThanTheBuffer) {
+    MobiusHostDevice first("c4:4f:33:0b:5e:11");
+    MobiusHostDevice second("c4:4f:33:0b:5e:12");
+    MobiusHostDevice third("c4:4f:33:0b:5e:13");
+    MobiusDevice devices[3];
+    // no expected count, so all three are found
+    CHECK_EQ(2, MobiusDevice::scanForMobiusDevices(1, devices, 2, 0));
+    BLEAddress address;
+    CHECK(devices[0].getAddress(address));
+    CHECK(devices[1].getAddress(address));
+    CHECK(!devices[2].getAddress(address));
+}
+
+MOBIUS_TEST(Scan, stopsAtTheExpectedCount) {
+    MobiusHostDevice first("c4:4f:33:0b:5e:21");
+    MobiusHostDevice second("c4:4f:33:0b:5e:22");
+    MobiusHostDevice third("c4:4f:33:0b:5e:23");
+    MobiusDevice devices[3];
+    CHECK_EQ(1, MobiusDevice::scanForMobiusDevices(1, devices, 3, 1));
+    BLEAddress address;
+    CHECK(!devices[1].getAddress(address));
+
+    // a scan until stopped ends by itself once the expected devices are found
+    std::atomic<uint32_t> found(0);
+    CHECK(MobiusDevice::startScan(0, [&found](MobiusDevice&) { found++; }, 2));
+    for (int i = 0; i < 100 && BLEDevice::getScan()->isScanning(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(!BLEDevice::getScan()->isScanning());
+    CHECK_EQ(2u, found.load());
+}
@@ -0,0 +1,155 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <thread>
+#include <esp_timer.h>
+#include "MobiusTest.h"
+#include "MobiusDevice.h"
+#include "MobiusSimulatedTransport.h"
+
+static const uint8_t DEVICE_COUNT = 6;
+static const uint32_t LATENCY_MILLIS = 20;
+static const uint32_t SCENES = 5;
+
+/*!
+ * Set 'SCENES' scenes on the 'device', counting the failures.
+ */
+static void setScenes(MobiusDevice& device, uint16_t firstScene, std::atomic<uint32_t>& failures) {
+    for (uint16_t i = 0; i < SCENES; i++) {
+        if (!device.setScene(firstScene + i)) {
+            failures++;
+        }
+    }
+}
+
+MOBIUS_TEST(Session, devicesRunInParallel) {
+    MobiusSimulatedTransport simulated[DEVICE_COUNT];
+    MobiusDevice devices[DEVICE_COUNT];
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        simulated[i].setLatency(LATENCY_MILLIS);
+        devices[i] = MobiusDevice(&simulated[i]);
+        CHECK(devices[i].connect());
+    }
+    // one device alone
+    std::atomic<uint32_t> failures(0);
+    int64_t start = esp_timer_get_time();
+    setScenes(devices[0], 1, failures);
+    int64_t oneMicros = esp_timer_get_time() - start;
+
+    // every device at once, each with different scenes
+    start = esp_timer_get_time();
+    std::thread threads[DEVICE_COUNT];
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        MobiusDevice& device = devices[i];
+        threads[i] = std::thread([&device, &failures, i] { setScenes(device, 100 * (i + 1), failures); });
+    }
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        threads[i].join();
+    }
+    int64_t allMicros = esp_timer_get_time() - start;
+    fprintf(stderr, "  1 device %lld us, %u devices %lld us\n", (long long)oneMicros, DEVICE_COUNT, (long long)allMicros);
+    CHECK_EQ(0, failures.load());
+    // near the time of one device, far from DEVICE_COUNT times it
+    CHECK(allMicros < 2 * oneMicros);
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        uint32_t scene = 0;
+        CHECK(simulated[i].getAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, scene));
+        CHECK_EQ(100 * (i + 1) + SCENES - 1, scene);
+        devices[i].disconnect();
+    }
+}
+
+MOBIUS_TEST(Session, setSceneOnAllFansOut) {
+    MobiusSimulatedTransport simulated[DEVICE_COUNT];
+    MobiusDevice devices[DEVICE_COUNT];
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        simulated[i].setLatency(LATENCY_MILLIS);
+        devices[i] = MobiusDevice(&simulated[i]);
+        CHECK(devices[i].connect());
+    }
+    int64_t start = esp_timer_get_time();
+    CHECK_EQ(DEVICE_COUNT, MobiusDevice::setSceneOnAll(devices, DEVICE_COUNT, 42));
+    int64_t elapsedMicros = esp_timer_get_time() - start;
+    // a single round trip, not one per device
+    CHECK(elapsedMicros < 2 * LATENCY_MILLIS * 1000);
+    for (uint8_t i = 0; i < DEVICE_COUNT; i++) {
+        uint32_t scene = 0;
+        CHECK(simulated[i].getAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, scene));
+        CHECK_EQ(42, scene);
+        devices[i].disconnect();
+    }
+}
+
+MOBIUS_TEST(Session, setSceneOnAllCountsFailures) {
+    MobiusSimulatedTransport simulated[3];
+    MobiusDevice devices[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        devices[i] = MobiusDevice(&simulated[i]);
+    }
+    CHECK(devices[0].connect());
+    CHECK(devices[2].connect());
+    // the second device is not connected
+    CHECK_EQ(2, MobiusDevice::setSceneOnAll(devices, 3, 7));
+    devices[0].disconnect();
+    devices[2].disconnect();
+}
+
+MOBIUS_TEST(Session, setSceneOnAllBeyondFramePool) {
+    static const uint8_t count = MOBIUS_FRAME_POOL_SIZE + 3;
+    MobiusSimulatedTransport simulated[count];
+    MobiusDevice devices[count];
+    for (uint8_t i = 0; i < count; i++) {
+        devices[i] = MobiusDevice(&simulated[i]);
+        CHECK(devices[i].connect());
+    }
+    CHECK_EQ(count, MobiusDevice::setSceneOnAll(devices, count, 12));
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t scene = 0;
+        CHECK(simulated[i].getAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, scene));
+        CHECK_EQ(12, scene);
+    }
+
+    // without free frames every device fails, none is written to
+    MobiusFrame* taken[MOBIUS_FRAME_POOL_SIZE];
+    for (uint8_t i = 0; i < MOBIUS_FRAME_POOL_SIZE; i++) {
+        taken[i] = MobiusFramePool::acquire();
+    }
+    uint8_t successCount = MobiusDevice::setSceneOnAll(devices, 2, 13);
+    for (uint8_t i = 0; i < MOBIUS_FRAME_POOL_SIZE; i++) {
+        MobiusFramePool::release(taken[i]);
+    }
+    CHECK_EQ(0, successCount);
+    CHECK_EQ(1, simulated[0].getRequestCount());
+    for (uint8_t i = 0; i < count; i++) {
+        devices[i].disconnect();
+    }
+}
+
+MOBIUS_TEST(Session, setSceneOnAllWritesThroughCache) {
+    MobiusSimulatedTransport simulated[2];
+    MobiusDevice devices[2];
+    for (uint8_t i = 0; i < 2; i++) {
+        devices[i] = MobiusDevice(&simulated[i]);
+        devices[i].setCacheTtl(60000);
+        CHECK(devices[i].connect());
+    }
+    CHECK_EQ(2, MobiusDevice::setSceneOnAll(devices, 2, 21));
+    // served from the cache, no GET is sent
+    CHECK_EQ(21, devices[0].getCurrentScene());
+    CHECK_EQ(1, simulated[0].getRequestCount());
+
+    // an unconfirmed scene is no longer cached
+    simulated[1].setLossRate(100);
+    MobiusDevice::setMaxRetransmissions(0);
+    uint8_t successCount = MobiusDevice::setSceneOnAll(devices, 2, 22);
+    MobiusDevice::setMaxRetransmissions(1);
+    CHECK_EQ(1, successCount);
+    simulated[1].setLossRate(0);
+    uint32_t requestCount = simulated[1].getRequestCount();
+    CHECK_EQ(22, devices[1].getCurrentScene());
+    CHECK_EQ(requestCount + 1, simulated[1].getRequestCount());
+    for (uint8_t i = 0; i < 2; i++) {
+        devices[i].disconnect();
+    }
+}
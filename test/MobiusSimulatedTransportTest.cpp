@@ -0,0 +1,172 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include <cstring>
+#include <mutex>
+#include <esp_timer.h>
+#include "MobiusTest.h"
+#include "MobiusCRC.h"
+#include "MobiusDevice.h"
+#include "MobiusSimulatedTransport.h"
+
+/*!
+ * Receiver keeping the fragments of the responses.
+ */
+struct FragmentCollector : MobiusTransport::Receiver {
+    std::mutex mutex;
+    MobiusFrame received;
+    uint32_t fragments = 0;
+    uint32_t finals = 0;
+
+    void onReceive(MobiusTransport::Channel channel, const uint8_t* data, size_t length) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (received.size + length <= MobiusFrame::CAPACITY) {
+            memcpy(&received.data[received.size], data, length);
+            received.size += length;
+        }
+        fragments++;
+        finals += (MobiusTransport::Channel::final == channel) ? 1 : 0;
+    }
+};
+
+/*!
+ * Build a C2 request for the 'data' into 'request'.
+ */
+static void buildRequest(uint8_t opCode, uint16_t messageId, const uint8_t* data, uint16_t size, MobiusFrame& request) {
+    request.data[0] = 0x02;
+    request.data[1] = Mobius::OP_GROUP_REQUEST;
+    request.data[2] = opCode;
+    request.data[3] = (uint8_t)messageId;
+    request.data[4] = (uint8_t)(messageId >> 8);
+    request.data[5] = 0x00;
+    request.data[6] = 0x00;
+    request.data[7] = (uint8_t)size;
+    request.data[8] = (uint8_t)(size >> 8);
+    memcpy(&request.data[9], data, size);
+    request.size = 9 + size + 2;
+    uint16_t crc = MobiusCRC::crc16(&request.data[1], request.size - 3);
+    request.data[request.size - 2] = (uint8_t)crc;
+    request.data[request.size - 1] = (uint8_t)(crc >> 8);
+}
+
+MOBIUS_TEST(SimulatedTransport, answersGetWithConfirm) {
+    MobiusSimulatedTransport simulated;
+    simulated.setAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, 7, Mobius::SceneAttribute::VALUE_WIDTH);
+    FragmentCollector collector;
+    CHECK(simulated.connect(&collector));
+    MobiusFrame request;
+    buildRequest(Mobius::OP_CODE_GET, 0x1234, Mobius::ATTRIBUTE_CURRENT_SCENE, sizeof Mobius::ATTRIBUTE_CURRENT_SCENE, request);
+    CHECK(simulated.write(request.data, request.size));
+
+    const MobiusFrame& response = collector.received;
+    CHECK_EQ(1, collector.finals);
+    CHECK(11 <= response.size);
+    CHECK_EQ(0x02, response.data[0]);
+    CHECK_EQ(Mobius::OP_GROUP_CONFIRM, response.data[1]);
+    CHECK_EQ(Mobius::OP_CODE_GET, response.data[2]);
+    CHECK_EQ(0x34, response.data[3]);
+    CHECK_EQ(0x12, response.data[4]);
+    CHECK_EQ(response.size - 11, response.data[7] + (response.data[8] << 8));
+    uint16_t crc = MobiusCRC::crc16(&response.data[1], response.size - 3);
+    CHECK_EQ((uint8_t)crc, response.data[response.size - 2]);
+    CHECK_EQ((uint8_t)(crc >> 8), response.data[response.size - 1]);
+    // 0x00, then the descriptor, the value width and the value
+    CHECK_EQ(0x00, response.data[9]);
+    CHECK(0 == memcmp(&response.data[10], Mobius::ATTRIBUTE_CURRENT_SCENE, 4));
+    CHECK_EQ(Mobius::SceneAttribute::VALUE_WIDTH, response.data[14]);
+    CHECK_EQ(7, response.data[15]);
+}
+
+MOBIUS_TEST(SimulatedTransport, ignoresMalformedRequests) {
+    MobiusSimulatedTransport simulated;
+    FragmentCollector collector;
+    CHECK(simulated.connect(&collector));
+    MobiusFrame request;
+    buildRequest(Mobius::OP_CODE_GET, 1, Mobius::ATTRIBUTE_CURRENT_SCENE, sizeof Mobius::ATTRIBUTE_CURRENT_SCENE, request);
+    request.data[request.size - 1] ^= 0xff;
+    CHECK(simulated.write(request.data, request.size));
+    // truncated
+    CHECK(simulated.write(request.data, 8));
+    CHECK_EQ(2, simulated.getRequestCount());
+    CHECK_EQ(0, collector.fragments);
+}
+
+MOBIUS_TEST(SimulatedTransport, splitsResponsesIntoFragments) {
+    MobiusSimulatedTransport whole;
+    MobiusSimulatedTransport fragmented;
+    fragmented.setFragmentSize(4);
+    FragmentCollector wholeCollector;
+    FragmentCollector fragmentCollector;
+    CHECK(whole.connect(&wholeCollector));
+    CHECK(fragmented.connect(&fragmentCollector));
+    MobiusFrame request;
+    buildRequest(Mobius::OP_CODE_GET, 2, Mobius::ATTRIBUTE_CURRENT_SCENE, sizeof Mobius::ATTRIBUTE_CURRENT_SCENE, request);
+    CHECK(whole.write(request.data, request.size));
+    CHECK(fragmented.write(request.data, request.size));
+
+    CHECK_EQ(1, wholeCollector.fragments);
+    CHECK_EQ((wholeCollector.received.size + 3) / 4, fragmentCollector.fragments);
+    CHECK_EQ(1, fragmentCollector.finals);
+    CHECK_EQ(wholeCollector.received.size, fragmentCollector.received.size);
+    CHECK(0 == memcmp(wholeCollector.received.data, fragmentCollector.received.data, wholeCollector.received.size));
+}
+
+MOBIUS_TEST(SimulatedTransport, deviceSetsAndGetsScene) {
+    MobiusSimulatedTransport simulated;
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    CHECK(device.setScene(5));
+    uint32_t value = 0;
+    CHECK(simulated.getAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, value));
+    CHECK_EQ(5, value);
+    CHECK_EQ(5, device.getCurrentScene());
+    CHECK(device.setFeedScene());
+    CHECK_EQ(Mobius::FEED_SCENE_ID, device.getCurrentScene());
+    device.disconnect();
+}
+
+MOBIUS_TEST(SimulatedTransport, delaysResponses) {
+    MobiusSimulatedTransport simulated;
+    simulated.setLatency(30);
+    simulated.setFragmentSize(5);
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    int64_t start = esp_timer_get_time();
+    CHECK(device.setScene(9));
+    CHECK(30000 <= esp_timer_get_time() - start);
+    CHECK_EQ(9, device.getCurrentScene());
+    device.disconnect();
+}
+
+MOBIUS_TEST(SimulatedTransport, losesResponses) {
+    MobiusSimulatedTransport simulated;
+    simulated.setLossRate(100);
+    MobiusDevice device(&simulated);
+    MobiusDevice::setMaxRetransmissions(0);
+    CHECK(device.connect());
+    bool isSet = device.setScene(3);
+    MobiusDevice::setMaxRetransmissions(1);
+    CHECK(!isSet);
+    CHECK_EQ(1, simulated.getLostCount());
+    // the SET was applied, only its confirm was lost
+    uint32_t value = 0;
+    CHECK(simulated.getAttribute(Mobius::SceneAttribute::ATTRIBUTE_ID, value));
+    CHECK_EQ(3, value);
+    simulated.setLossRate(0);
+    CHECK(device.setScene(4));
+    device.disconnect();
+}
+
+MOBIUS_TEST(SimulatedTransport, outOfRangeDropsLink) {
+    MobiusSimulatedTransport simulated;
+    MobiusDevice device(&simulated);
+    CHECK(device.connect());
+    simulated.setInRange(false);
+    CHECK(!device.isConnected());
+    CHECK(!device.connect());
+    simulated.setInRange(true);
+    CHECK(device.connect());
+    CHECK(device.setScene(2));
+    device.disconnect();
+}
@@ -0,0 +1,76 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#ifndef _MobiusTest_h
+#define _MobiusTest_h
+
+#include <cstdint>
+#include <cstdio>
+
+/*!
+ * @brief A test case of the host test suite.
+ *
+ * Test cases are declared with MOBIUS_TEST(suite, name) and register
+ * themselves before main runs. Each suite is run as its own ctest test
+ * ("mobius_tests <suite>").
+ */
+struct MobiusTestCase {
+    const char* suite;
+    const char* name;
+    void (*run)();
+    MobiusTestCase* next;
+
+    /*!
+     * Register the test case (test cases are never unregistered).
+     */
+    MobiusTestCase(const char* suite, const char* name, void (*run)());
+
+    /*!
+     * Get the first registered test case (nullptr if none).
+     */
+    static MobiusTestCase* first();
+
+    /*!
+     * Record a failed check of the running test case.
+     */
+    static void fail(const char* file, int line, const char* expression);
+
+    /*!
+     * Check whether a check of the running test case failed.
+     */
+    static bool failed();
+};
+
+#define MOBIUS_TEST(suite, name) \
+    static void suite##_##name(); \
+    static MobiusTestCase suite##_##name##_case(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+/*!
+ * Fail (and end) the running test case unless 'expression' is true.
+ */
+#define CHECK(expression) \
+    do { \
+        if (!(expression)) { \
+            MobiusTestCase::fail(__FILE__, __LINE__, #expression); \
+            return; \
+        } \
+    } while (0)
+
+/*!
+ * Fail (and end) the running test case unless 'actual' equals 'expected',
+ * printing both as integers.
+ */
+#define CHECK_EQ(expected, actual) \
+    do { \
+        long long _expected = (long long)(expected); \
+        long long _actual = (long long)(actual); \
+        if (_expected != _actual) { \
+            fprintf(stderr, "  expected %lld, got %lld\n", _expected, _actual); \
+            MobiusTestCase::fail(__FILE__, __LINE__, #expected " == " #actual); \
+            return; \
+        } \
+    } while (0)
+
+#endif
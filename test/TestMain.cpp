@@ -0,0 +1,57 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * Runs the registered test cases, only those of the suite given as the
+ * first argument if any.
+ */
+
+#include <cstring>
+#include "MobiusTest.h"
+
+// registered test cases, in reverse order of registration
+static MobiusTestCase* registered = nullptr;
+static bool runningFailed = false;
+
+MobiusTestCase::MobiusTestCase(const char* suite, const char* name, void (*run)())
+    : suite(suite), name(name), run(run), next(registered) {
+    registered = this;
+}
+
+MobiusTestCase* MobiusTestCase::first() {
+    return registered;
+}
+
+void MobiusTestCase::fail(const char* file, int line, const char* expression) {
+    fprintf(stderr, "  %s:%d: CHECK(%s) failed\n", file, line, expression);
+    runningFailed = true;
+}
+
+bool MobiusTestCase::failed() {
+    return runningFailed;
+}
+
+int main(int argc, char** argv) {
+    const char* suite = (1 < argc) ? argv[1] : nullptr;
+    // run in the order declared
+    MobiusTestCase* cases[512];
+    int count = 0;
+    for (MobiusTestCase* test = MobiusTestCase::first(); test && count < 512; test = test->next) {
+        if (nullptr == suite || 0 == strcmp(suite, test->suite)) {
+            cases[count++] = test;
+        }
+    }
+    int failures = 0;
+    for (int i = count - 1; 0 <= i; i--) {
+        fprintf(stderr, "[ RUN      ] %s.%s\n", cases[i]->suite, cases[i]->name);
+        runningFailed = false;
+        cases[i]->run();
+        fprintf(stderr, "%s %s.%s\n", runningFailed ? "[  FAILED  ]" : "[       OK ]", cases[i]->suite, cases[i]->name);
+        failures += runningFailed ? 1 : 0;
+    }
+    fprintf(stderr, "%d of %d test cases passed\n", count - failures, count);
+    if (0 == count) {
+        fprintf(stderr, "No test cases%s%s\n", suite ? " in suite " : "", suite ? suite : "");
+        return 1;
+    }
+    return (0 == failures) ? 0 : 1;
+}
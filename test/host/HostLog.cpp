@@ -0,0 +1,62 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * ESP-IDF logging. Every enabled log site is formatted, as it would be on
+ * an ESP32 whose runtime level matches the compile-time level, so the cost
+ * of logging is kept. Messages are only written to stderr at or below the
+ * runtime level.
+ */
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+/*!
+ * Get the runtime level, from the MOBIUS_HOST_LOG environment variable unless set.
+ */
+static std::atomic<int>& runtimeLevel() {
+    static std::atomic<int> level(-1);
+    if (0 > level.load()) {
+        const char* value = getenv("MOBIUS_HOST_LOG");
+        level.store(value ? atoi(value) : (int)ESP_LOG_ERROR);
+    }
+    return level;
+}
+
+void esp_log_level_set(const char* tag, esp_log_level_t level) {
+    (void)tag;
+    runtimeLevel().store((int)level);
+}
+
+uint32_t esp_log_timestamp() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
+    (void)tag;
+    char message[256];
+    va_list arguments;
+    va_start(arguments, format);
+    vsnprintf(message, sizeof message, format, arguments);
+    va_end(arguments);
+    if ((int)level <= runtimeLevel().load()) {
+        fputs(message, stderr);
+    }
+}
+
+void esp_log_buffer_hexdump_internal(const char* tag, const void* buffer, uint16_t length, esp_log_level_t level) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(buffer);
+    for (uint16_t offset = 0; offset < length; offset += 16) {
+        char line[16 * 3 + 1];
+        int used = 0;
+        for (uint16_t i = offset; i < length && i < offset + 16; i++) {
+            used += snprintf(&line[used], sizeof line - used, "%02x ", bytes[i]);
+        }
+        line[used] = '\0';
+        esp_log_write(level, tag, "%s: %p   %s\n", tag, (const void*)&bytes[offset], line);
+    }
+}
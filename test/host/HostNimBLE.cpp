@@ -0,0 +1,744 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * NimBLE client API backed by NimBLEHostPeripherals. All state is guarded
+ * by one lock, which is released while simulating over the air delays and
+ * while calling back (onWrite, notifications, scan results).
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <NimBLEDevice.h>
+
+namespace {
+    std::recursive_mutex& hostLock() {
+        static std::recursive_mutex lock;
+        return lock;
+    }
+
+    std::vector<NimBLEHostPeripheral*>& peripherals() {
+        static std::vector<NimBLEHostPeripheral*> list;
+        return list;
+    }
+
+    std::vector<NimBLEClient*>& clients() {
+        static std::vector<NimBLEClient*> list;
+        return list;
+    }
+
+    void sleepMillis(uint32_t millis) {
+        if (0 < millis) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+        }
+    }
+
+    /*!
+     * Scanner state, shared by the (singleton) NimBLEScan.
+     */
+    struct ScanState {
+        NimBLEAdvertisedDeviceCallbacks* callbacks = nullptr;
+        bool wantDuplicates = false;
+        uint16_t interval = 100;
+        uint16_t window = 100;
+        bool active = false;
+        std::atomic<bool> scanning{false};
+        std::atomic<bool> stopRequested{false};
+        std::thread thread;
+
+        ~ScanState() {
+            stopRequested.store(true);
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    };
+
+    ScanState& scanState() {
+        static ScanState state;
+        return state;
+    }
+}
+
+/*!
+ * Helpers with access to the state of every host class.
+ */
+struct NimBLEHostAccess {
+    /*!
+     * Find the peripheral connected to the 'client'.
+     */
+    static NimBLEHostPeripheral* peripheralOf(const NimBLEClient* client) {
+        for (NimBLEHostPeripheral* peripheral : peripherals()) {
+            if (client == peripheral->_client) {
+                return peripheral;
+            }
+        }
+        return nullptr;
+    }
+
+    /*!
+     * Check whether the attributes of 'service' still match its peripheral.
+     */
+    static bool isCurrent(NimBLERemoteService* service) {
+        NimBLEHostPeripheral* peripheral = NimBLEHostAccess::peripheralOf(service->_client);
+        return service->_client->_connected && peripheral && service->_generation == peripheral->_generation;
+    }
+
+    static void deliverAdvertisements(std::vector<NimBLEAddress>& seen);
+};
+
+NimBLEUUID::NimBLEUUID() {}
+
+NimBLEUUID::NimBLEUUID(const std::string& uuid) : _value(uuid) {
+    std::transform(_value.begin(), _value.end(), _value.begin(), [](char c) { return (char)tolower(c); });
+}
+
+NimBLEUUID::NimBLEUUID(const char* uuid) : NimBLEUUID(std::string(uuid)) {}
+
+NimBLEUUID::NimBLEUUID(uint16_t uuid) {
+    char text[7];
+    snprintf(text, sizeof text, "0x%04x", uuid);
+    _value = text;
+}
+
+bool NimBLEUUID::equals(const NimBLEUUID& uuid) const {
+    return _value == uuid._value;
+}
+
+bool NimBLEUUID::operator==(const NimBLEUUID& rhs) const {
+    return equals(rhs);
+}
+
+bool NimBLEUUID::operator!=(const NimBLEUUID& rhs) const {
+    return !equals(rhs);
+}
+
+std::string NimBLEUUID::toString() const {
+    return _value;
+}
+
+NimBLEAddress::NimBLEAddress() : _address(), _type(BLE_ADDR_PUBLIC) {}
+
+NimBLEAddress::NimBLEAddress(ble_addr_t address) : _type(address.type) {
+    memcpy(_address, address.val, sizeof _address);
+}
+
+NimBLEAddress::NimBLEAddress(const uint8_t address[6], uint8_t type) : _type(type) {
+    // as NimBLE, the bytes are given most significant first
+    std::reverse_copy(address, address + sizeof _address, _address);
+}
+
+NimBLEAddress::NimBLEAddress(const std::string& stringAddress, uint8_t type) : _address(), _type(type) {
+    unsigned int bytes[6];
+    if (6 == sscanf(stringAddress.c_str(), "%2x:%2x:%2x:%2x:%2x:%2x",
+                    &bytes[5], &bytes[4], &bytes[3], &bytes[2], &bytes[1], &bytes[0])) {
+        for (int i = 0; i < 6; i++) {
+            _address[i] = (uint8_t)bytes[i];
+        }
+    }
+}
+
+bool NimBLEAddress::equals(const NimBLEAddress& otherAddress) const {
+    return 0 == memcmp(_address, otherAddress._address, sizeof _address);
+}
+
+const uint8_t* NimBLEAddress::getNative() const {
+    return _address;
+}
+
+uint8_t NimBLEAddress::getType() const {
+    return _type;
+}
+
+std::string NimBLEAddress::toString() const {
+    char text[18];
+    snprintf(text, sizeof text, "%02x:%02x:%02x:%02x:%02x:%02x",
+             _address[5], _address[4], _address[3], _address[2], _address[1], _address[0]);
+    return text;
+}
+
+bool NimBLEAddress::operator==(const NimBLEAddress& rhs) const {
+    return equals(rhs);
+}
+
+bool NimBLEAddress::operator!=(const NimBLEAddress& rhs) const {
+    return !equals(rhs);
+}
+
+NimBLEAdvertisedDevice::NimBLEAdvertisedDevice() : _rssi(0) {}
+
+NimBLEAdvertisedDevice::NimBLEAdvertisedDevice(const NimBLEAddress& address, const std::string& name, int rssi,
+                                               const std::vector<NimBLEUUID>& serviceUUIDs)
+    : _address(address), _name(name), _rssi(rssi), _serviceUUIDs(serviceUUIDs) {}
+
+NimBLEAddress NimBLEAdvertisedDevice::getAddress() {
+    return _address;
+}
+
+std::string NimBLEAdvertisedDevice::getName() {
+    return _name;
+}
+
+int NimBLEAdvertisedDevice::getRSSI() {
+    return _rssi;
+}
+
+bool NimBLEAdvertisedDevice::haveServiceUUID() {
+    return !_serviceUUIDs.empty();
+}
+
+bool NimBLEAdvertisedDevice::isAdvertisingService(const NimBLEUUID& uuid) {
+    for (const NimBLEUUID& serviceUUID : _serviceUUIDs) {
+        if (serviceUUID.equals(uuid)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string NimBLEAdvertisedDevice::toString() {
+    // the same fields NimBLE formats
+    std::string text = "Name: " + _name + ", Address: " + _address.toString();
+    for (const NimBLEUUID& serviceUUID : _serviceUUIDs) {
+        text += ", serviceUUID: " + serviceUUID.toString();
+    }
+    char rssi[16];
+    snprintf(rssi, sizeof rssi, ", rssi: %d", _rssi);
+    return text + rssi;
+}
+
+void NimBLEScan::setInterval(uint16_t intervalMSecs) {
+    scanState().interval = intervalMSecs;
+}
+
+void NimBLEScan::setWindow(uint16_t windowMSecs) {
+    scanState().window = windowMSecs;
+}
+
+void NimBLEScan::setActiveScan(bool active) {
+    scanState().active = active;
+}
+
+void NimBLEScan::setMaxResults(uint8_t maxResults) {
+    // results are never kept
+    (void)maxResults;
+}
+
+void NimBLEScan::setAdvertisedDeviceCallbacks(NimBLEAdvertisedDeviceCallbacks* callbacks, bool wantDuplicates) {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    scanState().callbacks = callbacks;
+    scanState().wantDuplicates = wantDuplicates;
+}
+
+/*!
+ * Deliver one advertisement of each peripheral in range, skipping the
+ * addresses 'seen' before unless duplicates are wanted.
+ */
+void NimBLEHostAccess::deliverAdvertisements(std::vector<NimBLEAddress>& seen) {
+    ScanState& state = scanState();
+    std::vector<NimBLEAdvertisedDevice> advertisements;
+    NimBLEAdvertisedDeviceCallbacks* callbacks;
+    {
+        std::lock_guard<std::recursive_mutex> lock(hostLock());
+        callbacks = state.callbacks;
+        for (NimBLEHostPeripheral* peripheral : peripherals()) {
+            if (!peripheral->advertising || !peripheral->inRange) {
+                continue;
+            }
+            bool duplicate = std::find(seen.begin(), seen.end(), peripheral->address) != seen.end();
+            if (duplicate && !state.wantDuplicates) {
+                continue;
+            }
+            if (!duplicate) {
+                seen.push_back(peripheral->address);
+            }
+            NimBLEAdvertisedDevice advertisement;
+            advertisement._address = peripheral->address;
+            advertisement._name = peripheral->name;
+            advertisement._rssi = peripheral->rssi;
+            for (const NimBLEHostPeripheral::Service& service : peripheral->_services) {
+                advertisement._serviceUUIDs.push_back(service.uuid);
+            }
+            advertisements.push_back(advertisement);
+        }
+    }
+    for (NimBLEAdvertisedDevice& advertisement : advertisements) {
+        if (state.stopRequested.load()) {
+            break;
+        }
+        if (callbacks) {
+            callbacks->onResult(&advertisement);
+        }
+    }
+}
+
+NimBLEScanResults NimBLEScan::start(uint32_t duration, bool isContinue) {
+    (void)duration;
+    (void)isContinue;
+    ScanState& state = scanState();
+    if (state.scanning.exchange(true)) {
+        return NimBLEScanResults();
+    }
+    state.stopRequested.store(false);
+    std::vector<NimBLEAddress> seen;
+    NimBLEHostAccess::deliverAdvertisements(seen);
+    state.scanning.store(false);
+    return NimBLEScanResults();
+}
+
+bool NimBLEScan::start(uint32_t duration, void (*scanCompleteCB)(NimBLEScanResults), bool isContinue) {
+    (void)isContinue;
+    ScanState& state = scanState();
+    if (state.scanning.exchange(true)) {
+        return false;
+    }
+    state.stopRequested.store(false);
+    if (state.thread.joinable()) {
+        // a previous scan (possibly the calling one, from its completion)
+        if (std::this_thread::get_id() == state.thread.get_id()) {
+            state.thread.detach();
+        } else {
+            state.thread.join();
+        }
+    }
+    state.thread = std::thread([duration, scanCompleteCB] {
+        ScanState& state = scanState();
+        std::vector<NimBLEAddress> seen;
+        do {
+            NimBLEHostAccess::deliverAdvertisements(seen);
+            if (0 != duration) {
+                break;
+            }
+            sleepMillis(10);
+        } while (!state.stopRequested.load());
+        state.scanning.store(false);
+        if (scanCompleteCB) {
+            scanCompleteCB(NimBLEScanResults());
+        }
+    });
+    return true;
+}
+
+bool NimBLEScan::stop() {
+    ScanState& state = scanState();
+    state.stopRequested.store(true);
+    if (state.thread.joinable() && std::this_thread::get_id() != state.thread.get_id()) {
+        state.thread.join();
+    }
+    return true;
+}
+
+bool NimBLEScan::isScanning() {
+    return scanState().scanning.load();
+}
+
+void NimBLEScan::clearResults() {}
+
+uint16_t NimBLEScan::getInterval() const {
+    return scanState().interval;
+}
+
+uint16_t NimBLEScan::getWindow() const {
+    return scanState().window;
+}
+
+bool NimBLEScan::getActiveScan() const {
+    return scanState().active;
+}
+
+NimBLEAdvertisedDeviceCallbacks* NimBLEScan::getAdvertisedDeviceCallbacks() const {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    return scanState().callbacks;
+}
+
+NimBLEUUID NimBLERemoteDescriptor::getUUID() {
+    return _uuid;
+}
+
+bool NimBLERemoteDescriptor::writeValue(const uint8_t* data, size_t length, bool response) {
+    (void)response;
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    NimBLERemoteService* service = _characteristic->_service;
+    if (!NimBLEHostAccess::isCurrent(service) || 0 == length) {
+        return false;
+    }
+    bool subscribe = (0 != (data[0] & 0x01));
+    if (subscribe && !_characteristic->_subscribed) {
+        NimBLEHostAccess::peripheralOf(service->_client)->_subscribeCount++;
+    }
+    _characteristic->_subscribed = subscribe;
+    return true;
+}
+
+NimBLERemoteCharacteristic::~NimBLERemoteCharacteristic() {
+    delete _descriptor;
+}
+
+NimBLEUUID NimBLERemoteCharacteristic::getUUID() {
+    return _uuid;
+}
+
+uint16_t NimBLERemoteCharacteristic::getHandle() {
+    return _handle;
+}
+
+bool NimBLERemoteCharacteristic::canWriteNoResponse() {
+    return _writeNoResponse;
+}
+
+bool NimBLERemoteCharacteristic::canNotify() {
+    return _notify;
+}
+
+bool NimBLERemoteCharacteristic::registerForNotify(notify_callback callback, bool notifications, bool response) {
+    {
+        std::lock_guard<std::recursive_mutex> lock(hostLock());
+        _callback = callback;
+    }
+    // as NimBLE, subscribes straight away (or unsubscribes without a callback)
+    uint8_t value[2] = {(uint8_t)((callback && notifications) ? 0x01 : 0x00), 0x00};
+    NimBLERemoteDescriptor* descriptor = getDescriptor(NimBLEUUID((uint16_t)0x2902));
+    return descriptor && descriptor->writeValue(value, sizeof value, response);
+}
+
+NimBLERemoteDescriptor* NimBLERemoteCharacteristic::getDescriptor(const NimBLEUUID& uuid) {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    if (!_notify || !uuid.equals(NimBLEUUID((uint16_t)0x2902))) {
+        return nullptr;
+    }
+    if (nullptr == _descriptor) {
+        NimBLEHostPeripheral* peripheral = NimBLEHostAccess::peripheralOf(_service->_client);
+        if (nullptr == peripheral) {
+            return nullptr;
+        }
+        peripheral->_discoveryCount++;
+        _descriptor = new NimBLERemoteDescriptor();
+        _descriptor->_characteristic = this;
+        _descriptor->_uuid = uuid;
+    }
+    return _descriptor;
+}
+
+bool NimBLERemoteCharacteristic::writeValue(const uint8_t* data, size_t length, bool response) {
+    (void)response;
+    std::function<void(const NimBLEUUID&, const uint8_t*, size_t)> onWrite;
+    {
+        std::lock_guard<std::recursive_mutex> lock(hostLock());
+        if (!NimBLEHostAccess::isCurrent(_service)) {
+            return false;
+        }
+        onWrite = NimBLEHostAccess::peripheralOf(_service->_client)->onWrite;
+    }
+    if (onWrite) {
+        onWrite(_uuid, data, length);
+    }
+    return true;
+}
+
+NimBLERemoteService* NimBLERemoteCharacteristic::getRemoteService() {
+    return _service;
+}
+
+NimBLERemoteService::~NimBLERemoteService() {
+    for (NimBLERemoteCharacteristic* characteristic : _characteristics) {
+        delete characteristic;
+    }
+}
+
+NimBLEUUID NimBLERemoteService::getUUID() {
+    return _uuid;
+}
+
+NimBLERemoteCharacteristic* NimBLERemoteService::getCharacteristic(const NimBLEUUID& uuid) {
+    NimBLEHostPeripheral* peripheral;
+    {
+        std::lock_guard<std::recursive_mutex> lock(hostLock());
+        for (NimBLERemoteCharacteristic* characteristic : _characteristics) {
+            if (characteristic->_uuid.equals(uuid)) {
+                return characteristic;
+            }
+        }
+        peripheral = NimBLEHostAccess::peripheralOf(_client);
+        if (nullptr == peripheral || !_characteristics.empty()) {
+            return nullptr;
+        }
+    }
+    sleepMillis(peripheral->discoveryDelayMillis);
+    // discover all the characteristics of the service
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    if (peripheral != NimBLEHostAccess::peripheralOf(_client)) {
+        return nullptr;
+    }
+    peripheral->_discoveryCount++;
+    for (const NimBLEHostPeripheral::Service& service : peripheral->_services) {
+        if (!service.uuid.equals(_uuid)) {
+            continue;
+        }
+        uint16_t handle = (uint16_t)(0x10 + 0x10 * (peripheral->_generation % 16));
+        for (const NimBLEHostPeripheral::Characteristic& offered : service.characteristics) {
+            NimBLERemoteCharacteristic* characteristic = new NimBLERemoteCharacteristic();
+            characteristic->_service = this;
+            characteristic->_uuid = offered.uuid;
+            characteristic->_handle = handle++;
+            characteristic->_writeNoResponse = offered.writeNoResponse;
+            characteristic->_notify = offered.notify;
+            characteristic->_subscribed = false;
+            characteristic->_descriptor = nullptr;
+            _characteristics.push_back(characteristic);
+        }
+    }
+    for (NimBLERemoteCharacteristic* characteristic : _characteristics) {
+        if (characteristic->_uuid.equals(uuid)) {
+            return characteristic;
+        }
+    }
+    return nullptr;
+}
+
+NimBLEClient* NimBLERemoteService::getClient() {
+    return _client;
+}
+
+NimBLEClient::NimBLEClient() : _connected(false) {}
+
+NimBLEClient::~NimBLEClient() {
+    deleteServices();
+}
+
+bool NimBLEClient::connect(const NimBLEAddress& address, bool deleteAttributes) {
+    NimBLEHostPeripheral* peripheral = nullptr;
+    {
+        std::lock_guard<std::recursive_mutex> lock(hostLock());
+        if (_connected) {
+            return false;
+        }
+        for (NimBLEHostPeripheral* candidate : peripherals()) {
+            // the address type has to match, as over the air
+            if (candidate->address.equals(address) && candidate->address.getType() == address.getType()) {
+                peripheral = candidate;
+            }
+        }
+        if (nullptr == peripheral || !peripheral->inRange || nullptr != peripheral->_client) {
+            return false;
+        }
+        if (deleteAttributes) {
+            deleteServices();
+        }
+    }
+    sleepMillis(peripheral->connectDelayMillis);
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    bool registered = std::find(peripherals().begin(), peripherals().end(), peripheral) != peripherals().end();
+    if (!registered || !peripheral->inRange || nullptr != peripheral->_client) {
+        return false;
+    }
+    _peerAddress = address;
+    _connected = true;
+    peripheral->_client = this;
+    peripheral->_connectCount++;
+    return true;
+}
+
+int NimBLEClient::disconnect() {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    NimBLEHostPeripheral* peripheral = NimBLEHostAccess::peripheralOf(this);
+    if (peripheral) {
+        peripheral->_client = nullptr;
+    }
+    _connected = false;
+    return 0;
+}
+
+bool NimBLEClient::isConnected() {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    return _connected;
+}
+
+NimBLEAddress NimBLEClient::getPeerAddress() {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    return _peerAddress;
+}
+
+NimBLERemoteService* NimBLEClient::getService(const NimBLEUUID& uuid) {
+    NimBLEHostPeripheral* peripheral;
+    {
+        std::lock_guard<std::recursive_mutex> lock(hostLock());
+        for (NimBLERemoteService* service : _services) {
+            if (service->_uuid.equals(uuid)) {
+                return service;
+            }
+        }
+        peripheral = NimBLEHostAccess::peripheralOf(this);
+        if (nullptr == peripheral) {
+            return nullptr;
+        }
+    }
+    sleepMillis(peripheral->discoveryDelayMillis);
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    if (peripheral != NimBLEHostAccess::peripheralOf(this)) {
+        return nullptr;
+    }
+    peripheral->_discoveryCount++;
+    for (const NimBLEHostPeripheral::Service& offered : peripheral->_services) {
+        if (offered.uuid.equals(uuid)) {
+            NimBLERemoteService* service = new NimBLERemoteService();
+            service->_client = this;
+            service->_uuid = uuid;
+            service->_generation = peripheral->_generation;
+            _services.push_back(service);
+            return service;
+        }
+    }
+    return nullptr;
+}
+
+void NimBLEClient::deleteServices() {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    for (NimBLERemoteService* service : _services) {
+        delete service;
+    }
+    _services.clear();
+}
+
+void NimBLEDevice::init(const std::string& deviceName) {
+    (void)deviceName;
+}
+
+NimBLEScan* NimBLEDevice::getScan() {
+    static NimBLEScan scan;
+    return &scan;
+}
+
+NimBLEClient* NimBLEDevice::createClient() {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    if (NIMBLE_MAX_CONNECTIONS <= clients().size()) {
+        return nullptr;
+    }
+    NimBLEClient* client = new NimBLEClient();
+    clients().push_back(client);
+    return client;
+}
+
+bool NimBLEDevice::deleteClient(NimBLEClient* client) {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    std::vector<NimBLEClient*>& list = clients();
+    std::vector<NimBLEClient*>::iterator found = std::find(list.begin(), list.end(), client);
+    if (list.end() == found) {
+        return false;
+    }
+    list.erase(found);
+    client->disconnect();
+    delete client;
+    return true;
+}
+
+NimBLEClient* NimBLEDevice::getClientByPeerAddress(const NimBLEAddress& peerAddress) {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    for (NimBLEClient* client : clients()) {
+        if (client->_peerAddress.equals(peerAddress)) {
+            return client;
+        }
+    }
+    return nullptr;
+}
+
+NimBLEClient* NimBLEDevice::getDisconnectedClient() {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    for (NimBLEClient* client : clients()) {
+        if (!client->_connected) {
+            return client;
+        }
+    }
+    return nullptr;
+}
+
+size_t NimBLEDevice::getClientListSize() {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    return clients().size();
+}
+
+NimBLEHostPeripheral::NimBLEHostPeripheral(const NimBLEAddress& address) : address(address) {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    peripherals().push_back(this);
+}
+
+NimBLEHostPeripheral::~NimBLEHostPeripheral() {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    dropLink();
+    std::vector<NimBLEHostPeripheral*>& list = peripherals();
+    list.erase(std::remove(list.begin(), list.end(), this), list.end());
+}
+
+void NimBLEHostPeripheral::addService(const NimBLEUUID& uuid, const std::vector<Characteristic>& characteristics) {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    Service service;
+    service.uuid = uuid;
+    service.characteristics = characteristics;
+    _services.push_back(service);
+}
+
+bool NimBLEHostPeripheral::notify(const NimBLEUUID& characteristic, const uint8_t* data, size_t length) {
+    NimBLERemoteCharacteristic* subscribed = nullptr;
+    NimBLERemoteCharacteristic::notify_callback callback;
+    {
+        std::lock_guard<std::recursive_mutex> lock(hostLock());
+        if (nullptr == _client) {
+            return false;
+        }
+        for (NimBLERemoteService* service : _client->_services) {
+            for (NimBLERemoteCharacteristic* candidate : service->_characteristics) {
+                if (candidate->_uuid.equals(characteristic) && candidate->_subscribed
+                    && candidate->_callback && NimBLEHostAccess::isCurrent(service)) {
+                    subscribed = candidate;
+                    callback = candidate->_callback;
+                }
+            }
+        }
+    }
+    if (nullptr == subscribed) {
+        return false;
+    }
+    // the callback may keep the bytes only during the call, as with NimBLE
+    std::vector<uint8_t> value(data, data + length);
+    callback(subscribed, value.data(), value.size(), true);
+    return true;
+}
+
+void NimBLEHostPeripheral::changeHandles() {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    _generation++;
+}
+
+void NimBLEHostPeripheral::dropLink() {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    if (_client) {
+        _client->_connected = false;
+        _client = nullptr;
+    }
+}
+
+bool NimBLEHostPeripheral::isConnected() const {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    return nullptr != _client;
+}
+
+uint32_t NimBLEHostPeripheral::getConnectCount() const {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    return _connectCount;
+}
+
+uint32_t NimBLEHostPeripheral::getDiscoveryCount() const {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    return _discoveryCount;
+}
+
+uint32_t NimBLEHostPeripheral::getSubscribeCount() const {
+    std::lock_guard<std::recursive_mutex> lock(hostLock());
+    return _subscribeCount;
+}
+
@@ -0,0 +1,202 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * FreeRTOS tasks, notifications and timers, and the ESP32 timer, on top
+ * of the C++ standard library. Task and timer state lives in fixed pools
+ * which are never destroyed, so handles stay valid for late notifications
+ * and no heap is used (keeping allocation counting tests exact).
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
+
+/*!
+ * Most tasks (and timers) alive at once.
+ */
+static const int HOST_TASK_CAPACITY = 64;
+static const int HOST_TIMER_CAPACITY = 8;
+
+struct HostTask {
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t notifications = 0;
+    std::atomic<bool> used{false};
+};
+
+struct HostTimer {
+    std::mutex mutex;
+    std::condition_variable condition;
+    TickType_t period = 0;
+    bool autoReload = false;
+    bool running = false;
+    bool threadStarted = false;
+    uint32_t generation = 0;
+    TimerCallbackFunction_t callback = nullptr;
+    std::atomic<bool> used{false};
+};
+
+/*!
+ * Get the element 'index' of a pool of 'N' never destroyed 'T'.
+ */
+template<typename T, int N>
+static T& poolAt(int index) {
+    static typename std::aligned_storage<sizeof(T), alignof(T)>::type storage[N];
+    static std::once_flag once;
+    std::call_once(once, [] {
+        for (int i = 0; i < N; i++) {
+            new (&storage[i]) T();
+        }
+    });
+    return *reinterpret_cast<T*>(&storage[index]);
+}
+
+// the task of the calling thread, nullptr until first used
+static thread_local HostTask* currentTask = nullptr;
+
+int64_t esp_timer_get_time() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+BaseType_t xTaskCreate(void (*taskCode)(void*), const char* name, uint32_t stackDepth,
+                       void* parameters, UBaseType_t priority, TaskHandle_t* createdTask) {
+    (void)name;
+    (void)stackDepth;
+    (void)priority;
+    HostTask* task = nullptr;
+    for (int i = 0; !task && i < HOST_TASK_CAPACITY; i++) {
+        bool expected = false;
+        if (poolAt<HostTask, HOST_TASK_CAPACITY>(i).used.compare_exchange_strong(expected, true)) {
+            task = &poolAt<HostTask, HOST_TASK_CAPACITY>(i);
+        }
+    }
+    if (nullptr == task) {
+        return pdFAIL;
+    }
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->notifications = 0;
+    }
+    if (createdTask) {
+        *createdTask = task;
+    }
+    std::thread([task, taskCode, parameters] {
+        currentTask = task;
+        taskCode(parameters);
+        task->used.store(false);
+    }).detach();
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // only the calling task is ever deleted, and it returns right after
+    (void)task;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (nullptr == currentTask) {
+        // a thread not created by xTaskCreate, e.g. main
+        static thread_local HostTask threadTask;
+        currentTask = &threadTask;
+    }
+    return currentTask;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->notifications++;
+    task->condition.notify_all();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticks) {
+    HostTask* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    auto notified = [task] { return 0 < task->notifications; };
+    if (portMAX_DELAY == ticks) {
+        task->condition.wait(lock, notified);
+    } else {
+        task->condition.wait_for(lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), notified);
+    }
+    uint32_t count = task->notifications;
+    if (clearCountOnExit) {
+        task->notifications = 0;
+    } else if (0 < count) {
+        task->notifications--;
+    }
+    return count;
+}
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoReload,
+                           void* timerId, TimerCallbackFunction_t callback) {
+    (void)name;
+    (void)timerId;
+    for (int i = 0; i < HOST_TIMER_CAPACITY; i++) {
+        HostTimer& timer = poolAt<HostTimer, HOST_TIMER_CAPACITY>(i);
+        bool expected = false;
+        if (timer.used.compare_exchange_strong(expected, true)) {
+            std::lock_guard<std::mutex> lock(timer.mutex);
+            timer.period = period;
+            timer.autoReload = (pdFALSE != autoReload);
+            timer.callback = callback;
+            return &timer;
+        }
+    }
+    return nullptr;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticksToWait) {
+    (void)ticksToWait;
+    std::lock_guard<std::mutex> lock(timer->mutex);
+    timer->running = true;
+    // restarting begins a new period
+    timer->generation++;
+    timer->condition.notify_all();
+    if (!timer->threadStarted) {
+        timer->threadStarted = true;
+        std::thread([timer] {
+            std::unique_lock<std::mutex> lock(timer->mutex);
+            while (true) {
+                timer->condition.wait(lock, [timer] { return timer->running; });
+                uint32_t generation = timer->generation;
+                std::chrono::steady_clock::time_point due = std::chrono::steady_clock::now()
+                    + std::chrono::milliseconds(timer->period * portTICK_PERIOD_MS);
+                bool interrupted = timer->condition.wait_until(lock, due, [timer, generation] {
+                    return !timer->running || generation != timer->generation;
+                });
+                if (interrupted) {
+                    // stopped, or restarted with a new period
+                    continue;
+                }
+                TimerCallbackFunction_t callback = timer->callback;
+                timer->running = timer->autoReload;
+                lock.unlock();
+                callback(timer);
+                lock.lock();
+            }
+        }).detach();
+    }
+    return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticksToWait) {
+    (void)ticksToWait;
+    std::lock_guard<std::mutex> lock(timer->mutex);
+    timer->running = false;
+    timer->condition.notify_all();
+    return pdPASS;
+}
@@ -0,0 +1,332 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * The parts of the NimBLE-Arduino (1.x) client API the library uses,
+ * backed by in-process peripherals instead of a radio. Tests create a
+ * NimBLEHostPeripheral for each device which should advertise, accept
+ * connections, be discovered and exchange GATT writes and notifications.
+ */
+
+#ifndef _HostNimBLEDevice_h
+#define _HostNimBLEDevice_h
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define BLE_ADDR_PUBLIC 0x00
+#define BLE_ADDR_RANDOM 0x01
+
+#ifndef NIMBLE_MAX_CONNECTIONS
+#define NIMBLE_MAX_CONNECTIONS 3
+#endif
+
+typedef struct {
+    uint8_t type;
+    uint8_t val[6];
+} ble_addr_t;
+
+class NimBLEClient;
+class NimBLERemoteService;
+class NimBLERemoteCharacteristic;
+class NimBLEHostPeripheral;
+struct NimBLEHostAccess;
+
+/*!
+ * UUID of a service, characteristic or descriptor.
+ */
+class NimBLEUUID {
+public:
+    NimBLEUUID();
+    NimBLEUUID(const std::string& uuid);
+    NimBLEUUID(const char* uuid);
+    NimBLEUUID(uint16_t uuid);
+    bool equals(const NimBLEUUID& uuid) const;
+    bool operator==(const NimBLEUUID& rhs) const;
+    bool operator!=(const NimBLEUUID& rhs) const;
+    std::string toString() const;
+
+private:
+    std::string _value;
+};
+
+/*!
+ * BLE address and its type. The native bytes are least significant first,
+ * while the string form is most significant first ("c4:4f:33:0a:1b:2c").
+ */
+class NimBLEAddress {
+public:
+    NimBLEAddress();
+    NimBLEAddress(ble_addr_t address);
+    NimBLEAddress(const uint8_t address[6], uint8_t type = BLE_ADDR_PUBLIC);
+    NimBLEAddress(const std::string& stringAddress, uint8_t type = BLE_ADDR_PUBLIC);
+    bool equals(const NimBLEAddress& otherAddress) const;
+    const uint8_t* getNative() const;
+    uint8_t getType() const;
+    std::string toString() const;
+    bool operator==(const NimBLEAddress& rhs) const;
+    bool operator!=(const NimBLEAddress& rhs) const;
+
+private:
+    uint8_t _address[6];
+    uint8_t _type;
+};
+
+/*!
+ * An advertisement received while scanning.
+ */
+class NimBLEAdvertisedDevice {
+public:
+    NimBLEAdvertisedDevice();
+    // host only, an advertisement as received
+    NimBLEAdvertisedDevice(const NimBLEAddress& address, const std::string& name, int rssi,
+                           const std::vector<NimBLEUUID>& serviceUUIDs);
+    NimBLEAddress getAddress();
+    std::string getName();
+    int getRSSI();
+    bool haveServiceUUID();
+    bool isAdvertisingService(const NimBLEUUID& uuid);
+    std::string toString();
+
+private:
+    friend struct NimBLEHostAccess;
+    friend class NimBLEScan;
+    NimBLEAddress _address;
+    std::string _name;
+    int _rssi;
+    std::vector<NimBLEUUID> _serviceUUIDs;
+};
+
+class NimBLEAdvertisedDeviceCallbacks {
+public:
+    virtual ~NimBLEAdvertisedDeviceCallbacks() {}
+    virtual void onResult(NimBLEAdvertisedDevice* advertisedDevice) = 0;
+};
+
+class NimBLEScanResults {
+public:
+    int getCount() { return 0; }
+};
+
+/*!
+ * Scanner delivering the advertisements of the NimBLEHostPeripherals in
+ * range. A blocking scan delivers each advertisement once and returns
+ * without waiting for the duration. A non-blocking scan does the same
+ * from another thread (repeating every 10 ms while the duration is 0)
+ * and then calls the completion callback.
+ */
+class NimBLEScan {
+public:
+    void setInterval(uint16_t intervalMSecs);
+    void setWindow(uint16_t windowMSecs);
+    void setActiveScan(bool active);
+    void setMaxResults(uint8_t maxResults);
+    void setAdvertisedDeviceCallbacks(NimBLEAdvertisedDeviceCallbacks* callbacks, bool wantDuplicates = false);
+    NimBLEScanResults start(uint32_t duration, bool isContinue = false);
+    bool start(uint32_t duration, void (*scanCompleteCB)(NimBLEScanResults), bool isContinue = false);
+    bool stop();
+    bool isScanning();
+    void clearResults();
+
+    // host only, the current parameters
+    uint16_t getInterval() const;
+    uint16_t getWindow() const;
+    bool getActiveScan() const;
+    NimBLEAdvertisedDeviceCallbacks* getAdvertisedDeviceCallbacks() const;
+};
+
+class NimBLERemoteDescriptor {
+public:
+    NimBLEUUID getUUID();
+    bool writeValue(const uint8_t* data, size_t length, bool response = false);
+
+private:
+    friend struct NimBLEHostAccess;
+    friend class NimBLERemoteCharacteristic;
+    NimBLERemoteCharacteristic* _characteristic;
+    NimBLEUUID _uuid;
+};
+
+class NimBLERemoteCharacteristic {
+public:
+    typedef std::function<void(NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify)> notify_callback;
+
+    ~NimBLERemoteCharacteristic();
+    NimBLEUUID getUUID();
+    uint16_t getHandle();
+    bool canWriteNoResponse();
+    bool canNotify();
+    bool registerForNotify(notify_callback callback, bool notifications = true, bool response = true);
+    NimBLERemoteDescriptor* getDescriptor(const NimBLEUUID& uuid);
+    bool writeValue(const uint8_t* data, size_t length, bool response = false);
+    NimBLERemoteService* getRemoteService();
+
+private:
+    friend struct NimBLEHostAccess;
+    friend class NimBLERemoteService;
+    friend class NimBLERemoteDescriptor;
+    friend class NimBLEHostPeripheral;
+    NimBLERemoteService* _service;
+    NimBLEUUID _uuid;
+    uint16_t _handle;
+    bool _writeNoResponse;
+    bool _notify;
+    bool _subscribed;
+    notify_callback _callback;
+    NimBLERemoteDescriptor* _descriptor;
+};
+
+class NimBLERemoteService {
+public:
+    ~NimBLERemoteService();
+    NimBLEUUID getUUID();
+    NimBLERemoteCharacteristic* getCharacteristic(const NimBLEUUID& uuid);
+    NimBLEClient* getClient();
+
+private:
+    friend struct NimBLEHostAccess;
+    friend class NimBLEClient;
+    friend class NimBLERemoteCharacteristic;
+    friend class NimBLERemoteDescriptor;
+    friend class NimBLEHostPeripheral;
+    NimBLEClient* _client;
+    NimBLEUUID _uuid;
+    // the peripheral's attribute generation when discovered
+    uint32_t _generation;
+    std::vector<NimBLERemoteCharacteristic*> _characteristics;
+};
+
+/*!
+ * Client of a single peripheral. Discovered services (and their
+ * characteristics) are kept until deleteServices, or a connect asking
+ * for the attributes to be deleted.
+ */
+class NimBLEClient {
+public:
+    bool connect(const NimBLEAddress& address, bool deleteAttributes = true);
+    int disconnect();
+    bool isConnected();
+    NimBLEAddress getPeerAddress();
+    NimBLERemoteService* getService(const NimBLEUUID& uuid);
+    void deleteServices();
+
+private:
+    friend struct NimBLEHostAccess;
+    friend class NimBLEDevice;
+    friend class NimBLERemoteService;
+    friend class NimBLERemoteCharacteristic;
+    friend class NimBLERemoteDescriptor;
+    friend class NimBLEHostPeripheral;
+    NimBLEClient();
+    ~NimBLEClient();
+    NimBLEAddress _peerAddress;
+    bool _connected;
+    std::vector<NimBLERemoteService*> _services;
+};
+
+class NimBLEDevice {
+public:
+    static void init(const std::string& deviceName);
+    static NimBLEScan* getScan();
+    static NimBLEClient* createClient();
+    static bool deleteClient(NimBLEClient* client);
+    static NimBLEClient* getClientByPeerAddress(const NimBLEAddress& peerAddress);
+    static NimBLEClient* getDisconnectedClient();
+    static size_t getClientListSize();
+};
+
+/*!
+ * @brief An in-process BLE peripheral for the host build.
+ *
+ * Advertises (while 'advertising' and 'inRange'), accepts connections to
+ * its address (and type) and offers its services for discovery. Writes
+ * to its characteristics go to 'onWrite', and notify sends to the
+ * subscribed client. Peripherals register themselves while they exist.
+ */
+class NimBLEHostPeripheral {
+public:
+    /*!
+     * Properties of an offered characteristic.
+     */
+    struct Characteristic {
+        NimBLEUUID uuid;
+        bool writeNoResponse;
+        bool notify;
+    };
+
+    NimBLEHostPeripheral(const NimBLEAddress& address);
+    ~NimBLEHostPeripheral();
+
+    NimBLEAddress address;
+    std::string name;
+    int rssi = -60;
+    bool advertising = true;
+    bool inRange = true;
+    // time taken by a connect, and by each discovery, as over the air
+    uint32_t connectDelayMillis = 0;
+    uint32_t discoveryDelayMillis = 0;
+    // called (from the writing task) for each write to a characteristic
+    std::function<void(const NimBLEUUID& characteristic, const uint8_t* data, size_t length)> onWrite;
+
+    /*!
+     * Offer a service with the given characteristics.
+     */
+    void addService(const NimBLEUUID& uuid, const std::vector<Characteristic>& characteristics);
+
+    /*!
+     * Notify the connected client's subscription to 'characteristic'.
+     *
+     * @return false if not connected or not subscribed
+     */
+    bool notify(const NimBLEUUID& characteristic, const uint8_t* data, size_t length);
+
+    /*!
+     * Change every attribute handle (e.g. after a firmware update), so
+     * attributes discovered before no longer work.
+     */
+    void changeHandles();
+
+    /*!
+     * Drop the link, as when going out of range.
+     */
+    void dropLink();
+
+    bool isConnected() const;
+    uint32_t getConnectCount() const;
+    uint32_t getDiscoveryCount() const;
+    uint32_t getSubscribeCount() const;
+
+private:
+    friend struct NimBLEHostAccess;
+    friend class NimBLEClient;
+    friend class NimBLERemoteService;
+    friend class NimBLERemoteCharacteristic;
+    friend class NimBLERemoteDescriptor;
+    friend class NimBLEScan;
+    struct Service {
+        NimBLEUUID uuid;
+        std::vector<Characteristic> characteristics;
+    };
+    std::vector<Service> _services;
+    uint32_t _generation = 0;
+    NimBLEClient* _client = nullptr;
+    uint32_t _connectCount = 0;
+    uint32_t _discoveryCount = 0;
+    uint32_t _subscribeCount = 0;
+};
+
+typedef NimBLEUUID BLEUUID;
+typedef NimBLEAddress BLEAddress;
+typedef NimBLEAdvertisedDevice BLEAdvertisedDevice;
+typedef NimBLEAdvertisedDeviceCallbacks BLEAdvertisedDeviceCallbacks;
+typedef NimBLEScanResults BLEScanResults;
+typedef NimBLEScan BLEScan;
+typedef NimBLEClient BLEClient;
+typedef NimBLERemoteService BLERemoteService;
+typedef NimBLERemoteCharacteristic BLERemoteCharacteristic;
+typedef NimBLERemoteDescriptor BLERemoteDescriptor;
+typedef NimBLEDevice BLEDevice;
+
+#endif
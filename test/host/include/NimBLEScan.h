@@ -0,0 +1,5 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#include "NimBLEDevice.h"
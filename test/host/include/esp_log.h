@@ -0,0 +1,57 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * ESP-IDF logging. Enabled log sites are formatted as on the ESP32 and
+ * written to stderr when at or below the runtime level, which is taken
+ * from the MOBIUS_HOST_LOG environment variable (0 to 5, default 1, errors).
+ */
+
+#ifndef _HostEspLog_h
+#define _HostEspLog_h
+
+#include <cstdint>
+#include <cstddef>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+/*!
+ * Set the runtime level for every tag ('tag' is ignored on the host).
+ */
+void esp_log_level_set(const char* tag, esp_log_level_t level);
+
+/*!
+ * Get the time since the process started (in milliseconds).
+ */
+uint32_t esp_log_timestamp();
+
+/*!
+ * Format and (if at or below the runtime level) write a log message.
+ */
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/*!
+ * Write 'length' bytes of 'buffer' as a hex dump, 16 bytes per line.
+ */
+void esp_log_buffer_hexdump_internal(const char* tag, const void* buffer, uint16_t length, esp_log_level_t level);
+
+#define ESP_LOG_BUFFER_HEXDUMP(tag, buffer, length, level) \
+    esp_log_buffer_hexdump_internal((tag), (buffer), (length), (level))
+
+#define ESP_LOG_LEVEL(level, letter, tag, format, ...) \
+    esp_log_write((level), (tag), letter " (%u) %s: " format "\n", esp_log_timestamp(), (tag), ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_LEVEL(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
+
+#endif
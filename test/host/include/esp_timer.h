@@ -0,0 +1,16 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ */
+
+#ifndef _HostEspTimer_h
+#define _HostEspTimer_h
+
+#include <cstdint>
+
+/*!
+ * Get the time since the process started (in microseconds), like the
+ * time since boot on the ESP32.
+ */
+int64_t esp_timer_get_time();
+
+#endif
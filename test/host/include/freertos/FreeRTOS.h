@@ -0,0 +1,26 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * The parts of FreeRTOS the library uses, for building on a desktop OS.
+ */
+
+#ifndef _HostFreeRTOS_h
+#define _HostFreeRTOS_h
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdFAIL  0
+#define pdPASS  1
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+// ticks are milliseconds, as with the ESP32 Arduino core (CONFIG_FREERTOS_HZ 1000)
+#define portTICK_PERIOD_MS ((TickType_t)1)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#endif
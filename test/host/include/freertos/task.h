@@ -0,0 +1,54 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * FreeRTOS tasks and task notifications on top of std::thread.
+ */
+
+#ifndef _HostTask_h
+#define _HostTask_h
+
+#include <cstdint>
+#include "FreeRTOS.h"
+
+struct HostTask;
+typedef HostTask* TaskHandle_t;
+
+/*!
+ * Start 'taskCode' with 'parameters' on a new thread. The stack depth
+ * and priority are ignored.
+ */
+BaseType_t xTaskCreate(void (*taskCode)(void*), const char* name, uint32_t stackDepth,
+                       void* parameters, UBaseType_t priority, TaskHandle_t* createdTask);
+
+/*!
+ * End a task. Only the calling task (nullptr) can be deleted, and as the
+ * library always does so last, the host version returns to let the
+ * thread end.
+ */
+void vTaskDelete(TaskHandle_t task);
+
+/*!
+ * Sleep for 'ticks' (milliseconds).
+ */
+void vTaskDelay(TickType_t ticks);
+
+/*!
+ * Get the calling task. Threads not created by xTaskCreate (e.g. main)
+ * get their own handle on first use.
+ */
+TaskHandle_t xTaskGetCurrentTaskHandle();
+
+/*!
+ * Increment the notification count of 'task', waking it if waiting.
+ */
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+/*!
+ * Wait up to 'ticks' for the notification count of the calling task to be
+ * non-zero, then clear it (or decrement it).
+ *
+ * @return the count before it was cleared or decremented
+ */
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticks);
+
+#endif
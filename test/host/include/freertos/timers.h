@@ -0,0 +1,33 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * FreeRTOS software timers, each run by its own thread.
+ */
+
+#ifndef _HostTimers_h
+#define _HostTimers_h
+
+#include "FreeRTOS.h"
+
+struct HostTimer;
+typedef HostTimer* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+/*!
+ * Create a (dormant) timer calling 'callback' every 'period' ticks, or
+ * once unless 'autoReload'.
+ */
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoReload,
+                           void* timerId, TimerCallbackFunction_t callback);
+
+/*!
+ * Start the 'timer'.
+ */
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticksToWait);
+
+/*!
+ * Stop the 'timer'.
+ */
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticksToWait);
+
+#endif
@@ -0,0 +1,10 @@
+/*!
+ * This file is part of the ESP32_MobiusBLE library host build.
+ *
+ * No ESP-IDF configuration on the host, the library defaults apply.
+ */
+
+#ifndef _HostSdkconfig_h
+#define _HostSdkconfig_h
+
+#endif